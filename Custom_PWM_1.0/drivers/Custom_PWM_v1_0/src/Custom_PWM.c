@@ -2,5 +2,80 @@
 
 /***************************** Include Files *******************************/
 #include "Custom_PWM.h"
+#include "xil_io.h"
 
 /************************** Function Definitions ***************************/
+
+void CUSTOM_PWM_Enable(u32 BaseAddress, u32 Enable)
+{
+	CUSTOM_PWM_mWriteReg(BaseAddress, CUSTOM_PWM_CONTROL_OFFSET,
+			     Enable ? CUSTOM_PWM_CONTROL_ENABLE_MASK : 0);
+}
+
+u32 CUSTOM_PWM_GetChannels(u32 BaseAddress)
+{
+	return CUSTOM_PWM_mReadReg(BaseAddress, CUSTOM_PWM_CHANNELS_OFFSET);
+}
+
+void CUSTOM_PWM_Commit(u32 BaseAddress)
+{
+	CUSTOM_PWM_mWriteReg(BaseAddress, CUSTOM_PWM_COMMIT_OFFSET,
+			     CUSTOM_PWM_COMMIT_MASK);
+}
+
+u32 CUSTOM_PWM_IsCommitPending(u32 BaseAddress)
+{
+	return (CUSTOM_PWM_mReadReg(BaseAddress, CUSTOM_PWM_COMMIT_OFFSET) &
+		CUSTOM_PWM_COMMIT_MASK) ? TRUE : FALSE;
+}
+
+void CUSTOM_PWM_SetPeriod(u32 BaseAddress, u32 Period, u32 Prescale)
+{
+	CUSTOM_PWM_mWriteReg(BaseAddress, CUSTOM_PWM_PRESCALE_OFFSET, Prescale);
+	CUSTOM_PWM_mWriteReg(BaseAddress, CUSTOM_PWM_PERIOD_OFFSET, Period);
+	CUSTOM_PWM_Commit(BaseAddress);
+}
+
+u32 CUSTOM_PWM_SetFrequency(u32 BaseAddress, u32 ClockHz, u32 Hz)
+{
+	u32 Prescale;
+	u32 Counts;
+
+	if (Hz == 0 || Hz > ClockHz)
+		return 0;
+
+	Counts = ClockHz / Hz;
+	Prescale = (Counts - 1) / (CUSTOM_PWM_MAX_COUNT + 1);
+	if (Prescale > CUSTOM_PWM_MAX_PRESCALE)
+		return 0;
+	Counts /= Prescale + 1;
+
+	CUSTOM_PWM_SetPeriod(BaseAddress, Counts - 1, Prescale);
+	return Counts;
+}
+
+void CUSTOM_PWM_SetDuty(u32 BaseAddress, u32 Channel, u32 Duty)
+{
+	CUSTOM_PWM_mWriteReg(BaseAddress, CUSTOM_PWM_DUTY_OFFSET(Channel), Duty);
+	CUSTOM_PWM_Commit(BaseAddress);
+}
+
+void CUSTOM_PWM_SetDuties(u32 BaseAddress, const u32 *Duty, u32 Count)
+{
+	u32 Channel;
+
+	for (Channel = 0; Channel < Count; Channel++)
+		CUSTOM_PWM_mWriteReg(BaseAddress, CUSTOM_PWM_DUTY_OFFSET(Channel),
+				     Duty[Channel]);
+	CUSTOM_PWM_Commit(BaseAddress);
+}
+
+void CUSTOM_PWM_SetPhase(u32 BaseAddress, u32 Channel, u32 Phase)
+{
+	CUSTOM_PWM_mWriteReg(BaseAddress, CUSTOM_PWM_PHASE_OFFSET(Channel), Phase);
+}
+
+u32 CUSTOM_PWM_GetCounter(u32 BaseAddress)
+{
+	return CUSTOM_PWM_mReadReg(BaseAddress, CUSTOM_PWM_COUNTER_OFFSET);
+}
@@ -11,7 +11,31 @@
 #define CUSTOM_PWM_S00_AXI_SLV_REG1_OFFSET 4
 #define CUSTOM_PWM_S00_AXI_SLV_REG2_OFFSET 8
 #define CUSTOM_PWM_S00_AXI_SLV_REG3_OFFSET 12
+#define CUSTOM_PWM_S00_AXI_SLV_REG4_OFFSET 16
+#define CUSTOM_PWM_S00_AXI_SLV_REG5_OFFSET 20
 
+/*
+ * Register map of motor_pwm. All channels share one counter. Period,
+ * prescaler, duty and phase registers are staged: a write to the commit
+ * register hands all of them to the counter at once, and they take effect
+ * together at the next counter wrap.
+ */
+#define CUSTOM_PWM_CONTROL_OFFSET	CUSTOM_PWM_S00_AXI_SLV_REG0_OFFSET
+#define CUSTOM_PWM_PERIOD_OFFSET	CUSTOM_PWM_S00_AXI_SLV_REG1_OFFSET
+#define CUSTOM_PWM_PRESCALE_OFFSET	CUSTOM_PWM_S00_AXI_SLV_REG2_OFFSET
+#define CUSTOM_PWM_COMMIT_OFFSET	CUSTOM_PWM_S00_AXI_SLV_REG3_OFFSET
+#define CUSTOM_PWM_COUNTER_OFFSET	CUSTOM_PWM_S00_AXI_SLV_REG4_OFFSET	/* read only */
+#define CUSTOM_PWM_CHANNELS_OFFSET	CUSTOM_PWM_S00_AXI_SLV_REG5_OFFSET	/* read only */
+#define CUSTOM_PWM_DUTY_OFFSET(Channel)		(0x20 + 8 * (Channel))
+#define CUSTOM_PWM_PHASE_OFFSET(Channel)	(0x24 + 8 * (Channel))
+
+#define CUSTOM_PWM_CONTROL_ENABLE_MASK	0x1	/* set at reset */
+#define CUSTOM_PWM_COMMIT_MASK		0x1	/* reads 1 until the wrap */
+
+#define CUSTOM_PWM_MAX_CHANNELS		12	/* 7-bit address bus */
+#define CUSTOM_PWM_MAX_COUNT		0xFFFFFF	/* 24-bit counter */
+#define CUSTOM_PWM_MAX_PRESCALE		0xFFFF
+#define CUSTOM_PWM_DEFAULT_PERIOD	2500000	/* 40 Hz at 100 MHz */
 
 /**************************** Type Definitions *****************************/
 /**
@@ -76,4 +100,136 @@
  */
 XStatus CUSTOM_PWM_Reg_SelfTest(void * baseaddr_p);
 
+/**
+ *
+ * Starts or stops the PWM output. While stopped the output is low, the
+ * counter is held at 0 and new duty, period and prescaler values take
+ * effect immediately.
+ *
+ * @param   BaseAddress is the base address of the CUSTOM_PWM device.
+ * @param   Enable is non-zero to run the counter.
+ *
+ * @return  None.
+ *
+ */
+void CUSTOM_PWM_Enable(u32 BaseAddress, u32 Enable);
+
+/**
+ *
+ * Returns the number of channels the IP was built with.
+ *
+ * @param   BaseAddress is the base address of the CUSTOM_PWM device.
+ *
+ * @return  C_NUM_CHANNELS.
+ *
+ */
+u32 CUSTOM_PWM_GetChannels(u32 BaseAddress);
+
+/**
+ *
+ * Commits the staged period, prescaler, duty and phase registers. They
+ * take effect together at the next counter wrap.
+ *
+ * @param   BaseAddress is the base address of the CUSTOM_PWM device.
+ *
+ * @return  None.
+ *
+ */
+void CUSTOM_PWM_Commit(u32 BaseAddress);
+
+/**
+ *
+ * Checks whether a commit is still waiting for the counter to wrap.
+ *
+ * @param   BaseAddress is the base address of the CUSTOM_PWM device.
+ *
+ * @return  TRUE until the committed values are in use.
+ *
+ */
+u32 CUSTOM_PWM_IsCommitPending(u32 BaseAddress);
+
+/**
+ *
+ * Sets the PWM period of all channels and commits it. The counter advances
+ * every Prescale + 1 clocks and runs from 0 to Period, so the output
+ * frequency is clock / ((Period + 1) * (Prescale + 1)).
+ *
+ * @param   BaseAddress is the base address of the CUSTOM_PWM device.
+ * @param   Period is the terminal count, at most CUSTOM_PWM_MAX_COUNT.
+ * @param   Prescale is the clock prescaler, at most CUSTOM_PWM_MAX_PRESCALE.
+ *
+ * @return  None.
+ *
+ */
+void CUSTOM_PWM_SetPeriod(u32 BaseAddress, u32 Period, u32 Prescale);
+
+/**
+ *
+ * Picks the smallest prescaler that fits the 24-bit counter and sets the
+ * period for the requested output frequency.
+ *
+ * @param   BaseAddress is the base address of the CUSTOM_PWM device.
+ * @param   ClockHz is the S00_AXI clock frequency.
+ * @param   Hz is the PWM frequency.
+ *
+ * @return  Counts per period, the full-scale duty value, or 0 if the
+ *          frequency cannot be reached.
+ *
+ */
+u32 CUSTOM_PWM_SetFrequency(u32 BaseAddress, u32 ClockHz, u32 Hz);
+
+/**
+ *
+ * Sets the number of counts per period one channel is high and commits it.
+ * 0 keeps the output low and a value above the period keeps it high.
+ *
+ * @param   BaseAddress is the base address of the CUSTOM_PWM device.
+ * @param   Channel is the channel, 0 to C_NUM_CHANNELS - 1.
+ * @param   Duty is the high time in counts.
+ *
+ * @return  None.
+ *
+ */
+void CUSTOM_PWM_SetDuty(u32 BaseAddress, u32 Channel, u32 Duty);
+
+/**
+ *
+ * Sets the duty of channels 0 to Count - 1 with one commit, so all of them
+ * change in the same period.
+ *
+ * @param   BaseAddress is the base address of the CUSTOM_PWM device.
+ * @param   Duty holds one high time in counts per channel.
+ * @param   Count is the number of channels to set.
+ *
+ * @return  None.
+ *
+ */
+void CUSTOM_PWM_SetDuties(u32 BaseAddress, const u32 *Duty, u32 Count);
+
+/**
+ *
+ * Sets the phase offset of one channel without committing it. The channel
+ * goes high Phase counts after the start of the period, which staggers the
+ * switching edges of the channels. Call CUSTOM_PWM_Commit() when done.
+ *
+ * @param   BaseAddress is the base address of the CUSTOM_PWM device.
+ * @param   Channel is the channel, 0 to C_NUM_CHANNELS - 1.
+ * @param   Phase is the offset in counts, at most the period.
+ *
+ * @return  None.
+ *
+ */
+void CUSTOM_PWM_SetPhase(u32 BaseAddress, u32 Channel, u32 Phase);
+
+/**
+ *
+ * Reads the live counter.
+ *
+ * @param   BaseAddress is the base address of the CUSTOM_PWM device.
+ *
+ * @return  Counter value, 0 to the active period.
+ *
+ */
+u32 CUSTOM_PWM_GetCounter(u32 BaseAddress);
+
 #endif // CUSTOM_PWM_H
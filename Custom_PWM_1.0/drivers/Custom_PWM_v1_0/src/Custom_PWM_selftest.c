@@ -8,6 +8,16 @@
 /************************** Constant Definitions ***************************/
 #define READ_WRITE_MUL_FACTOR 0x10
 
+/* Read/write registers; commit, counter and channel count are not */
+static const u32 TestOffsets[] = {
+	CUSTOM_PWM_CONTROL_OFFSET,
+	CUSTOM_PWM_PERIOD_OFFSET,
+	CUSTOM_PWM_PRESCALE_OFFSET,
+	CUSTOM_PWM_DUTY_OFFSET(0),
+	CUSTOM_PWM_PHASE_OFFSET(0),
+};
+#define TEST_OFFSET_COUNT (sizeof(TestOffsets) / sizeof(TestOffsets[0]))
+
 /************************** Function Definitions ***************************/
 /**
  *
@@ -46,11 +56,11 @@ XStatus CUSTOM_PWM_Reg_SelfTest(void * baseaddr_p)
 	 */
 	xil_printf("User logic slave module test...\n\r");
 
-	for (write_loop_index = 0 ; write_loop_index < 4; write_loop_index++)
-	  CUSTOM_PWM_mWriteReg (baseaddr, write_loop_index*4, (write_loop_index+1)*READ_WRITE_MUL_FACTOR);
-	for (read_loop_index = 0 ; read_loop_index < 4; read_loop_index++)
-	  if ( CUSTOM_PWM_mReadReg (baseaddr, read_loop_index*4) != (read_loop_index+1)*READ_WRITE_MUL_FACTOR){
-	    xil_printf ("Error reading register value at address %x\n", (int)baseaddr + read_loop_index*4);
+	for (write_loop_index = 0 ; write_loop_index < TEST_OFFSET_COUNT; write_loop_index++)
+	  CUSTOM_PWM_mWriteReg (baseaddr, TestOffsets[write_loop_index], (write_loop_index+1)*READ_WRITE_MUL_FACTOR);
+	for (read_loop_index = 0 ; read_loop_index < TEST_OFFSET_COUNT; read_loop_index++)
+	  if ( CUSTOM_PWM_mReadReg (baseaddr, TestOffsets[read_loop_index]) != (read_loop_index+1)*READ_WRITE_MUL_FACTOR){
+	    xil_printf ("Error reading register value at address %x\n", (int)baseaddr + TestOffsets[read_loop_index]);
 	    return XST_FAILURE;
 	  }
 
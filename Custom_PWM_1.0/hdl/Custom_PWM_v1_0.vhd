@@ -5,18 +5,21 @@ use ieee.numeric_std.all;
 entity Custom_PWM_v1_0 is
 	generic (
 		-- Users to add parameters here
-
+		-- Number of PWM outputs, 1 to 12 with the 7-bit address bus
+		C_NUM_CHANNELS	: integer	:= 4;
 		-- User parameters ends
 		-- Do not modify the parameters beyond this line
 
 
 		-- Parameters of Axi Slave Bus Interface S00_AXI
 		C_S00_AXI_DATA_WIDTH	: integer	:= 32;
-		C_S00_AXI_ADDR_WIDTH	: integer	:= 4
+		C_S00_AXI_ADDR_WIDTH	: integer	:= 7
 	);
 	port (
 		-- Users to add ports here
+        -- o_data is channel 0, o_pwm has every channel
         o_data : out std_logic;
+        o_pwm : out std_logic_vector(C_NUM_CHANNELS-1 downto 0);
 		-- User ports ends
 		-- Do not modify the ports beyond this line
 
@@ -51,11 +54,12 @@ architecture arch_imp of Custom_PWM_v1_0 is
 	-- component declaration
 	component Custom_PWM_v1_0_S00_AXI is
 		generic (
+		C_NUM_CHANNELS	: integer	:= 4;
 		C_S_AXI_DATA_WIDTH	: integer	:= 32;
-		C_S_AXI_ADDR_WIDTH	: integer	:= 4
+		C_S_AXI_ADDR_WIDTH	: integer	:= 7
 		);
 		port (
-		o_data : out std_logic;
+		o_data : out std_logic_vector(C_NUM_CHANNELS-1 downto 0);
 		S_AXI_ACLK	: in std_logic;
 		S_AXI_ARESETN	: in std_logic;
 		S_AXI_AWADDR	: in std_logic_vector(C_S_AXI_ADDR_WIDTH-1 downto 0);
@@ -80,16 +84,19 @@ architecture arch_imp of Custom_PWM_v1_0 is
 		);
 	end component Custom_PWM_v1_0_S00_AXI;
 
+	signal pwm_out	: std_logic_vector(C_NUM_CHANNELS-1 downto 0);
+
 begin
 
 -- Instantiation of Axi Bus Interface S00_AXI
 Custom_PWM_v1_0_S00_AXI_inst : Custom_PWM_v1_0_S00_AXI
 	generic map (
+		C_NUM_CHANNELS	=> C_NUM_CHANNELS,
 		C_S_AXI_DATA_WIDTH	=> C_S00_AXI_DATA_WIDTH,
 		C_S_AXI_ADDR_WIDTH	=> C_S00_AXI_ADDR_WIDTH
 	)
 	port map (
-	    o_data => o_data,
+	    o_data => pwm_out,
 		S_AXI_ACLK	=> s00_axi_aclk,
 		S_AXI_ARESETN	=> s00_axi_aresetn,
 		S_AXI_AWADDR	=> s00_axi_awaddr,
@@ -114,6 +121,8 @@ Custom_PWM_v1_0_S00_AXI_inst : Custom_PWM_v1_0_S00_AXI
 	);
 
 	-- Add user logic here
+	o_data <= pwm_out(0);
+	o_pwm <= pwm_out;
 
 	-- User logic ends
 
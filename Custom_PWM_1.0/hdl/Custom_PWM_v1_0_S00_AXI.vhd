@@ -5,18 +5,19 @@ use ieee.numeric_std.all;
 entity Custom_PWM_v1_0_S00_AXI is
 	generic (
 		-- Users to add parameters here
-
+		-- Number of PWM outputs, 1 to 12 with the 7-bit address bus
+		C_NUM_CHANNELS	: integer	:= 4;
 		-- User parameters ends
 		-- Do not modify the parameters beyond this line
 
 		-- Width of S_AXI data bus
 		C_S_AXI_DATA_WIDTH	: integer	:= 32;
 		-- Width of S_AXI address bus
-		C_S_AXI_ADDR_WIDTH	: integer	:= 4
+		C_S_AXI_ADDR_WIDTH	: integer	:= 7
 	);
 	port (
 		-- Users to add ports here
-        o_data : out std_logic;
+        o_data : out std_logic_vector(C_NUM_CHANNELS-1 downto 0);
 		-- User ports ends
 		-- Do not modify the ports beyond this line
 
@@ -103,15 +104,40 @@ architecture arch_imp of Custom_PWM_v1_0_S00_AXI is
 	-- ADDR_LSB = 2 for 32 bits (n downto 2)
 	-- ADDR_LSB = 3 for 64 bits (n downto 3)
 	constant ADDR_LSB  : integer := (C_S_AXI_DATA_WIDTH/32)+ 1;
-	constant OPT_MEM_ADDR_BITS : integer := 1;
+	constant OPT_MEM_ADDR_BITS : integer := C_S_AXI_ADDR_WIDTH - ADDR_LSB - 1;
 	------------------------------------------------
 	---- Signals for user logic register space example
 	--------------------------------------------------
-	---- Number of Slave Registers 4
+	---- Number of Slave Registers 6 + 2 * C_NUM_CHANNELS
+	-- slv_reg0 (0x00) : control (bit 0 enable, set at reset)
+	-- slv_reg1 (0x04) : period, the counter runs 0 to period
+	-- slv_reg2 (0x08) : prescaler, the counter advances every
+	--                   prescaler + 1 clocks (bits 15-0)
+	-- slv_reg3 (0x0C) : commit, writing bit 0 hands period, prescaler and
+	--                   all duty and phase registers to motor_pwm together,
+	--                   they take effect at the next counter wrap. Reads
+	--                   bit 0 set until that wrap.
+	-- slv_reg4 (0x10) : live counter value, read only
+	-- slv_reg5 (0x14) : C_NUM_CHANNELS, read only
+	-- 0x20 + 8 * n    : duty of channel n in counts
+	-- 0x24 + 8 * n    : phase offset of channel n in counts
+	constant PWM_DEFAULT_PERIOD : integer := 2500000;	-- 40 Hz at 100 MHz
+	constant PWM_WIDTH : integer := 24;
+	constant CHAN_BASE : integer := 8;	-- register index of channel 0 duty
+	type chan_regs_t is array (0 to C_NUM_CHANNELS-1) of std_logic_vector(C_S_AXI_DATA_WIDTH-1 downto 0);
 	signal slv_reg0	:std_logic_vector(C_S_AXI_DATA_WIDTH-1 downto 0);
 	signal slv_reg1	:std_logic_vector(C_S_AXI_DATA_WIDTH-1 downto 0);
 	signal slv_reg2	:std_logic_vector(C_S_AXI_DATA_WIDTH-1 downto 0);
 	signal slv_reg3	:std_logic_vector(C_S_AXI_DATA_WIDTH-1 downto 0);
+	signal slv_reg4	:std_logic_vector(C_S_AXI_DATA_WIDTH-1 downto 0);
+	signal slv_reg5	:std_logic_vector(C_S_AXI_DATA_WIDTH-1 downto 0);
+	signal duty_regs	: chan_regs_t;
+	signal phase_regs	: chan_regs_t;
+	signal duty_bus	: std_logic_vector(C_NUM_CHANNELS*PWM_WIDTH-1 downto 0);
+	signal phase_bus	: std_logic_vector(C_NUM_CHANNELS*PWM_WIDTH-1 downto 0);
+	signal pwm_commit	: std_logic;
+	signal pwm_pending	: std_logic;
+	signal pwm_count	: std_logic_vector(PWM_WIDTH-1 downto 0);
 	signal slv_reg_rden	: std_logic;
 	signal slv_reg_wren	: std_logic;
 	signal reg_data_out	:std_logic_vector(C_S_AXI_DATA_WIDTH-1 downto 0);
@@ -119,10 +145,22 @@ architecture arch_imp of Custom_PWM_v1_0_S00_AXI is
 	signal aw_en	: std_logic;
     
     component motor_pwm is
+	   generic (
+	       C_WIDTH    :   integer := 24;
+	       C_NUM_CHANNELS : integer := 4
+	   );
 	   port (
-	       I_CLK   :   in std_logic;
-	       I_DATA  :   in std_logic_vector(23 downto 0);
-	       O_DATA  :   out std_logic
+	       I_CLK      :   in std_logic;
+	       I_RESETN   :   in std_logic;
+	       I_ENABLE   :   in std_logic;
+	       I_COMMIT   :   in std_logic;
+	       I_PERIOD   :   in std_logic_vector(C_WIDTH-1 downto 0);
+	       I_PRESCALE :   in std_logic_vector(15 downto 0);
+	       I_DUTY     :   in std_logic_vector(C_NUM_CHANNELS*C_WIDTH-1 downto 0);
+	       I_PHASE    :   in std_logic_vector(C_NUM_CHANNELS*C_WIDTH-1 downto 0);
+	       O_COUNT    :   out std_logic_vector(C_WIDTH-1 downto 0);
+	       O_PENDING  :   out std_logic;
+	       O_DATA     :   out std_logic_vector(C_NUM_CHANNELS-1 downto 0)
 	   );
 	end component motor_pwm;
 begin
@@ -141,10 +179,23 @@ begin
 	-- S_AXI_AWVALID and S_AXI_WVALID are asserted. axi_awready is
 	-- de-asserted when reset is low.
      motor_pwm_inst1 : motor_pwm
+    generic map
+    (
+        C_WIDTH => PWM_WIDTH,
+        C_NUM_CHANNELS => C_NUM_CHANNELS
+    )
     port map
     (
         I_CLK => S_AXI_ACLK,
-        I_DATA => S_AXI_WDATA(23 downto 0),
+        I_RESETN => S_AXI_ARESETN,
+        I_ENABLE => slv_reg0(0),
+        I_COMMIT => pwm_commit,
+        I_PERIOD => slv_reg1(PWM_WIDTH-1 downto 0),
+        I_PRESCALE => slv_reg2(15 downto 0),
+        I_DUTY => duty_bus,
+        I_PHASE => phase_bus,
+        O_COUNT => pwm_count,
+        O_PENDING => pwm_pending,
         O_DATA => O_DATA
     );
     
@@ -225,55 +276,47 @@ begin
 
 	process (S_AXI_ACLK)
 	variable loc_addr :std_logic_vector(OPT_MEM_ADDR_BITS downto 0); 
+	variable reg_index : integer;
+	variable chan : integer;
 	begin
 	  if rising_edge(S_AXI_ACLK) then 
+	    pwm_commit <= '0';
 	    if S_AXI_ARESETN = '0' then
-	      slv_reg0 <= (others => '0');
-	      slv_reg1 <= (others => '0');
+	      slv_reg0 <= (0 => '1', others => '0');
+	      slv_reg1 <= std_logic_vector(to_unsigned(PWM_DEFAULT_PERIOD, C_S_AXI_DATA_WIDTH));
 	      slv_reg2 <= (others => '0');
-	      slv_reg3 <= (others => '0');
+	      duty_regs <= (others => (others => '0'));
+	      phase_regs <= (others => (others => '0'));
 	    else
 	      loc_addr := axi_awaddr(ADDR_LSB + OPT_MEM_ADDR_BITS downto ADDR_LSB);
+	      reg_index := to_integer(unsigned(loc_addr));
+	      chan := (reg_index - CHAN_BASE) / 2;
 	      if (slv_reg_wren = '1') then
-	        case loc_addr is
-	          when b"00" =>
-	            for byte_index in 0 to (C_S_AXI_DATA_WIDTH/8-1) loop
-	              if ( S_AXI_WSTRB(byte_index) = '1' ) then
-	                -- Respective byte enables are asserted as per write strobes                   
-	                -- slave registor 0
+	        for byte_index in 0 to (C_S_AXI_DATA_WIDTH/8-1) loop
+	          if ( S_AXI_WSTRB(byte_index) = '1' ) then
+	            -- Respective byte enables are asserted as per write strobes
+	            case reg_index is
+	              when 0 =>
 	                slv_reg0(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
-	              end if;
-	            end loop;
-	          when b"01" =>
-	            for byte_index in 0 to (C_S_AXI_DATA_WIDTH/8-1) loop
-	              if ( S_AXI_WSTRB(byte_index) = '1' ) then
-	                -- Respective byte enables are asserted as per write strobes                   
-	                -- slave registor 1
+	              when 1 =>
 	                slv_reg1(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
-	              end if;
-	            end loop;
-	          when b"10" =>
-	            for byte_index in 0 to (C_S_AXI_DATA_WIDTH/8-1) loop
-	              if ( S_AXI_WSTRB(byte_index) = '1' ) then
-	                -- Respective byte enables are asserted as per write strobes                   
-	                -- slave registor 2
+	              when 2 =>
 	                slv_reg2(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
-	              end if;
-	            end loop;
-	          when b"11" =>
-	            for byte_index in 0 to (C_S_AXI_DATA_WIDTH/8-1) loop
-	              if ( S_AXI_WSTRB(byte_index) = '1' ) then
-	                -- Respective byte enables are asserted as per write strobes                   
-	                -- slave registor 3
-	                slv_reg3(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
-	              end if;
-	            end loop;
-	          when others =>
-	            slv_reg0 <= slv_reg0;
-	            slv_reg1 <= slv_reg1;
-	            slv_reg2 <= slv_reg2;
-	            slv_reg3 <= slv_reg3;
-	        end case;
+	              when others =>
+	                -- channel duty and phase, the rest is read only
+	                if (reg_index >= CHAN_BASE and chan < C_NUM_CHANNELS) then
+	                  if (reg_index mod 2 = 0) then
+	                    duty_regs(chan)(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
+	                  else
+	                    phase_regs(chan)(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
+	                  end if;
+	                end if;
+	            end case;
+	          end if;
+	        end loop;
+	        if (reg_index = 3 and S_AXI_WSTRB(0) = '1' and S_AXI_WDATA(0) = '1') then
+	          pwm_commit <= '1';
+	        end if;
 	      end if;
 	    end if;
 	  end if;                   
@@ -360,22 +403,38 @@ begin
 	-- and the slave is ready to accept the read address.
 	slv_reg_rden <= axi_arready and S_AXI_ARVALID and (not axi_rvalid) ;
 
-	process (slv_reg0, slv_reg1, slv_reg2, slv_reg3, axi_araddr, S_AXI_ARESETN, slv_reg_rden)
+	process (slv_reg0, slv_reg1, slv_reg2, slv_reg3, slv_reg4, slv_reg5, duty_regs, phase_regs, axi_araddr, S_AXI_ARESETN, slv_reg_rden)
 	variable loc_addr :std_logic_vector(OPT_MEM_ADDR_BITS downto 0);
+	variable reg_index : integer;
+	variable chan : integer;
 	begin
 	    -- Address decoding for reading registers
 	    loc_addr := axi_araddr(ADDR_LSB + OPT_MEM_ADDR_BITS downto ADDR_LSB);
-	    case loc_addr is
-	      when b"00" =>
+	    reg_index := to_integer(unsigned(loc_addr));
+	    chan := (reg_index - CHAN_BASE) / 2;
+	    case reg_index is
+	      when 0 =>
 	        reg_data_out <= slv_reg0;
-	      when b"01" =>
+	      when 1 =>
 	        reg_data_out <= slv_reg1;
-	      when b"10" =>
+	      when 2 =>
 	        reg_data_out <= slv_reg2;
-	      when b"11" =>
+	      when 3 =>
 	        reg_data_out <= slv_reg3;
+	      when 4 =>
+	        reg_data_out <= slv_reg4;
+	      when 5 =>
+	        reg_data_out <= slv_reg5;
 	      when others =>
-	        reg_data_out  <= (others => '0');
+	        if (reg_index >= CHAN_BASE and chan < C_NUM_CHANNELS) then
+	          if (reg_index mod 2 = 0) then
+	            reg_data_out <= duty_regs(chan);
+	          else
+	            reg_data_out <= phase_regs(chan);
+	          end if;
+	        else
+	          reg_data_out  <= (others => '0');
+	        end if;
 	    end case;
 	end process; 
 
@@ -399,7 +458,14 @@ begin
 
 
 	-- Add user logic here
+	slv_reg3 <= (0 => pwm_pending, others => '0');
+	slv_reg4 <= std_logic_vector(resize(unsigned(pwm_count), C_S_AXI_DATA_WIDTH));
+	slv_reg5 <= std_logic_vector(to_unsigned(C_NUM_CHANNELS, C_S_AXI_DATA_WIDTH));
 
+	channel_bus : for n in 0 to C_NUM_CHANNELS-1 generate
+	    duty_bus((n+1)*PWM_WIDTH-1 downto n*PWM_WIDTH) <= duty_regs(n)(PWM_WIDTH-1 downto 0);
+	    phase_bus((n+1)*PWM_WIDTH-1 downto n*PWM_WIDTH) <= phase_regs(n)(PWM_WIDTH-1 downto 0);
+	end generate;
 	-- User logic ends
 
 end arch_imp;
@@ -0,0 +1,445 @@
+----------------------------------------------------------------------------------
+-- Module Name: Custom_PWM_v1_0_tb
+-- Description: Testbench for motor_pwm through the Custom_PWM_v1_0 AXI slave.
+--
+-- Programs the registers the way the CUSTOM_PWM_* driver calls do and checks
+-- that:
+--   * over one full period channel 0 is high for exactly
+--     min(duty, period + 1) * (prescale + 1) clocks, for every duty from 0
+--     to period + 2, with and without the prescaler,
+--   * duty and period committed in the middle of a period only take effect
+--     at the wrap: every pulse and every period has either the old or the
+--     new length, never a runt or a split pulse,
+--   * staged duties of all four channels do nothing until the commit, and
+--     after it every channel switches to its new duty in the same period,
+--   * each channel rises phase * (prescale + 1) clocks after channel 0,
+--   * the counter, channel count and commit pending registers read back.
+--
+-- Run with GHDL:
+--   ghdl -a --std=08 ../src/motor_pwm.vhd ../hdl/Custom_PWM_v1_0_S00_AXI.vhd \
+--        ../hdl/Custom_PWM_v1_0.vhd Custom_PWM_v1_0_tb.vhd
+--   ghdl -e --std=08 Custom_PWM_v1_0_tb
+--   ghdl -r --std=08 Custom_PWM_v1_0_tb --assert-level=error
+----------------------------------------------------------------------------------
+
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+entity Custom_PWM_v1_0_tb is
+end Custom_PWM_v1_0_tb;
+
+architecture Behavioral of Custom_PWM_v1_0_tb is
+
+constant CLK_PERIOD : time := 10 ns;
+
+constant CHANNELS     : integer := 4;
+
+constant REG_CTRL     : integer := 16#00#;
+constant REG_PERIOD   : integer := 16#04#;
+constant REG_PRESCALE : integer := 16#08#;
+constant REG_COMMIT   : integer := 16#0C#;
+constant REG_COUNTER  : integer := 16#10#;
+constant REG_CHANNELS : integer := 16#14#;
+constant REG_DUTY     : integer := 16#20#;	-- + 8 * channel
+constant REG_PHASE    : integer := 16#24#;	-- + 8 * channel
+
+type int_array_t is array (0 to CHANNELS-1) of integer;
+
+signal clk      : std_logic := '0';
+signal resetn   : std_logic := '0';
+signal o_data   : std_logic;
+signal o_pwm    : std_logic_vector(CHANNELS-1 downto 0);
+
+signal awaddr   : std_logic_vector(6 downto 0) := (others => '0');
+signal awvalid  : std_logic := '0';
+signal awready  : std_logic;
+signal wdata    : std_logic_vector(31 downto 0) := (others => '0');
+signal wvalid   : std_logic := '0';
+signal wready   : std_logic;
+signal bresp    : std_logic_vector(1 downto 0);
+signal bvalid   : std_logic;
+signal araddr   : std_logic_vector(6 downto 0) := (others => '0');
+signal arvalid  : std_logic := '0';
+signal arready  : std_logic;
+signal rdata    : std_logic_vector(31 downto 0);
+signal rresp    : std_logic_vector(1 downto 0);
+signal rvalid   : std_logic;
+
+-- pulse checker: lengths in clocks that are accepted while check_en is set
+signal check_en  : boolean := false;
+signal high_a    : integer := 0;
+signal high_b    : integer := 0;
+signal period_a  : integer := 0;
+signal period_b  : integer := 0;
+signal pulses    : integer := 0;
+
+-- channel checker: per period every channel has its old or its new duty,
+-- all of them the same one, and the new ones only after the commit
+signal chan_en   : boolean := false;
+signal committed : boolean := false;
+signal old_high  : int_array_t := (others => 0);
+signal new_high  : int_array_t := (others => 0);
+signal switched  : integer := 0;
+
+signal errors   : integer := 0;
+signal done     : boolean := false;
+
+begin
+
+    clk <= not clk after CLK_PERIOD / 2 when not done;
+
+    dut : entity work.Custom_PWM_v1_0
+    generic map (
+        C_NUM_CHANNELS  => CHANNELS
+    )
+    port map (
+        o_data          => o_data,
+        o_pwm           => o_pwm,
+        s00_axi_aclk    => clk,
+        s00_axi_aresetn => resetn,
+        s00_axi_awaddr  => awaddr,
+        s00_axi_awprot  => "000",
+        s00_axi_awvalid => awvalid,
+        s00_axi_awready => awready,
+        s00_axi_wdata   => wdata,
+        s00_axi_wstrb   => "1111",
+        s00_axi_wvalid  => wvalid,
+        s00_axi_wready  => wready,
+        s00_axi_bresp   => bresp,
+        s00_axi_bvalid  => bvalid,
+        s00_axi_bready  => '1',
+        s00_axi_araddr  => araddr,
+        s00_axi_arprot  => "000",
+        s00_axi_arvalid => arvalid,
+        s00_axi_arready => arready,
+        s00_axi_rdata   => rdata,
+        s00_axi_rresp   => rresp,
+        s00_axi_rvalid  => rvalid,
+        s00_axi_rready  => '1'
+    );
+
+	-- measures every pulse (rise to fall) and every period (rise to rise)
+	checker: process(clk)
+	    variable high_cnt   : integer := 0;
+	    variable period_cnt : integer := 0;
+	    variable started    : boolean := false;
+	    variable last       : std_logic := '0';
+	begin
+	    if rising_edge(clk) then
+	        if not check_en then
+	            started := false;
+	        elsif o_data = '1' and last = '0' then
+	            if started then
+	                if period_cnt /= period_a and period_cnt /= period_b then
+	                    report "period of " & integer'image(period_cnt) &
+	                           " clocks, expected " & integer'image(period_a) &
+	                           " or " & integer'image(period_b) severity error;
+	                    errors <= errors + 1;
+	                end if;
+	                pulses <= pulses + 1;
+	            end if;
+	            started := true;
+	            high_cnt := 1;
+	            period_cnt := 1;
+	        else
+	            period_cnt := period_cnt + 1;
+	            if o_data = '1' then
+	                high_cnt := high_cnt + 1;
+	            elsif last = '1' and started then
+	                if high_cnt /= high_a and high_cnt /= high_b then
+	                    report "pulse of " & integer'image(high_cnt) &
+	                           " clocks, expected " & integer'image(high_a) &
+	                           " or " & integer'image(high_b) severity error;
+	                    errors <= errors + 1;
+	                end if;
+	            end if;
+	        end if;
+	        last := o_data;
+	    end if;
+	end process;
+
+	-- with all phases 0 every channel rises at the start of the period
+	channels: process(clk)
+	    variable high_cnt  : int_array_t := (others => 0);
+	    variable started   : boolean := false;
+	    variable last      : std_logic := '0';
+	    variable n_old     : integer;
+	    variable n_new     : integer;
+	begin
+	    if rising_edge(clk) then
+	        if not chan_en then
+	            started := false;
+	        elsif o_pwm(0) = '1' and last = '0' then
+	            if started then
+	                n_old := 0;
+	                n_new := 0;
+	                for n in 0 to CHANNELS-1 loop
+	                    if high_cnt(n) = old_high(n) then
+	                        n_old := n_old + 1;
+	                    elsif high_cnt(n) = new_high(n) then
+	                        n_new := n_new + 1;
+	                    else
+	                        report "channel " & integer'image(n) & " high for " &
+	                               integer'image(high_cnt(n)) & " clocks, expected " &
+	                               integer'image(old_high(n)) & " or " &
+	                               integer'image(new_high(n)) severity error;
+	                        errors <= errors + 1;
+	                    end if;
+	                end loop;
+	                if n_old /= CHANNELS and n_new /= CHANNELS then
+	                    report "channels did not switch together: " &
+	                           integer'image(n_old) & " old, " &
+	                           integer'image(n_new) & " new" severity error;
+	                    errors <= errors + 1;
+	                elsif n_new = CHANNELS then
+	                    if not committed then
+	                        report "new duty in use before the commit" severity error;
+	                        errors <= errors + 1;
+	                    end if;
+	                    switched <= switched + 1;
+	                elsif switched > 0 then
+	                    report "channels went back to the old duty" severity error;
+	                    errors <= errors + 1;
+	                end if;
+	            end if;
+	            started := true;
+	            high_cnt := (others => 0);
+	        end if;
+	        if chan_en then
+	            for n in 0 to CHANNELS-1 loop
+	                if o_pwm(n) = '1' then
+	                    high_cnt(n) := high_cnt(n) + 1;
+	                end if;
+	            end loop;
+	        end if;
+	        last := o_pwm(0);
+	    end if;
+	end process;
+
+	stimulus: process
+	    variable data : std_logic_vector(31 downto 0);
+	    variable rise : int_array_t;
+	    variable prev : std_logic_vector(CHANNELS-1 downto 0);
+
+	    procedure axi_write(addr : in integer; value : in integer) is
+	    begin
+	        awaddr  <= std_logic_vector(to_unsigned(addr, 7));
+	        wdata   <= std_logic_vector(to_unsigned(value, 32));
+	        awvalid <= '1';
+	        wvalid  <= '1';
+	        loop
+	            wait until rising_edge(clk);
+	            exit when awready = '1';
+	        end loop;
+	        awvalid <= '0';
+	        wvalid  <= '0';
+	        wait until rising_edge(clk) and bvalid = '1';
+	    end procedure;
+
+	    procedure axi_read(addr : in integer; value : out std_logic_vector(31 downto 0)) is
+	    begin
+	        araddr  <= std_logic_vector(to_unsigned(addr, 7));
+	        arvalid <= '1';
+	        loop
+	            wait until rising_edge(clk);
+	            exit when arready = '1';
+	        end loop;
+	        arvalid <= '0';
+	        wait until rising_edge(clk) and rvalid = '1';
+	        value := rdata;
+	    end procedure;
+
+	    -- CUSTOM_PWM_Enable(0), set everything, CUSTOM_PWM_Enable(1); no
+	    -- commit is needed while disabled
+	    procedure program(period, prescale, duty : in integer) is
+	    begin
+	        axi_write(REG_CTRL, 0);
+	        axi_write(REG_PRESCALE, prescale);
+	        axi_write(REG_PERIOD, period);
+	        for n in 0 to CHANNELS-1 loop
+	            axi_write(REG_DUTY + 8 * n, duty);
+	            axi_write(REG_PHASE + 8 * n, 0);
+	        end loop;
+	        axi_write(REG_CTRL, 1);
+	    end procedure;
+
+	    -- CUSTOM_PWM_SetDuty(0, duty)
+	    procedure set_duty(duty : in integer) is
+	    begin
+	        axi_write(REG_DUTY, duty);
+	        axi_write(REG_COMMIT, 1);
+	    end procedure;
+
+	    -- high clocks over one full period, after the shadow values are live
+	    procedure check_duty(period, prescale, duty : in integer) is
+	        constant LEN  : integer := (period + 1) * (prescale + 1);
+	        variable high : integer := 0;
+	        variable want : integer;
+	    begin
+	        set_duty(duty);
+	        for i in 1 to 2 * LEN + 4 loop
+	            wait until rising_edge(clk);
+	        end loop;
+	        for i in 1 to LEN loop
+	            wait until rising_edge(clk);
+	            if o_data = '1' then
+	                high := high + 1;
+	            end if;
+	        end loop;
+	        want := duty;
+	        if want > period + 1 then
+	            want := period + 1;
+	        end if;
+	        want := want * (prescale + 1);
+	        if high /= want then
+	            report "period " & integer'image(period) & " prescale " &
+	                   integer'image(prescale) & " duty " & integer'image(duty) &
+	                   ": high for " & integer'image(high) & " of " &
+	                   integer'image(LEN) & " clocks, expected " &
+	                   integer'image(want) severity error;
+	            errors <= errors + 1;
+	        end if;
+	    end procedure;
+
+	    procedure sweep(period, prescale : in integer) is
+	    begin
+	        program(period, prescale, 0);
+	        for duty in 0 to period + 2 loop
+	            check_duty(period, prescale, duty);
+	        end loop;
+	    end procedure;
+	begin
+	    resetn <= '0';
+	    wait for 10 * CLK_PERIOD;
+	    wait until rising_edge(clk);
+	    resetn <= '1';
+	    wait for 5 * CLK_PERIOD;
+
+	    -- reset state: enabled, default period, duty 0
+	    axi_read(REG_CTRL, data);
+	    assert data(0) = '1' report "not enabled after reset" severity error;
+	    axi_read(REG_PERIOD, data);
+	    assert to_integer(unsigned(data)) = 2500000
+	        report "default period is not 2500000" severity error;
+	    axi_read(REG_CHANNELS, data);
+	    assert to_integer(unsigned(data)) = CHANNELS
+	        report "channel count register is not " & integer'image(CHANNELS)
+	        severity error;
+
+	    -- full duty range
+	    sweep(15, 0);
+	    sweep(15, 2);
+	    sweep(7, 9);
+
+	    -- counter readback stays within the active period
+	    program(99, 0, 50);
+	    for i in 1 to 20 loop
+	        axi_read(REG_COUNTER, data);
+	        assert to_integer(unsigned(data)) <= 99
+	            report "counter " & integer'image(to_integer(unsigned(data))) &
+	                   " outside period 99" severity error;
+	        wait for 37 * CLK_PERIOD;
+	    end loop;
+
+	    -- duty changes at random points in the period
+	    program(49, 1, 10);
+	    wait for 200 * CLK_PERIOD;
+	    high_a   <= 10 * 2;
+	    high_b   <= 10 * 2;
+	    period_a <= 50 * 2;
+	    period_b <= 50 * 2;
+	    check_en <= true;
+	    for i in 0 to 39 loop
+	        high_a <= high_b;
+	        high_b <= (10 + (i * 7) mod 35) * 2;
+	        set_duty(10 + (i * 7) mod 35);
+	        wait for (130 + 17 * i) * CLK_PERIOD;
+	        high_a <= (10 + (i * 7) mod 35) * 2;
+	        wait for 100 * CLK_PERIOD;
+	    end loop;
+
+	    -- period and duty changes together, shadows keep them paired
+	    for i in 0 to 19 loop
+	        period_a <= period_b;
+	        high_a   <= high_b;
+	        period_b <= (30 + (i * 11) mod 40) * 2;
+	        high_b   <= (5 + (i * 3) mod 20) * 2;
+	        axi_write(REG_PERIOD, 29 + (i * 11) mod 40);
+	        axi_write(REG_DUTY, 5 + (i * 3) mod 20);
+	        axi_write(REG_COMMIT, 1);
+	        wait for (170 + 23 * i) * CLK_PERIOD;
+	        period_a <= (30 + (i * 11) mod 40) * 2;
+	        high_a   <= (5 + (i * 3) mod 20) * 2;
+	        wait for 200 * CLK_PERIOD;
+	    end loop;
+	    check_en <= false;
+
+	    -- all channels: stage new duties over several periods, then commit
+	    program(99, 0, 0);
+	    for n in 0 to CHANNELS-1 loop
+	        axi_write(REG_DUTY + 8 * n, 10 + 10 * n);
+	    end loop;
+	    axi_write(REG_COMMIT, 1);
+	    wait for 300 * CLK_PERIOD;
+	    for n in 0 to CHANNELS-1 loop
+	        old_high(n) <= 10 + 10 * n;
+	        new_high(n) <= 85 - 20 * n;
+	    end loop;
+	    chan_en <= true;
+	    for n in 0 to CHANNELS-1 loop
+	        axi_write(REG_DUTY + 8 * n, 85 - 20 * n);
+	        wait for 130 * CLK_PERIOD;
+	    end loop;
+	    wait until rising_edge(clk) and o_pwm(0) = '1' and o_pwm(CHANNELS-1) = '1';
+	    committed <= true;
+	    axi_write(REG_COMMIT, 1);
+	    axi_read(REG_COMMIT, data);
+	    assert data(0) = '1' report "commit not pending before the wrap" severity error;
+	    wait for 500 * CLK_PERIOD;
+	    axi_read(REG_COMMIT, data);
+	    assert data(0) = '0' report "commit still pending after the wrap" severity error;
+	    chan_en <= false;
+	    assert switched >= 3
+	        report "channels did not switch after the commit" severity error;
+
+	    -- phase offsets: channel n rises phase(n) * (prescale + 1) later
+	    axi_write(REG_CTRL, 0);
+	    axi_write(REG_PRESCALE, 1);
+	    for n in 0 to CHANNELS-1 loop
+	        axi_write(REG_DUTY + 8 * n, 20);
+	        axi_write(REG_PHASE + 8 * n, 25 * n);
+	    end loop;
+	    axi_write(REG_CTRL, 1);
+	    wait for 400 * CLK_PERIOD;
+	    wait until rising_edge(clk) and o_pwm(0) = '1';
+	    prev := o_pwm;
+	    rise := (others => -1);
+	    for i in 1 to 200 loop
+	        wait until rising_edge(clk);
+	        for n in 1 to CHANNELS-1 loop
+	            if o_pwm(n) = '1' and prev(n) = '0' and rise(n) < 0 then
+	                rise(n) := i;
+	            end if;
+	        end loop;
+	        prev := o_pwm;
+	    end loop;
+	    for n in 1 to CHANNELS-1 loop
+	        if rise(n) /= 25 * n * 2 then
+	            report "channel " & integer'image(n) & " rose " &
+	                   integer'image(rise(n)) & " clocks after channel 0, expected " &
+	                   integer'image(25 * n * 2) severity error;
+	            errors <= errors + 1;
+	        end if;
+	    end loop;
+
+	    report "pulses checked: " & integer'image(pulses);
+	    report "errors: " & integer'image(errors);
+	    assert errors = 0 report "PWM duty or glitch errors" severity error;
+
+	    done <= true;
+	    wait;
+	end process;
+
+end Behavioral;
@@ -1,32 +1,44 @@
 ----------------------------------------------------------------------------------
--- Company: 
--- Engineer: 
--- 
+-- Company:
+-- Engineer:
+--
 -- Create Date: 04/14/2021 11:58:38 PM
--- Design Name: 
+-- Design Name:
 -- Module Name: motor_pwm - Behavioral
--- Project Name: 
--- Target Devices: 
--- Tool Versions: 
--- Description: 
--- 
--- Dependencies: 
--- 
+-- Project Name:
+-- Target Devices:
+-- Tool Versions:
+-- Description: Multi-channel PWM generator on one shared counter.
+--
+-- The counter advances once every prescale + 1 clocks and runs from 0 to
+-- period, so one PWM period is (period + 1) * (prescale + 1) clocks. Each
+-- channel has a duty and a phase offset: channel n is high while
+-- (counter - phase(n)) mod (period + 1) is below duty(n). A duty of 0 keeps
+-- the channel low and a duty above the period keeps it high. The phase must
+-- not exceed the period.
+--
+-- The register inputs are staged. A pulse on I_COMMIT copies all of them
+-- into the shadow registers at once, and the shadow registers are loaded
+-- into the active ones on the next counter wrap, so every channel switches
+-- in the same clock and a period is never cut short. While disabled the
+-- inputs are loaded directly and the counter is held at 0.
+--
+-- Channel n of I_DUTY and I_PHASE is bits (n+1)*C_WIDTH-1 downto n*C_WIDTH.
+--
+-- Dependencies:
+--
 -- Revision:
+-- Revision 0.03 - Channels, phase offsets and commit
+-- Revision 0.02 - Period, prescaler and double-buffered duty
 -- Revision 0.01 - File Created
 -- Additional Comments:
--- 
+--
 ----------------------------------------------------------------------------------
 
 
 library IEEE;
 use IEEE.STD_LOGIC_1164.ALL;
 use ieee.numeric_std.all;
-use ieee.std_logic_unsigned.all;
-
--- Uncomment the following library declaration if using
--- arithmetic functions with Signed or Unsigned values
---use IEEE.NUMERIC_STD.ALL;
 
 -- Uncomment the following library declaration if instantiating
 -- any Xilinx leaf cells in this code.
@@ -34,28 +46,114 @@ use ieee.std_logic_unsigned.all;
 --use UNISIM.VComponents.all;
 
 entity motor_pwm is
+    Generic ( C_WIDTH : integer := 24;
+              C_NUM_CHANNELS : integer := 4);
     Port ( I_CLK : in STD_LOGIC;
-           I_DATA : in STD_LOGIC_VECTOR (23 downto 0);
-           O_DATA : out STD_LOGIC);
+           I_RESETN : in STD_LOGIC;
+           I_ENABLE : in STD_LOGIC;
+           I_COMMIT : in STD_LOGIC;
+           I_PERIOD : in STD_LOGIC_VECTOR (C_WIDTH-1 downto 0);
+           I_PRESCALE : in STD_LOGIC_VECTOR (15 downto 0);
+           I_DUTY : in STD_LOGIC_VECTOR (C_NUM_CHANNELS*C_WIDTH-1 downto 0);
+           I_PHASE : in STD_LOGIC_VECTOR (C_NUM_CHANNELS*C_WIDTH-1 downto 0);
+           O_COUNT : out STD_LOGIC_VECTOR (C_WIDTH-1 downto 0);
+           O_PENDING : out STD_LOGIC;
+           O_DATA : out STD_LOGIC_VECTOR (C_NUM_CHANNELS-1 downto 0));
 end motor_pwm;
 
 architecture Behavioral of motor_pwm is
 
-signal counter : std_logic_vector(23 downto 0) := (others => '0');
+type chan_t is array (0 to C_NUM_CHANNELS-1) of unsigned(C_WIDTH-1 downto 0);
+
+signal counter      : unsigned(C_WIDTH-1 downto 0) := (others => '0');
+signal prescale_cnt : unsigned(15 downto 0) := (others => '0');
+
+-- committed values waiting for the wrap
+signal pending      : std_logic := '0';
+signal next_period  : unsigned(C_WIDTH-1 downto 0) := (others => '0');
+signal next_prescale : unsigned(15 downto 0) := (others => '0');
+signal next_duty    : chan_t := (others => (others => '0'));
+signal next_phase   : chan_t := (others => (others => '0'));
+
+-- active values
+signal period       : unsigned(C_WIDTH-1 downto 0) := (others => '0');
+signal prescale     : unsigned(15 downto 0) := (others => '0');
+signal duty         : chan_t := (others => (others => '0'));
+signal phase        : chan_t := (others => (others => '0'));
+
+function unpack(v : std_logic_vector) return chan_t is
+    variable r : chan_t;
+begin
+    for n in 0 to C_NUM_CHANNELS-1 loop
+        r(n) := unsigned(v((n+1)*C_WIDTH-1 + v'low downto n*C_WIDTH + v'low));
+    end loop;
+    return r;
+end function;
 
 begin
+
+    O_COUNT   <= std_logic_vector(counter);
+    O_PENDING <= pending;
+
 	P0: process(I_CLK)
+	    variable pos : unsigned(C_WIDTH downto 0);
 	begin
 		if(rising_edge(I_CLK)) then
-			if(counter <= I_DATA) then
-				O_DATA <= '1';
-			else
-				O_DATA <= '0';
-			end if;
-			if(counter = "001001100010010110100000") then
-				counter <= (others => '0');
+			if(I_RESETN = '0' or I_ENABLE = '0') then
+				counter       <= (others => '0');
+				prescale_cnt  <= unsigned(I_PRESCALE);
+				pending       <= '0';
+				next_period   <= unsigned(I_PERIOD);
+				next_prescale <= unsigned(I_PRESCALE);
+				next_duty     <= unpack(I_DUTY);
+				next_phase    <= unpack(I_PHASE);
+				period        <= unsigned(I_PERIOD);
+				prescale      <= unsigned(I_PRESCALE);
+				duty          <= unpack(I_DUTY);
+				phase         <= unpack(I_PHASE);
+				O_DATA        <= (others => '0');
 			else
-				counter <= counter + "00000001";
+				for n in 0 to C_NUM_CHANNELS-1 loop
+					if(counter >= phase(n)) then
+						pos := resize(counter, C_WIDTH+1) - phase(n);
+					else
+						pos := resize(counter, C_WIDTH+1) + period + 1 - phase(n);
+					end if;
+					if(pos < duty(n)) then
+						O_DATA(n) <= '1';
+					else
+						O_DATA(n) <= '0';
+					end if;
+				end loop;
+
+				if(prescale_cnt /= 0) then
+					prescale_cnt <= prescale_cnt - 1;
+				elsif(counter >= period) then
+					-- period boundary, take the committed values
+					counter <= (others => '0');
+					if(pending = '1') then
+						pending      <= '0';
+						period       <= next_period;
+						prescale     <= next_prescale;
+						duty         <= next_duty;
+						phase        <= next_phase;
+						prescale_cnt <= next_prescale;
+					else
+						prescale_cnt <= prescale;
+					end if;
+				else
+					counter      <= counter + 1;
+					prescale_cnt <= prescale;
+				end if;
+
+				-- a commit on the wrap clock waits for the next wrap
+				if(I_COMMIT = '1') then
+					pending       <= '1';
+					next_period   <= unsigned(I_PERIOD);
+					next_prescale <= unsigned(I_PRESCALE);
+					next_duty     <= unpack(I_DUTY);
+					next_phase    <= unpack(I_PHASE);
+				end if;
 			end if;
 		end if;
 	end process;
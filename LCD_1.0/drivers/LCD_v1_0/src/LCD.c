@@ -2,5 +2,40 @@
 
 /***************************** Include Files *******************************/
 #include "LCD.h"
+#include "xil_io.h"
 
 /************************** Function Definitions ***************************/
+
+void LCD_SequencerEnable(u32 BaseAddress, u32 IrqEnable)
+{
+	u32 Control = LCD_CONTROL_SEQ_EN_MASK;
+
+	if (IrqEnable)
+		Control |= LCD_CONTROL_IRQ_EN_MASK;
+	LCD_mWriteReg(BaseAddress, LCD_CONTROL_OFFSET, Control);
+}
+
+u32 LCD_FifoSpace(u32 BaseAddress)
+{
+	u32 Level = LCD_mReadReg(BaseAddress, LCD_STATUS_OFFSET) & LCD_STATUS_LEVEL_MASK;
+
+	return (Level < LCD_FIFO_DEPTH) ? LCD_FIFO_DEPTH - Level : 0;
+}
+
+u32 LCD_WriteBurst(u32 BaseAddress, const u16 *Words, u32 Count)
+{
+	u32 Space = LCD_FifoSpace(BaseAddress);
+	u32 Index;
+
+	if (Count > Space)
+		Count = Space;
+	for (Index = 0; Index < Count; Index++)
+		LCD_mWriteReg(BaseAddress, LCD_FIFO_OFFSET, Words[Index]);
+
+	return Count;
+}
+
+int LCD_IsIdle(u32 BaseAddress)
+{
+	return (LCD_mReadReg(BaseAddress, LCD_STATUS_OFFSET) & LCD_STATUS_IDLE_MASK) != 0;
+}
@@ -12,6 +12,35 @@
 #define LCD_S00_AXI_SLV_REG2_OFFSET 8
 #define LCD_S00_AXI_SLV_REG3_OFFSET 12
 
+/*
+ * Register map of the HD44780 sequencer
+ */
+#define LCD_FIFO_OFFSET		LCD_S00_AXI_SLV_REG0_OFFSET	/* write only */
+#define LCD_RAW_OFFSET		LCD_S00_AXI_SLV_REG1_OFFSET
+#define LCD_STATUS_OFFSET	LCD_S00_AXI_SLV_REG2_OFFSET	/* read only */
+#define LCD_CONTROL_OFFSET	LCD_S00_AXI_SLV_REG3_OFFSET
+
+#define LCD_FIFO_DEPTH		16
+
+/* FIFO word: one command or data byte */
+#define LCD_FIFO_RS_MASK	0x100	/* data byte when set */
+#define LCD_FIFO_NIBBLE_MASK	0x200	/* send the upper nibble only */
+
+#define LCD_FIFO_CMD(Cmd)	((u16)((Cmd) & 0xFF))
+#define LCD_FIFO_DATA(Data)	((u16)(((Data) & 0xFF) | LCD_FIFO_RS_MASK))
+#define LCD_FIFO_NIBBLE(Data)	((u16)(((Data) & 0xF0) | LCD_FIFO_NIBBLE_MASK))
+
+/* Status register */
+#define LCD_STATUS_LEVEL_MASK	0x0001F	/* words waiting in the FIFO */
+#define LCD_STATUS_BUSY_MASK	0x00100	/* a word is being sent */
+#define LCD_STATUS_FULL_MASK	0x00200
+#define LCD_STATUS_IDLE_MASK	0x00400	/* FIFO empty and not busy */
+#define LCD_STATUS_IRQ_MASK	0x10000	/* lcd_irq is asserted */
+
+/* Control register */
+#define LCD_CONTROL_IRQ_EN_MASK	0x1	/* assert lcd_irq while idle */
+#define LCD_CONTROL_SEQ_EN_MASK	0x2	/* sequencer drives lcd_out */
+
 
 /**************************** Type Definitions *****************************/
 /**
@@ -76,4 +105,56 @@
  */
 XStatus LCD_Reg_SelfTest(void * baseaddr_p);
 
+/**
+ *
+ * Hands the LCD pins to the hardware sequencer. While it is enabled the raw
+ * register is ignored.
+ *
+ * @param   BaseAddress is the base address of the LCD device.
+ * @param   IrqEnable asserts lcd_irq whenever the FIFO has drained and the
+ *          last command has finished executing.
+ *
+ * @return  None.
+ *
+ */
+void LCD_SequencerEnable(u32 BaseAddress, u32 IrqEnable);
+
+/**
+ *
+ * Returns the number of FIFO words that can be written without overflow.
+ *
+ * @param   BaseAddress is the base address of the LCD device.
+ *
+ * @return  Free FIFO entries.
+ *
+ */
+u32 LCD_FifoSpace(u32 BaseAddress);
+
+/**
+ *
+ * Writes as many words as currently fit in the FIFO, with one status read
+ * per call. Words are built with LCD_FIFO_CMD(), LCD_FIFO_DATA() and
+ * LCD_FIFO_NIBBLE().
+ *
+ * @param   BaseAddress is the base address of the LCD device.
+ * @param   Words is the array of FIFO words.
+ * @param   Count is the number of words in the array.
+ *
+ * @return  Number of words written. The caller resumes with the rest, for
+ *          example from the lcd_irq handler.
+ *
+ */
+u32 LCD_WriteBurst(u32 BaseAddress, const u16 *Words, u32 Count);
+
+/**
+ *
+ * Reports whether the sequencer has sent everything written so far.
+ *
+ * @param   BaseAddress is the base address of the LCD device.
+ *
+ * @return  TRUE when the FIFO is empty and the last command has executed.
+ *
+ */
+int LCD_IsIdle(u32 BaseAddress);
+
 #endif // LCD_H
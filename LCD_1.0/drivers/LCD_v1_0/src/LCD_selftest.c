@@ -46,10 +46,15 @@ XStatus LCD_Reg_SelfTest(void * baseaddr_p)
 	 */
 	xil_printf("User logic slave module test...\n\r");
 
+	/*
+	 * The status register is read only and is skipped
+	 */
 	for (write_loop_index = 0 ; write_loop_index < 4; write_loop_index++)
-	  LCD_mWriteReg (baseaddr, write_loop_index*4, (write_loop_index+1)*READ_WRITE_MUL_FACTOR);
+	  if (write_loop_index*4 != LCD_STATUS_OFFSET)
+	    LCD_mWriteReg (baseaddr, write_loop_index*4, (write_loop_index+1)*READ_WRITE_MUL_FACTOR);
 	for (read_loop_index = 0 ; read_loop_index < 4; read_loop_index++)
-	  if ( LCD_mReadReg (baseaddr, read_loop_index*4) != (read_loop_index+1)*READ_WRITE_MUL_FACTOR){
+	  if ( read_loop_index*4 != LCD_STATUS_OFFSET &&
+	       LCD_mReadReg (baseaddr, read_loop_index*4) != (read_loop_index+1)*READ_WRITE_MUL_FACTOR){
 	    xil_printf ("Error reading register value at address %x\n", (int)baseaddr + read_loop_index*4);
 	    return XST_FAILURE;
 	  }
@@ -17,6 +17,7 @@ entity LCD_v1_0 is
 	port (
 		-- Users to add ports here
         lcd_out : out std_logic_vector (5 downto 0);
+        lcd_irq : out std_logic;
         -- User ports ends
 		-- Do not modify the ports beyond this line
 
@@ -56,6 +57,7 @@ architecture arch_imp of LCD_v1_0 is
 		);
 		port (
 		lcd_out : out std_logic_vector (5 downto 0);
+		lcd_irq : out std_logic;
 		S_AXI_ACLK	: in std_logic;
 		S_AXI_ARESETN	: in std_logic;
 		S_AXI_AWADDR	: in std_logic_vector(C_S_AXI_ADDR_WIDTH-1 downto 0);
@@ -90,6 +92,7 @@ LCD_v1_0_S00_AXI_inst : LCD_v1_0_S00_AXI
 	)
 	port map (
 	    lcd_out =>lcd_out,
+	    lcd_irq =>lcd_irq,
 		S_AXI_ACLK	=> s00_axi_aclk,
 		S_AXI_ARESETN	=> s00_axi_aresetn,
 		S_AXI_AWADDR	=> s00_axi_awaddr,
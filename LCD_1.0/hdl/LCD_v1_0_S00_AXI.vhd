@@ -17,6 +17,7 @@ entity LCD_v1_0_S00_AXI is
 	port (
 		-- Users to add ports here
         lcd_out : out std_logic_vector (5 downto 0);
+        lcd_irq : out std_logic;
 		-- User ports ends
 		-- Do not modify the ports beyond this line
 
@@ -118,6 +119,39 @@ architecture arch_imp of LCD_v1_0_S00_AXI is
 	signal byte_index	: integer;
 	signal aw_en	: std_logic;
 
+	-- Register map
+	-- slv_reg0 (0x0) : write pushes a word into the sequencer FIFO
+	--                  (bit 9 nibble only, bit 8 RS, bits 7-0 byte)
+	-- slv_reg1 (0x4) : raw lcd_out, used while the sequencer is disabled
+	-- slv_reg2 (0x8) : status, read only
+	--                  (bits 4-0 FIFO level, bit 8 busy, bit 9 FIFO full,
+	--                   bit 10 idle, bit 16 interrupt pending)
+	-- slv_reg3 (0xC) : control (bit 0 FIFO empty interrupt enable,
+	--                  bit 1 sequencer drives lcd_out)
+	signal seq_wr_en	: std_logic;
+	signal seq_level	: std_logic_vector(4 downto 0);
+	signal seq_full	: std_logic;
+	signal seq_busy	: std_logic;
+	signal seq_lcd	: std_logic_vector(5 downto 0);
+	signal seq_idle	: std_logic;
+	signal irq	: std_logic;
+
+	component lcd_sequencer is
+	   generic (
+	       C_FIFO_DEPTH_LOG2 : integer := 4
+	   );
+	   port (
+	       I_CLK     : in std_logic;
+	       I_RESETN  : in std_logic;
+	       I_WR_EN   : in std_logic;
+	       I_WR_DATA : in std_logic_vector(9 downto 0);
+	       O_LEVEL   : out std_logic_vector(C_FIFO_DEPTH_LOG2 downto 0);
+	       O_FULL    : out std_logic;
+	       O_BUSY    : out std_logic;
+	       O_LCD     : out std_logic_vector(5 downto 0)
+	   );
+	end component lcd_sequencer;
+
 begin
 	-- I/O Connections assignments
 
@@ -213,55 +247,41 @@ begin
 	variable loc_addr :std_logic_vector(OPT_MEM_ADDR_BITS downto 0); 
 	begin
 	  if rising_edge(S_AXI_ACLK) then 
+	    seq_wr_en <= '0';
 	    if S_AXI_ARESETN = '0' then
---	      slv_reg0 <= (others => '0');
---	      slv_reg1 <= (others => '0');
---	      slv_reg2 <= (others => '0');
---	      slv_reg3 <= (others => '0');
-          lcd_out <= (others => '0');
+	      slv_reg0 <= (others => '0');
+	      slv_reg1 <= (others => '0');
+	      slv_reg3 <= (others => '0');
 	    else
 	      loc_addr := axi_awaddr(ADDR_LSB + OPT_MEM_ADDR_BITS downto ADDR_LSB);
 	      if (slv_reg_wren = '1') then
-	        lcd_out <= S_AXI_WDATA(5 downto 0);
---	        case loc_addr is
---	          when b"00" =>
---	            for byte_index in 0 to (C_S_AXI_DATA_WIDTH/8-1) loop
---	              if ( S_AXI_WSTRB(byte_index) = '1' ) then
---	                -- Respective byte enables are asserted as per write strobes                   
---	                -- slave registor 0
---	                slv_reg0(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
---	              end if;
---	            end loop;
---	          when b"01" =>
---	            for byte_index in 0 to (C_S_AXI_DATA_WIDTH/8-1) loop
---	              if ( S_AXI_WSTRB(byte_index) = '1' ) then
---	                -- Respective byte enables are asserted as per write strobes                   
---	                -- slave registor 1
---	                slv_reg1(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
---	              end if;
---	            end loop;
---	          when b"10" =>
---	            for byte_index in 0 to (C_S_AXI_DATA_WIDTH/8-1) loop
---	              if ( S_AXI_WSTRB(byte_index) = '1' ) then
---	                -- Respective byte enables are asserted as per write strobes                   
---	                -- slave registor 2
---	                slv_reg2(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
---	              end if;
---	            end loop;
---	          when b"11" =>
---	            for byte_index in 0 to (C_S_AXI_DATA_WIDTH/8-1) loop
---	              if ( S_AXI_WSTRB(byte_index) = '1' ) then
---	                -- Respective byte enables are asserted as per write strobes                   
---	                -- slave registor 3
---	                slv_reg3(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
---	              end if;
---	            end loop;
---	          when others =>
---	            slv_reg0 <= slv_reg0;
---	            slv_reg1 <= slv_reg1;
---	            slv_reg2 <= slv_reg2;
---	            slv_reg3 <= slv_reg3;
---	        end case;
+	        case loc_addr is
+	          when b"00" =>
+	            -- FIFO push, one command or data byte per write
+	            slv_reg0 <= S_AXI_WDATA;
+	            seq_wr_en <= '1';
+	          when b"01" =>
+	            for byte_index in 0 to (C_S_AXI_DATA_WIDTH/8-1) loop
+	              if ( S_AXI_WSTRB(byte_index) = '1' ) then
+	                -- Respective byte enables are asserted as per write strobes                   
+	                -- slave registor 1
+	                slv_reg1(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
+	              end if;
+	            end loop;
+	          when b"11" =>
+	            for byte_index in 0 to (C_S_AXI_DATA_WIDTH/8-1) loop
+	              if ( S_AXI_WSTRB(byte_index) = '1' ) then
+	                -- Respective byte enables are asserted as per write strobes                   
+	                -- slave registor 3
+	                slv_reg3(byte_index*8+7 downto byte_index*8) <= S_AXI_WDATA(byte_index*8+7 downto byte_index*8);
+	              end if;
+	            end loop;
+	          when others =>
+	            -- status register is read only
+	            slv_reg0 <= slv_reg0;
+	            slv_reg1 <= slv_reg1;
+	            slv_reg3 <= slv_reg3;
+	        end case;
 	      end if;
 	    end if;
 	  end if;                   
@@ -387,7 +407,32 @@ begin
 
 
 	-- Add user logic here
+	lcd_sequencer_inst : lcd_sequencer
+	generic map
+	(
+	    C_FIFO_DEPTH_LOG2 => 4
+	)
+	port map
+	(
+	    I_CLK => S_AXI_ACLK,
+	    I_RESETN => S_AXI_ARESETN,
+	    I_WR_EN => seq_wr_en,
+	    I_WR_DATA => slv_reg0(9 downto 0),
+	    O_LEVEL => seq_level,
+	    O_FULL => seq_full,
+	    O_BUSY => seq_busy,
+	    O_LCD => seq_lcd
+	);
+
+	seq_idle <= '1' when seq_busy = '0' and unsigned(seq_level) = 0 else '0';
+	irq <= slv_reg3(0) and seq_idle;
+	lcd_irq <= irq;
+
+	slv_reg2 <= (16 => irq, 10 => seq_idle, 9 => seq_full, 8 => seq_busy,
+	             4 => seq_level(4), 3 => seq_level(3), 2 => seq_level(2),
+	             1 => seq_level(1), 0 => seq_level(0), others => '0');
 
+	lcd_out <= seq_lcd when slv_reg3(1) = '1' else slv_reg1(5 downto 0);
 	-- User logic ends
 
 end arch_imp;
@@ -0,0 +1,267 @@
+----------------------------------------------------------------------------------
+-- Module Name: LCD_v1_0_seq_tb
+-- Description: Testbench for the HD44780 sequencer in LCD_v1_0.
+--
+-- Drives the AXI-Lite slave the way LCD_WriteBurst does (one status read,
+-- then as many FIFO writes as there is space) to send a clear followed by a
+-- full 2x16 screen, and checks on lcd_out that:
+--   * RS and data are stable for at least 40 ns before E rises,
+--   * E is high for at least 230 ns and data does not change while it is,
+--   * data is held for at least 10 ns after E falls,
+--   * consecutive bytes are at least 37 us apart (1.52 ms after clear/home),
+--   * the decoded bytes are the ones that were written,
+--   * lcd_irq is asserted once everything has been sent.
+-- It also reports the CPU bus accesses the update took, against the
+-- software bit-bang path (per byte: 2 nibbles x (1 write + 1 read-modify-
+-- write) = 4 writes and 2 reads).
+--
+-- Run with GHDL:
+--   ghdl -a --std=08 ../src/lcd_sequencer.vhd ../hdl/LCD_v1_0_S00_AXI.vhd \
+--        ../hdl/LCD_v1_0.vhd LCD_v1_0_seq_tb.vhd
+--   ghdl -e --std=08 LCD_v1_0_seq_tb
+--   ghdl -r --std=08 LCD_v1_0_seq_tb --assert-level=error
+----------------------------------------------------------------------------------
+
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+entity LCD_v1_0_seq_tb is
+end LCD_v1_0_seq_tb;
+
+architecture Behavioral of LCD_v1_0_seq_tb is
+
+constant CLK_PERIOD : time := 10 ns;
+
+type byte_array_t is array (natural range <>) of std_logic_vector(8 downto 0);
+
+-- clear, line 1, line 2; bit 8 is RS
+function screen return byte_array_t is
+    constant LINE1 : string(1 to 16) := "     Enable     ";
+    constant LINE2 : string(1 to 16) := " Photoresistor  ";
+    variable words : byte_array_t(0 to 34);
+begin
+    words(0) := '0' & x"01";
+    words(1) := '0' & x"80";
+    for i in 1 to 16 loop
+        words(1 + i) := '1' & std_logic_vector(to_unsigned(character'pos(LINE1(i)), 8));
+    end loop;
+    words(18) := '0' & x"C0";
+    for i in 1 to 16 loop
+        words(18 + i) := '1' & std_logic_vector(to_unsigned(character'pos(LINE2(i)), 8));
+    end loop;
+    return words;
+end function;
+
+constant WORDS : byte_array_t := screen;
+
+signal clk      : std_logic := '0';
+signal resetn   : std_logic := '0';
+signal lcd_out  : std_logic_vector(5 downto 0);
+signal lcd_irq  : std_logic;
+signal lcd_bus  : std_logic_vector(4 downto 0);
+signal lcd_e    : std_logic;
+
+signal awaddr   : std_logic_vector(3 downto 0) := (others => '0');
+signal awvalid  : std_logic := '0';
+signal awready  : std_logic;
+signal wdata    : std_logic_vector(31 downto 0) := (others => '0');
+signal wvalid   : std_logic := '0';
+signal wready   : std_logic;
+signal bresp    : std_logic_vector(1 downto 0);
+signal bvalid   : std_logic;
+signal araddr   : std_logic_vector(3 downto 0) := (others => '0');
+signal arvalid  : std_logic := '0';
+signal arready  : std_logic;
+signal rdata    : std_logic_vector(31 downto 0);
+signal rresp    : std_logic_vector(1 downto 0);
+signal rvalid   : std_logic;
+
+signal decoded  : integer := 0;
+signal errors   : integer := 0;
+signal done     : boolean := false;
+
+begin
+
+    clk <= not clk after CLK_PERIOD / 2 when not done;
+
+    lcd_bus <= lcd_out(5 downto 2) & lcd_out(0);
+    lcd_e   <= lcd_out(1);
+
+    dut : entity work.LCD_v1_0
+    port map (
+        lcd_out         => lcd_out,
+        lcd_irq         => lcd_irq,
+        s00_axi_aclk    => clk,
+        s00_axi_aresetn => resetn,
+        s00_axi_awaddr  => awaddr,
+        s00_axi_awprot  => "000",
+        s00_axi_awvalid => awvalid,
+        s00_axi_awready => awready,
+        s00_axi_wdata   => wdata,
+        s00_axi_wstrb   => "1111",
+        s00_axi_wvalid  => wvalid,
+        s00_axi_wready  => wready,
+        s00_axi_bresp   => bresp,
+        s00_axi_bvalid  => bvalid,
+        s00_axi_bready  => '1',
+        s00_axi_araddr  => araddr,
+        s00_axi_arprot  => "000",
+        s00_axi_arvalid => arvalid,
+        s00_axi_arready => arready,
+        s00_axi_rdata   => rdata,
+        s00_axi_rresp   => rresp,
+        s00_axi_rvalid  => rvalid,
+        s00_axi_rready  => '1'
+    );
+
+	-- CPU side: LCD_SequencerEnable, then LCD_WriteBurst until all is sent
+	stimulus: process
+	    variable cpu_writes : integer := 0;
+	    variable cpu_reads  : integer := 0;
+	    variable status     : std_logic_vector(31 downto 0);
+	    variable space      : integer;
+	    variable next_word  : integer := 0;
+
+	    procedure axi_write(addr : in integer; data : in std_logic_vector(31 downto 0)) is
+	    begin
+	        awaddr  <= std_logic_vector(to_unsigned(addr, 4));
+	        wdata   <= data;
+	        awvalid <= '1';
+	        wvalid  <= '1';
+	        loop
+	            wait until rising_edge(clk);
+	            exit when awready = '1';
+	        end loop;
+	        awvalid <= '0';
+	        wvalid  <= '0';
+	        wait until rising_edge(clk) and bvalid = '1';
+	        cpu_writes := cpu_writes + 1;
+	    end procedure;
+
+	    procedure axi_read(addr : in integer; data : out std_logic_vector(31 downto 0)) is
+	    begin
+	        araddr  <= std_logic_vector(to_unsigned(addr, 4));
+	        arvalid <= '1';
+	        loop
+	            wait until rising_edge(clk);
+	            exit when arready = '1';
+	        end loop;
+	        arvalid <= '0';
+	        wait until rising_edge(clk) and rvalid = '1';
+	        data := rdata;
+	        cpu_reads := cpu_reads + 1;
+	    end procedure;
+	begin
+	    resetn <= '0';
+	    wait for 10 * CLK_PERIOD;
+	    wait until rising_edge(clk);
+	    resetn <= '1';
+	    wait for 5 * CLK_PERIOD;
+
+	    -- sequencer on, FIFO empty interrupt on
+	    axi_write(16#C#, x"00000003");
+
+	    while next_word <= WORDS'high loop
+	        axi_read(16#8#, status);
+	        space := 16 - to_integer(unsigned(status(4 downto 0)));
+	        while space > 0 and next_word <= WORDS'high loop
+	            axi_write(16#0#, x"00000" & "000" & WORDS(next_word));
+	            next_word := next_word + 1;
+	            space := space - 1;
+	        end loop;
+	        -- software would return here and resume from lcd_irq
+	        wait for 50 us;
+	    end loop;
+
+	    assert lcd_irq = '0'
+	        report "lcd_irq asserted while bytes are pending" severity error;
+
+	    wait until lcd_irq = '1' for 10 ms;
+	    assert lcd_irq = '1'
+	        report "lcd_irq not asserted after the FIFO drained" severity error;
+	    axi_read(16#8#, status);
+	    assert status(10) = '1' and status(16) = '1'
+	        report "status does not report idle with interrupt pending" severity error;
+
+	    assert decoded = WORDS'length
+	        report "decoded " & integer'image(decoded) & " bytes, expected " &
+	               integer'image(WORDS'length) severity error;
+
+	    report "full-screen update: sequencer " & integer'image(cpu_writes - 1) &
+	           " writes + " & integer'image(cpu_reads - 1) & " status reads; bit-bang " &
+	           integer'image(4 * WORDS'length) & " writes + " &
+	           integer'image(2 * WORDS'length) & " reads";
+	    report "errors: " & integer'image(errors);
+	    assert errors = 0 report "LCD timing or data errors" severity error;
+
+	    done <= true;
+	    wait;
+	end process;
+
+	-- LCD side: timing checks and nibble decode
+	monitor: process
+	    variable t_rise       : time := 0 ns;
+	    variable t_fall       : time := 0 ns;
+	    variable t_ready      : time := 0 ns;
+	    variable high_nibble  : std_logic_vector(3 downto 0);
+	    variable have_high    : boolean := false;
+	    variable byte         : std_logic_vector(8 downto 0);
+	    variable count        : integer := 0;
+	    variable errs         : integer := 0;
+	begin
+	    wait until resetn = '1';
+	    loop
+	        wait on lcd_e, lcd_bus;
+
+	        if lcd_e'event and lcd_e = '1' then
+	            t_rise := now;
+	            if lcd_bus'last_event < 40 ns then
+	                report "setup time violated" severity error;
+	                errs := errs + 1;
+	            end if;
+	            if not have_high and now < t_ready then
+	                report "byte started " & time'image(t_ready - now) &
+	                       " before the previous command finished" severity error;
+	                errs := errs + 1;
+	            end if;
+	        elsif lcd_e'event and lcd_e = '0' then
+	            t_fall := now;
+	            if now - t_rise < 230 ns then
+	                report "E pulse too short" severity error;
+	                errs := errs + 1;
+	            end if;
+	            if lcd_bus'last_event < now - t_rise then
+	                report "data changed while E was high" severity error;
+	                errs := errs + 1;
+	            end if;
+	            if not have_high then
+	                high_nibble := lcd_bus(4 downto 1);
+	                have_high := true;
+	            else
+	                byte := lcd_bus(0) & high_nibble & lcd_bus(4 downto 1);
+	                have_high := false;
+	                if count > WORDS'high or byte /= WORDS(count) then
+	                    report "unexpected byte " & integer'image(to_integer(unsigned(byte)))
+	                        severity error;
+	                    errs := errs + 1;
+	                end if;
+	                if byte(8) = '0' and unsigned(byte(7 downto 0)) < 4 then
+	                    t_ready := now + 1520 us;
+	                else
+	                    t_ready := now + 37 us;
+	                end if;
+	                count := count + 1;
+	            end if;
+	        elsif lcd_bus'event and lcd_e = '0' and now - t_fall < 10 ns then
+	            report "hold time violated" severity error;
+	            errs := errs + 1;
+	        end if;
+
+	        decoded <= count;
+	        errors <= errs;
+	    end loop;
+	end process;
+
+end Behavioral;
@@ -0,0 +1,164 @@
+----------------------------------------------------------------------------------
+-- Module Name: lcd_sequencer - Behavioral
+-- Description: HD44780 4-bit bus sequencer with a write FIFO.
+--
+-- Each FIFO word is one command or data byte:
+--   bit 9    : nibble only, send the upper nibble of the byte (reset sequence)
+--   bit 8    : RS, '1' for a data byte
+--   bits 7-0 : the byte
+-- The sequencer splits the byte into nibbles, drives RS and data for
+-- C_E_CYCLES before raising E, holds E high for C_E_CYCLES, keeps the data
+-- stable for C_E_CYCLES after the falling edge, and then waits for the
+-- command to execute before starting the next word:
+--   clear/home (RS = 0, byte < 4) : C_EXEC_CLEAR_US
+--   nibble only                   : C_EXEC_RESET_US
+--   everything else               : C_EXEC_US
+--
+-- O_LCD uses the lcd_out layout of the IP: D7..D4 on bits 5..2, E on bit 1,
+-- RS on bit 0.
+----------------------------------------------------------------------------------
+
+
+library IEEE;
+use IEEE.STD_LOGIC_1164.ALL;
+use ieee.numeric_std.all;
+
+entity lcd_sequencer is
+    Generic ( C_FIFO_DEPTH_LOG2 : integer := 4;
+              C_CLK_PER_US      : integer := 100;
+              C_E_CYCLES        : integer := 100;
+              C_EXEC_US         : integer := 37;
+              C_EXEC_CLEAR_US   : integer := 1520;
+              C_EXEC_RESET_US   : integer := 4100);
+    Port ( I_CLK     : in STD_LOGIC;
+           I_RESETN  : in STD_LOGIC;
+           I_WR_EN   : in STD_LOGIC;
+           I_WR_DATA : in STD_LOGIC_VECTOR (9 downto 0);
+           O_LEVEL   : out STD_LOGIC_VECTOR (C_FIFO_DEPTH_LOG2 downto 0);
+           O_FULL    : out STD_LOGIC;
+           O_BUSY    : out STD_LOGIC;
+           O_LCD     : out STD_LOGIC_VECTOR (5 downto 0));
+end lcd_sequencer;
+
+architecture Behavioral of lcd_sequencer is
+
+constant FIFO_DEPTH : integer := 2**C_FIFO_DEPTH_LOG2;
+constant MAX_WAIT   : integer := C_EXEC_RESET_US * C_CLK_PER_US;
+
+type fifo_t is array (0 to FIFO_DEPTH-1) of std_logic_vector(9 downto 0);
+type state_t is (S_IDLE, S_SETUP, S_E_HIGH, S_HOLD, S_EXEC);
+
+signal fifo       : fifo_t;
+signal wr_ptr     : unsigned(C_FIFO_DEPTH_LOG2 downto 0) := (others => '0');
+signal rd_ptr     : unsigned(C_FIFO_DEPTH_LOG2 downto 0) := (others => '0');
+signal level      : unsigned(C_FIFO_DEPTH_LOG2 downto 0);
+signal full       : std_logic;
+
+signal state      : state_t := S_IDLE;
+signal cur        : std_logic_vector(9 downto 0) := (others => '0');
+signal low_nibble : std_logic := '0';
+signal timer      : integer range 0 to MAX_WAIT := 0;
+signal lcd_data   : std_logic_vector(3 downto 0) := (others => '0');
+signal lcd_e      : std_logic := '0';
+
+-- execution time of the word that has just been clocked out, in I_CLK cycles
+function exec_cycles(word : std_logic_vector(9 downto 0)) return integer is
+begin
+    if word(9) = '1' then
+        return C_EXEC_RESET_US * C_CLK_PER_US;
+    elsif word(8) = '0' and unsigned(word(7 downto 0)) < 4 then
+        return C_EXEC_CLEAR_US * C_CLK_PER_US;
+    else
+        return C_EXEC_US * C_CLK_PER_US;
+    end if;
+end function;
+
+begin
+
+    level   <= wr_ptr - rd_ptr;
+    full    <= '1' when level = FIFO_DEPTH else '0';
+    O_LEVEL <= std_logic_vector(level);
+    O_FULL  <= full;
+    O_BUSY  <= '0' when state = S_IDLE else '1';
+    O_LCD   <= lcd_data & lcd_e & cur(8);
+
+	-- write side of the FIFO, words written while full are dropped
+	P0: process(I_CLK)
+	begin
+		if(rising_edge(I_CLK)) then
+			if(I_WR_EN = '1' and full = '0') then
+				fifo(to_integer(wr_ptr(C_FIFO_DEPTH_LOG2-1 downto 0))) <= I_WR_DATA;
+			end if;
+			if(I_RESETN = '0') then
+				wr_ptr <= (others => '0');
+			elsif(I_WR_EN = '1' and full = '0') then
+				wr_ptr <= wr_ptr + 1;
+			end if;
+		end if;
+	end process;
+
+	-- bus sequencer, pops one word at a time
+	P1: process(I_CLK)
+	begin
+		if(rising_edge(I_CLK)) then
+			if(I_RESETN = '0') then
+				state      <= S_IDLE;
+				rd_ptr     <= (others => '0');
+				cur        <= (others => '0');
+				low_nibble <= '0';
+				timer      <= 0;
+				lcd_data   <= (others => '0');
+				lcd_e      <= '0';
+			else
+				case state is
+				when S_IDLE =>
+					if(level /= 0) then
+						cur        <= fifo(to_integer(rd_ptr(C_FIFO_DEPTH_LOG2-1 downto 0)));
+						lcd_data   <= fifo(to_integer(rd_ptr(C_FIFO_DEPTH_LOG2-1 downto 0)))(7 downto 4);
+						rd_ptr     <= rd_ptr + 1;
+						low_nibble <= '0';
+						timer      <= C_E_CYCLES - 1;
+						state      <= S_SETUP;
+					end if;
+				when S_SETUP =>   -- RS and data settle before E rises
+					if(timer = 0) then
+						lcd_e <= '1';
+						timer <= C_E_CYCLES - 1;
+						state <= S_E_HIGH;
+					else
+						timer <= timer - 1;
+					end if;
+				when S_E_HIGH =>  -- falling edge latches the nibble
+					if(timer = 0) then
+						lcd_e <= '0';
+						timer <= C_E_CYCLES - 1;
+						state <= S_HOLD;
+					else
+						timer <= timer - 1;
+					end if;
+				when S_HOLD =>    -- data held after the falling edge
+					if(timer = 0) then
+						if(cur(9) = '0' and low_nibble = '0') then
+							low_nibble <= '1';
+							lcd_data   <= cur(3 downto 0);
+							timer      <= C_E_CYCLES - 1;
+							state      <= S_SETUP;
+						else
+							timer <= exec_cycles(cur) - 1;
+							state <= S_EXEC;
+						end if;
+					else
+						timer <= timer - 1;
+					end if;
+				when S_EXEC =>    -- command execution time
+					if(timer = 0) then
+						state <= S_IDLE;
+					else
+						timer <= timer - 1;
+					end if;
+				end case;
+			end if;
+		end if;
+	end process;
+
+end Behavioral;
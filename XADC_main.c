@@ -8,43 +8,77 @@
 #include "xgpio.h"
 #include "xil_types.h"
 #include "debounce.h"
+#include "fixed.h"
+#include "xadc_acq.h"
+#include "adc_stream.h"
+#include "filter.h"
+#include "xadc_chan.h"
+#include "xadc_band.h"
+#include "xscugic.h"
+#include "xscutimer.h"
+#include "xil_printf.h"
+#include "bench.h"
+#include "dlog.h"
+#include "timebase.h"
+#include "event_queue.h"
+#include "idle.h"
+#include "scheduler.h"
+#include "intr.h"
 
 //#define RGBLED_BASEADDR XPAR_PWM_0_PWM_AXI_BASEADDR
 // servo base address
 #define SERVO_BASEADDR XPAR_PWM_0_PWM_AXI_BASEADDR
 
+// servo duty: 0.025 of the period at ADC code 0, 0.225 at full scale
+#define SERVO_PERIOD 0xFFFF
+#define SERVO_DUTY_MIN FIXED_Q15(0.025)
+#define SERVO_DUTY_MAX FIXED_Q15(0.225)
+
 #define LED_ON_DUTY 0x3FFF
 #define LED_OFF_DUTY 0x3000
 #define XADC_DEVICE_ID XPAR_XADC_WIZ_0_DEVICE_ID
+#define XADC_INTR_ID XPAR_FABRIC_XADC_WIZ_0_IP2INTC_IRPT_INTR
+// scheduler tick, Cortex-A9 private timer at half the CPU clock
+#define TICK_TIMER_DEVICE_ID XPAR_XSCUTIMER_0_DEVICE_ID
+#define TICK_TIMER_INTR_ID XPAR_SCUTIMER_INTR
+#define TICK_TIMER_LOAD ((XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / 2 / 1000000) * SCHED_TICK_US - 1)
+// XADC_ACQ_MODE_INTR: the EOS interrupt captures each sequence
+// XADC_ACQ_MODE_POLL: Xadc_ReadData waits for the end of a sequence
+#define XADC_ACQ_MODE XADC_ACQ_MODE_INTR
 #define BTN_DEVICE_ID XPAR_AXI_GPIO_0_DEVICE_ID
 // define servo here (maybe not)
 #define SERVO_DEVICE_ID XPAR_AXI_GPIO_0_DEVICE_ID
 
-// Channels 0, 1, 5, 6, 8, 9, 12, 13, 15, VPVN are available
-// Channels 0, 8, 12 are differential 1.0V max
-// Channels 1, 5, 6, 9, 13, 15 are single-ended 3.3V max
-// All channels should be used in differential input mode
-#define XADC_SEQ_CHANNELS 0x00020800
-#define XADC_CHANNELS 0x00020000
-#define NUMBER_OF_CHANNELS 1
-const u8 Channel_List[NUMBER_OF_CHANNELS] = {
-	//3, // Start with VP/VN
-	//28, // 16, // 24, // Diff. Channels in ascending order
-	17 // , 25, 31 // 22, 21, 29 // Single-Ended Channels in ascending order
-}; // 00008
-const char *Channel_Names[32] = {
-	"", "", "", "",
-	"", "", "", "",
-	"", "", "", "",
-	"", "", "", "",
-	"", "A0", "", "",
-	"", "", "", "",
-	"", "", "", "",
-	"", "", "", ""
-};
+// The analog inputs, their modes and which of them are sequenced are listed
+// in XadcChan_Table (xadc_chan.c)
+#define XADC_ADCCLK_HZ (100000000 / 32)
+#define XADC_AVERAGE 16
+#define SERVO_CHANNEL XADC_CHAN_AUX(1) // A0
+#define SERVO_CUTOFF_HZ 20
+#define LIGHT_CHANNEL XADC_CHAN_AUX(9) // A1, photoresistor divider
+
+#define DLOG_DRAIN_MAX 4 // log lines printed per loop pass
+#define BTN_DEBOUNCE_COUNT 3 // button samples, 30 ms at 100 Hz
 
 #define Test_Bit(VEC,BIT) ((VEC&(1<<BIT))!=0)
 
+static XSysMon Xadc;
+static XadcAcq Xadc_Acq;
+static XScuGic Intc;
+static XScuTimer TickTimer;	// wakes the loop for the scheduler
+static Sched Tasks;
+static XGpio Btn;
+static Debounce Btn0_Db, Btn1_Db;
+static u8 ChannelIndex = 0;
+static u32 Xadc_LastSeq;
+static AdcStream Xadc_Stream;	// every sample of every sequence, for the readers
+static AdcStream_Reader Xadc_FilterReader;
+static Filter_Chain Xadc_ServoFilter;
+static Filter_Chain *Xadc_Filters[32];	// per-channel filter, NULL if unfiltered
+static u32 Xadc_FilterMask;	// channels with a filter
+static s32 Xadc_Filtered[32];	// newest filter output of each channel
+static XadcBand_Engine Xadc_Bands;	// threshold bands, reported on crossings
+
 // void RGBLED_SetColor(u32 base_address, u16 r, u16 g, u16 b) {
 	// PWM_Set_Duty(RGBLED_BASEADDR, b, 0);
 	// PWM_Set_Duty(RGBLED_BASEADDR, g, 1);
@@ -62,7 +96,7 @@ void Servo_Set(u32 base_address, u16 clk) {
 }
 
 void Servo_Init(u32 base_address) {
-	PWM_Set_Period(base_address, 0xffff);
+	PWM_Set_Period(base_address, SERVO_PERIOD);
 	Servo_Set(base_address, 0);
 	PWM_Enable(base_address);
 }
@@ -74,7 +108,7 @@ void Xadc_Init(XSysMon *InstancePtr, u32 DeviceId) {
 
 	// Disable the Channel Sequencer before configuring the Sequence registers.
 	XSysMon_SetSequencerMode(InstancePtr, XSM_SEQ_MODE_SAFE);
-	// Disable all alarms
+	// Disable all alarms, XadcBand_Arm enables the ones the bands use
 	XSysMon_SetAlarmEnables(InstancePtr, 0x0);
 	// Set averaging for all channels to 16 samples
 	XSysMon_SetAvg(InstancePtr, XSM_AVG_16_SAMPLES);
@@ -84,15 +118,15 @@ void Xadc_Init(XSysMon *InstancePtr, u32 DeviceId) {
 	//XSysMon_SetSeqInputMode(InstancePtr, 0);
 
 	// Set differential input mode for all channels
-	XSysMon_SetSeqInputMode(InstancePtr, XADC_SEQ_CHANNELS);
+	XSysMon_SetSeqInputMode(InstancePtr, XadcChan_BipolarSeqMask());
 
 
 	// Set 6ADCCLK acquisition time in all channels
-	XSysMon_SetSeqAcqTime(InstancePtr, XADC_SEQ_CHANNELS);
+	XSysMon_SetSeqAcqTime(InstancePtr, XadcChan_SeqMask());
 	// Disable averaging in all channels
-	XSysMon_SetSeqAvgEnables(InstancePtr, XADC_SEQ_CHANNELS);
-	// Enable all channels
-	XSysMon_SetSeqChEnables(InstancePtr, XADC_SEQ_CHANNELS);
+	XSysMon_SetSeqAvgEnables(InstancePtr, XadcChan_SeqMask() | XadcBand_SeqMask(&Xadc_Bands));
+	// Enable all channels, plus the on-chip sensors the bands watch
+	XSysMon_SetSeqChEnables(InstancePtr, XadcChan_SeqMask() | XadcBand_SeqMask(&Xadc_Bands));
 	// Set the ADCCLK frequency equal to 1/32 of System clock
 	XSysMon_SetAdcClkDivisor(InstancePtr, 32);
 	// Enable Calibration
@@ -103,67 +137,170 @@ void Xadc_Init(XSysMon *InstancePtr, u32 DeviceId) {
 	//	XSysMon_GetStatus(InstancePtr);
 }
 
+// Runs after each frame is published: appends its samples to the stream
+// and checks the software bands
+static void Xadc_FrameDone(XadcAcq *AcqPtr, u32 Seq) {
+	(void)Seq;
+	AdcStream_WriteFrame(&Xadc_Stream, &AcqPtr->Buf[AcqPtr->Front], AcqPtr->Mask);
+	XadcBand_Update(&Xadc_Bands, &AcqPtr->Buf[AcqPtr->Front]);
+}
+
+// Passes the alarm interrupts on to the band engine
+static void Xadc_Alarm(XadcAcq *AcqPtr, u32 Status) {
+	XadcBand_AlarmHandler(AcqPtr->AlarmRef, Status);
+}
+
+// Registers the threshold bands. Call before Xadc_Init, which adds the
+// sensors they watch to the sequence.
+void Xadc_BandInit(XSysMon *InstancePtr) {
+	const XadcChan_Info *ServoPtr = XadcChan_Lookup(SERVO_CHANNEL);
+	const XadcChan_Info *LightPtr = XadcChan_Lookup(LIGHT_CHANNEL);
+
+	XadcBand_Init(&Xadc_Bands, InstancePtr);
+	XadcBand_Add(&Xadc_Bands, "A0 above 90%", SERVO_CHANNEL,
+		     XadcChan_FromMillivolts(ServoPtr, XADC_CHAN_SE_MV * 9 / 10), 0xFFFF,
+		     XadcChan_FromMillivolts(ServoPtr, 33), NULL);
+	XadcBand_Add(&Xadc_Bands, "A1 dark", LIGHT_CHANNEL,
+		     0, XadcChan_FromMillivolts(LightPtr, 330),
+		     XadcChan_FromMillivolts(LightPtr, 33), NULL);
+	XadcBand_Add(&Xadc_Bands, "A1 light", LIGHT_CHANNEL,
+		     XadcChan_FromMillivolts(LightPtr, 1650), 0xFFFF,
+		     XadcChan_FromMillivolts(LightPtr, 33), NULL);
+	XadcBand_Add(&Xadc_Bands, "Die above 60C", XADC_BAND_CH_TEMP,
+		     XADC_BAND_TEMP_CODE(60), 0xFFFF,
+		     XADC_BAND_TEMP_CODE(60) - XADC_BAND_TEMP_CODE(55), NULL);
+}
+
+// Prints the band crossings since the last call
+void Xadc_BandReport(void) {
+	Event Ev;
+
+	while (XadcBand_Pop(&Xadc_Bands, &Ev) == XST_SUCCESS)
+		DLOG("%s %s\r\n", DLOG_S(Xadc_Bands.Band[Ev.Type].Name),
+		     DLOG_S(XADC_BAND_EVENT_ENTERED(Ev.Arg) ? "entered" : "left"));
+}
+
+// Connects the XADC EOS interrupt, in the acquisition tier
+int Xadc_IntrInit(XadcAcq *AcqPtr, XScuGic *IntcPtr) {
+	return XadcAcq_SetupIntr(AcqPtr, IntcPtr, XADC_INTR_ID);
+}
+
+// The tick only wakes the loop from Idle_Wait; the scheduler decides what runs
+static void Tick_Handler(void *CallBackRef) {
+	XScuTimer_ClearInterruptStatus((XScuTimer *)CallBackRef);
+}
+
+// Starts the private timer interrupt every SCHED_TICK_US, in the control
+// tier so the releases are not held up by the XADC handler
+int Tick_Init(XScuTimer *TimerPtr, XScuGic *IntcPtr) {
+	XScuTimer_Config *ConfigPtr;
+
+	ConfigPtr = XScuTimer_LookupConfig(TICK_TIMER_DEVICE_ID);
+	if (ConfigPtr == NULL)
+		return XST_FAILURE;
+	if (XScuTimer_CfgInitialize(TimerPtr, ConfigPtr, ConfigPtr->BaseAddr) != XST_SUCCESS)
+		return XST_FAILURE;
+	if (Intr_Init(IntcPtr) != XST_SUCCESS ||
+	    Intr_Connect(TICK_TIMER_INTR_ID, INTR_TIER_CONTROL, INTR_TRIGGER_KEEP,
+			 Tick_Handler, TimerPtr) != XST_SUCCESS)
+		return XST_FAILURE;
+	Intr_SetProbe(TICK_TIMER_INTR_ID, Intr_ScuTimerProbe);
+
+	XScuTimer_LoadTimer(TimerPtr, TICK_TIMER_LOAD);
+	XScuTimer_EnableAutoReload(TimerPtr);
+	XScuTimer_EnableInterrupt(TimerPtr);
+	XScuTimer_Start(TimerPtr);
+	return XST_SUCCESS;
+}
+
 #define READDATA_DBG 0
 u32 Xadc_ReadData (XSysMon *InstancePtr, u16 RawData[32])
 {
-	u8 Channel;
-	float voltage;
-	float duty_cycle;
-
-	if (READDATA_DBG != 0)
-		xil_printf("Waiting for EOS...\r\n");
+	u32 Channel, Mask;
+	XadcAcq_Frame Frame;
+	u32 Seq;
+	BENCH_START(Cycles);
+
+	if (Xadc_Acq.Mode == XADC_ACQ_MODE_POLL) {
+		if (READDATA_DBG != 0)
+			DLOG("Waiting for EOS...\r\n");
+		XadcAcq_Poll(&Xadc_Acq);
+	}
 
-	// Clear the Status
-	XSysMon_GetStatus(InstancePtr);
-	// Wait until the End of Sequence occurs
-	while ((XSysMon_GetStatus(InstancePtr) & XSM_SR_EOS_MASK) != XSM_SR_EOS_MASK);
+	// Newest frame captured by the EOS interrupt (or the poll above)
+	Seq = XadcAcq_Read(&Xadc_Acq, &Frame);
+	if (Seq == 0) {
+		BENCH_STOP(BENCH_XADC_READ, Cycles);
+		return 0;
+	}
+	if (READDATA_DBG != 0 && XadcAcq_Lost(Xadc_LastSeq, Seq) != 0)
+		DLOG("%d frames not read\r\n", XadcAcq_Lost(Xadc_LastSeq, Seq));
+	Xadc_LastSeq = Seq;
 
 	if (READDATA_DBG != 0)
-		xil_printf("Capturing XADC Data...\r\n");
+		DLOG("Capturing XADC Data...\r\n");
+
+	Mask = Xadc_Acq.Mask;
+	while (Mask != 0) {
+		Channel = XadcChan_NextBit(&Mask);
+		RawData[Channel] = Frame.Data[Channel];
+		if (READDATA_DBG != 0)
+			DLOG("Raw data %d %d \r\n", Channel, RawData[Channel]);
+	}
+	BENCH_STOP(BENCH_XADC_READ, Cycles);
+	return Xadc_Acq.Mask; // return a high bit for each channel successfully read
+}
 
-	for (Channel=0; Channel<32; Channel++) {
-		if (((1 << Channel) & XADC_CHANNELS) != 0) {
-			if (READDATA_DBG != 0)
-				xil_printf("Capturing Data for Channel %d\r\n", Channel);
-			RawData[Channel] = XSysMon_GetAdcData(InstancePtr, Channel);
-			xil_printf("Raw data %d %d \r\n", Channel, RawData[Channel]);
+// Millivolts at the input pins, 0 for a channel the board does not have
+s32 Xadc_RawToMillivolts(u16 Data, u8 Channel) {
+	const XadcChan_Info *InfoPtr = XadcChan_Lookup(Channel);
 
-			//adding stuff here
-			//voltage = ((float)RawData[Channel] / (float)0x7FFF) * (float)3.3;
-			//printf("Output voltage: %.3fV\r\n", voltage);
-			//duty_cycle = ((float)RawData[Channel] / 327670) + 0.025;
-			//printf("Duty cycle: %.3f \r\n", duty_cycle);
+	if (InfoPtr == NULL)
+		return 0;
+	return XadcChan_ToMillivolts(InfoPtr, Data);
+}
 
-		}
-	}
-	return XADC_CHANNELS; // return a high bit for each channel successfully read
+// Sets up the filter of each channel that needs one
+void Xadc_FilterInit(void) {
+	// Reject single-sample spikes, then smooth out the servo jitter
+	Filter_ChainInit(&Xadc_ServoFilter);
+	Filter_AddMedian(&Xadc_ServoFilter, 5);
+	Filter_AddLowpass(&Xadc_ServoFilter, SERVO_CUTOFF_HZ,
+			  XadcChan_FrameHz(XADC_ADCCLK_HZ, XADC_AVERAGE));
+	Xadc_Filters[SERVO_CHANNEL] = &Xadc_ServoFilter;
+	Xadc_FilterMask |= 1U << SERVO_CHANNEL;
+
+	AdcStream_Attach(&Xadc_FilterReader, &Xadc_Stream);
 }
 
-	float Xadc_RawToVoltage(u16 Data, u8 Channel) {
-	float FloatData;
-	float Scale;
-
-
-	switch (Channel) {
-	//case 3: // VP/VN (Cora Dedicated Analog Input)
-	//case 16: // AUX0 (Cora A8/A9 Diff. Analog Input)
-	// case 24: // AUX8 (Cora A10/A11 Diff. Analog Input)
-	//case 28: Scale = 1.0; break; // AUX12 (Cora A6/A7 Diff. Analog Input)
-	case 17: // AUX1 (Cora A0 Single-Ended Analog Input)
-	//case 21: // AUX5 (Cora A4 Single-Ended Analog Input)
-	//case 22: // AUX6 (Cora A2 Single-Ended Analog Input)
-	//case 25: // AUX9 (Cora A1 Single-Ended Analog Input)
-	//case 29: // AUX13 (Cora A5 Single-Ended Analog Input)
-	//case 31: Scale = 3.3; break; // AUX15 (Cora A3 Single-Ended Analog Input)
-	default: Scale = 0.0;
+// Runs every new sample of the filtered channels through its filter.
+// Call often enough that the stream does not lap the reader.
+void Xadc_FilterUpdate(void) {
+	const AdcStream_Sample *Span;
+	AdcStream_Sample Copy[FILTER_CHUNK];
+	s32 Block[FILTER_CHUNK];
+	u32 Count, Index, Len, Over, Channel, Mask;
+
+	while ((Count = AdcStream_Peek(&Xadc_FilterReader, &Span)) != 0) {
+		if (Count > FILTER_CHUNK)
+			Count = FILTER_CHUNK;
+		// copy first, the samples the writer overwrote meanwhile are dropped
+		for (Index = 0; Index < Count; Index++)
+			Copy[Index] = Span[Index];
+		Over = AdcStream_Release(&Xadc_FilterReader, Count);
+
+		Mask = Xadc_FilterMask;
+		while (Mask != 0) {
+			Channel = XadcChan_NextBit(&Mask);
+			Len = 0;
+			for (Index = Over; Index < Count; Index++)
+				if (Copy[Index].Channel == Channel)
+					Block[Len++] = Copy[Index].Code;
+			Len = Filter_Process(Xadc_Filters[Channel], Block, Len);
+			if (Len != 0)
+				Xadc_Filtered[Channel] = Block[Len - 1];
+		}
 	}
-	if (Test_Bit(Data, 15)) {
-		FloatData = -Scale;
-		Data = ~Data + 1;
-	} else
-		FloatData = Scale;
-	FloatData *= (float)Data / (float)0xFFFF;
-	return FloatData;
 }
 
 void Btn_Init(XGpio *InstancePtr, u32 DeviceId) {
@@ -184,23 +321,26 @@ void Btn_Init(XGpio *InstancePtr, u32 DeviceId) {
 
 void Xadc_Demo1(XSysMon *InstancePtr, u32 Servo_BaseAddr, u32 ChannelSelect) {
 	u16 Xadc_RawData[32];
-	u8 Channel;
 	u32 ChannelValidVector;
-	float Xadc_VoltageData;
-	float voltage;
+	u32 duty_counts;
+	const XadcChan_Info *InfoPtr = XadcChan_Lookup(ChannelSelect);
 	ChannelValidVector = Xadc_ReadData(InstancePtr, Xadc_RawData);
-	if (ChannelSelect == 17) {
-		float temp = Xadc_RawData[ChannelSelect];
-		//voltage = ((float)Xadc_RawData[ChannelSelect] / (float)0x7FFF) * (float)3.3;
-		float duty_cycle = (temp / 327670) + 0.025;
-		//printf("Analog Input: %s: %.3fV\r\n", Channel_Names[ChannelSelect], Xadc_VoltageData);
-		//printf("Output voltage: %.3fV\r\n", voltage);
+	if (ChannelSelect == SERVO_CHANNEL && Test_Bit(ChannelValidVector, ChannelSelect)) {
+		if (Xadc_Filters[ChannelSelect] != NULL)
+			Xadc_RawData[ChannelSelect] = (u16)Xadc_Filtered[ChannelSelect];
+		duty_counts = Fixed_AdcToCounts(Xadc_RawData[ChannelSelect],
+						SERVO_DUTY_MIN, SERVO_DUTY_MAX, SERVO_PERIOD);
 		//printf("Channel number: %d \r\n", ChannelSelect);
-		printf("Duty Cycle: %.3f \r\n", duty_cycle);
-		Servo_Set(Servo_BaseAddr, duty_cycle);
+		DLOG("Duty Cycle: %lu/%u \r\n", duty_counts, SERVO_PERIOD);
+		Servo_Set(Servo_BaseAddr, duty_counts);
 		//return voltage;
+	} else if (Test_Bit(ChannelValidVector, ChannelSelect)) {
+		DLOG("Analog Input %s: %ld mV\r\n", DLOG_S(InfoPtr->Name),
+		     XadcChan_ToMillivolts(InfoPtr, Xadc_RawData[ChannelSelect]));
+		Servo_Set(Servo_BaseAddr, 0);
 	} else {
-		printf("Channel %d (%s) Not Available\r\n", (int)ChannelSelect, Channel_Names[ChannelSelect]);
+		DLOG("Channel %d (%s) Not Available\r\n", ChannelSelect,
+		     DLOG_S(InfoPtr != NULL ? InfoPtr->Name : ""));
 		Servo_Set(Servo_BaseAddr, 0);
 	}
 }
@@ -226,49 +366,82 @@ void Xadc_Demo1(XSysMon *InstancePtr, u32 Servo_BaseAddr, u32 ChannelSelect) {
 	}
 } */
 
-int main () {
-	XSysMon Xadc;
-	u8 ChannelIndex = 0;
-	XGpio Btn;
+// 1 kHz: filters the new samples and reports band crossings
+static void Adc_Task(void) {
+	Xadc_FilterUpdate();
+	Xadc_BandReport();
+}
+
+// 100 Hz: steps the selected channel on a button press
+static void Btn_Task(void) {
 	u32 Btn_Data;
+
+	Btn_Data = XGpio_DiscreteRead(&Btn, 1) & 0b11;
+	Debounce_Update(&Btn0_Db, Btn_Data & 0b01);
+	Debounce_Update(&Btn1_Db, Btn_Data & 0b10);
+
+	if (Btn1_Db.Flag == 1 && Btn0_Db.Flag == 0) {
+		if (ChannelIndex + 1 < XADC_CHAN_COUNT)
+			ChannelIndex ++;
+		else
+			ChannelIndex = 0;
+	} else if (Btn1_Db.Flag == 0 && Btn0_Db.Flag == 1) {
+		if (ChannelIndex > 0)
+			ChannelIndex --;
+		else
+			ChannelIndex = XADC_CHAN_COUNT-1;
+	}
+}
+
+// 10 Hz: shows the selected channel and drives the servo
+static void Demo_Task(void) {
+	Xadc_Demo1(&Xadc, SERVO_BASEADDR, XadcChan_Table[ChannelIndex].Channel);
+	// Xadc_Demo(&Xadc, RGBLED_BASEADDR, XadcChan_Table[ChannelIndex].Channel);
+}
+
+int main () {
 	//const u32 RGBLED_BaseAddr = RGBLED_BASEADDR;
-	const u32 Servo_BaseAddr = Servo_BaseAddr;
-	Debounce Btn0_Db, Btn1_Db;
-	u32 time_count = 0;
+	const u32 Servo_BaseAddr = SERVO_BASEADDR;
 
+	timebase_init();
+	Dlog_Init();
+	Event_Init();
+	Idle_Init();
+	Xadc_BandInit(&Xadc);
 	Xadc_Init(&Xadc, XADC_DEVICE_ID);
+	XadcAcq_Init(&Xadc_Acq, &Xadc, XadcChan_Mask() | Xadc_Bands.SwMask, XADC_ACQ_MODE);
+	AdcStream_Init(&Xadc_Stream);
+	XadcAcq_SetCallback(&Xadc_Acq, Xadc_FrameDone);
+	XadcAcq_SetAlarmCallback(&Xadc_Acq, Xadc_Alarm, &Xadc_Bands);
+	Xadc_FilterInit();
+	if (Intr_Init(&Intc) != XST_SUCCESS)
+		printf("GIC setup failed\r\n");
+	if (XADC_ACQ_MODE == XADC_ACQ_MODE_INTR &&
+	    Xadc_IntrInit(&Xadc_Acq, &Intc) != XST_SUCCESS)
+		printf("XADC interrupt setup failed\r\n");
+	if (Tick_Init(&TickTimer, &Intc) != XST_SUCCESS)
+		printf("Tick timer setup failed\r\n");
+	XadcBand_Arm(&Xadc_Bands);
 	//RGBLED_Init(RGBLED_BaseAddr);
 	Servo_Init(Servo_BaseAddr);
 	//servo_Init(&servo, SERVO_DEVICE_ID
 	Btn_Init(&Btn, BTN_DEVICE_ID);
-	Debounce_Init(&Btn0_Db, 10000);
-	Debounce_Init(&Btn1_Db, 10000);
+	Debounce_Init(&Btn0_Db, BTN_DEBOUNCE_COUNT);
+	Debounce_Init(&Btn1_Db, BTN_DEBOUNCE_COUNT);
+
+	// fastest first; phases keep the slower tasks off the same tick
+	Sched_Init(&Tasks);
+	Sched_Add(&Tasks, "adc", Adc_Task, SCHED_HZ(1000), 0, SCHED_NO_DEADLINE);
+	Sched_Add(&Tasks, "buttons", Btn_Task, SCHED_HZ(100), 1, SCHED_NO_DEADLINE);
+	Sched_Add(&Tasks, "demo", Demo_Task, SCHED_HZ(10), 5, SCHED_NO_DEADLINE);
 
 	printf("Cora XADC Demo Initialized!\r\n");
 
+	Sched_Start(&Tasks);
 	while(1) {
-		Btn_Data = XGpio_DiscreteRead(&Btn, 1) & 0b11;
-		Debounce_Update(&Btn0_Db, Btn_Data & 0b01);
-		Debounce_Update(&Btn1_Db, Btn_Data & 0b10);
-
-		if (Btn1_Db.Flag == 1 && Btn0_Db.Flag == 0) {
-			if (ChannelIndex + 1 < NUMBER_OF_CHANNELS)
-				ChannelIndex ++;
-			else
-				ChannelIndex = 0;
-		} else if (Btn1_Db.Flag == 0 && Btn0_Db.Flag == 1) {
-			if (ChannelIndex > 0)
-				ChannelIndex --;
-			else
-				ChannelIndex = NUMBER_OF_CHANNELS-1;
-		}
+		u64 Next = Sched_Run(&Tasks);
 
-		time_count ++;
-		if (time_count == 100000) { // print channel reading approx. 10x per second
-			time_count = 0;
-			Xadc_Demo1(&Xadc, Servo_BaseAddr, Channel_List[ChannelIndex]);
-			// Xadc_Demo(&Xadc, RGBLED_BaseAddr, Channel_List[ChannelIndex]);
-		}
-		usleep(1);
+		Dlog_Drain(print, DLOG_DRAIN_MAX);
+		Idle_Wait(Next);
 	}
 }
@@ -0,0 +1,393 @@
+/*****************************************************************************/
+/**
+* @file adc_stream.c
+*
+* Multi-reader XADC sample ring. See adc_stream.h.
+*
+* The writer only ever publishes Head, the count of samples written, and
+* never reads the readers' cursors. Before it overwrites the slot of sample
+* n it has published Head = n, so a reader that reads Head after copying or
+* using sample t knows that sample was intact if t + ADC_STREAM_LEN > Head.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "adc_stream.h"
+#include "timebase.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define ADC_STREAM_MASK		(ADC_STREAM_LEN - 1)
+
+#ifdef HOST_SIM
+#define ADC_STREAM_BENCH_MS	500	/* Length of each threaded run */
+#define ADC_STREAM_BENCH_CHANNELS 4
+#define ADC_STREAM_BENCH_READERS 3
+#endif
+
+/*****************************************************************************/
+/**
+* Empties a stream. Readers must be attached again afterwards.
+*
+******************************************************************************/
+void AdcStream_Init(AdcStream *StreamPtr)
+{
+	StreamPtr->Head = 0;
+}
+
+/*****************************************************************************/
+/**
+* Appends one sample, overwriting the oldest if the ring is full.
+*
+* @param	StreamPtr is the stream.
+* @param	Stamp is the time base tick count the sample was taken at.
+* @param	Seq is the sequence number of the frame it belongs to.
+* @param	Channel is the XSysMon channel number.
+* @param	Code is the ADC code.
+*
+* @note		Call from the writer context only.
+*
+******************************************************************************/
+void AdcStream_Write(AdcStream *StreamPtr, u64 Stamp, u32 Seq, u8 Channel,
+		     u16 Code)
+{
+	u32 Head = StreamPtr->Head;
+	AdcStream_Sample *SamplePtr = &StreamPtr->Ring[Head & ADC_STREAM_MASK];
+
+	/* Head = n is visible before sample n - ADC_STREAM_LEN is overwritten */
+	MEMORY_BARRIER();
+	SamplePtr->Stamp = Stamp;
+	SamplePtr->Seq = Seq;
+	SamplePtr->Code = Code;
+	SamplePtr->Channel = Channel;
+	SamplePtr->Reserved = 0;
+	MEMORY_BARRIER();
+	StreamPtr->Head = Head + 1;
+}
+
+/*****************************************************************************/
+/**
+* Appends one sample per channel of a frame, in channel order. Meant to be
+* called from the XadcAcq callback.
+*
+* @param	StreamPtr is the stream.
+* @param	FramePtr is the frame just published.
+* @param	ChannelMask selects the channels to append.
+*
+******************************************************************************/
+void AdcStream_WriteFrame(AdcStream *StreamPtr, const XadcAcq_Frame *FramePtr,
+			  u32 ChannelMask)
+{
+	u32 Channel;
+
+	for (Channel = 0; Channel < XADC_ACQ_CHANNELS; Channel++) {
+		if (ChannelMask & (1U << Channel))
+			AdcStream_Write(StreamPtr, FramePtr->Stamp, FramePtr->Seq,
+					Channel, FramePtr->Data[Channel]);
+	}
+}
+
+/*****************************************************************************/
+/**
+* Attaches a reader to a stream. The reader starts with the next sample
+* written.
+*
+******************************************************************************/
+void AdcStream_Attach(AdcStream_Reader *ReaderPtr, AdcStream *StreamPtr)
+{
+	*ReaderPtr = (AdcStream_Reader){0};
+	ReaderPtr->StreamPtr = StreamPtr;
+	ReaderPtr->Tail = StreamPtr->Head;
+}
+
+/*****************************************************************************/
+/**
+* @return	Samples the reader has not read yet and that are still in the
+*		ring.
+*
+******************************************************************************/
+u32 AdcStream_Available(const AdcStream_Reader *ReaderPtr)
+{
+	u32 Avail = ReaderPtr->StreamPtr->Head - ReaderPtr->Tail;
+
+	return (Avail > ADC_STREAM_LEN) ? ADC_STREAM_LEN : Avail;
+}
+
+/*****************************************************************************/
+/**
+* Returns the oldest unread samples in place. The span ends at the newest
+* sample or at the end of the ring, whichever comes first, so a reader that
+* wants everything calls Peek and Release until Peek returns 0.
+*
+* If the writer has lapped the reader since its last call, the samples that
+* were overwritten are skipped and counted as lost.
+*
+* @param	ReaderPtr is the reader.
+* @param	SpanPtr receives the address of the first sample.
+*
+* @return	Number of samples in the span, 0 if there are none.
+*
+* @note		The samples stay in the ring; the writer may overwrite the
+*		start of the span if the reader keeps it too long, which
+*		AdcStream_Release() reports.
+*
+******************************************************************************/
+u32 AdcStream_Peek(AdcStream_Reader *ReaderPtr,
+		   const AdcStream_Sample **SpanPtr)
+{
+	AdcStream *StreamPtr = ReaderPtr->StreamPtr;
+	AdcStream_Stats *StatsPtr = &ReaderPtr->Stats;
+	u32 Head = StreamPtr->Head;
+	u32 Avail = Head - ReaderPtr->Tail;
+	u32 Start, Span;
+	u64 Age;
+
+	if (Avail > ADC_STREAM_LEN) {
+		StatsPtr->Overruns++;
+		StatsPtr->Lost += Avail - ADC_STREAM_LEN;
+		ReaderPtr->Tail = Head - ADC_STREAM_LEN;
+		Avail = ADC_STREAM_LEN;
+	}
+	ReaderPtr->Peeked = 0;
+	if (Avail == 0)
+		return 0;
+
+	MEMORY_BARRIER();
+	Start = ReaderPtr->Tail & ADC_STREAM_MASK;
+	Span = ADC_STREAM_LEN - Start;
+	if (Span > Avail)
+		Span = Avail;
+
+	if (Avail > StatsPtr->MaxLag)
+		StatsPtr->MaxLag = Avail;
+	Age = now_ticks() - StreamPtr->Ring[Start].Stamp;
+	if (Age > StatsPtr->MaxLagTicks && Age < (1ULL << 63))
+		StatsPtr->MaxLagTicks = Age;
+	StatsPtr->Spans++;
+
+	ReaderPtr->Peeked = Span;
+	*SpanPtr = &StreamPtr->Ring[Start];
+	return Span;
+}
+
+/*****************************************************************************/
+/**
+* Consumes samples from the start of the span the last AdcStream_Peek()
+* returned and checks that the writer did not overwrite them while they
+* were in use.
+*
+* @param	ReaderPtr is the reader.
+* @param	Count is the number of samples consumed, at most the span
+*		length.
+*
+* @return	Number of samples at the start of the span that were
+*		overwritten and must be discarded, normally 0.
+*
+******************************************************************************/
+u32 AdcStream_Release(AdcStream_Reader *ReaderPtr, u32 Count)
+{
+	AdcStream_Stats *StatsPtr = &ReaderPtr->Stats;
+	u32 Head;
+	s32 Over;
+
+	if (Count > ReaderPtr->Peeked)
+		Count = ReaderPtr->Peeked;
+
+	MEMORY_BARRIER();
+	Head = ReaderPtr->StreamPtr->Head;
+	/* Sample Head - ADC_STREAM_LEN may be being overwritten right now */
+	Over = (s32)(Head + 1 - ADC_STREAM_LEN - ReaderPtr->Tail);
+	if (Over <= 0) {
+		Over = 0;
+	} else {
+		if ((u32)Over > Count)
+			Over = Count;
+		StatsPtr->Overruns++;
+		StatsPtr->Lost += Over;
+	}
+
+	StatsPtr->Samples += Count - Over;
+	ReaderPtr->Tail += Count;
+	ReaderPtr->Peeked -= Count;
+	return Over;
+}
+
+/*****************************************************************************/
+/**
+* Returns a snapshot of a reader's counters.
+*
+******************************************************************************/
+void AdcStream_GetStats(const AdcStream_Reader *ReaderPtr,
+			AdcStream_Stats *StatsPtr)
+{
+	*StatsPtr = ReaderPtr->Stats;
+}
+
+#ifdef HOST_SIM
+typedef struct {
+	const char *Name;
+	u32 IntervalUs;		/* Sleep between drains */
+	AdcStream_Reader Reader;
+	u32 Errors;		/* Samples accepted out of order */
+	u32 Sum;
+	pthread_t Thread;
+} AdcStream_BenchReader;
+
+static AdcStream BenchStream;
+static volatile int BenchStop;
+
+static void AdcStream_BenchSleep(u32 Us)
+{
+	struct timespec Ts;
+
+	Ts.tv_sec = Us / 1000000;
+	Ts.tv_nsec = (long)(Us % 1000000) * 1000;
+	nanosleep(&Ts, NULL);
+}
+
+/*
+ * Drains the stream in spans and checks that every sample it keeps is the
+ * one that follows the previous sample it kept or skipped
+ */
+static u32 AdcStream_BenchDrain(AdcStream_BenchReader *BrPtr)
+{
+	const AdcStream_Sample *Span;
+	u32 Count, Tail, Over, Index, LastBad, Total = 0;
+
+	while (1) {
+		Count = AdcStream_Peek(&BrPtr->Reader, &Span);
+		if (Count == 0)
+			break;
+		Tail = BrPtr->Reader.Tail;
+		LastBad = 0;
+		for (Index = 0; Index < Count; Index++) {
+			if (Span[Index].Seq != Tail + Index ||
+			    Span[Index].Channel !=
+			    (Tail + Index) % ADC_STREAM_BENCH_CHANNELS)
+				LastBad = Index + 1;
+			BrPtr->Sum += Span[Index].Code;
+		}
+		Over = AdcStream_Release(&BrPtr->Reader, Count);
+		if (LastBad > Over)
+			BrPtr->Errors++;
+		Total += Count;
+	}
+	return Total;
+}
+
+static void *AdcStream_BenchReaderThread(void *Arg)
+{
+	AdcStream_BenchReader *BrPtr = (AdcStream_BenchReader *)Arg;
+
+	while (!BenchStop) {
+		AdcStream_BenchSleep(BrPtr->IntervalUs);
+		AdcStream_BenchDrain(BrPtr);
+	}
+	return NULL;
+}
+
+/*****************************************************************************/
+/**
+* Host benchmark.
+*
+* First times AdcStream_Write() and a Peek/Release drain on one thread.
+* Then writes SamplesPerSec samples per second, in the pattern four
+* channels would produce, for ADC_STREAM_BENCH_MS while three reader
+* threads drain the stream every 50 us (motor), 1 ms (telemetry) and
+* 10 ms (display). For each reader it prints the samples per second it
+* kept, its overruns and lost samples, the most samples it found waiting
+* and the age of the oldest of them, and the number of spans in which it
+* accepted a sample out of order, which must be 0.
+*
+* @note		The host has no real ADC; the writer thread wakes every 20 us
+*		and writes the samples that fell due, stamped with the time each
+*		was due, so the lag includes the writer's own scheduling delay.
+*
+******************************************************************************/
+void AdcStream_Benchmark(u32 SamplesPerSec)
+{
+	static AdcStream_BenchReader Readers[ADC_STREAM_BENCH_READERS] = {
+		{ .Name = "motor",     .IntervalUs = 50 },
+		{ .Name = "telemetry", .IntervalUs = 1000 },
+		{ .Name = "display",   .IntervalUs = 10000 },
+	};
+	AdcStream_BenchReader *BrPtr;
+	AdcStream_Stats Stats;
+	u64 Start, Elapsed, Due, Written;
+	u32 Index, Count;
+
+	/* Single thread cost of the writer and of a drain */
+	AdcStream_Init(&BenchStream);
+	BrPtr = &Readers[0];
+	AdcStream_Attach(&BrPtr->Reader, &BenchStream);
+	Count = 2000000;
+	Start = now_ticks();
+	for (Index = 0; Index < Count; Index++)
+		AdcStream_Write(&BenchStream, Index, Index,
+				Index % ADC_STREAM_BENCH_CHANNELS, Index << 4);
+	Elapsed = now_ticks() - Start;
+	printf("adc_stream: write %.2f ns per sample\n",
+	       (double)Elapsed / Count);
+	Written = 0;
+	Start = now_ticks();
+	for (Index = 0; Index < Count; Index += ADC_STREAM_LEN / 2) {
+		BrPtr->Reader.Tail = Index;
+		Written += AdcStream_BenchDrain(BrPtr);
+	}
+	Elapsed = now_ticks() - Start;
+	printf("adc_stream: peek/release drain %.2f ns per sample, %u errors\n",
+	       (double)Elapsed / Written, BrPtr->Errors);
+
+	/* Threaded: one writer, three readers at different rates */
+	AdcStream_Init(&BenchStream);
+	BenchStop = FALSE;
+	for (Index = 0; Index < ADC_STREAM_BENCH_READERS; Index++) {
+		BrPtr = &Readers[Index];
+		BrPtr->Errors = 0;
+		AdcStream_Attach(&BrPtr->Reader, &BenchStream);
+		pthread_create(&BrPtr->Thread, NULL,
+			       AdcStream_BenchReaderThread, BrPtr);
+	}
+
+	Written = 0;
+	Start = now_ticks();
+	do {
+		AdcStream_BenchSleep(20);
+		Elapsed = now_ticks() - Start;
+		Due = Elapsed * SamplesPerSec / TIMEBASE_HZ;
+		while (Written < Due) {
+			AdcStream_Write(&BenchStream,
+					Start + Written * TIMEBASE_HZ /
+					SamplesPerSec, (u32)Written,
+					Written % ADC_STREAM_BENCH_CHANNELS,
+					(u16)(Written << 4));
+			Written++;
+		}
+	} while (Elapsed < us_to_ticks(ADC_STREAM_BENCH_MS * 1000));
+
+	BenchStop = TRUE;
+	for (Index = 0; Index < ADC_STREAM_BENCH_READERS; Index++)
+		pthread_join(Readers[Index].Thread, NULL);
+
+	printf("adc_stream: %u samples/s written for %u ms, ring %u samples\n",
+	       (u32)((double)Written * TIMEBASE_HZ / Elapsed),
+	       ADC_STREAM_BENCH_MS, ADC_STREAM_LEN);
+	for (Index = 0; Index < ADC_STREAM_BENCH_READERS; Index++) {
+		BrPtr = &Readers[Index];
+		AdcStream_GetStats(&BrPtr->Reader, &Stats);
+		printf("adc_stream:   %-9s every %5u us: %7.0f samples/s, "
+		       "%u overruns, %u lost, max lag %u samples / %.0f us, "
+		       "%u errors\n", BrPtr->Name, BrPtr->IntervalUs,
+		       (double)Stats.Samples * TIMEBASE_HZ / Elapsed,
+		       Stats.Overruns, Stats.Lost, Stats.MaxLag,
+		       ticks_to_us(Stats.MaxLagTicks) * 1.0, BrPtr->Errors);
+	}
+}
+#endif /* HOST_SIM */
@@ -0,0 +1,86 @@
+/*****************************************************************************/
+/**
+* @file adc_stream.h
+*
+* Continuous XADC sample stream.
+*
+* Every frame the acquisition publishes is split into timestamped
+* per-channel samples and appended to a ring by AdcStream_WriteFrame(),
+* normally from the XadcAcq callback in interrupt context. The writer never
+* waits for readers: it always overwrites the oldest samples.
+*
+* Any number of readers (motor control, display, telemetry) attach to a
+* stream, each with its own cursor. A reader gets the samples it has not
+* seen yet in place with AdcStream_Peek(), as one contiguous span of the
+* ring, and hands them back with AdcStream_Release(). If the writer lapped a
+* reader, Peek moves the cursor to the oldest sample still in the ring and
+* Release reports how many samples at the start of the span were
+* overwritten while the reader was using them; both are counted as lost in
+* the reader's statistics.
+*
+* There is one writer context. Each reader must be used from one context
+* only, but different readers may run in different contexts.
+*
+******************************************************************************/
+#ifndef ADC_STREAM_H
+#define ADC_STREAM_H
+
+#include "platform.h"
+#include "xadc_acq.h"
+
+/************************** Constant Definitions *****************************/
+
+#define ADC_STREAM_LEN		4096	/* Ring entries, power of two */
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u64 Stamp;		/* now_ticks() at the end of the sequence */
+	u32 Seq;		/* Sequence number of the frame */
+	u16 Code;		/* Left-aligned 16-bit ADC code */
+	u8 Channel;		/* XSysMon channel number */
+	u8 Reserved;
+} AdcStream_Sample;
+
+typedef struct {
+	AdcStream_Sample Ring[ADC_STREAM_LEN];
+	volatile u32 Head;	/* Samples written, written by the writer only */
+} AdcStream;
+
+typedef struct {
+	u32 Samples;		/* Samples released */
+	u32 Spans;		/* Non-empty spans returned by AdcStream_Peek() */
+	u32 Overruns;		/* Times the writer lapped the reader */
+	u32 Lost;		/* Samples overwritten before they were read */
+	u32 MaxLag;		/* Most samples waiting at a peek */
+	u64 MaxLagTicks;	/* Oldest waiting sample's age at a peek */
+} AdcStream_Stats;
+
+typedef struct {
+	AdcStream *StreamPtr;
+	u32 Tail;		/* Next sample to read */
+	u32 Peeked;		/* Length of the span handed out */
+	AdcStream_Stats Stats;
+} AdcStream_Reader;
+
+/************************** Function Prototypes ******************************/
+
+void AdcStream_Init(AdcStream *StreamPtr);
+void AdcStream_Write(AdcStream *StreamPtr, u64 Stamp, u32 Seq, u8 Channel,
+		     u16 Code);
+void AdcStream_WriteFrame(AdcStream *StreamPtr, const XadcAcq_Frame *FramePtr,
+			  u32 ChannelMask);
+
+void AdcStream_Attach(AdcStream_Reader *ReaderPtr, AdcStream *StreamPtr);
+u32 AdcStream_Available(const AdcStream_Reader *ReaderPtr);
+u32 AdcStream_Peek(AdcStream_Reader *ReaderPtr,
+		   const AdcStream_Sample **SpanPtr);
+u32 AdcStream_Release(AdcStream_Reader *ReaderPtr, u32 Count);
+void AdcStream_GetStats(const AdcStream_Reader *ReaderPtr,
+			AdcStream_Stats *StatsPtr);
+
+#ifdef HOST_SIM
+void AdcStream_Benchmark(u32 SamplesPerSec);
+#endif
+
+#endif /* ADC_STREAM_H */
@@ -0,0 +1,380 @@
+/*****************************************************************************/
+/**
+* @file amp.c
+*
+* Mailbox between the UI core and the control core. See amp.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#ifdef HOST_SIM
+#define _GNU_SOURCE		/* pthread_setaffinity_np() */
+#endif
+
+#include "amp.h"
+#include "timebase.h"
+#include <stdio.h>
+
+#ifdef HOST_SIM
+#include <pthread.h>
+#include <sched.h>
+#else
+#include "xil_io.h"
+#include "xil_mmu.h"
+#include "intr.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#ifndef HOST_SIM
+/*
+ * OCM section attributes: shareable, strongly ordered outer, non-cacheable
+ * (S=b1 TEX=b100 AP=b11, Domain=b1111, C=b0, B=b0)
+ */
+#define AMP_OCM_UNCACHED	0x14DE2
+
+#define AMP_CPU1_RELEASE_ADDR	0xFFFFFFF0	/* Polled by CPU1 in the boot ROM */
+#endif
+
+#ifdef HOST_SIM
+#define AMP_BENCH_PINGS		10000
+#endif
+
+/************************** Variable Definitions *****************************/
+
+#ifdef HOST_SIM
+static Amp_Mailbox HostMailbox;
+#else
+static XScuGic *SgiIntc;	/* This core's GIC, for the doorbell */
+#endif
+
+static Amp_Mailbox *Amp_Map(void)
+{
+#ifdef HOST_SIM
+	return &HostMailbox;
+#else
+	Xil_SetTlbAttributes(AMP_MAILBOX_ADDR, AMP_OCM_UNCACHED);
+	return (Amp_Mailbox *)AMP_MAILBOX_ADDR;
+#endif
+}
+
+/*****************************************************************************/
+/**
+* Empties both channels and publishes the mailbox. Called by CPU0 before it
+* starts CPU1.
+*
+* @return	The mailbox.
+*
+******************************************************************************/
+Amp_Mailbox *Amp_Init(void)
+{
+	Amp_Mailbox *MailboxPtr = Amp_Map();
+	u32 Cpu;
+
+	MailboxPtr->Magic = 0;
+	MailboxPtr->Ready = FALSE;
+	for (Cpu = 0; Cpu < AMP_CPU_COUNT; Cpu++) {
+		Event_QueueInit(&MailboxPtr->To[Cpu].Queue);
+		MailboxPtr->To[Cpu].Stats = (Amp_Stats){0};
+	}
+	MEMORY_BARRIER();
+	MailboxPtr->Magic = AMP_MAILBOX_MAGIC;
+	return MailboxPtr;
+}
+
+/*****************************************************************************/
+/**
+* Waits until CPU0 has published the mailbox. Called by CPU1.
+*
+* @return	The mailbox.
+*
+******************************************************************************/
+Amp_Mailbox *Amp_Attach(void)
+{
+	Amp_Mailbox *MailboxPtr = Amp_Map();
+
+	while (((volatile Amp_Mailbox *)MailboxPtr)->Magic != AMP_MAILBOX_MAGIC)
+		;
+	MEMORY_BARRIER();
+	return MailboxPtr;
+}
+
+/*****************************************************************************/
+/**
+* Tells CPU0 that CPU1 has its doorbell connected and takes messages.
+*
+******************************************************************************/
+void Amp_SetReady(Amp_Mailbox *MailboxPtr)
+{
+	MEMORY_BARRIER();
+	MailboxPtr->Ready = TRUE;
+}
+
+/*****************************************************************************/
+/**
+* Stamps a message, queues it for the other core and rings its doorbell.
+*
+* @param	MailboxPtr is the mailbox.
+* @param	ToCpu is the receiving core, AMP_CPU_UI or AMP_CPU_CONTROL.
+* @param	Type is one of AMP_MSG_*.
+* @param	Arg is the payload.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the channel was full and the
+*		message was dropped.
+*
+* @note		Main loop only: the channel has one producer per core.
+*
+******************************************************************************/
+int Amp_Send(Amp_Mailbox *MailboxPtr, u32 ToCpu, u16 Type, u32 Arg)
+{
+	Event Msg;
+
+	Msg.Stamp = now_ticks();
+	Msg.Type = Type;
+	Msg.Reserved = 0;
+	Msg.Arg = Arg;
+	if (Event_Push(&MailboxPtr->To[ToCpu].Queue, &Msg) != XST_SUCCESS)
+		return XST_FAILURE;
+
+#ifndef HOST_SIM
+	if (SgiIntc != NULL)
+		XScuGic_SoftwareIntr(SgiIntc, AMP_SGI_ID, 1U << ToCpu);
+#endif
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Takes the oldest message for this core and counts its latency.
+*
+* @param	MailboxPtr is the mailbox.
+* @param	Cpu is this core.
+* @param	EventPtr receives the message.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the channel was empty.
+*
+******************************************************************************/
+int Amp_Receive(Amp_Mailbox *MailboxPtr, u32 Cpu, Event *EventPtr)
+{
+	Amp_Channel *ChanPtr = &MailboxPtr->To[Cpu];
+	u32 Ticks;
+
+	if (Event_Pop(&ChanPtr->Queue, EventPtr) != XST_SUCCESS)
+		return XST_FAILURE;
+
+	Ticks = (u32)(now_ticks() - EventPtr->Stamp);
+	ChanPtr->Stats.Received++;
+	ChanPtr->Stats.TotalTicks += Ticks;
+	if (Ticks > ChanPtr->Stats.MaxTicks)
+		ChanPtr->Stats.MaxTicks = Ticks;
+	return XST_SUCCESS;
+}
+
+static u32 Amp_TicksToNs(u64 Ticks)
+{
+	return (u32)(Ticks * 1000000000ULL / TIMEBASE_HZ);
+}
+
+/*****************************************************************************/
+/**
+* Prints the messages, latencies and losses of both channels.
+*
+******************************************************************************/
+void Amp_Report(const Amp_Mailbox *MailboxPtr)
+{
+	static const char *const Name[AMP_CPU_COUNT] = { "ui", "control" };
+	const Amp_Channel *ChanPtr;
+	u32 Cpu;
+
+	for (Cpu = 0; Cpu < AMP_CPU_COUNT; Cpu++) {
+		ChanPtr = &MailboxPtr->To[Cpu];
+		printf("amp: to %-7s %8lu msgs, latency avg %6lu ns, max %6lu ns, "
+		       "%lu dropped, peak depth %lu, %lu doorbells\r\n", Name[Cpu],
+		       (unsigned long)ChanPtr->Stats.Received,
+		       (unsigned long)Amp_TicksToNs(ChanPtr->Stats.Received ?
+				ChanPtr->Stats.TotalTicks / ChanPtr->Stats.Received : 0),
+		       (unsigned long)Amp_TicksToNs(ChanPtr->Stats.MaxTicks),
+		       (unsigned long)ChanPtr->Queue.Dropped,
+		       (unsigned long)ChanPtr->Queue.PeakDepth,
+		       (unsigned long)ChanPtr->Stats.Doorbells);
+	}
+}
+
+#ifndef HOST_SIM
+/*
+ * Doorbell: hands the drain to the main loop. Runs in the UI tier, so on
+ * the control core it can be preempted by the XADC handler, which posts to
+ * the same event ring; Event_Post() masks the IRQ around each push.
+ */
+static void Amp_SgiHandler(void *CallBackRef)
+{
+	Amp_Channel *ChanPtr = CallBackRef;
+	u64 Start = now_ticks();
+
+	ChanPtr->Stats.Doorbells++;
+	Event_Post(EVENT_MAILBOX, 0);
+	Event_IsrDone(EVENT_MAILBOX, Start);
+}
+
+/*****************************************************************************/
+/**
+* Connects this core's doorbell in the UI tier of the interrupt manager on
+* both cores: the handler only posts an event, and on the control core the
+* XADC interrupt must not wait for it. Messages for Cpu then post
+* EVENT_MAILBOX; its handler should drain the channel with Amp_Receive().
+*
+* @param	MailboxPtr is the mailbox.
+* @param	IntcPtr is this core's GIC driver instance, passed to
+*		Intr_Init().
+* @param	Cpu is this core.
+*
+* @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+*
+******************************************************************************/
+int Amp_SetupSgi(Amp_Mailbox *MailboxPtr, XScuGic *IntcPtr, u32 Cpu)
+{
+	if (Intr_Init(IntcPtr) != XST_SUCCESS ||
+	    Intr_Connect(AMP_SGI_ID, INTR_TIER_UI, INTR_TRIGGER_KEEP,
+			 Amp_SgiHandler, &MailboxPtr->To[Cpu]) != XST_SUCCESS)
+		return XST_FAILURE;
+	SgiIntc = IntcPtr;
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Releases CPU1 from the boot ROM wait loop to Entry, the start of the
+* control application.
+*
+******************************************************************************/
+void Amp_StartCpu1(u32 Entry)
+{
+	Xil_Out32(AMP_CPU1_RELEASE_ADDR, Entry);
+	MEMORY_BARRIER();
+	__asm__ __volatile__("sev");
+}
+#else /* HOST_SIM */
+/*
+ * Host benchmark: the control half echoes pings and checks the order of
+ * the data stream
+ */
+static volatile int BenchStop;
+static volatile u32 BenchData;		/* Data messages received in order */
+static volatile u32 BenchDisorder;
+
+static int Amp_Pin(pthread_t Thread, int Cpu)
+{
+	cpu_set_t Set;
+
+	CPU_ZERO(&Set);
+	CPU_SET(Cpu, &Set);
+	return pthread_setaffinity_np(Thread, sizeof(Set), &Set) == 0;
+}
+
+static void *Amp_BenchControl(void *Param)
+{
+	Amp_Mailbox *MailboxPtr = Param;
+	Event Msg;
+
+	Amp_SetReady(MailboxPtr);
+	while (!BenchStop) {
+		if (Amp_Receive(MailboxPtr, AMP_CPU_CONTROL, &Msg) != XST_SUCCESS) {
+			sched_yield();
+			continue;
+		}
+		if (Msg.Type == AMP_MSG_PING) {
+			while (Amp_Send(MailboxPtr, AMP_CPU_UI, AMP_MSG_PONG,
+					Msg.Arg) != XST_SUCCESS)
+				sched_yield();
+		} else if (Msg.Type == AMP_MSG_DATA) {
+			if (Msg.Arg != BenchData)
+				BenchDisorder++;
+			BenchData = BenchData + 1;
+		}
+	}
+	return NULL;
+}
+
+/*****************************************************************************/
+/**
+* Host benchmark. Runs the control half in a thread pinned to CPU1 and the
+* UI half in this thread pinned to CPU0, over the mailbox code:
+* - AMP_BENCH_PINGS ping-pong round trips, for the one-way latency of each
+*   channel and the round trip;
+* - Count data messages streamed from the UI to the control half as fast as
+*   the channel takes them (a full channel is retried and counted as a drop),
+*   for the throughput.
+* Checks that every ping was answered with its own number and that the
+* stream arrived complete and in order. Both halves yield when they cannot
+* make progress, so the test also runs on a host with one CPU, unpinned.
+*
+******************************************************************************/
+void Amp_Benchmark(u32 Count)
+{
+	Amp_Mailbox *MailboxPtr;
+	pthread_t Control;
+	Event Msg;
+	u64 Start, Ticks, MaxRound = 0, TotalRound = 0, Elapsed;
+	u32 i, Fail = 0;
+	int Pinned;
+
+	MailboxPtr = Amp_Init();
+	BenchStop = FALSE;
+	BenchData = 0;
+	BenchDisorder = 0;
+	Pinned = Amp_Pin(pthread_self(), AMP_CPU_UI);
+	pthread_create(&Control, NULL, Amp_BenchControl, MailboxPtr);
+	Pinned &= Amp_Pin(Control, AMP_CPU_CONTROL);
+	while (!MailboxPtr->Ready)
+		sched_yield();
+	printf("amp: halves %s\n", Pinned ? "pinned to CPU0 and CPU1" :
+	       "not pinned, fewer than two CPUs available");
+
+	for (i = 0; i < AMP_BENCH_PINGS; i++) {
+		Start = now_ticks();
+		Amp_Send(MailboxPtr, AMP_CPU_CONTROL, AMP_MSG_PING, i);
+		while (Amp_Receive(MailboxPtr, AMP_CPU_UI, &Msg) != XST_SUCCESS)
+			sched_yield();
+		Ticks = now_ticks() - Start;
+		TotalRound += Ticks;
+		if (Ticks > MaxRound)
+			MaxRound = Ticks;
+		if (Msg.Type != AMP_MSG_PONG || Msg.Arg != i)
+			Fail |= 1;
+	}
+	printf("amp: %u round trips, avg %lu ns, max %lu ns\n", AMP_BENCH_PINGS,
+	       (unsigned long)Amp_TicksToNs(TotalRound / AMP_BENCH_PINGS),
+	       (unsigned long)Amp_TicksToNs(MaxRound));
+	Amp_Report(MailboxPtr);
+
+	/* The control half is idle between the phases */
+	MailboxPtr->To[AMP_CPU_CONTROL].Stats = (Amp_Stats){0};
+	MailboxPtr->To[AMP_CPU_CONTROL].Queue.Dropped = 0;
+	MailboxPtr->To[AMP_CPU_CONTROL].Queue.PeakDepth = 0;
+	Start = now_ticks();
+	for (i = 0; i < Count; i++) {
+		while (Amp_Send(MailboxPtr, AMP_CPU_CONTROL, AMP_MSG_DATA, i)
+		       != XST_SUCCESS)
+			sched_yield();
+	}
+	while (BenchData != Count)
+		sched_yield();
+	Elapsed = now_ticks() - Start;
+	BenchStop = TRUE;
+	pthread_join(Control, NULL);
+
+	printf("amp: %u messages streamed in %.3f ms, %.2f M msgs/s, "
+	       "%u full channel retries\n", Count,
+	       Elapsed * 1e3 / TIMEBASE_HZ, Count * (double)TIMEBASE_HZ /
+	       Elapsed / 1e6, MailboxPtr->To[AMP_CPU_CONTROL].Queue.Dropped);
+	Amp_Report(MailboxPtr);
+
+	if (BenchDisorder != 0)
+		Fail |= 2;
+	if (MailboxPtr->To[AMP_CPU_CONTROL].Stats.Received != Count ||
+	    MailboxPtr->To[AMP_CPU_UI].Stats.Received != AMP_BENCH_PINGS)
+		Fail |= 4;
+	printf("amp: checks %s (0x%x)\n", Fail ? "FAIL" : "ok", Fail);
+}
+#endif /* HOST_SIM */
@@ -0,0 +1,110 @@
+/*****************************************************************************/
+/**
+* @file amp.h
+*
+* Asymmetric multiprocessing mailbox between the two Cortex-A9 cores.
+*
+* In the AMP build CPU1 runs the control application (amp_control.c), which
+* owns the XADC acquisition, the pipeline and the PWM, and CPU0 runs main.c
+* and app.c built with AMP defined, which own the buttons, the LCD and the
+* UART. The cores share nothing but the mailbox at AMP_MAILBOX_ADDR in
+* on-chip memory, mapped uncached on both cores.
+*
+* The mailbox holds one channel per direction. Each channel is an
+* Event_Queue, the single-producer/single-consumer ring behind
+* Event_Post(); its barriers order the copy against the index on the other
+* core as they do against an interrupt handler. The producer of a channel
+* is the sending core's main loop, so Amp_Send() must not be called from
+* an interrupt handler. After a push the
+* sender raises software generated interrupt AMP_SGI_ID on the receiving
+* core, which wakes it from Idle_Wait() and posts EVENT_MAILBOX to its main
+* loop, where Amp_Receive() drains the channel.
+*
+* Messages are stamped by the sender on the global timer, which both cores
+* read, so the receiver counts the cross-core latency of each message in
+* the channel statistics. Each statistics block is written only by the
+* receiving core and can be read by either.
+*
+* On the host the two halves run as threads, pinned to two CPUs when the
+* host has them, over the same channel code (Amp_Benchmark()).
+*
+******************************************************************************/
+#ifndef AMP_H
+#define AMP_H
+
+#include "platform.h"
+#include "event_queue.h"
+
+#ifndef HOST_SIM
+#include "xscugic.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define AMP_CPU_UI		0	/* Buttons, LCD, UART */
+#define AMP_CPU_CONTROL		1	/* XADC, pipeline, PWM */
+#define AMP_CPU_COUNT		2
+
+#define AMP_MAILBOX_ADDR	0xFFFF0000	/* High OCM, last 64 KB */
+#define AMP_MAILBOX_MAGIC	0x31504D41	/* "AMP1" */
+#define AMP_SGI_ID		15		/* Mailbox doorbell */
+
+#ifndef AMP_CPU1_START_ADDR
+#define AMP_CPU1_START_ADDR	0x02000000	/* amp_control.c link address */
+#endif
+
+/*
+ * Message types, in Event.Type
+ */
+#define AMP_MSG_SELECT		0	/* UI to control, Arg: AMP_SELECT() */
+#define AMP_MSG_VOLTS		1	/* Control to UI, Arg: Fixed_Q16 input */
+#define AMP_MSG_DUTY		2	/* Control to UI, Arg: motor permille */
+#define AMP_MSG_PING		3	/* Either way, echoed as AMP_MSG_PONG */
+#define AMP_MSG_PONG		4
+#define AMP_MSG_DATA		5	/* Throughput test payload */
+#define AMP_MSG_TYPE_COUNT	6
+
+#define AMP_SELECT(Source, Enabled)	(((Source) & 0xFF) | ((Enabled) ? 0x100 : 0))
+#define AMP_SELECT_SOURCE(Arg)		((Arg) & 0xFF)
+#define AMP_SELECT_ENABLED(Arg)		(((Arg) & 0x100) != 0)
+
+/**************************** Type Definitions *******************************/
+
+/*
+ * Receive side statistics of a channel, latencies in time base ticks
+ */
+typedef struct {
+	u32 Received;
+	u32 Doorbells;		/* SGIs taken */
+	u32 MaxTicks;
+	u64 TotalTicks;
+} Amp_Stats;
+
+typedef struct {
+	Event_Queue Queue;
+	Amp_Stats Stats;	/* Written by the receiver only */
+} Amp_Channel;
+
+typedef struct {
+	u32 Magic;		/* Set by CPU0 once the channels are empty */
+	volatile u32 Ready;	/* Set by CPU1 once it takes messages */
+	Amp_Channel To[AMP_CPU_COUNT];	/* Indexed by receiving CPU */
+} Amp_Mailbox;
+
+/************************** Function Prototypes ******************************/
+
+Amp_Mailbox *Amp_Init(void);
+Amp_Mailbox *Amp_Attach(void);
+void Amp_SetReady(Amp_Mailbox *MailboxPtr);
+int Amp_Send(Amp_Mailbox *MailboxPtr, u32 ToCpu, u16 Type, u32 Arg);
+int Amp_Receive(Amp_Mailbox *MailboxPtr, u32 Cpu, Event *EventPtr);
+void Amp_Report(const Amp_Mailbox *MailboxPtr);
+
+#ifndef HOST_SIM
+int Amp_SetupSgi(Amp_Mailbox *MailboxPtr, XScuGic *IntcPtr, u32 Cpu);
+void Amp_StartCpu1(u32 Entry);
+#else
+void Amp_Benchmark(u32 Count);
+#endif
+
+#endif /* AMP_H */
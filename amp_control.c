@@ -0,0 +1,185 @@
+/*****************************************************************************/
+/**
+* @file amp_control.c
+*
+* Control application for CPU1 in the AMP build (see amp.h).
+*
+* CPU1 owns the latency-critical half of the firmware: the XADC end of
+* sequence interrupt, the pipeline and the motor and buzzer PWM. It takes
+* source and state changes from the UI core (main.c and app.c built with
+* AMP) and sends the live input and motor duty back at AMP_CONTROL_LIVE_HZ.
+* It has no UART; its timing is reported by the UI core from the mailbox.
+*
+* Build it as a separate standalone application for ps7_cortexa9_1 with
+* USE_AMP=1 in its BSP, so the GIC distributor is left to CPU0, linked at
+* AMP_CPU1_START_ADDR in a DDR range the CPU0 application does not use.
+* CPU0 loads both and releases CPU1 with Amp_StartCpu1().
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xparameters.h"
+#include "xscugic.h"
+#include "xtmrctr.h"
+#include "amp.h"
+#include "timebase.h"
+#include "event_queue.h"
+#include "idle.h"
+#include "scheduler.h"
+#include "xadc_acq.h"
+#include "pwm_update.h"
+#include "pipeline.h"
+#include "hal.h"
+#include "intr.h"
+
+/************************** Constant Definitions *****************************/
+
+#define XADC_DEVICE_ID		XPAR_XADC_WIZ_0_DEVICE_ID
+#define XADC_INTERRUPT_ID	XPAR_FABRIC_XADC_WIZ_0_IP2INTC_IRPT_INTR
+#define BUZZER_DEVICE_ID	XPAR_TMRCTR_0_DEVICE_ID
+
+#define AMP_CONTROL_LIVE_HZ	10	/* Live values to the UI core */
+
+/************************** Variable Definitions *****************************/
+
+static XScuGic Intc;
+static XSysMon Xadc;
+static XadcAcq XadcIn;		/* Potentiometer and photoresistor frames */
+static XTmrCtr Buzzer;		/* AXI timer PWM */
+static PwmUpdate PwmOut;
+static Pipeline Pipe;		/* Selected input to motor and buzzer PWM */
+static Amp_Mailbox *Mailbox;
+static Sched Tasks;
+
+/*
+ * XADC end of sequence, in interrupt context: posts the frame to the loop.
+ * It preempts the doorbell handler, which posts to the same event ring;
+ * Event_Post() keeps the two pushes apart.
+ */
+static void Control_EosHandler(XadcAcq *AcqPtr, u32 Seq)
+{
+	Event_Post(EVENT_XADC_EOS, Seq);
+	Event_IsrDone(EVENT_XADC_EOS, AcqPtr->Buf[AcqPtr->Front].Stamp);
+}
+
+static void Control_AdcEvent(const Event *EventPtr)
+{
+	(void)EventPtr;
+	Pipeline_Update(&Pipe);
+}
+
+/*
+ * Doorbell bottom half: applies the UI core's messages. A selection is
+ * timed from the UI core's stamp, on the global timer both cores read.
+ */
+static void Control_MailboxEvent(const Event *EventPtr)
+{
+	Event Msg;
+
+	(void)EventPtr;
+	while (Amp_Receive(Mailbox, AMP_CPU_CONTROL, &Msg) == XST_SUCCESS) {
+		switch (Msg.Type) {
+		case AMP_MSG_SELECT:
+			Pipeline_Select(&Pipe, AMP_SELECT_SOURCE(Msg.Arg),
+					AMP_SELECT_ENABLED(Msg.Arg), Msg.Stamp);
+			break;
+		case AMP_MSG_PING:
+			Amp_Send(Mailbox, AMP_CPU_UI, AMP_MSG_PONG, Msg.Arg);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/*
+ * 500 Hz: makes sure the newest frame has been applied
+ */
+static void Control_Task(void)
+{
+	Pipeline_Update(&Pipe);
+}
+
+/*
+ * AMP_CONTROL_LIVE_HZ: sends the live values for the LCD and the UART
+ */
+static void Control_LiveTask(void)
+{
+	Amp_Send(Mailbox, AMP_CPU_UI, AMP_MSG_VOLTS, (u32)Pipe.Volts);
+	Amp_Send(Mailbox, AMP_CPU_UI, AMP_MSG_DUTY,
+		 PwmOut.MotorDuty / PWM_UPDATE_MOTOR_QUANTUM);
+}
+
+/*
+ * Connects the XADC interrupt, routed to this core only, and the doorbell
+ * through the interrupt manager, which enables interrupts. CPU0 has
+ * already initialized the distributor.
+ */
+static int Control_IntrSetup(void)
+{
+	if (Intr_Init(&Intc) != XST_SUCCESS)
+		return XST_FAILURE;
+
+	if (XadcAcq_SetupIntr(&XadcIn, &Intc, XADC_INTERRUPT_ID) != XST_SUCCESS)
+		return XST_FAILURE;
+	XScuGic_InterruptUnmapFromCpu(&Intc, AMP_CPU_UI, XADC_INTERRUPT_ID);
+	XScuGic_InterruptMaptoCpu(&Intc, AMP_CPU_CONTROL, XADC_INTERRUPT_ID);
+
+	if (Amp_SetupSgi(Mailbox, &Intc, AMP_CPU_CONTROL) != XST_SUCCESS)
+		return XST_FAILURE;
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* CPU1 entry. Waits for the mailbox, sets up the acquisition and the PWM,
+* tells CPU0 it is ready and runs the control loop. The XADC end of
+* sequence interrupts, several per scheduler tick, wake the loop for the
+* task releases.
+*
+* @return	XST_FAILURE if the setup failed; CPU0 then reports that the
+*		control core is not ready.
+*
+******************************************************************************/
+int main(void)
+{
+	timebase_init();
+	Mailbox = Amp_Attach();
+
+	Event_Init();
+	Idle_Init();
+	Event_Register(EVENT_XADC_EOS, Control_AdcEvent);
+	Event_Register(EVENT_MAILBOX, Control_MailboxEvent);
+
+	if (XTmrCtr_Initialize(&Buzzer, BUZZER_DEVICE_ID) != XST_SUCCESS)
+		return XST_FAILURE;
+	if (PwmUpdate_Init(&PwmOut, &Buzzer, HAL_PWM_BASEADDR, 0) != XST_SUCCESS)
+		return XST_FAILURE;
+	if (Pipeline_XadcSetup(&Xadc, XADC_DEVICE_ID) != XST_SUCCESS)
+		return XST_FAILURE;
+	XadcAcq_Init(&XadcIn, &Xadc, Pipeline_Mask(), XADC_ACQ_MODE_INTR);
+	XadcAcq_SetCallback(&XadcIn, Control_EosHandler);
+	Pipeline_Init(&Pipe, &XadcIn, &PwmOut);
+	Pipeline_Select(&Pipe, PIPELINE_LIGHT, FALSE, now_ticks());
+
+	Sched_Init(&Tasks);
+	Sched_Add(&Tasks, "control", Control_Task, SCHED_HZ(500), 0,
+		  SCHED_NO_DEADLINE);
+	Sched_Add(&Tasks, "live", Control_LiveTask,
+		  SCHED_HZ(AMP_CONTROL_LIVE_HZ), 3, SCHED_NO_DEADLINE);
+
+	if (Control_IntrSetup() != XST_SUCCESS)
+		return XST_FAILURE;
+	Amp_SetReady(Mailbox);
+
+	Sched_Start(&Tasks);
+	while (1) {
+		u64 Next;
+
+		Event_Dispatch();
+		Next = Sched_Run(&Tasks);
+		Idle_Wait(Next);
+	}
+	return XST_SUCCESS;
+}
@@ -0,0 +1,940 @@
+/*****************************************************************************/
+/**
+* @file app.c
+*
+* The application of the UI core. See app.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "app.h"
+#include "timebase.h"
+#include "lcd_async.h"
+#include "lcd_ui.h"
+#include "idle.h"
+#include "hal.h"
+#include "bench.h"
+#include "trace.h"
+#include "dlog.h"
+#include "numfmt.h"
+#include "intr.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#else
+#include "xil_printf.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define REPORT_PERIOD		(10 * SCHED_HZ(1))	/* Latency, load and schedule printout */
+
+#ifdef HOST_SIM
+#define APP_CPU_CLK_HZ		HWSIM_CPU_CLK_HZ
+#else
+#define APP_CPU_CLK_HZ		XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ
+#endif
+
+/* Private timer and watchdog run at half the CPU clock */
+#define APP_SCU_CLK_MHZ		(APP_CPU_CLK_HZ / 2 / 1000000)
+#define TICK_TIMER_LOAD_VALUE	(APP_SCU_CLK_MHZ * SCHED_TICK_US - 1)
+#define LCD_TIMER_LOAD_VALUE	(APP_SCU_CLK_MHZ * LCD_ASYNC_TICK_US - 1)
+
+#ifdef HOST_SIM
+#define XGPIO_GIE_OFFSET	0x11C	/* AXI GPIO registers */
+#define XGPIO_ISR_OFFSET	0x120
+#define XGPIO_IER_OFFSET	0x128
+#define XGPIO_GIE_GINTR_ENABLE_MASK	0x80000000
+
+#define XSCUWDT_CONTROL_AUTO_RELOAD_MASK	0x2
+#define XSCUWDT_CONTROL_IT_ENABLE_MASK		0x4
+#define XSCUWDT_ISR_OFFSET			0x0C
+#define XSCUWDT_ISR_EVENT_FLAG_MASK		0x1
+#endif
+
+/************************** Variable Definitions *****************************/
+
+XGpio Gpio;
+INTC Intc;
+XScuTimer TickTimer;
+XScuWdt LcdTimer;
+XTmrCtr TimerCounterInst;
+Sched Tasks;
+
+volatile u32 *baseaddr_lcd = HAL_LCD_BASEADDR; //lcd base address pointer
+volatile u32 *baseaddr_gpio = HAL_GPIO_BASEADDR; //axi gpio pmod base address pointer
+volatile u32 *baseaddr_pwm = HAL_PWM_BASEADDR; //pwm baseaddr
+volatile u32 IntrFlag; /* Interrupt Handler Flag */
+
+int state = 0;
+int analog_source = 1;
+
+#ifdef AMP
+Amp_Mailbox *Mailbox;
+Fixed_Q16 LiveVolts;
+u32 LivePermille;
+#else
+PwmUpdate PwmOut;
+XSysMon Xadc;
+XadcAcq XadcIn;
+Pipeline Pipe;
+#endif
+
+static u16 GlobalIntrMask; /* GPIO channel mask that is needed by
+			    * the Interrupt Handler */
+
+static ButtonFsm Buttons;	/* Decodes buttons into state and analog_source */
+
+#ifdef HOST_SIM
+/*
+ * Simulated AXI GPIO, private timer and private watchdog, see hw_sim.h.
+ * The timers stand in for the counters and raise their interrupt every
+ * load value + 1 counts.
+ */
+static XScuTimer_Config ScuTimerConfig = { 0, 0, HWSIM_IRQ_SCUTIMER };
+static XScuWdt_Config ScuWdtConfig = { 0, 0, HWSIM_IRQ_SCUWDT };
+
+static void XGpio_WriteReg(u32 Offset, u32 Value)
+{
+	HAL_WRITE(&HAL_GPIO_BASEADDR[Offset / 4], Value);
+}
+
+static void XGpio_InterruptEnable(XGpio *InstancePtr, u32 Mask)
+{
+	(void)InstancePtr;
+	XGpio_WriteReg(XGPIO_IER_OFFSET, Mask);
+}
+
+static void XGpio_InterruptDisable(XGpio *InstancePtr, u32 Mask)
+{
+	(void)InstancePtr;
+	(void)Mask;
+	XGpio_WriteReg(XGPIO_IER_OFFSET, 0);
+}
+
+static void XGpio_InterruptGlobalEnable(XGpio *InstancePtr)
+{
+	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+	XGpio_WriteReg(XGPIO_GIE_OFFSET, XGPIO_GIE_GINTR_ENABLE_MASK);
+}
+
+static void XGpio_InterruptClear(XGpio *InstancePtr, u32 Mask)
+{
+	(void)InstancePtr;
+	XGpio_WriteReg(XGPIO_ISR_OFFSET, Mask);
+}
+
+static XScuTimer_Config *XScuTimer_LookupConfig(u16 DeviceId)
+{
+	return DeviceId == 0 ? &ScuTimerConfig : NULL;
+}
+
+static int XScuTimer_CfgInitialize(XScuTimer *TimerPtr,
+				   XScuTimer_Config *ConfigPtr, u32 BaseAddr)
+{
+	*TimerPtr = (XScuTimer){0};
+	TimerPtr->Config = *ConfigPtr;
+	TimerPtr->Config.BaseAddr = BaseAddr;
+	TimerPtr->IsReady = XIL_COMPONENT_IS_READY;
+	return XST_SUCCESS;
+}
+
+static void XScuTimer_LoadTimer(XScuTimer *TimerPtr, u32 Value)
+{
+	TimerPtr->Load = Value;
+	if (!TimerPtr->Loaded &&
+	    HwSim_TimerStart(TimerPtr->Config.IntrId,
+			     (Value + 1) / APP_SCU_CLK_MHZ) == XST_SUCCESS) {
+		HwSim_TimerRun(TimerPtr->Config.IntrId, FALSE);
+		TimerPtr->Loaded = TRUE;
+	}
+}
+
+static void XScuTimer_Start(XScuTimer *TimerPtr)
+{
+	HwSim_TimerRun(TimerPtr->Config.IntrId, TRUE);
+}
+
+static void XScuTimer_Stop(XScuTimer *TimerPtr)
+{
+	HwSim_TimerRun(TimerPtr->Config.IntrId, FALSE);
+}
+
+/* The simulated timers always reload and raise their interrupt */
+#define XScuTimer_EnableAutoReload(TimerPtr)	((void)(TimerPtr))
+#define XScuTimer_EnableInterrupt(TimerPtr)	((void)(TimerPtr))
+#define XScuTimer_ClearInterruptStatus(TimerPtr)	((void)(TimerPtr))
+
+static XScuWdt_Config *XScuWdt_LookupConfig(u16 DeviceId)
+{
+	return DeviceId == 0 ? &ScuWdtConfig : NULL;
+}
+
+#define XScuWdt_CfgInitialize		XScuTimer_CfgInitialize
+#define XScuWdt_LoadWdt			XScuTimer_LoadTimer
+#define XScuWdt_Start			XScuTimer_Start
+#define XScuWdt_Stop			XScuTimer_Stop
+#define XScuWdt_SetTimerMode(WdtPtr)	((void)(WdtPtr))
+#define XScuWdt_GetControlReg(WdtPtr)	((void)(WdtPtr), 0U)
+#define XScuWdt_SetControlReg(WdtPtr, Value)	((void)(WdtPtr), (void)(Value))
+#define XScuWdt_WriteReg(BaseAddr, Offset, Value) \
+	((void)(BaseAddr), (void)(Offset), (void)(Value))
+
+static void print(const char *Ptr)
+{
+	fputs(Ptr, stdout);
+}
+#endif /* HOST_SIM */
+
+/*****************************************************************************/
+/**
+* Sets up the event handlers and the scheduler tasks. Call before any
+* interrupt that posts events is enabled.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void App_Init(void)
+{
+	/* Interrupt handlers post events, the main loop runs their handlers */
+	Event_Init();
+	Idle_Init();
+	ButtonFsm_Init(&Buttons);
+	Event_Register(EVENT_BUTTON, ButtonEventHandler);
+#ifdef AMP
+	Event_Register(EVENT_MAILBOX, MailboxEventHandler);
+#else
+	Event_Register(EVENT_XADC_EOS, AdcEventHandler);
+#endif
+
+	/*
+	 * Fixed-rate work, fastest first. The phases keep the slower tasks off
+	 * the ticks the faster ones start on.
+	 */
+	Sched_Init(&Tasks);
+#ifndef AMP
+	Sched_Add(&Tasks, "control", ControlTask, SCHED_HZ(500), 0,
+		  SCHED_NO_DEADLINE);
+#endif
+	Sched_Add(&Tasks, "buttons", ButtonEventPoll, SCHED_HZ(100), 1,
+		  SCHED_NO_DEADLINE);
+	Sched_Add(&Tasks, "lcd", LcdTask, SCHED_HZ(10), 3, SCHED_NO_DEADLINE);
+	Sched_Add(&Tasks, "report", ReportTask, REPORT_PERIOD, 7,
+		  SCHED_NO_DEADLINE);
+}
+
+#ifndef AMP
+/*****************************************************************************/
+/**
+* Connects the buzzer timer, the XADC acquisition and the motor PWM through
+* the pipeline and selects the input analog_source names. The buzzer timer
+* and the XADC must have been initialized.
+*
+* @param	None.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the PWM could not be set up.
+*
+* @note		None.
+*
+******************************************************************************/
+int App_ControlInit(void)
+{
+	int Status;
+
+	/* The buzzer runs on the AXI timer in PWM mode, set by PwmUpdate */
+	Status = PwmUpdate_Init(&PwmOut, &TimerCounterInst, baseaddr_pwm, 0);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	/* Both inputs are converted in every sequence, analog_source picks */
+	XadcAcq_Init(&XadcIn, &Xadc, Pipeline_Mask(), XADC_ACQ_MODE_INTR);
+	XadcAcq_SetCallback(&XadcIn, XadcEosHandler);
+	Pipeline_Init(&Pipe, &XadcIn, &PwmOut);
+	Pipeline_Select(&Pipe, analog_source, state == 1, now_ticks());
+
+	return XST_SUCCESS;
+}
+#endif
+
+/*****************************************************************************/
+/**
+* Queues the LCD reset sequence and the status screen. The LCD timer clocks
+* them out once LcdTimerSetupIntrSystem() has connected it.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void App_LcdInit(void)
+{
+	LcdAsync_Init(baseaddr_lcd + 1);
+	LCD_Setup();
+	lcd_output(state, analog_source);
+}
+
+/*****************************************************************************/
+/**
+* One pass of the main loop work: the bottom halves of the events the
+* interrupt handlers have posted, then the scheduler tasks that are due.
+*
+* @param	None.
+*
+* @return	When the next task is due, for Idle_Wait().
+*
+* @note		None.
+*
+******************************************************************************/
+u64 App_Run(void)
+{
+	Event_Dispatch();
+	return Sched_Run(&Tasks);
+}
+
+/******************************************************************************/
+/**
+*
+* This function performs the GPIO set up for Interrupts
+*
+* @param	IntcInstancePtr is a reference to the Interrupt Controller
+*		driver Instance
+* @param	InstancePtr is a reference to the GPIO driver Instance
+* @param	DeviceId is the XPAR_<GPIO_instance>_DEVICE_ID value from
+*		xparameters.h
+* @param	IntrId is XPAR_<INTC_instance>_<GPIO_instance>_IP2INTC_IRPT_INTR
+*		value from xparameters.h
+* @param	IntrMask is the GPIO channel mask
+*
+* @return	XST_SUCCESS if the Test is successful, otherwise XST_FAILURE
+*
+* @note		None.
+*
+******************************************************************************/
+int GpioSetupIntrSystem(INTC *IntcInstancePtr, XGpio *InstancePtr,
+			u16 DeviceId, u16 IntrId, u16 IntrMask)
+{
+	int Result;
+
+	(void)DeviceId;
+	GlobalIntrMask = IntrMask;
+
+#ifdef XPAR_INTC_0_DEVICE_ID
+
+#ifndef TESTAPP_GEN
+	/*
+	 * Initialize the interrupt controller driver so that it's ready to use.
+	 * specify the device ID that was generated in xparameters.h
+	 */
+	Result = XIntc_Initialize(IntcInstancePtr, INTC_DEVICE_ID);
+	if (Result != XST_SUCCESS) {
+		return Result;
+	}
+#endif /* TESTAPP_GEN */
+
+	/* Hook up interrupt service routine */
+	XIntc_Connect(IntcInstancePtr, IntrId,
+		      (Xil_ExceptionHandler)GpioHandler, InstancePtr);
+
+	/* Enable the interrupt vector at the interrupt controller */
+	XIntc_Enable(IntcInstancePtr, IntrId);
+
+#ifndef TESTAPP_GEN
+	/*
+	 * Start the interrupt controller such that interrupts are recognized
+	 * and handled by the processor
+	 */
+	Result = XIntc_Start(IntcInstancePtr, XIN_REAL_MODE);
+	if (Result != XST_SUCCESS) {
+		return Result;
+	}
+#endif /* TESTAPP_GEN */
+
+#else /* !XPAR_INTC_0_DEVICE_ID */
+
+	/*
+	 * The interrupt manager initializes the GIC and the exception table
+	 * the first time it is called. The buttons are the UI tier, which
+	 * the control and acquisition interrupts preempt.
+	 */
+	Result = Intr_Init(IntcInstancePtr);
+	if (Result != XST_SUCCESS) {
+		return Result;
+	}
+
+	Result = Intr_Connect(IntrId, INTR_TIER_UI, INTR_TRIGGER_EDGE,
+			      GpioHandler, InstancePtr);
+	if (Result != XST_SUCCESS) {
+		return Result;
+	}
+#endif /* XPAR_INTC_0_DEVICE_ID */
+
+	/*
+	 * Enable the GPIO channel interrupts so that push button can be
+	 * detected and enable interrupts for the GPIO device
+	 */
+	XGpio_InterruptEnable(InstancePtr, IntrMask);
+	XGpio_InterruptGlobalEnable(InstancePtr);
+
+#ifdef XPAR_INTC_0_DEVICE_ID
+	/*
+	 * Initialize the exception table and register the interrupt
+	 * controller handler with the exception table
+	 */
+	Xil_ExceptionInit();
+
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+			 (Xil_ExceptionHandler)INTC_HANDLER, IntcInstancePtr);
+
+	/* Enable non-critical exceptions */
+	Xil_ExceptionEnable();
+#endif
+
+	return XST_SUCCESS;
+}
+
+/******************************************************************************/
+/**
+*
+* This is the interrupt handler routine for the GPIO for this example. It
+* only reads the buttons and posts them to the main loop, which runs
+* ButtonEventHandler.
+*
+* @param	CallbackRef is the Callback reference for the handler.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void GpioHandler(void *CallbackRef)
+{
+	BENCH_START(Cycles);
+	XGpio *GpioPtr = (XGpio *)CallbackRef;
+	u64 Start = now_ticks();
+
+	TRACE_ISR_ENTER(APP_GPIO_INTR_ID);
+	IntrFlag = 1;
+	Event_Post(EVENT_BUTTON, HAL_READ(baseaddr_gpio));
+
+	/* Clear the Interrupt */
+	XGpio_InterruptClear(GpioPtr, GlobalIntrMask);
+
+	Event_IsrDone(EVENT_BUTTON, Start);
+	TRACE_ISR_EXIT(APP_GPIO_INTR_ID);
+	BENCH_STOP(BENCH_GPIO_HANDLER, Cycles);
+}
+
+/******************************************************************************/
+/**
+*
+* Copies the button state machine into state and analog_source and, if the
+* inputs just run changed them, switches the pipeline over and redraws the
+* LCD.
+*
+* @param	Stamp is when the inputs were read.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+static void ButtonApply(u64 Stamp)
+{
+	if (state == Buttons.State && analog_source == Buttons.Source)
+		return;
+
+	state = Buttons.State;
+	analog_source = Buttons.Source;
+#ifdef AMP
+	Amp_Send(Mailbox, AMP_CPU_CONTROL, AMP_MSG_SELECT,
+		 AMP_SELECT(analog_source, state == 1));
+#else
+	Pipeline_Select(&Pipe, analog_source, state == 1, Stamp);
+#endif
+	lcd_output(state, analog_source);
+}
+
+/******************************************************************************/
+/**
+*
+* This is the bottom half of the GPIO interrupt, run from the main loop. It
+* runs the button level through the button state machine, which detects
+* each press, chord and long press, and redraws the LCD on a change.
+*
+* @param	EventPtr is the event posted by GpioHandler, Arg holds the
+*		button value.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void ButtonEventHandler(const Event *EventPtr)
+{
+	DLOG("Inside GPIO Handler\n");
+	int btn_value = EventPtr->Arg;
+
+	ButtonFsm_Update(&Buttons, btn_value, EventPtr->Stamp);
+
+	DLOG("Data read: %d\n", btn_value);
+	ButtonApply(EventPtr->Stamp);
+}
+
+/******************************************************************************/
+/**
+*
+* Reports long presses while the button is still held. Run at 100 Hz by the
+* scheduler.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void ButtonEventPoll(void)
+{
+	u64 Now;
+
+	if (Buttons.Held == 0)
+		return;
+
+	Now = now_ticks();
+	if (ButtonFsm_Poll(&Buttons, Now) != 0)
+		ButtonApply(Now);
+}
+
+/******************************************************************************/
+/**
+*
+* This function disables the interrupts for the GPIO
+*
+* @param	IntcInstancePtr is a pointer to the Interrupt Controller
+*		driver Instance
+* @param	InstancePtr is a pointer to the GPIO driver Instance
+* @param	IntrId is XPAR_<INTC_instance>_<GPIO_instance>_VEC
+*		value from xparameters.h
+* @param	IntrMask is the GPIO channel mask
+*
+* @return	None
+*
+* @note		None.
+*
+******************************************************************************/
+void GpioDisableIntr(INTC *IntcInstancePtr, XGpio *InstancePtr,
+			u16 IntrId, u16 IntrMask)
+{
+	XGpio_InterruptDisable(InstancePtr, IntrMask);
+#ifdef XPAR_INTC_0_DEVICE_ID
+	XIntc_Disable(IntcInstancePtr, IntrId);
+#else
+	/* Disconnect the interrupt */
+	(void)IntcInstancePtr;
+	Intr_Disconnect(IntrId);
+#endif
+	return;
+}
+
+/*****************************************************************************/
+/**
+* 500 Hz scheduler task. The PWM follows every XADC frame (AdcEventHandler),
+* so this only makes sure the newest frame has been applied.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+#ifndef AMP
+void ControlTask(void)
+{
+	Pipeline_Update(&Pipe);
+}
+#endif
+
+/*
+ * Newest selected input and motor duty, from the pipeline or, in the AMP
+ * build, from the control core
+ */
+static void LiveGet(Fixed_Q16 *VoltsPtr, u32 *PermillePtr)
+{
+#ifdef AMP
+	*VoltsPtr = LiveVolts;
+	*PermillePtr = LivePermille;
+#else
+	*VoltsPtr = Pipe.Volts;
+	*PermillePtr = PwmOut.MotorDuty / PWM_UPDATE_MOTOR_QUANTUM;
+#endif
+}
+
+/*****************************************************************************/
+/**
+* 10 Hz scheduler task. Shows the selected input and the motor duty on the
+* LCD.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void LcdTask(void)
+{
+	Fixed_Q16 Volts;
+	u32 Permille;
+
+	LiveGet(&Volts, &Permille);
+	LcdUi_SetLive(Volts, Permille);
+	lcd_output(state, analog_source);
+}
+
+/*****************************************************************************/
+/**
+* Scheduler task every REPORT_PERIOD. Prints the input to PWM latency, or
+* in the AMP build the mailbox traffic, the live values, the benchmarks,
+* the task timing and the interrupt counts and latencies.
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void ReportTask(void)
+{
+#ifdef AMP
+	Amp_Report(Mailbox);
+#else
+	Pipeline_PrintLatency(&Pipe.Latency);
+#endif
+	LiveReport();
+	Bench_Report();
+	Sched_Report(&Tasks);
+	Intr_Report();
+}
+
+#ifndef AMP
+/*****************************************************************************/
+/**
+*
+* This is called from the XADC interrupt handler after each frame is
+* published. It only posts the frame to the main loop, which runs
+* AdcEventHandler.
+*
+* @param	AcqPtr is the acquisition.
+* @param	Seq is the sequence number of the frame.
+*
+* @return	None.
+*
+* @note		The interrupt time is counted from the frame stamp, taken
+*		when the handler started.
+*
+******************************************************************************/
+void XadcEosHandler(XadcAcq *AcqPtr, u32 Seq)
+{
+	Event_Post(EVENT_XADC_EOS, Seq);
+	Event_IsrDone(EVENT_XADC_EOS, AcqPtr->Buf[AcqPtr->Front].Stamp);
+}
+
+/*****************************************************************************/
+/**
+*
+* This is the bottom half of the XADC interrupt, run from the main loop. It
+* drives the motor and the buzzer from the selected input of the newest
+* frame.
+*
+* @param	EventPtr is the event posted by XadcEosHandler.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void AdcEventHandler(const Event *EventPtr)
+{
+	(void)EventPtr;
+	Pipeline_Update(&Pipe);
+}
+#else /* AMP */
+/*****************************************************************************/
+/**
+*
+* This is the bottom half of the mailbox doorbell, run from the main loop.
+* It keeps the live values the control core sends and answers its pings.
+*
+* @param	EventPtr is the event posted by the doorbell handler.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void MailboxEventHandler(const Event *EventPtr)
+{
+	Event Msg;
+
+	while (Amp_Receive(Mailbox, AMP_CPU_UI, &Msg) == XST_SUCCESS) {
+		switch (Msg.Type) {
+		case AMP_MSG_VOLTS:
+			LiveVolts = (Fixed_Q16)Msg.Arg;
+			break;
+		case AMP_MSG_DUTY:
+			LivePermille = Msg.Arg;
+			break;
+		case AMP_MSG_PING:
+			Amp_Send(Mailbox, AMP_CPU_CONTROL, AMP_MSG_PONG,
+				 Msg.Arg);
+			break;
+		default:
+			break;
+		}
+	}
+}
+#endif /* AMP */
+
+/*****************************************************************************/
+/**
+*
+* Prints the selected input and the motor duty to the UART, e.g.
+* "input 1.234 V, motor 37.5 %".
+*
+* @param	None.
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void LiveReport(void)
+{
+	char Volts[NUMFMT_MAX], Duty[NUMFMT_MAX];
+	Fixed_Q16 Live;
+	u32 Permille;
+
+	LiveGet(&Live, &Permille);
+	NumFmt_Q16(Volts, Live, 3);
+	NumFmt_Point(Duty, (s32)Permille, 1);
+	print("input ");
+	print(Volts);
+	print(" V, motor ");
+	print(Duty);
+	print(" %\r\n");
+}
+
+/******************************************************************************/
+/**
+*
+* This function sets up the Cortex-A9 private timer as the 1 kHz scheduler
+* tick, in the control tier of the interrupt manager so the releases are
+* not held up by the XADC handler. Its latency is probed from the timer's
+* counter.
+*
+* @param	IntcInstancePtr is a reference to the Interrupt Controller
+*		driver Instance
+* @param	TimerPtr is a reference to the XScuTimer driver Instance
+* @param	DeviceId is the XPAR_<SCUTIMER_instance>_DEVICE_ID value from
+*		xparameters.h
+* @param	IntrId is XPAR_SCUTIMER_INTR value from xparameters.h
+*
+* @return	XST_SUCCESS if successful, otherwise XST_FAILURE
+*
+* @note		On a HOST_SIM build the simulated GIC times the latency.
+*
+******************************************************************************/
+int TickTimerSetupIntrSystem(INTC *IntcInstancePtr, XScuTimer *TimerPtr,
+			u16 DeviceId, u16 IntrId)
+{
+	XScuTimer_Config *TimerConfig;
+	int Status;
+
+	TimerConfig = XScuTimer_LookupConfig(DeviceId);
+	if (NULL == TimerConfig) {
+		return XST_FAILURE;
+	}
+
+	Status = XScuTimer_CfgInitialize(TimerPtr, TimerConfig,
+					TimerConfig->BaseAddr);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	Status = Intr_Init(IntcInstancePtr);
+	if (Status != XST_SUCCESS) {
+		return Status;
+	}
+	Status = Intr_Connect(IntrId, INTR_TIER_CONTROL, INTR_TRIGGER_KEEP,
+			      TickTimerHandler, TimerPtr);
+	if (Status != XST_SUCCESS) {
+		return Status;
+	}
+#ifndef HOST_SIM
+	Intr_SetProbe(IntrId, Intr_ScuTimerProbe);
+#endif
+
+	XScuTimer_EnableAutoReload(TimerPtr);
+	XScuTimer_LoadTimer(TimerPtr, TICK_TIMER_LOAD_VALUE);
+	XScuTimer_EnableInterrupt(TimerPtr);
+	XScuTimer_Start(TimerPtr);
+
+	return XST_SUCCESS;
+}
+
+/******************************************************************************/
+/**
+*
+* This is the interrupt handler for the scheduler tick. It only wakes the
+* main loop from Idle_Wait(); the scheduler decides what runs.
+*
+* @param	CallBackRef is a pointer to the XScuTimer driver Instance
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void TickTimerHandler(void *CallBackRef)
+{
+	BENCH_START(Cycles);
+	u64 Start = now_ticks();
+
+	TRACE_ISR_ENTER(APP_TICK_INTR_ID);
+	XScuTimer_ClearInterruptStatus((XScuTimer *)CallBackRef);
+	Event_IsrDone(EVENT_TIMER_TICK, Start);
+	TRACE_ISR_EXIT(APP_TICK_INTR_ID);
+	BENCH_STOP(BENCH_TIMER_HANDLER, Cycles);
+}
+
+/******************************************************************************/
+/**
+*
+* This function sets up the Cortex-A9 private watchdog, in timer mode, to
+* clock the LCD command queue in the UI tier of the interrupt manager. The
+* timer is left stopped; the queue starts it through LcdTimerRun() when
+* there is work, and stops it once it has drained.
+*
+* @param	IntcInstancePtr is a reference to the Interrupt Controller
+*		driver Instance
+* @param	WdtPtr is a reference to the XScuWdt driver Instance
+* @param	DeviceId is the XPAR_<SCUWDT_instance>_DEVICE_ID value from
+*		xparameters.h
+* @param	IntrId is XPAR_SCUWDT_INTR value from xparameters.h
+*
+* @return	XST_SUCCESS if successful, otherwise XST_FAILURE
+*
+* @note		None.
+*
+******************************************************************************/
+int LcdTimerSetupIntrSystem(INTC *IntcInstancePtr, XScuWdt *WdtPtr,
+			u16 DeviceId, u16 IntrId)
+{
+	XScuWdt_Config *WdtConfig;
+	int Status;
+
+	WdtConfig = XScuWdt_LookupConfig(DeviceId);
+	if (NULL == WdtConfig) {
+		return XST_FAILURE;
+	}
+
+	Status = XScuWdt_CfgInitialize(WdtPtr, WdtConfig,
+					WdtConfig->BaseAddr);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	XScuWdt_SetTimerMode(WdtPtr);
+
+	Status = Intr_Init(IntcInstancePtr);
+	if (Status != XST_SUCCESS) {
+		return Status;
+	}
+	Status = Intr_Connect(IntrId, INTR_TIER_UI, INTR_TRIGGER_KEEP,
+			      LcdTimerHandler, WdtPtr);
+	if (Status != XST_SUCCESS) {
+		return Status;
+	}
+
+	XScuWdt_SetControlReg(WdtPtr, XScuWdt_GetControlReg(WdtPtr) |
+			      XSCUWDT_CONTROL_AUTO_RELOAD_MASK |
+			      XSCUWDT_CONTROL_IT_ENABLE_MASK);
+
+	/* Starts the timer now if LCD_Setup() has queued the reset sequence */
+	LcdAsync_SetTimer(LcdTimerRun);
+
+	return XST_SUCCESS;
+}
+
+/******************************************************************************/
+/**
+*
+* Starts or stops the LCD timer for the LCD command queue. A start reloads
+* the counter, so the first tick comes a full LCD_ASYNC_TICK_US later.
+*
+* @param	Run is TRUE to start the timer, FALSE to stop it.
+*
+* @return	None.
+*
+* @note		Called from the main loop and from LcdTimerHandler().
+*
+******************************************************************************/
+void LcdTimerRun(int Run)
+{
+	if (Run) {
+		XScuWdt_LoadWdt(&LcdTimer, LCD_TIMER_LOAD_VALUE);
+		XScuWdt_Start(&LcdTimer);
+	} else {
+		XScuWdt_Stop(&LcdTimer);
+	}
+}
+
+/******************************************************************************/
+/**
+*
+* This is the interrupt handler for the LCD timer. It advances the LCD
+* command queue by one step.
+*
+* @param	CallBackRef is a pointer to the XScuWdt driver Instance
+*
+* @return	None.
+*
+* @note		None.
+*
+******************************************************************************/
+void LcdTimerHandler(void *CallBackRef)
+{
+	XScuWdt *WdtPtr = (XScuWdt *)CallBackRef;
+
+	TRACE_ISR_ENTER(APP_LCD_INTR_ID);
+	XScuWdt_WriteReg(WdtPtr->Config.BaseAddr, XSCUWDT_ISR_OFFSET,
+			 XSCUWDT_ISR_EVENT_FLAG_MASK);
+	LcdAsync_Tick();
+	TRACE_ISR_EXIT(APP_LCD_INTR_ID);
+}
+
+//lcd initialzation sequence, queued and clocked out by the LCD timer
+void LCD_Setup(){
+	LcdUi_Setup();
+}
+
+//queue a command, the LCD timer observes the 1.52ms clear/home time
+void LCD_command(unsigned char command)
+{
+    LcdAsync_Command(command);
+}
+
+///function to queue data to lcd
+void LCD_data(unsigned char data)
+{
+    LcdAsync_Data(data);
+}
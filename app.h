@@ -0,0 +1,177 @@
+/*****************************************************************************/
+/**
+* @file app.h
+*
+* The application of the UI core: the interrupt handlers, their bottom
+* halves, the scheduler tasks and the setup of the devices they use.
+*
+* main.c brings up the Xilinx drivers that only exist on the board, calls
+* the setup functions below and runs the main loop around App_Run(). The
+* same functions build with HOST_SIM, where HwSim_Benchmark() runs them
+* against the simulated board instead. The host stand-ins for the GPIO,
+* private timer and private watchdog drivers below drive the simulated
+* devices of hw_sim.h.
+*
+******************************************************************************/
+#ifndef APP_H
+#define APP_H
+
+#include "platform.h"
+#include "event_queue.h"
+#include "scheduler.h"
+#include "button_fsm.h"
+#include "pwm_update.h"
+#include "xadc_acq.h"
+#include "pipeline.h"
+#include "fixed.h"
+#include "amp.h"
+
+#ifdef HOST_SIM
+#include "hw_sim.h"
+#else
+#include "xparameters.h"
+#include "xgpio.h"
+#include "xscutimer.h"
+#include "xscuwdt.h"
+#ifdef XPAR_INTC_0_DEVICE_ID
+ #include "xintc.h"
+#else
+ #include "xscugic.h"
+#endif
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#ifdef XPAR_INTC_0_DEVICE_ID
+ #define INTC_DEVICE_ID	XPAR_INTC_0_DEVICE_ID
+ #define INTC		XIntc
+ #define INTC_HANDLER	XIntc_InterruptHandler
+#else
+ #define INTC_DEVICE_ID	XPAR_SCUGIC_SINGLE_DEVICE_ID
+ #define INTC		XScuGic
+ #define INTC_HANDLER	XScuGic_InterruptHandler
+#endif /* XPAR_INTC_0_DEVICE_ID */
+
+/*
+ * Interrupt IDs the handlers trace, as in xparameters.h
+ */
+#ifdef HOST_SIM
+#define APP_GPIO_INTR_ID	HWSIM_IRQ_GPIO
+#define APP_TICK_INTR_ID	HWSIM_IRQ_SCUTIMER
+#define APP_LCD_INTR_ID		HWSIM_IRQ_SCUWDT
+#elif defined(XPAR_INTC_0_DEVICE_ID)
+#define APP_GPIO_INTR_ID	XPAR_INTC_0_GPIO_0_VEC_ID
+#define APP_TICK_INTR_ID	XPAR_SCUTIMER_INTR
+#define APP_LCD_INTR_ID		XPAR_SCUWDT_INTR
+#else
+#define APP_GPIO_INTR_ID	XPAR_FABRIC_AXI_GPIO_0_IP2INTC_IRPT_INTR
+#define APP_TICK_INTR_ID	XPAR_SCUTIMER_INTR
+#define APP_LCD_INTR_ID		XPAR_SCUWDT_INTR
+#endif
+
+#ifdef HOST_SIM
+#define XGPIO_IR_CH1_MASK	0x1
+#endif
+
+/**************************** Type Definitions *******************************/
+
+#ifdef HOST_SIM
+/*
+ * Host stand-in for the AXI GPIO driver instance: its calls are register
+ * writes to the simulated GPIO
+ */
+typedef struct {
+	u32 IsReady;
+} XGpio;
+
+/*
+ * Host stand-ins for the Cortex-A9 private timer and watchdog: IntrId is the
+ * simulated timer of hw_sim.h that stands in for the counter
+ */
+typedef struct {
+	u16 DeviceId;
+	u32 BaseAddr;
+	u32 IntrId;
+} XScuTimer_Config;
+
+typedef struct {
+	XScuTimer_Config Config;
+	u32 IsReady;
+	u32 Load;
+	u8 Loaded;		/* The simulated timer has been created */
+} XScuTimer;
+
+typedef XScuTimer_Config XScuWdt_Config;
+typedef XScuTimer XScuWdt;
+#endif
+
+/************************** Variable Definitions *****************************/
+
+/*
+ * Declared globally so they are zeroed and so they are easily accessible
+ * from a debugger
+ */
+extern XGpio Gpio;		/* The buttons */
+extern INTC Intc;		/* The interrupt controller */
+extern XScuTimer TickTimer;	/* Scheduler tick */
+extern XScuWdt LcdTimer;	/* LCD queue tick */
+extern XTmrCtr TimerCounterInst;	/* Buzzer PWM, no interrupt */
+extern Sched Tasks;		/* Fixed-rate work of the main loop */
+
+extern volatile u32 *baseaddr_lcd;
+extern volatile u32 *baseaddr_gpio;
+extern volatile u32 *baseaddr_pwm;
+extern volatile u32 IntrFlag;	/* Set by the GPIO handler */
+
+extern int state;
+extern int analog_source;
+
+#ifdef AMP
+extern Amp_Mailbox *Mailbox;	/* To the control core */
+extern Fixed_Q16 LiveVolts;	/* Newest live values from the control core */
+extern u32 LivePermille;
+#else
+extern PwmUpdate PwmOut;	/* Change-only buzzer and motor PWM updates */
+extern XSysMon Xadc;
+extern XadcAcq XadcIn;		/* Potentiometer and photoresistor frames */
+extern Pipeline Pipe;		/* Selected input to motor and buzzer PWM */
+#endif
+
+/************************** Function Prototypes ******************************/
+
+void App_Init(void);
+int App_ControlInit(void);
+void App_LcdInit(void);
+u64 App_Run(void);
+
+int GpioSetupIntrSystem(INTC *IntcInstancePtr, XGpio *InstancePtr,
+			u16 DeviceId, u16 IntrId, u16 IntrMask);
+void GpioDisableIntr(INTC *IntcInstancePtr, XGpio *InstancePtr,
+			u16 IntrId, u16 IntrMask);
+void GpioHandler(void *CallBackRef);
+void ButtonEventHandler(const Event *EventPtr);
+void ButtonEventPoll(void);
+
+void ControlTask(void);
+void LcdTask(void);
+void ReportTask(void);
+
+void XadcEosHandler(XadcAcq *AcqPtr, u32 Seq);
+void AdcEventHandler(const Event *EventPtr);
+void MailboxEventHandler(const Event *EventPtr);
+void LiveReport(void);
+
+int TickTimerSetupIntrSystem(INTC *IntcInstancePtr, XScuTimer *TimerPtr,
+			u16 DeviceId, u16 IntrId);
+void TickTimerHandler(void *CallBackRef);
+
+int LcdTimerSetupIntrSystem(INTC *IntcInstancePtr, XScuWdt *WdtPtr,
+			u16 DeviceId, u16 IntrId);
+void LcdTimerHandler(void *CallBackRef);
+void LcdTimerRun(int Run);
+
+void LCD_command(unsigned char command);
+void LCD_data(unsigned char data);
+void LCD_Setup(void);
+
+#endif /* APP_H */
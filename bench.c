@@ -0,0 +1,252 @@
+/*****************************************************************************/
+/**
+* @file bench.c
+*
+* Timing probes. See bench.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "bench.h"
+#include "timebase.h"
+#include <stdio.h>
+
+#ifdef HOST_SIM
+#include "hw_sim.h"
+#include "hal.h"
+#include "lcd_async.h"
+#include "lcd_ui.h"
+#include "xadc_acq.h"
+#include "pipeline.h"
+#include "app.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define BENCH_SAMPLE_MASK	(BENCH_SAMPLES - 1)
+#define BENCH_CALIBRATION_RUNS	64
+
+#ifndef HOST_SIM
+#define BENCH_PMCR_ENABLE	0x1	/* All counters on */
+#define BENCH_PMCR_CYCLE_RESET	0x4
+#define BENCH_PMCNTEN_CYCLE	0x80000000
+#endif
+
+#ifdef HOST_SIM
+#define BENCH_BUILD		"host"
+#define BENCH_SUITE_BOOTS	8
+#define BENCH_SUITE_SCREENS	300
+#define BENCH_SUITE_READS	10000
+#define BENCH_SUITE_SIM_MS	2000
+#else
+#define BENCH_BUILD		"target"
+#endif
+
+/************************** Variable Definitions *****************************/
+
+static const char *const ProbeName[BENCH_PROBES] = {
+	"gpio_handler",
+	"timer_handler",
+	"lcd_output_reset",
+	"lcd_output_enable",
+	"lcd_output_disable",
+	"lcd_setup",
+	"xadc_read",
+	"adc_to_pwm",
+};
+
+static Bench_Probe Probes[BENCH_PROBES];
+static u32 OverheadCycles;	/* Cost of an empty BENCH_START/BENCH_STOP */
+
+/*****************************************************************************/
+/**
+* Starts the cycle counter, measures the cost of a probe pair, which
+* Bench_Record() then takes off every sample, and clears the probes.
+*
+******************************************************************************/
+void Bench_Init(void)
+{
+	u32 Min = ~0U;
+	u32 Start, Cycles;
+	int i;
+
+#ifndef HOST_SIM
+	mtcp(XREG_CP15_PERF_MONITOR_CTRL,
+	     BENCH_PMCR_ENABLE | BENCH_PMCR_CYCLE_RESET);
+	mtcp(XREG_CP15_COUNT_ENABLE_SET, BENCH_PMCNTEN_CYCLE);
+#endif
+	for (i = 0; i < BENCH_CALIBRATION_RUNS; i++) {
+		Start = Bench_Cycles();
+		Cycles = Bench_Cycles() - Start;
+		if (Cycles < Min)
+			Min = Cycles;
+	}
+	OverheadCycles = Min;
+	for (i = 0; i < BENCH_PROBES; i++)
+		Bench_Reset(i);
+}
+
+void Bench_Reset(u32 Probe)
+{
+	Probes[Probe] = (Bench_Probe){ .Min = ~0U };
+}
+
+static void Bench_Add(Bench_Probe *ProbePtr, u32 Cycles)
+{
+	ProbePtr->Sample[ProbePtr->Count & BENCH_SAMPLE_MASK] = Cycles;
+	ProbePtr->Count++;
+	ProbePtr->Sum += Cycles;
+	if (Cycles < ProbePtr->Min)
+		ProbePtr->Min = Cycles;
+	if (Cycles > ProbePtr->Max)
+		ProbePtr->Max = Cycles;
+}
+
+/*****************************************************************************/
+/**
+* Adds one sample to a probe. Safe to call from an interrupt handler as
+* long as a probe is only recorded from one context.
+*
+******************************************************************************/
+void Bench_Record(u32 Probe, u32 Cycles)
+{
+	Bench_Add(&Probes[Probe],
+		  (Cycles > OverheadCycles) ? Cycles - OverheadCycles : 0);
+}
+
+/*
+ * Records a duration measured on the time base, e.g. from a frame stamp
+ */
+void Bench_RecordTicks(u32 Probe, u64 Ticks)
+{
+	u64 Cycles = Ticks * BENCH_HZ / TIMEBASE_HZ;
+
+	Bench_Add(&Probes[Probe], (Cycles > 0xFFFFFFFFULL) ? 0xFFFFFFFFU :
+		  (u32)Cycles);
+}
+
+void Bench_GetProbe(u32 Probe, Bench_Probe *ProbePtr)
+{
+	*ProbePtr = Probes[Probe];
+}
+
+/*****************************************************************************/
+/**
+* Returns the Percent-th percentile of the samples a probe still holds, the
+* last BENCH_SAMPLES, by nearest rank.
+*
+******************************************************************************/
+u32 Bench_Percentile(const Bench_Probe *ProbePtr, u32 Percent)
+{
+	u32 Sorted[BENCH_SAMPLES];
+	u32 Held = (ProbePtr->Count < BENCH_SAMPLES) ? ProbePtr->Count :
+		   BENCH_SAMPLES;
+	u32 i, j, Value, Rank;
+
+	if (Held == 0)
+		return 0;
+	for (i = 0; i < Held; i++) {
+		Value = ProbePtr->Sample[i];
+		for (j = i; j > 0 && Sorted[j - 1] > Value; j--)
+			Sorted[j] = Sorted[j - 1];
+		Sorted[j] = Value;
+	}
+	Rank = (Held * Percent + 99) / 100;
+	return Sorted[(Rank == 0) ? 0 : Rank - 1];
+}
+
+/*****************************************************************************/
+/**
+* Prints every probe that has samples as one JSON object per line, in
+* counts of BENCH_HZ ("hz"): cycles on the board, ns on the host.
+*
+******************************************************************************/
+void Bench_Report(void)
+{
+	Bench_Probe Snap;
+	u32 i;
+
+	for (i = 0; i < BENCH_PROBES; i++) {
+		Snap = Probes[i];
+		if (Snap.Count == 0)
+			continue;
+		printf("{\"probe\":\"%s\",\"build\":\"%s\",\"hz\":%lu,"
+		       "\"n\":%lu,\"min\":%lu,\"mean\":%lu,\"p99\":%lu,"
+		       "\"max\":%lu}\r\n", ProbeName[i], BENCH_BUILD,
+		       (unsigned long)BENCH_HZ, (unsigned long)Snap.Count,
+		       (unsigned long)Snap.Min,
+		       (unsigned long)(Snap.Sum / Snap.Count),
+		       (unsigned long)Bench_Percentile(&Snap, 99),
+		       (unsigned long)Snap.Max);
+	}
+}
+
+#ifdef HOST_SIM
+/*****************************************************************************/
+/**
+* Host benchmark suite. Fills every probe from the host build and prints
+* the report:
+* - lcd_setup: App_LcdInit(), the reset sequence and the first screen,
+*   until the LCD is idle, in simulated time;
+* - lcd_output_*: BENCH_SUITE_SCREENS state changes on the simulated LCD;
+* - xadc_read: XadcAcq_Read(), the work Xadc_ReadData does per call in
+*   interrupt mode;
+* - gpio_handler, timer_handler: GpioHandler() and TickTimerHandler() of
+*   app.c, run by HwSim_Benchmark() over BENCH_SUITE_SIM_MS of simulated
+*   time;
+* - adc_to_pwm: the real-time run of Pipeline_Benchmark().
+*
+* Host figures are in ns and only comparable between host builds.
+*
+******************************************************************************/
+void Bench_Suite(void)
+{
+	static XSysMon Xadc;
+	static XadcAcq Acq;
+	static XScuGic Intc;
+	XadcAcq_Frame Frame;
+	u64 Start;
+	u32 i;
+
+	Bench_Init();
+
+	/* Boot and screen changes, ticked on the simulated clock */
+	for (i = 0; i < BENCH_SUITE_BOOTS; i++) {
+		HwSim_Init();
+		Start = now_ticks();
+		App_LcdInit();
+		while (!LcdAsync_IsIdle()) {
+			LcdAsync_Tick();
+			timebase_sim_advance_us(LCD_ASYNC_TICK_US);
+		}
+		Bench_RecordTicks(BENCH_LCD_SETUP, now_ticks() - Start);
+	}
+	for (i = 0; i < BENCH_SUITE_SCREENS; i++) {
+		lcd_output(i % 3, (i / 3) & 1);
+		while (!LcdAsync_IsIdle()) {
+			LcdAsync_Tick();
+			timebase_sim_advance_us(LCD_ASYNC_TICK_US);
+		}
+	}
+
+	/* Frame reads between end-of-sequence interrupts */
+	HwSim_Init();
+	XadcAcq_SimSetRate(&Xadc, 1000);
+	XadcAcq_Init(&Acq, &Xadc, Pipeline_Mask(), XADC_ACQ_MODE_INTR);
+	XadcAcq_SetupIntr(&Acq, &Intc, HWSIM_IRQ_XADC);
+	for (i = 0; i < BENCH_SUITE_READS; i++) {
+		BENCH_START(ReadStart);
+
+		XadcAcq_Read(&Acq, &Frame);
+		BENCH_STOP(BENCH_XADC_READ, ReadStart);
+		HwSim_Step(now_ticks() + us_to_ticks(100));
+	}
+	timebase_sim_clock(FALSE);
+
+	HwSim_Benchmark(BENCH_SUITE_SIM_MS);
+	Pipeline_Benchmark();
+
+	Bench_Report();
+}
+#endif /* HOST_SIM */
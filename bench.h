@@ -0,0 +1,104 @@
+/*****************************************************************************/
+/**
+* @file bench.h
+*
+* Timing probes for the interrupt handlers, the LCD and the control path.
+*
+* BENCH_START() reads a free-running counter and BENCH_STOP() adds the
+* elapsed count to a probe. On the board the counter is the Cortex-A9 PMU
+* cycle counter, so probes count CPU cycles; on a HOST_SIM build it is
+* CLOCK_MONOTONIC in nanoseconds. Each probe keeps count, min, max and sum
+* and its last BENCH_SAMPLES samples, from which Bench_Report() takes the
+* 99th percentile. The report is one JSON object per line so the output of
+* two builds can be compared by a script.
+*
+* Building with BENCH_DISABLE removes the probes from the handlers.
+*
+******************************************************************************/
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "platform.h"
+
+#ifdef HOST_SIM
+#include <time.h>
+#else
+#include "xparameters.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+/*
+ * Probes
+ */
+#define BENCH_GPIO_HANDLER	0	/* GpioHandler entry to exit */
+#define BENCH_TIMER_HANDLER	1	/* TickTimerHandler */
+#define BENCH_LCD_OUTPUT_RESET	2	/* lcd_output(), one per state */
+#define BENCH_LCD_OUTPUT_ENABLE	3
+#define BENCH_LCD_OUTPUT_DISABLE 4
+#define BENCH_LCD_SETUP		5	/* LCD_Setup to first screen on the glass */
+#define BENCH_XADC_READ		6	/* Xadc_ReadData */
+#define BENCH_ADC_TO_PWM	7	/* End of sequence to PWM register write */
+#define BENCH_PROBES		8
+
+#define BENCH_SAMPLES		256	/* Samples kept per probe, power of two */
+
+#ifdef HOST_SIM
+#define BENCH_HZ		1000000000ULL
+#else
+#define BENCH_HZ		((u64)XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ)
+#endif
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Count;
+	u32 Min;
+	u32 Max;
+	u64 Sum;
+	u32 Sample[BENCH_SAMPLES];	/* Ring of the most recent samples */
+} Bench_Probe;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*
+ * Free-running counter at BENCH_HZ. Differences are valid across one
+ * 32-bit wrap, about 6 s at 667 MHz.
+ */
+static inline u32 Bench_Cycles(void)
+{
+#ifdef HOST_SIM
+	struct timespec Ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &Ts);
+	return (u32)((u64)Ts.tv_sec * 1000000000ULL + (u64)Ts.tv_nsec);
+#else
+	return mfcp(XREG_CP15_PERF_CYCLE_COUNTER);
+#endif
+}
+
+#ifdef BENCH_DISABLE
+#define BENCH_START(Var)
+#define BENCH_STOP(Probe, Var)	do { } while (0)
+#else
+#define BENCH_START(Var)	u32 Var = Bench_Cycles()
+#define BENCH_STOP(Probe, Var)	Bench_Record((Probe), Bench_Cycles() - (Var))
+#endif
+
+/************************** Function Prototypes ******************************/
+
+void Bench_Init(void);
+void Bench_Reset(u32 Probe);
+void Bench_Record(u32 Probe, u32 Cycles);
+void Bench_RecordTicks(u32 Probe, u64 Ticks);
+void Bench_GetProbe(u32 Probe, Bench_Probe *ProbePtr);
+u32 Bench_Percentile(const Bench_Probe *ProbePtr, u32 Percent);
+void Bench_Report(void);
+
+#ifdef HOST_SIM
+void Bench_Suite(void);
+#endif
+
+#endif /* BENCH_H */
@@ -0,0 +1,323 @@
+/*****************************************************************************/
+/**
+* @file button_fsm.c
+*
+* Button decoding and transition-table state machine. See button_fsm.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "button_fsm.h"
+#include "timebase.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include "event_queue.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define BUTTON_TRACE_MASK	(BUTTON_TRACE_LEN - 1)
+
+#define BUTTON_CHORD_ALL	0x7	/* Reset, source and enable together */
+
+/************************** Function Prototypes ******************************/
+
+static void ButtonFsm_ToggleSource(ButtonFsm *FsmPtr);
+static void ButtonFsm_DefaultSource(ButtonFsm *FsmPtr);
+
+/************************** Variable Definitions *****************************/
+
+/*
+ * The first row whose State and Input match is taken. A Next of
+ * BUTTON_STATE_ANY keeps the current state.
+ */
+static const ButtonFsm_Transition Transitions[] = {
+	{ BUTTON_STATE_RESET,    BUTTON_IN_PRESS(BUTTON_ENABLE),
+	  BUTTON_STATE_ENABLED,  NULL },
+	{ BUTTON_STATE_ENABLED,  BUTTON_IN_PRESS(BUTTON_ENABLE),
+	  BUTTON_STATE_DISABLED, NULL },
+	{ BUTTON_STATE_DISABLED, BUTTON_IN_PRESS(BUTTON_ENABLE),
+	  BUTTON_STATE_ENABLED,  NULL },
+	{ BUTTON_STATE_ANY,      BUTTON_IN_PRESS(BUTTON_RESET),
+	  BUTTON_STATE_RESET,    NULL },
+	{ BUTTON_STATE_ANY,      BUTTON_IN_PRESS(BUTTON_SOURCE),
+	  BUTTON_STATE_ANY,      ButtonFsm_ToggleSource },
+
+	/* Holding reset, or all three buttons, also restores the source */
+	{ BUTTON_STATE_ANY,      BUTTON_IN_LONG(BUTTON_RESET),
+	  BUTTON_STATE_RESET,    ButtonFsm_DefaultSource },
+	{ BUTTON_STATE_ANY,      BUTTON_IN_CHORD(BUTTON_CHORD_ALL),
+	  BUTTON_STATE_RESET,    ButtonFsm_DefaultSource },
+};
+
+static void ButtonFsm_ToggleSource(ButtonFsm *FsmPtr)
+{
+	FsmPtr->Source = !FsmPtr->Source;
+}
+
+static void ButtonFsm_DefaultSource(ButtonFsm *FsmPtr)
+{
+	FsmPtr->Source = 1;
+}
+
+static u32 ButtonFsm_Count(u32 Mask)
+{
+	u32 Count = 0;
+
+	for (; Mask != 0; Mask &= Mask - 1)
+		Count++;
+	return Count;
+}
+
+/*****************************************************************************/
+/**
+* Puts the machine in the reset state with the photoresistor selected, no
+* buttons held and an empty trace, and binds it to the transition table.
+*
+******************************************************************************/
+void ButtonFsm_Init(ButtonFsm *FsmPtr)
+{
+	*FsmPtr = (ButtonFsm){0};
+	FsmPtr->Table = Transitions;
+	FsmPtr->TableLen = sizeof(Transitions) / sizeof(Transitions[0]);
+	FsmPtr->State = BUTTON_STATE_RESET;
+	FsmPtr->Source = 1;
+	FsmPtr->LongTicks = us_to_ticks(BUTTON_LONG_US);
+}
+
+/*****************************************************************************/
+/**
+* Runs one input through the transition table and records it in the trace.
+*
+* @param	FsmPtr is the state machine.
+* @param	Input is one of the BUTTON_IN_* values.
+* @param	Stamp is the time base tick the input happened at.
+*
+* @return	XST_SUCCESS if a transition accepted the input, otherwise
+*		XST_FAILURE and the state is unchanged.
+*
+******************************************************************************/
+int ButtonFsm_Input(ButtonFsm *FsmPtr, u8 Input, u64 Stamp)
+{
+	const ButtonFsm_Transition *RowPtr = NULL;
+	ButtonFsm_TraceEntry *EntryPtr;
+	u8 From = FsmPtr->State;
+	u32 i;
+
+	for (i = 0; i < FsmPtr->TableLen; i++) {
+		if (FsmPtr->Table[i].Input == Input &&
+		    (FsmPtr->Table[i].State == From ||
+		     FsmPtr->Table[i].State == BUTTON_STATE_ANY)) {
+			RowPtr = &FsmPtr->Table[i];
+			break;
+		}
+	}
+
+	if (RowPtr != NULL) {
+		if (RowPtr->Next != BUTTON_STATE_ANY)
+			FsmPtr->State = RowPtr->Next;
+		if (RowPtr->Action != NULL)
+			RowPtr->Action(FsmPtr);
+		FsmPtr->Transitions++;
+	}
+	FsmPtr->Inputs++;
+
+	EntryPtr = &FsmPtr->Trace[FsmPtr->TraceCount & BUTTON_TRACE_MASK];
+	EntryPtr->Stamp = Stamp;
+	EntryPtr->From = From;
+	EntryPtr->Input = Input;
+	EntryPtr->To = FsmPtr->State;
+	EntryPtr->Matched = (RowPtr != NULL);
+	FsmPtr->TraceCount++;
+
+	return (RowPtr != NULL) ? XST_SUCCESS : XST_FAILURE;
+}
+
+/*****************************************************************************/
+/**
+* Reports a long press for every button held for BUTTON_LONG_US that has not
+* been reported yet. Call periodically, e.g. from the main loop, so a long
+* press is seen while the button is still down.
+*
+* @return	Number of inputs run through the table.
+*
+******************************************************************************/
+u32 ButtonFsm_Poll(ButtonFsm *FsmPtr, u64 Now)
+{
+	u32 Inputs = 0;
+	u8 Pending = FsmPtr->Held & ~FsmPtr->LongSent;
+	u8 Bit;
+
+	for (Bit = 0; Pending != 0; Bit++, Pending >>= 1) {
+		if ((Pending & 1) == 0 ||
+		    Now - FsmPtr->PressStamp[Bit] < FsmPtr->LongTicks)
+			continue;
+		FsmPtr->LongSent |= 1 << Bit;
+		ButtonFsm_Input(FsmPtr, BUTTON_IN_LONG(Bit),
+				FsmPtr->PressStamp[Bit] + FsmPtr->LongTicks);
+		Inputs++;
+	}
+
+	return Inputs;
+}
+
+/*****************************************************************************/
+/**
+* Decodes a new button level into inputs and runs them through the table:
+* any long presses that became due before Stamp, then one press per button
+* that went down, in bit order, then a chord if two or more buttons are now
+* held.
+*
+* @param	FsmPtr is the state machine.
+* @param	Buttons is the pmod_pushbutton_tri_i value.
+* @param	Stamp is the time base tick the level was read at.
+*
+* @return	Number of inputs run through the table.
+*
+* @note		Only the previous level is kept, so if a button event is lost
+*		the edges on either side of it merge rather than leaving a
+*		button stuck.
+*
+******************************************************************************/
+u32 ButtonFsm_Update(ButtonFsm *FsmPtr, u32 Buttons, u64 Stamp)
+{
+	u32 Inputs = ButtonFsm_Poll(FsmPtr, Stamp);
+	u8 Pressed;
+	u8 Bit;
+
+	Buttons &= BUTTON_MASK;
+	Pressed = Buttons & ~FsmPtr->Held;
+	FsmPtr->Held = Buttons;
+	FsmPtr->LongSent &= Buttons;
+
+	for (Bit = 0; Bit < BUTTON_COUNT; Bit++) {
+		if ((Pressed & (1 << Bit)) == 0)
+			continue;
+		FsmPtr->PressStamp[Bit] = Stamp;
+		ButtonFsm_Input(FsmPtr, BUTTON_IN_PRESS(Bit), Stamp);
+		Inputs++;
+	}
+
+	if (Pressed != 0 && ButtonFsm_Count(Buttons) >= 2) {
+		ButtonFsm_Input(FsmPtr, BUTTON_IN_CHORD(Buttons), Stamp);
+		Inputs++;
+	}
+
+	return Inputs;
+}
+
+/*****************************************************************************/
+/**
+* Copies out the newest trace entries, oldest first.
+*
+* @param	FsmPtr is the state machine.
+* @param	Buf receives up to Max entries.
+* @param	Max is the size of Buf.
+*
+* @return	Number of entries copied, at most BUTTON_TRACE_LEN.
+*
+******************************************************************************/
+u32 ButtonFsm_TraceRead(const ButtonFsm *FsmPtr, ButtonFsm_TraceEntry *Buf,
+			u32 Max)
+{
+	u32 Count = FsmPtr->TraceCount;
+	u32 First;
+	u32 i;
+
+	if (Count > BUTTON_TRACE_LEN)
+		Count = BUTTON_TRACE_LEN;
+	if (Count > Max)
+		Count = Max;
+
+	First = FsmPtr->TraceCount - Count;
+	for (i = 0; i < Count; i++)
+		Buf[i] = FsmPtr->Trace[(First + i) & BUTTON_TRACE_MASK];
+
+	return Count;
+}
+
+#ifdef HOST_SIM
+static ButtonFsm BenchFsm;
+static u32 BenchSeed;
+
+static u32 ButtonFsm_BenchRandom(void)
+{
+	BenchSeed = BenchSeed * 1103515245 + 12345;
+	return BenchSeed >> 16;
+}
+
+static void ButtonFsm_BenchHandler(const Event *EventPtr)
+{
+	ButtonFsm_Update(&BenchFsm, EventPtr->Arg, EventPtr->Stamp);
+}
+
+/*****************************************************************************/
+/**
+* Host benchmark. Feeds Count random button levels straight into the engine
+* to measure inputs and transitions per second, then posts bursts of 1 to
+* EVENT_QUEUE_LEN levels through the event queue, as back-to-back button
+* interrupts would, and checks that the engine saw exactly the presses and
+* chords the levels contain.
+*
+******************************************************************************/
+void ButtonFsm_Benchmark(u32 Count)
+{
+	ButtonFsm_TraceEntry Trace[BUTTON_TRACE_LEN];
+	Event_Stats EvStats;
+	u64 Start, Elapsed;
+	u32 Expected = 0;
+	u32 Prev = 0;
+	u32 Level, Rising;
+	u32 Burst, i;
+
+	ButtonFsm_Init(&BenchFsm);
+	BenchSeed = 1;
+	Start = now_ticks();
+	for (i = 0; i < Count; i++)
+		ButtonFsm_Update(&BenchFsm, ButtonFsm_BenchRandom(), Start);
+	Elapsed = now_ticks() - Start;
+
+	printf("button_fsm: %u updates in %.3f ms, %.1f M inputs/s, "
+	       "%.1f M transitions/s (%u of %u inputs matched)\n",
+	       Count, Elapsed / 1e6, BenchFsm.Inputs * 1e3 / Elapsed,
+	       BenchFsm.Transitions * 1e3 / Elapsed,
+	       BenchFsm.Transitions, BenchFsm.Inputs);
+
+	/* Bursts through the interrupt event queue on the simulated clock */
+	timebase_sim_clock(TRUE);
+	ButtonFsm_Init(&BenchFsm);
+	Event_Init();
+	Event_Register(EVENT_BUTTON, ButtonFsm_BenchHandler);
+	for (Burst = 1; Burst <= EVENT_QUEUE_LEN; Burst++) {
+		for (i = 0; i < Burst; i++) {
+			Level = ButtonFsm_BenchRandom() & BUTTON_MASK;
+			Rising = Level & ~Prev;
+			Expected += ButtonFsm_Count(Rising);
+			if (Rising != 0 && ButtonFsm_Count(Level) >= 2)
+				Expected++;
+			Prev = Level;
+			Event_Post(EVENT_BUTTON, Level);
+		}
+		Event_Dispatch();
+		timebase_sim_advance_us(1000);
+	}
+	Event_GetStats(&EvStats);
+	timebase_sim_clock(FALSE);
+
+	printf("button_fsm: bursts of 1..%u, %u events, %u dropped, "
+	       "%u inputs expected, %u seen, %s\n",
+	       EVENT_QUEUE_LEN, EvStats.Posted, EvStats.Dropped, Expected,
+	       BenchFsm.Inputs,
+	       (Expected == BenchFsm.Inputs && EvStats.Dropped == 0) ?
+	       "none lost" : "LOST");
+
+	Count = ButtonFsm_TraceRead(&BenchFsm, Trace, 4);
+	for (i = 0; i < Count; i++)
+		printf("button_fsm: trace %llu: state %u input 0x%02x -> %u%s\n",
+		       (unsigned long long)Trace[i].Stamp, Trace[i].From,
+		       Trace[i].Input, Trace[i].To,
+		       Trace[i].Matched ? "" : " (ignored)");
+}
+#endif /* HOST_SIM */
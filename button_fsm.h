@@ -0,0 +1,106 @@
+/*****************************************************************************/
+/**
+* @file button_fsm.h
+*
+* Push button decoding and the Reset/Enabled/Disabled state machine.
+*
+* Each button interrupt delivers the full pmod_pushbutton_tri_i[3:0] level.
+* ButtonFsm_Update() compares it with the previous level and turns every bit
+* that changed into an input, so buttons that change together (a chord, or
+* presses that overlap) are all seen:
+*   - BUTTON_IN_PRESS(n) on the rising edge of button n,
+*   - BUTTON_IN_CHORD(mask) when a press leaves two or more buttons held,
+*   - BUTTON_IN_LONG(n) once button n has been held for BUTTON_LONG_US,
+*     reported by ButtonFsm_Poll() or the next update.
+*
+* Inputs are run through a declarative transition table. Every input,
+* whether or not a transition matched it, is recorded with its timestamp in
+* a trace ring that keeps the newest BUTTON_TRACE_LEN entries.
+*
+******************************************************************************/
+#ifndef BUTTON_FSM_H
+#define BUTTON_FSM_H
+
+#include "platform.h"
+
+/************************** Constant Definitions *****************************/
+
+#define BUTTON_COUNT		4
+#define BUTTON_MASK		((1 << BUTTON_COUNT) - 1)
+
+#define BUTTON_RESET		0	/* pmod_pushbutton_tri_i bit numbers */
+#define BUTTON_SOURCE		1
+#define BUTTON_ENABLE		2
+
+#define BUTTON_LONG_US		1000000	/* Hold time of a long press */
+#define BUTTON_TRACE_LEN	32	/* Trace entries, power of two */
+
+/*
+ * States, numbered as the state variable lcd_output() takes
+ */
+#define BUTTON_STATE_RESET	0
+#define BUTTON_STATE_ENABLED	1
+#define BUTTON_STATE_DISABLED	2
+#define BUTTON_STATE_ANY	0xFF	/* Wildcard in the transition table */
+
+/*
+ * Inputs. A chord carries the mask of the buttons held.
+ */
+#define BUTTON_IN_PRESS(n)	(0x00 | (n))
+#define BUTTON_IN_LONG(n)	(0x10 | (n))
+#define BUTTON_IN_CHORD(mask)	(0x20 | (mask))
+
+#define BUTTON_IN_IS_CHORD(in)	(((in) & 0xF0) == 0x20)
+
+/**************************** Type Definitions *******************************/
+
+typedef struct ButtonFsm ButtonFsm;
+
+typedef void (*ButtonFsm_Action)(ButtonFsm *FsmPtr);
+
+typedef struct {
+	u8 State;		/* Current state, or BUTTON_STATE_ANY */
+	u8 Input;
+	u8 Next;		/* State after the transition */
+	ButtonFsm_Action Action;	/* Run after the state changes, may be NULL */
+} ButtonFsm_Transition;
+
+typedef struct {
+	u64 Stamp;		/* Time base ticks of the button event */
+	u8 From;
+	u8 Input;
+	u8 To;
+	u8 Matched;		/* FALSE if no transition accepted the input */
+} ButtonFsm_TraceEntry;
+
+struct ButtonFsm {
+	const ButtonFsm_Transition *Table;
+	u32 TableLen;
+	u8 State;
+	u8 Source;		/* analog_source, 0 = potentiometer */
+	u8 Held;		/* Buttons currently down */
+	u8 LongSent;		/* Held buttons already reported as long */
+	u64 PressStamp[BUTTON_COUNT];
+	u64 LongTicks;
+
+	ButtonFsm_TraceEntry Trace[BUTTON_TRACE_LEN];
+	u32 TraceCount;		/* Entries ever recorded */
+
+	u32 Inputs;		/* Inputs run through the table */
+	u32 Transitions;	/* Inputs a transition accepted */
+};
+
+/************************** Function Prototypes ******************************/
+
+void ButtonFsm_Init(ButtonFsm *FsmPtr);
+u32 ButtonFsm_Update(ButtonFsm *FsmPtr, u32 Buttons, u64 Stamp);
+u32 ButtonFsm_Poll(ButtonFsm *FsmPtr, u64 Now);
+int ButtonFsm_Input(ButtonFsm *FsmPtr, u8 Input, u64 Stamp);
+u32 ButtonFsm_TraceRead(const ButtonFsm *FsmPtr, ButtonFsm_TraceEntry *Buf,
+			u32 Max);
+
+#ifdef HOST_SIM
+void ButtonFsm_Benchmark(u32 Count);
+#endif
+
+#endif /* BUTTON_FSM_H */
@@ -0,0 +1,364 @@
+/*****************************************************************************/
+/**
+* @file dlog.c
+*
+* Deferred logging ring and formatter. See dlog.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "dlog.h"
+#include "numfmt.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HOST_SIM
+#include "bench.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define DLOG_MASK		(DLOG_LEN - 1)
+#define DLOG_SPEC_MAX		16	/* Longest conversion, e.g. "%-+08.3lf" */
+
+#ifdef HOST_SIM
+#define DLOG_BENCH_NAME		"A0"
+#endif
+
+/************************** Variable Definitions *****************************/
+
+static Dlog_Msg Ring[DLOG_LEN];
+static volatile u32 Head;	/* Slots claimed by producers */
+static volatile u32 Tail;	/* Slots printed, written by the drain only */
+static Dlog_Stats Stats;
+static u32 DroppedReported;
+
+/*****************************************************************************/
+/**
+* Empties the ring and clears the counters. Call before any handler logs.
+*
+******************************************************************************/
+void Dlog_Init(void)
+{
+	u32 i;
+
+	Head = 0;
+	Tail = 0;
+	for (i = 0; i < DLOG_LEN; i++)
+		Ring[i].Seq = 0;
+	Stats = (Dlog_Stats){0};
+	DroppedReported = 0;
+}
+
+/*****************************************************************************/
+/**
+* Producer side, called through DLOG(). Claims a slot with compare and swap,
+* so a handler that preempts another producer takes the next slot, and
+* marks it filled through Seq last.
+*
+* @param	Fmt is the format string.
+* @param	Args holds a dummy word and then Count argument words.
+* @param	Count is the number of argument words.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the ring was full and the
+*		message was dropped.
+*
+******************************************************************************/
+int Dlog_Post(const char *Fmt, const Dlog_Word *Args, u32 Count)
+{
+	Dlog_Msg *MsgPtr;
+	u32 Claim, Depth, i;
+
+	Claim = Head;
+	do {
+		Depth = Claim - Tail;
+		if (Depth >= DLOG_LEN) {
+			__atomic_fetch_add(&Stats.Dropped, 1, __ATOMIC_RELAXED);
+			return XST_FAILURE;
+		}
+	} while (!__atomic_compare_exchange_n(&Head, &Claim, Claim + 1, FALSE,
+					      __ATOMIC_ACQUIRE,
+					      __ATOMIC_RELAXED));
+
+	if (Count > DLOG_MAX_ARGS)
+		Count = DLOG_MAX_ARGS;
+	MsgPtr = &Ring[Claim & DLOG_MASK];
+	MsgPtr->Fmt = Fmt;
+	MsgPtr->Count = Count;
+	for (i = 0; i < Count; i++)
+		MsgPtr->Arg[i] = Args[i + 1];
+	MEMORY_BARRIER();
+	MsgPtr->Seq = Claim + 1;
+
+	__atomic_fetch_add(&Stats.Posted, 1, __ATOMIC_RELAXED);
+	if (Depth + 1 > Stats.PeakDepth)
+		Stats.PeakDepth = Depth + 1;
+	return XST_SUCCESS;
+}
+
+/*
+ * Formats one argument word with one conversion. Spec holds the conversion
+ * without a length modifier; Long is set if the caller wrote one. Plain
+ * %d, %i, %u and %x, the common case, skip snprintf.
+ */
+static int Dlog_FormatArg(char *Buf, u32 Size, char *Spec, u32 SpecLen,
+			  int Long, Dlog_Word Word)
+{
+	char Conv = Spec[SpecLen - 1];
+	union {
+		u32 W;
+		float F;
+	} Bits;
+
+	if (SpecLen == 2 && !Long && Size >= NUMFMT_MAX) {
+		if (Conv == 'd' || Conv == 'i')
+			return NumFmt_Dec(Buf, (s32)(u32)Word);
+		if (Conv == 'u')
+			return NumFmt_Udec(Buf, (u32)Word);
+		if (Conv == 'x')
+			return NumFmt_Hex(Buf, (u32)Word, 0);
+	}
+
+	switch (Conv) {
+	case 'd':
+	case 'i':
+		if (!Long)
+			return snprintf(Buf, Size, Spec, (int)(u32)Word);
+		break;
+	case 'u':
+	case 'x':
+	case 'X':
+	case 'o':
+		if (!Long)
+			return snprintf(Buf, Size, Spec, (unsigned int)(u32)Word);
+		break;
+	case 'c':
+		return snprintf(Buf, Size, Spec, (int)Word);
+	case 's':
+		return snprintf(Buf, Size, Spec, (const char *)Word);
+	case 'p':
+		return snprintf(Buf, Size, Spec, (void *)Word);
+	default:
+		Bits.W = (u32)Word;
+		return snprintf(Buf, Size, Spec, (double)Bits.F);
+	}
+
+	/* Put the l back in front of the conversion character */
+	Spec[SpecLen - 1] = 'l';
+	Spec[SpecLen] = Conv;
+	Spec[SpecLen + 1] = '\0';
+	if (Conv == 'd' || Conv == 'i')
+		return snprintf(Buf, Size, Spec, (long)Word);
+	return snprintf(Buf, Size, Spec, (unsigned long)Word);
+}
+
+/*****************************************************************************/
+/**
+* Formats a message the way printf would with the same arguments. Text
+* that does not fit in Size is cut off.
+*
+* @return	Length of the text in Buf.
+*
+******************************************************************************/
+u32 Dlog_Format(const Dlog_Msg *MsgPtr, char *Buf, u32 Size)
+{
+	const char *Fmt = MsgPtr->Fmt;
+	char Spec[DLOG_SPEC_MAX + 2];
+	u32 Len = 0, SpecLen, Arg = 0;
+	int Long, Out;
+
+	if (Size == 0)
+		return 0;
+	while (*Fmt != '\0' && Len + 1 < Size) {
+		if (*Fmt != '%') {
+			Buf[Len++] = *Fmt++;
+			continue;
+		}
+		if (Fmt[1] == '%') {
+			Buf[Len++] = '%';
+			Fmt += 2;
+			continue;
+		}
+
+		/* Flags, width and precision go into Spec as they are */
+		SpecLen = 0;
+		Long = FALSE;
+		Spec[SpecLen++] = *Fmt++;
+		while (*Fmt != '\0' && SpecLen < DLOG_SPEC_MAX - 1 &&
+		       strchr("-+ #0123456789.hlzjt", *Fmt) != NULL) {
+			if (*Fmt == 'l')
+				Long = TRUE;
+			if (strchr("hlzjt", *Fmt) == NULL)
+				Spec[SpecLen++] = *Fmt;
+			Fmt++;
+		}
+		if (*Fmt == '\0')
+			break;
+		Spec[SpecLen++] = *Fmt++;
+		Spec[SpecLen] = '\0';
+
+		Out = Dlog_FormatArg(Buf + Len, Size - Len, Spec, SpecLen, Long,
+				     (Arg < MsgPtr->Count) ? MsgPtr->Arg[Arg] : 0);
+		Arg++;
+		if (Out > 0)
+			Len += ((u32)Out < Size - Len) ? (u32)Out : Size - Len - 1;
+	}
+	Buf[Len] = '\0';
+	return Len;
+}
+
+/*****************************************************************************/
+/**
+* Consumer side, called from the main loop. Formats and sends up to Max
+* messages, oldest first, and then a line with the number of messages
+* dropped since the last report, if any. Stops early at a slot whose
+* producer was interrupted before it finished filling it.
+*
+* @return	Messages sent.
+*
+******************************************************************************/
+u32 Dlog_Drain(Dlog_PutFn Put, u32 Max)
+{
+	char Line[DLOG_LINE_MAX];
+	Dlog_Msg *MsgPtr;
+	u32 Done = 0, Dropped;
+
+	while (Done < Max && Tail != Head) {
+		MsgPtr = &Ring[Tail & DLOG_MASK];
+		if (MsgPtr->Seq != Tail + 1)
+			break;
+		MEMORY_BARRIER();
+		Dlog_Format(MsgPtr, Line, sizeof(Line));
+		MEMORY_BARRIER();
+		Tail = Tail + 1;
+		Put(Line);
+		Done++;
+	}
+	Stats.Printed += Done;
+
+	Dropped = Stats.Dropped;
+	if (Dropped != DroppedReported) {
+		snprintf(Line, sizeof(Line), "dlog: %lu messages dropped\r\n",
+			 (unsigned long)(Dropped - DroppedReported));
+		DroppedReported = Dropped;
+		Put(Line);
+	}
+	return Done;
+}
+
+void Dlog_GetStats(Dlog_Stats *StatsPtr)
+{
+	*StatsPtr = Stats;
+}
+
+#ifdef HOST_SIM
+static char PutBuf[DLOG_LEN * DLOG_LINE_MAX];
+static u32 PutLen;
+
+static void Dlog_BufPut(const char *Text)
+{
+	u32 Len = strlen(Text);
+
+	if (PutLen + Len < sizeof(PutBuf)) {
+		memcpy(PutBuf + PutLen, Text, Len + 1);
+		PutLen += Len;
+	}
+}
+
+/*****************************************************************************/
+/**
+* Host benchmark. Times Count DLOG() calls against fprintf() of the same
+* message to /dev/null, which still formats but does not wait for a UART
+* the way printf does on the board. Then checks that the drained text
+* matches snprintf() for a set of formats used in the firmware, and that a
+* full ring drops and reports the overflow.
+*
+******************************************************************************/
+void Dlog_Benchmark(u32 Count)
+{
+	static const char *const Name = DLOG_BENCH_NAME;
+	char Expect[DLOG_LEN * DLOG_LINE_MAX];
+	u32 ExpectLen = 0, Start = 0, DlogCycles, PrintfCycles, i;
+	u32 Fail = 0;
+	Dlog_Stats Snap;
+	FILE *Null;
+
+	Bench_Init();
+	Null = fopen("/dev/null", "w");
+	if (Null == NULL)
+		return;
+
+	/* Timed a ring at a time, emptying it in between is not counted */
+	DlogCycles = 0;
+	for (i = 0; i < Count; i++) {
+		if ((i & DLOG_MASK) == 0) {
+			Dlog_Init();
+			Start = Bench_Cycles();
+		}
+		DLOG("Analog Input %s: %ld mV\r\n", DLOG_S(Name), (long)i);
+		if ((i & DLOG_MASK) == DLOG_MASK || i + 1 == Count)
+			DlogCycles += Bench_Cycles() - Start;
+	}
+	Start = Bench_Cycles();
+	for (i = 0; i < Count; i++)
+		fprintf(Null, "Analog Input %s: %ld mV\r\n", Name, (long)i);
+	PrintfCycles = Bench_Cycles() - Start;
+	fclose(Null);
+	printf("dlog: %.1f ns per DLOG, %.1f ns per fprintf\n",
+	       (double)DlogCycles / Count, (double)PrintfCycles / Count);
+
+	/* The drained text must be what printf prints */
+#define DLOG_CHECK(Fmt, ...) \
+	do { \
+		DLOG(Fmt, ##__VA_ARGS__); \
+		ExpectLen += snprintf(Expect + ExpectLen, \
+				      sizeof(Expect) - ExpectLen, \
+				      Fmt, ##__VA_ARGS__); \
+	} while (0)
+	Dlog_Init();
+	PutLen = 0;
+	DLOG("Inside GPIO Handler\n");
+	ExpectLen += snprintf(Expect + ExpectLen, sizeof(Expect) - ExpectLen,
+			      "Inside GPIO Handler\n");
+	DLOG_CHECK("Duty Cycle: %lu/%u \r\n", 3276UL, 0xFFFFU);
+	DLOG_CHECK("%d frames not read\r\n", -7);
+	DLOG_CHECK("Raw data %d %d \r\n", 17, 0xFFF0);
+	DLOG_CHECK("%5u|%-5d|%05x|%#X|%o|%c|%%\n", 42U, -42, 0xBEEF, 0xBEEFU,
+		   8U, 'Z');
+	DLOG_CHECK("%ld %lu %lx\n", -123456789L, 4000000000UL, 0xDEADBEEFUL);
+	DLOG("%s %s\r\n", DLOG_S("A1 dark"), DLOG_S("entered"));
+	ExpectLen += snprintf(Expect + ExpectLen, sizeof(Expect) - ExpectLen,
+			      "%s %s\r\n", "A1 dark", "entered");
+	DLOG("[%8s|%-8s|%.2s]\n", DLOG_S("ab"), DLOG_S("cd"), DLOG_S("efg"));
+	ExpectLen += snprintf(Expect + ExpectLen, sizeof(Expect) - ExpectLen,
+			      "[%8s|%-8s|%.2s]\n", "ab", "cd", "efg");
+	DLOG("Analog Input %s: %.3fV %5.2F %e %g\r\n", DLOG_S(Name),
+	     DLOG_F(1.25f), DLOG_F(-3.5f), DLOG_F(0.000125f), DLOG_F(100.0f));
+	ExpectLen += snprintf(Expect + ExpectLen, sizeof(Expect) - ExpectLen,
+			      "Analog Input %s: %.3fV %5.2F %e %g\r\n", Name,
+			      1.25, -3.5, 0.000125, 100.0);
+#undef DLOG_CHECK
+	Dlog_Drain(Dlog_BufPut, DLOG_LEN);
+	if (PutLen != ExpectLen || strcmp(PutBuf, Expect) != 0) {
+		printf("dlog: got\n%s\ndlog: expected\n%s\n", PutBuf, Expect);
+		Fail |= 1;
+	}
+
+	/* One ring full, then drops */
+	Dlog_Init();
+	for (i = 0; i < DLOG_LEN + 5; i++)
+		DLOG("%u\n", i);
+	PutLen = 0;
+	if (Dlog_Drain(Dlog_BufPut, DLOG_LEN * 2) != DLOG_LEN)
+		Fail |= 2;
+	Dlog_GetStats(&Snap);
+	if (Snap.Dropped != 5 || Snap.Posted != DLOG_LEN ||
+	    strstr(PutBuf, "dlog: 5 messages dropped") == NULL)
+		Fail |= 4;
+	if (Dlog_Drain(Dlog_BufPut, DLOG_LEN) != 0 || DLOG("x\n") != XST_SUCCESS)
+		Fail |= 8;
+
+	printf("dlog: checks %s (0x%x)\n", Fail ? "FAIL" : "ok", Fail);
+}
+#endif /* HOST_SIM */
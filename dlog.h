@@ -0,0 +1,96 @@
+/*****************************************************************************/
+/**
+* @file dlog.h
+*
+* Deferred logging for interrupt handlers and hot loops.
+*
+* DLOG() takes a printf format and its arguments, but only stores the
+* address of the format string, which is fixed at link time and serves as
+* its ID, and the raw argument words in a slot of a lock-free ring. The main
+* loop calls Dlog_Drain(), which does the formatting and sends the text
+* out, so the caller never waits for the UART. When the ring is full a
+* message is dropped and counted; the drain reports the count.
+*
+* DLOG() is safe from the main loop and from interrupt handlers, including
+* nested ones. The format must be a string literal. Arguments are stored as
+* Dlog_Word, a native word:
+* - integers (%d %i %u %x %X %o %c, with or without l) are passed as is;
+* - strings (%s) and pointers (%p) with DLOG_S(), and the string must
+*   still exist when the drain runs, e.g. a literal or a table entry;
+* - floating point (%f %F %e %g) with DLOG_F(), which keeps float
+*   precision.
+* 64-bit integers (%ll) and %n are not supported.
+*
+******************************************************************************/
+#ifndef DLOG_H
+#define DLOG_H
+
+#include "platform.h"
+
+/************************** Constant Definitions *****************************/
+
+#define DLOG_LEN		64	/* Slots in the ring, power of two */
+#define DLOG_MAX_ARGS		6	/* Argument words per message */
+#define DLOG_LINE_MAX		128	/* Longest formatted message */
+
+/**************************** Type Definitions *******************************/
+
+typedef unsigned long Dlog_Word;	/* Holds a u32 or a pointer */
+
+typedef struct {
+	volatile u32 Seq;	/* Claim number + 1 once the slot is filled */
+	u32 Count;		/* Argument words used */
+	const char *Fmt;
+	Dlog_Word Arg[DLOG_MAX_ARGS];
+} Dlog_Msg;
+
+typedef struct {
+	u32 Posted;
+	u32 Dropped;		/* Messages lost because the ring was full */
+	u32 PeakDepth;
+	u32 Printed;
+} Dlog_Stats;
+
+/*
+ * Sends one formatted message, e.g. print() to the UART
+ */
+typedef void (*Dlog_PutFn)(const char *Text);
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+static inline Dlog_Word Dlog_FloatWord(float Value)
+{
+	union {
+		float F;
+		u32 W;
+	} Bits;
+
+	Bits.F = Value;
+	return Bits.W;
+}
+
+#define DLOG_F(Value)		Dlog_FloatWord(Value)
+#define DLOG_S(Ptr)		((Dlog_Word)(const void *)(Ptr))
+
+/*
+ * The leading 0 lets the list be empty; Dlog_Post() skips it. sizeof does
+ * not evaluate the arguments.
+ */
+#define DLOG(Fmt, ...) \
+	Dlog_Post((Fmt), (const Dlog_Word[]){ 0, ##__VA_ARGS__ }, \
+		  sizeof((Dlog_Word[]){ 0, ##__VA_ARGS__ }) / \
+		  sizeof(Dlog_Word) - 1)
+
+/************************** Function Prototypes ******************************/
+
+void Dlog_Init(void);
+int Dlog_Post(const char *Fmt, const Dlog_Word *Args, u32 Count);
+u32 Dlog_Drain(Dlog_PutFn Put, u32 Max);
+u32 Dlog_Format(const Dlog_Msg *MsgPtr, char *Buf, u32 Size);
+void Dlog_GetStats(Dlog_Stats *StatsPtr);
+
+#ifdef HOST_SIM
+void Dlog_Benchmark(u32 Count);
+#endif
+
+#endif /* DLOG_H */
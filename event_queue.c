@@ -0,0 +1,325 @@
+/*****************************************************************************/
+/**
+* @file event_queue.c
+*
+* Lock-free event ring and main-loop dispatcher. See event_queue.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "event_queue.h"
+#include "timebase.h"
+#include "idle.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#else
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define EVENT_QUEUE_MASK	(EVENT_QUEUE_LEN - 1)
+
+/************************** Variable Definitions *****************************/
+
+static Event_Queue IsrQueue;
+static Event_Handler Handlers[EVENT_TYPE_COUNT];
+static Event_IsrStats IsrStats[EVENT_TYPE_COUNT];
+static u32 Dispatched;
+
+/*****************************************************************************/
+/**
+* Empties a ring and clears its counters.
+*
+******************************************************************************/
+void Event_QueueInit(Event_Queue *QueuePtr)
+{
+	QueuePtr->Head = 0;
+	QueuePtr->Tail = 0;
+	QueuePtr->Posted = 0;
+	QueuePtr->Dropped = 0;
+	QueuePtr->PeakDepth = 0;
+}
+
+/*****************************************************************************/
+/**
+* Producer side. Copies the event into the ring.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the ring was full and the event
+*		was dropped.
+*
+******************************************************************************/
+int Event_Push(Event_Queue *QueuePtr, const Event *EventPtr)
+{
+	u32 Head = QueuePtr->Head;
+	u32 Depth = Head - QueuePtr->Tail;
+
+	if (Depth >= EVENT_QUEUE_LEN) {
+		QueuePtr->Dropped++;
+		return XST_FAILURE;
+	}
+
+	QueuePtr->Ring[Head & EVENT_QUEUE_MASK] = *EventPtr;
+	MEMORY_BARRIER();
+	QueuePtr->Head = Head + 1;
+
+	QueuePtr->Posted++;
+	if (Depth + 1 > QueuePtr->PeakDepth)
+		QueuePtr->PeakDepth = Depth + 1;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Consumer side. Copies the oldest event out of the ring.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the ring was empty.
+*
+******************************************************************************/
+int Event_Pop(Event_Queue *QueuePtr, Event *EventPtr)
+{
+	u32 Tail = QueuePtr->Tail;
+
+	if (QueuePtr->Head == Tail)
+		return XST_FAILURE;
+
+	MEMORY_BARRIER();
+	*EventPtr = QueuePtr->Ring[Tail & EVENT_QUEUE_MASK];
+	MEMORY_BARRIER();
+	QueuePtr->Tail = Tail + 1;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Resets the interrupt event ring, the handler table and the statistics.
+* Call before any interrupt that posts events is enabled.
+*
+******************************************************************************/
+void Event_Init(void)
+{
+	u16 Type;
+
+	Event_QueueInit(&IsrQueue);
+	for (Type = 0; Type < EVENT_TYPE_COUNT; Type++) {
+		Handlers[Type] = NULL;
+		IsrStats[Type] = (Event_IsrStats){0};
+	}
+	Dispatched = 0;
+}
+
+/*****************************************************************************/
+/**
+* Sets the bottom-half handler run by Event_Dispatch() for an event type.
+*
+******************************************************************************/
+void Event_Register(u16 Type, Event_Handler Handler)
+{
+	if (Type < EVENT_TYPE_COUNT)
+		Handlers[Type] = Handler;
+}
+
+/*****************************************************************************/
+/**
+* Timestamps an event and queues it for the main loop. Called from interrupt
+* context, in any tier.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the ring was full.
+*
+* @note		The push runs with the IRQ masked and the caller's mask
+*		restored afterwards, so a more urgent handler cannot post
+*		into the ring between another handler's copy and its Head
+*		update. The simulated GIC only preempts in HwSim_GicRaise(),
+*		never inside a push.
+*
+******************************************************************************/
+int Event_Post(u16 Type, u32 Arg)
+{
+	Event Ev;
+	int Status;
+#ifndef HOST_SIM
+	u32 Cpsr;
+#endif
+
+	Ev.Stamp = now_ticks();
+	Ev.Type = Type;
+	Ev.Reserved = 0;
+	Ev.Arg = Arg;
+
+#ifndef HOST_SIM
+	Cpsr = mfcpsr();
+	mtcpsr(Cpsr | XIL_EXCEPTION_IRQ);
+#endif
+	Status = Event_Push(&IsrQueue, &Ev);
+#ifndef HOST_SIM
+	mtcpsr(Cpsr);
+#endif
+	return Status;
+}
+
+/*****************************************************************************/
+/**
+* Records the duration of the interrupt handler that posts Type. Call at the
+* end of the handler with the now_ticks() value read on entry.
+*
+* @note		The CPU load report does not use these times: they include
+*		any handler nested in this one. Intr_Entry() charges
+*		IDLE_SLOT_ISR instead.
+*
+******************************************************************************/
+void Event_IsrDone(u16 Type, u64 StartTicks)
+{
+	u32 Ticks = (u32)(now_ticks() - StartTicks);
+	Event_IsrStats *StatsPtr;
+
+	if (Type >= EVENT_TYPE_COUNT)
+		return;
+
+	StatsPtr = &IsrStats[Type];
+	StatsPtr->Count++;
+	StatsPtr->TotalTicks += Ticks;
+	if (Ticks > StatsPtr->MaxTicks)
+		StatsPtr->MaxTicks = Ticks;
+}
+
+/*****************************************************************************/
+/**
+* @return	TRUE if an interrupt has posted an event that has not been
+*		dispatched yet.
+*
+******************************************************************************/
+int Event_Pending(void)
+{
+	return IsrQueue.Head != IsrQueue.Tail;
+}
+
+/*****************************************************************************/
+/**
+* Drains the interrupt event ring and runs the registered handlers. Called
+* from the main loop. The time each handler takes is charged to its event
+* type for the CPU load report.
+*
+* @return	Number of events handled.
+*
+******************************************************************************/
+u32 Event_Dispatch(void)
+{
+	Event Ev;
+	u32 Count = 0;
+	u64 Start;
+
+	while (Event_Pop(&IsrQueue, &Ev) == XST_SUCCESS) {
+		if (Ev.Type < EVENT_TYPE_COUNT && Handlers[Ev.Type] != NULL) {
+			Start = now_ticks();
+			Handlers[Ev.Type](&Ev);
+			Idle_Charge(Ev.Type, now_ticks() - Start);
+		}
+		Count++;
+	}
+	Dispatched += Count;
+
+	return Count;
+}
+
+/*****************************************************************************/
+/**
+* Returns a snapshot of the ring and interrupt handler statistics.
+*
+******************************************************************************/
+void Event_GetStats(Event_Stats *StatsPtr)
+{
+	u16 Type;
+
+	StatsPtr->Posted = IsrQueue.Posted;
+	StatsPtr->Dropped = IsrQueue.Dropped;
+	StatsPtr->PeakDepth = IsrQueue.PeakDepth;
+	StatsPtr->Dispatched = Dispatched;
+	for (Type = 0; Type < EVENT_TYPE_COUNT; Type++)
+		StatsPtr->Isr[Type] = IsrStats[Type];
+}
+
+#ifdef HOST_SIM
+static Event_Queue BenchQueue;
+static volatile int BenchDone;
+static u32 BenchCount;
+static int BenchRetry;
+
+static void *Event_BenchProducer(void *Param)
+{
+	Event Ev = {0};
+	u32 i;
+
+	(void)Param;
+	for (i = 0; i < BenchCount; i++) {
+		Ev.Arg = i;
+		while (Event_Push(&BenchQueue, &Ev) != XST_SUCCESS && BenchRetry)
+			sched_yield();
+	}
+	MEMORY_BARRIER();
+	BenchDone = 1;
+	return NULL;
+}
+
+static void Event_BenchRun(u32 Count, int Retry)
+{
+	pthread_t Producer;
+	Event Ev;
+	u64 Start, Elapsed;
+	u32 Received = 0;
+	u32 Disorder = 0;
+	s64 Last = -1;
+
+	Event_QueueInit(&BenchQueue);
+	BenchDone = 0;
+	BenchCount = Count;
+	BenchRetry = Retry;
+
+	Start = now_ticks();
+	pthread_create(&Producer, NULL, Event_BenchProducer, NULL);
+	for (;;) {
+		if (Event_Pop(&BenchQueue, &Ev) == XST_SUCCESS) {
+			if ((s64)Ev.Arg <= Last)
+				Disorder++;
+			Last = Ev.Arg;
+			Received++;
+		} else if (BenchDone && BenchQueue.Head == BenchQueue.Tail) {
+			break;
+		} else {
+			sched_yield();
+		}
+	}
+	pthread_join(Producer, NULL);
+	Elapsed = now_ticks() - Start;
+
+	printf("event_queue: %-8s %u events in %.3f ms, %.1f M delivered/s, "
+	       "delivered %u, dropped %u, peak depth %u, out of order %u, "
+	       "unaccounted %d\n",
+	       Retry ? "retry" : "drop", Count, Elapsed / 1e6,
+	       Received * 1e3 / Elapsed, Received, BenchQueue.Dropped,
+	       BenchQueue.PeakDepth, Disorder,
+	       (int)(Count - Received - (Retry ? 0 : BenchQueue.Dropped)));
+}
+
+/*****************************************************************************/
+/**
+* Host stress test. A producer thread pushes Count events as fast as it can
+* while this thread drains them, once retrying on a full ring to measure
+* lossless throughput (Dropped then counts the retries), and once dropping
+* like an interrupt handler would. Checks that events arrive in order and
+* that every event was either delivered or counted as dropped. Both sides
+* yield when they cannot make progress so the test also runs on one core.
+*
+******************************************************************************/
+void Event_Benchmark(u32 Count)
+{
+	Event_BenchRun(Count, TRUE);
+	Event_BenchRun(Count, FALSE);
+}
+#endif /* HOST_SIM */
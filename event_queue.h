@@ -0,0 +1,94 @@
+/*****************************************************************************/
+/**
+* @file event_queue.h
+*
+* Deferred work for interrupt handlers.
+*
+* An interrupt handler (top half) only timestamps a small event record and
+* pushes it into a fixed-size single-producer/single-consumer ring with
+* Event_Post(). The main loop calls Event_Dispatch(), which drains the ring
+* and runs the handler registered for each event type (bottom half) outside
+* interrupt context.
+*
+* Event_Push() and Event_Pop() form a single-producer/single-consumer pair.
+* Handlers of different interrupt tiers nest and all post to the one
+* interrupt ring, so Event_Post() masks the IRQ for the few instructions of
+* the push: a handler that preempts another one in the middle of a post
+* then waits until that post is complete. The consumer is the main loop.
+*
+******************************************************************************/
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include "platform.h"
+
+/************************** Constant Definitions *****************************/
+
+#define EVENT_QUEUE_LEN		64	/* Ring entries, power of two */
+
+/*
+ * Event types, one per interrupt source
+ */
+#define EVENT_BUTTON		0	/* Arg: pmod_pushbutton_tri_i bitmask */
+#define EVENT_TIMER_TICK	1	/* Arg: XTmrCtr timer number */
+#define EVENT_XADC_EOS		2	/* Arg: XSysMon status */
+#define EVENT_MAILBOX		3	/* AMP doorbell SGI, Arg: 0 */
+#define EVENT_TYPE_COUNT	4
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u64 Stamp;		/* now_ticks() when the event was posted */
+	u16 Type;
+	u16 Reserved;
+	u32 Arg;
+} Event;
+
+typedef struct {
+	Event Ring[EVENT_QUEUE_LEN];
+	volatile u32 Head;	/* Written by the producer only */
+	volatile u32 Tail;	/* Written by the consumer only */
+	u32 Posted;
+	u32 Dropped;		/* Events lost because the ring was full */
+	u32 PeakDepth;
+} Event_Queue;
+
+typedef void (*Event_Handler)(const Event *EventPtr);
+
+/*
+ * Time spent in the interrupt handler that posts each event type, in time
+ * base ticks
+ */
+typedef struct {
+	u32 Count;
+	u32 MaxTicks;
+	u64 TotalTicks;
+} Event_IsrStats;
+
+typedef struct {
+	u32 Posted;
+	u32 Dropped;
+	u32 PeakDepth;
+	u32 Dispatched;
+	Event_IsrStats Isr[EVENT_TYPE_COUNT];
+} Event_Stats;
+
+/************************** Function Prototypes ******************************/
+
+void Event_QueueInit(Event_Queue *QueuePtr);
+int Event_Push(Event_Queue *QueuePtr, const Event *EventPtr);
+int Event_Pop(Event_Queue *QueuePtr, Event *EventPtr);
+
+void Event_Init(void);
+void Event_Register(u16 Type, Event_Handler Handler);
+int Event_Post(u16 Type, u32 Arg);
+void Event_IsrDone(u16 Type, u64 StartTicks);
+int Event_Pending(void);
+u32 Event_Dispatch(void);
+void Event_GetStats(Event_Stats *StatsPtr);
+
+#ifdef HOST_SIM
+void Event_Benchmark(u32 Count);
+#endif
+
+#endif /* EVENT_QUEUE_H */
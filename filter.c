@@ -0,0 +1,774 @@
+/*****************************************************************************/
+/**
+* @file filter.c
+*
+* ADC filter stages and chains. See filter.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "filter.h"
+#include "fixed.h"
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include <string.h>
+#include "timebase.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define FILTER_Y_FRAC		12	/* Fraction bits kept in biquad feedback */
+#define FILTER_MAX_FACTOR	256	/* Largest decimation factor */
+
+#define FILTER_PI		3.14159265358979323846
+
+#ifdef HOST_SIM
+#define FILTER_BENCH_LEN	100000	/* Samples in the self-check signal */
+#define FILTER_BENCH_BLOCK	256
+#endif
+
+/*****************************************************************************/
+/**
+* @return	log2(Value) if Value is a power of two, otherwise -1.
+*
+******************************************************************************/
+static s32 Filter_Log2(u32 Value)
+{
+	s32 Shift = 0;
+
+	if (Value == 0 || (Value & (Value - 1)) != 0)
+		return -1;
+	while ((1U << Shift) != Value)
+		Shift++;
+	return Shift;
+}
+
+/*
+ * Sum / Len rounded to nearest, by shifting when Len is a power of two
+ */
+static inline s32 Filter_Mean(s32 Sum, u32 Len, s32 Shift)
+{
+	if (Shift == 0)
+		return Sum;
+	if (Shift > 0)
+		return (s32)Fixed_RoundShift(Sum, Shift);
+	return (s32)Fixed_RoundDiv(Sum, Len);
+}
+
+static inline s32 Filter_Med3(s32 A, s32 B, s32 C)
+{
+	s32 Lo = (A < B) ? A : B;
+	s32 Hi = (A < B) ? B : A;
+
+	if (Hi > C)
+		Hi = C;
+	return (Lo > Hi) ? Lo : Hi;
+}
+
+/*
+ * Median of five: the median of E and the middle pair of A..D
+ */
+static inline s32 Filter_Med5(s32 A, s32 B, s32 C, s32 D, s32 E)
+{
+	s32 MinAB = (A < B) ? A : B, MaxAB = (A < B) ? B : A;
+	s32 MinCD = (C < D) ? C : D, MaxCD = (C < D) ? D : C;
+
+	return Filter_Med3(E, (MinAB > MinCD) ? MinAB : MinCD,
+			   (MaxAB < MaxCD) ? MaxAB : MaxCD);
+}
+
+/*
+ * Cosine and sine by their series, for the coefficient design at init, so
+ * the application does not need libm. |W| must not exceed pi.
+ */
+static double Filter_CosSin(double W, double *SinPtr)
+{
+	double Cos = 1.0, Sin = W, CosTerm = 1.0, SinTerm = W;
+	u32 N;
+
+	for (N = 1; N < 12; N++) {
+		CosTerm *= -W * W / ((2 * N - 1) * (2 * N));
+		SinTerm *= -W * W / ((2 * N) * (2 * N + 1));
+		Cos += CosTerm;
+		Sin += SinTerm;
+	}
+	*SinPtr = Sin;
+	return Cos;
+}
+
+/*****************************************************************************/
+/**
+* Moving average of the last Len inputs.
+*
+******************************************************************************/
+static u32 Filter_MovAvgBlock(Filter_Stage *StagePtr, s32 *Data, u32 Count)
+{
+	Filter_MovAvg *Ma = &StagePtr->S.MovAvg;
+	u32 Index, Pos = Ma->Pos;
+	s32 Sum = Ma->Sum;
+
+	if (!StagePtr->Primed) {
+		for (Index = 0; Index < Ma->Len; Index++)
+			Ma->Hist[Index] = Data[0];
+		Sum = Data[0] * (s32)Ma->Len;
+		StagePtr->Primed = TRUE;
+	}
+
+	for (Index = 0; Index < Count; Index++) {
+		Sum += Data[Index] - Ma->Hist[Pos];
+		Ma->Hist[Pos] = Data[Index];
+		if (++Pos == Ma->Len)
+			Pos = 0;
+		Data[Index] = Filter_Mean(Sum, Ma->Len, Ma->Shift);
+	}
+
+	Ma->Pos = Pos;
+	Ma->Sum = Sum;
+	return Count;
+}
+
+/*****************************************************************************/
+/**
+* Direct form I biquad. The feedback path keeps FILTER_Y_FRAC fraction bits
+* so low cut-off sections do not stall on rounding.
+*
+******************************************************************************/
+static u32 Filter_BiquadBlock(Filter_Stage *StagePtr, s32 *Data, u32 Count)
+{
+	Filter_Biquad *Bq = &StagePtr->S.Biquad;
+	s32 X1, X2, Y1, Y2, Y;
+	s64 Acc;
+	u32 Index;
+
+	if (!StagePtr->Primed) {
+		Bq->X1 = Bq->X2 = Data[0];
+		Bq->Y1 = Bq->Y2 = Data[0] << FILTER_Y_FRAC;
+		StagePtr->Primed = TRUE;
+	}
+	X1 = Bq->X1;
+	X2 = Bq->X2;
+	Y1 = Bq->Y1;
+	Y2 = Bq->Y2;
+
+	for (Index = 0; Index < Count; Index++) {
+		Acc = ((s64)Bq->B0 * Data[Index] + (s64)Bq->B1 * X1 +
+		       (s64)Bq->B2 * X2) * (1 << FILTER_Y_FRAC) -
+		      (s64)Bq->A1 * Y1 - (s64)Bq->A2 * Y2;
+		Y = Fixed_Q16Sat(Fixed_RoundShift(Acc, FILTER_BIQUAD_FRAC));
+		X2 = X1;
+		X1 = Data[Index];
+		Y2 = Y1;
+		Y1 = Y;
+		Data[Index] = (s32)Fixed_RoundShift(Y, FILTER_Y_FRAC);
+	}
+
+	Bq->X1 = X1;
+	Bq->X2 = X2;
+	Bq->Y1 = Y1;
+	Bq->Y2 = Y2;
+	return Count;
+}
+
+/*
+ * Out[i] is the median of In[i] to In[i + Len - 1]
+ */
+static void Filter_MedianKernel(const s32 *In, s32 *Out, u32 Count, u32 Len)
+{
+	u32 Index = 0;
+
+#ifdef __ARM_NEON
+	if (Len == 3) {
+		for (; Index + 4 <= Count; Index += 4) {
+			int32x4_t A = vld1q_s32(In + Index);
+			int32x4_t B = vld1q_s32(In + Index + 1);
+			int32x4_t C = vld1q_s32(In + Index + 2);
+			int32x4_t Lo = vminq_s32(A, B);
+			int32x4_t Hi = vminq_s32(vmaxq_s32(A, B), C);
+
+			vst1q_s32(Out + Index, vmaxq_s32(Lo, Hi));
+		}
+	} else {
+		for (; Index + 4 <= Count; Index += 4) {
+			int32x4_t A = vld1q_s32(In + Index);
+			int32x4_t B = vld1q_s32(In + Index + 1);
+			int32x4_t C = vld1q_s32(In + Index + 2);
+			int32x4_t D = vld1q_s32(In + Index + 3);
+			int32x4_t E = vld1q_s32(In + Index + 4);
+			int32x4_t F = vmaxq_s32(vminq_s32(A, B), vminq_s32(C, D));
+			int32x4_t G = vminq_s32(vmaxq_s32(A, B), vmaxq_s32(C, D));
+			int32x4_t Lo = vminq_s32(E, F);
+			int32x4_t Hi = vminq_s32(vmaxq_s32(E, F), G);
+
+			vst1q_s32(Out + Index, vmaxq_s32(Lo, Hi));
+		}
+	}
+#endif
+
+	if (Len == 3) {
+		for (; Index < Count; Index++)
+			Out[Index] = Filter_Med3(In[Index], In[Index + 1],
+						 In[Index + 2]);
+	} else {
+		for (; Index < Count; Index++)
+			Out[Index] = Filter_Med5(In[Index], In[Index + 1],
+						 In[Index + 2], In[Index + 3],
+						 In[Index + 4]);
+	}
+}
+
+/*****************************************************************************/
+/**
+* Median of the last Len inputs. The block is copied behind the saved
+* history a chunk at a time so the kernel reads one contiguous window.
+*
+******************************************************************************/
+static u32 Filter_MedianBlock(Filter_Stage *StagePtr, s32 *Data, u32 Count)
+{
+	Filter_Median *Md = &StagePtr->S.Median;
+	s32 Ext[FILTER_MAX_MEDIAN - 1 + FILTER_CHUNK];
+	u32 Hist = Md->Len - 1;
+	u32 Index, Done, Chunk;
+
+	if (!StagePtr->Primed) {
+		for (Index = 0; Index < Hist; Index++)
+			Md->Hist[Index] = Data[0];
+		StagePtr->Primed = TRUE;
+	}
+
+	for (Done = 0; Done < Count; Done += Chunk) {
+		Chunk = Count - Done;
+		if (Chunk > FILTER_CHUNK)
+			Chunk = FILTER_CHUNK;
+		for (Index = 0; Index < Hist; Index++)
+			Ext[Index] = Md->Hist[Index];
+		for (Index = 0; Index < Chunk; Index++)
+			Ext[Hist + Index] = Data[Done + Index];
+
+		Filter_MedianKernel(Ext, Data + Done, Chunk, Md->Len);
+
+		for (Index = 0; Index < Hist; Index++)
+			Md->Hist[Index] = Ext[Chunk + Index];
+	}
+	return Count;
+}
+
+/*****************************************************************************/
+/**
+* Replaces every Factor inputs by their mean. Groups continue across
+* blocks.
+*
+******************************************************************************/
+static u32 Filter_DecimateBlock(Filter_Stage *StagePtr, s32 *Data, u32 Count)
+{
+	Filter_Decimate *Dc = &StagePtr->S.Decimate;
+	u32 Index = 0, Out = 0, Pos = Dc->Pos;
+	s32 Sum = Dc->Sum;
+
+	while (Index < Count) {
+#ifdef __ARM_NEON
+		if (Pos == 0 && (Dc->Factor & 3) == 0 &&
+		    Count - Index >= Dc->Factor) {
+			int32x4_t Acc = vld1q_s32(Data + Index);
+			int32x2_t Pair;
+			u32 Lane;
+
+			for (Lane = 4; Lane < Dc->Factor; Lane += 4)
+				Acc = vaddq_s32(Acc, vld1q_s32(Data + Index + Lane));
+			Pair = vpadd_s32(vget_low_s32(Acc), vget_high_s32(Acc));
+			Sum = vget_lane_s32(Pair, 0) + vget_lane_s32(Pair, 1);
+			Data[Out++] = Filter_Mean(Sum, Dc->Factor, Dc->Shift);
+			Sum = 0;
+			Index += Dc->Factor;
+			continue;
+		}
+#endif
+		Sum += Data[Index++];
+		if (++Pos == Dc->Factor) {
+			Data[Out++] = Filter_Mean(Sum, Dc->Factor, Dc->Shift);
+			Sum = 0;
+			Pos = 0;
+		}
+	}
+
+	Dc->Pos = Pos;
+	Dc->Sum = Sum;
+	return Out;
+}
+
+/*
+ * Appends a cleared stage of the given type
+ */
+static Filter_Stage *Filter_AddStage(Filter_Chain *ChainPtr, u32 Type)
+{
+	Filter_Stage *StagePtr;
+
+	if (ChainPtr->Count >= FILTER_MAX_STAGES)
+		return NULL;
+
+	StagePtr = &ChainPtr->Stage[ChainPtr->Count++];
+	*StagePtr = (Filter_Stage){0};
+	StagePtr->Type = Type;
+	return StagePtr;
+}
+
+/*****************************************************************************/
+/**
+* Empties a chain. A chain with no stages passes samples through.
+*
+******************************************************************************/
+void Filter_ChainInit(Filter_Chain *ChainPtr)
+{
+	ChainPtr->Count = 0;
+}
+
+/*****************************************************************************/
+/**
+* Appends a moving average stage.
+*
+* @param	ChainPtr is the chain.
+* @param	Len is the window length, 1 to FILTER_MAX_WINDOW. Powers of
+*		two avoid a division per sample.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if Len is out of range or the
+*		chain is full.
+*
+******************************************************************************/
+int Filter_AddMovAvg(Filter_Chain *ChainPtr, u32 Len)
+{
+	Filter_Stage *StagePtr;
+
+	if (Len == 0 || Len > FILTER_MAX_WINDOW)
+		return XST_FAILURE;
+	StagePtr = Filter_AddStage(ChainPtr, FILTER_MOVAVG);
+	if (StagePtr == NULL)
+		return XST_FAILURE;
+
+	StagePtr->S.MovAvg.Len = Len;
+	StagePtr->S.MovAvg.Shift = Filter_Log2(Len);
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Appends a biquad section
+*	y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+*
+* @param	ChainPtr is the chain.
+* @param	Coef holds b0, b1, b2, a1 and a2 in Q4.28.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the chain is full.
+*
+* @note		The stage starts from the steady state of its first input,
+*		which assumes unity gain at DC.
+*
+******************************************************************************/
+int Filter_AddBiquad(Filter_Chain *ChainPtr, const s32 Coef[5])
+{
+	Filter_Stage *StagePtr = Filter_AddStage(ChainPtr, FILTER_BIQUAD);
+
+	if (StagePtr == NULL)
+		return XST_FAILURE;
+
+	StagePtr->S.Biquad.B0 = Coef[0];
+	StagePtr->S.Biquad.B1 = Coef[1];
+	StagePtr->S.Biquad.B2 = Coef[2];
+	StagePtr->S.Biquad.A1 = Coef[3];
+	StagePtr->S.Biquad.A2 = Coef[4];
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Appends a second order Butterworth low-pass biquad.
+*
+* @param	ChainPtr is the chain.
+* @param	CutoffHz is the -3 dB frequency.
+* @param	SampleHz is the rate the stage sees samples at, after any
+*		earlier decimation.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the cut-off is not below half
+*		the sample rate or the chain is full.
+*
+* @note		Uses floating point to design the section; call at init.
+*		b1 absorbs the coefficient rounding so the DC gain is exactly 1.
+*
+******************************************************************************/
+int Filter_AddLowpass(Filter_Chain *ChainPtr, u32 CutoffHz, u32 SampleHz)
+{
+	const double One = (double)(1 << FILTER_BIQUAD_FRAC);
+	double W0, Cos, Sin, Alpha, A0;
+	s32 Coef[5];
+
+	if (CutoffHz == 0 || 2 * CutoffHz >= SampleHz)
+		return XST_FAILURE;
+
+	/* Bilinear transform design with Q = 1/sqrt(2) */
+	W0 = 2 * FILTER_PI * CutoffHz / SampleHz;
+	Cos = Filter_CosSin(W0, &Sin);
+	Alpha = Sin * 0.70710678118654752;
+	A0 = 1 + Alpha;
+
+	Coef[0] = (s32)((1 - Cos) / 2 / A0 * One + 0.5);
+	Coef[2] = Coef[0];
+	Coef[3] = (s32)(-2 * Cos / A0 * One - 0.5);
+	Coef[4] = (s32)((1 - Alpha) / A0 * One + 0.5);
+	Coef[1] = (1 << FILTER_BIQUAD_FRAC) + Coef[3] + Coef[4] -
+		  Coef[0] - Coef[2];
+
+	return Filter_AddBiquad(ChainPtr, Coef);
+}
+
+/*****************************************************************************/
+/**
+* Appends a median stage, which removes spikes shorter than half its
+* length.
+*
+* @param	ChainPtr is the chain.
+* @param	Len is 3 or 5.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if Len is not supported or the
+*		chain is full.
+*
+******************************************************************************/
+int Filter_AddMedian(Filter_Chain *ChainPtr, u32 Len)
+{
+	Filter_Stage *StagePtr;
+
+	if (Len != 3 && Len != 5)
+		return XST_FAILURE;
+	StagePtr = Filter_AddStage(ChainPtr, FILTER_MEDIAN);
+	if (StagePtr == NULL)
+		return XST_FAILURE;
+
+	StagePtr->S.Median.Len = Len;
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Appends a decimation stage that outputs the mean of every Factor inputs.
+*
+* @param	ChainPtr is the chain.
+* @param	Factor is 1 to FILTER_MAX_FACTOR. Multiples of 4 use NEON on
+*		the board.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if Factor is out of range or the
+*		chain is full.
+*
+******************************************************************************/
+int Filter_AddDecimate(Filter_Chain *ChainPtr, u32 Factor)
+{
+	Filter_Stage *StagePtr;
+
+	if (Factor == 0 || Factor > FILTER_MAX_FACTOR)
+		return XST_FAILURE;
+	StagePtr = Filter_AddStage(ChainPtr, FILTER_DECIMATE);
+	if (StagePtr == NULL)
+		return XST_FAILURE;
+
+	StagePtr->S.Decimate.Factor = Factor;
+	StagePtr->S.Decimate.Shift = Filter_Log2(Factor);
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Forgets the history of every stage; the next sample primes them again.
+*
+******************************************************************************/
+void Filter_Reset(Filter_Chain *ChainPtr)
+{
+	Filter_Stage *StagePtr;
+	u32 Index;
+
+	for (Index = 0; Index < ChainPtr->Count; Index++) {
+		StagePtr = &ChainPtr->Stage[Index];
+		StagePtr->Primed = FALSE;
+		if (StagePtr->Type == FILTER_MOVAVG)
+			StagePtr->S.MovAvg.Pos = 0;
+		if (StagePtr->Type == FILTER_DECIMATE) {
+			StagePtr->S.Decimate.Pos = 0;
+			StagePtr->S.Decimate.Sum = 0;
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+* Runs a block of samples through every stage of a chain, in place.
+*
+* @param	ChainPtr is the chain.
+* @param	Data holds the input samples and receives the output.
+* @param	Count is the number of input samples.
+*
+* @return	Number of output samples, fewer than Count if the chain
+*		decimates.
+*
+******************************************************************************/
+u32 Filter_Process(Filter_Chain *ChainPtr, s32 *Data, u32 Count)
+{
+	Filter_Stage *StagePtr;
+	u32 Index;
+
+	for (Index = 0; Index < ChainPtr->Count && Count != 0; Index++) {
+		StagePtr = &ChainPtr->Stage[Index];
+		switch (StagePtr->Type) {
+		case FILTER_MOVAVG:
+			Count = Filter_MovAvgBlock(StagePtr, Data, Count);
+			break;
+		case FILTER_BIQUAD:
+			Count = Filter_BiquadBlock(StagePtr, Data, Count);
+			break;
+		case FILTER_MEDIAN:
+			Count = Filter_MedianBlock(StagePtr, Data, Count);
+			break;
+		case FILTER_DECIMATE:
+			Count = Filter_DecimateBlock(StagePtr, Data, Count);
+			break;
+		default:
+			break;
+		}
+	}
+	return Count;
+}
+
+#ifdef HOST_SIM
+static s32 BenchIn[FILTER_BENCH_LEN];
+static s32 BenchOut[FILTER_BENCH_LEN];
+static s32 BenchRef[FILTER_BENCH_LEN];
+
+/*
+ * A slow sine with noise and an occasional full-scale spike, in 16-bit
+ * ADC codes
+ */
+static void Filter_BenchSignal(void)
+{
+	u32 Seed = 12345, Index;
+	double Sin, Phase;
+
+	for (Index = 0; Index < FILTER_BENCH_LEN; Index++) {
+		Seed = Seed * 1103515245 + 12345;
+		Phase = 2 * FILTER_PI * (Index % 2000) / 2000 - FILTER_PI;
+		Filter_CosSin(Phase, &Sin);
+		BenchIn[Index] = 32768 + (s32)(20000 * Sin) +
+				 (s32)((Seed >> 16) % 801) - 400;
+		if ((Seed >> 8) % 97 == 0)
+			BenchIn[Index] = (Seed & 0x100) ? 65535 : 0;
+	}
+}
+
+/*
+ * Reference implementations: straightforward per-sample code that shares
+ * nothing with the block kernels
+ */
+static s32 Filter_RefInput(s32 Index)
+{
+	return BenchIn[(Index < 0) ? 0 : Index];
+}
+
+static u32 Filter_RefMovAvg(u32 Len)
+{
+	s64 Sum;
+	u32 Index, Tap;
+
+	for (Index = 0; Index < FILTER_BENCH_LEN; Index++) {
+		for (Sum = 0, Tap = 0; Tap < Len; Tap++)
+			Sum += Filter_RefInput((s32)Index - (s32)Tap);
+		BenchRef[Index] = (s32)Fixed_RoundDiv(Sum, Len);
+	}
+	return FILTER_BENCH_LEN;
+}
+
+static u32 Filter_RefMedian(u32 Len)
+{
+	s32 Win[FILTER_MAX_MEDIAN], Tmp;
+	u32 Index, I, J;
+
+	for (Index = 0; Index < FILTER_BENCH_LEN; Index++) {
+		for (I = 0; I < Len; I++)
+			Win[I] = Filter_RefInput((s32)Index - (s32)I);
+		for (I = 1; I < Len; I++)
+			for (J = I; J > 0 && Win[J - 1] > Win[J]; J--) {
+				Tmp = Win[J];
+				Win[J] = Win[J - 1];
+				Win[J - 1] = Tmp;
+			}
+		BenchRef[Index] = Win[Len / 2];
+	}
+	return FILTER_BENCH_LEN;
+}
+
+static u32 Filter_RefBiquad(const Filter_Biquad *Bq)
+{
+	const double One = (double)(1 << FILTER_BIQUAD_FRAC);
+	double X1, X2, Y1, Y2, Y;
+	u32 Index;
+
+	X1 = X2 = Y1 = Y2 = BenchIn[0];
+	for (Index = 0; Index < FILTER_BENCH_LEN; Index++) {
+		Y = (Bq->B0 * (double)BenchIn[Index] + Bq->B1 * X1 +
+		     Bq->B2 * X2 - Bq->A1 * Y1 - Bq->A2 * Y2) / One;
+		X2 = X1;
+		X1 = BenchIn[Index];
+		Y2 = Y1;
+		Y1 = Y;
+		BenchRef[Index] = (s32)(Y + ((Y < 0) ? -0.5 : 0.5));
+	}
+	return FILTER_BENCH_LEN;
+}
+
+static u32 Filter_RefDecimate(u32 Factor)
+{
+	s64 Sum;
+	u32 Out, Tap;
+
+	for (Out = 0; (Out + 1) * Factor <= FILTER_BENCH_LEN; Out++) {
+		for (Sum = 0, Tap = 0; Tap < Factor; Tap++)
+			Sum += BenchIn[Out * Factor + Tap];
+		BenchRef[Out] = (s32)Fixed_RoundDiv(Sum, Factor);
+	}
+	return Out;
+}
+
+/*
+ * Filters the signal in blocks of pseudo-random length, so history is
+ * carried across every kind of boundary, and returns the output length
+ */
+static u32 Filter_BenchRun(Filter_Chain *ChainPtr)
+{
+	u32 Seed = 777, Done = 0, Out = 0, Len, Got;
+
+	Filter_Reset(ChainPtr);
+	memcpy(BenchOut, BenchIn, sizeof(BenchIn));
+	while (Done < FILTER_BENCH_LEN) {
+		Seed = Seed * 1103515245 + 12345;
+		Len = 1 + (Seed >> 16) % 300;
+		if (Len > FILTER_BENCH_LEN - Done)
+			Len = FILTER_BENCH_LEN - Done;
+		/* Output never overtakes input, so compacting in place is safe */
+		Got = Filter_Process(ChainPtr, BenchOut + Done, Len);
+		memmove(BenchOut + Out, BenchOut + Done, Got * sizeof(s32));
+		Out += Got;
+		Done += Len;
+	}
+	return Out;
+}
+
+/*
+ * Throughput of a chain on FILTER_BENCH_BLOCK sample blocks, in samples
+ * per second
+ */
+static double Filter_BenchTime(Filter_Chain *ChainPtr)
+{
+	const u32 Reps = 20;
+	u32 Rep, Done;
+	u64 Start;
+
+	Filter_Reset(ChainPtr);
+	Start = now_ticks();
+	for (Rep = 0; Rep < Reps; Rep++) {
+		memcpy(BenchOut, BenchIn, sizeof(BenchIn));
+		for (Done = 0; Done + FILTER_BENCH_BLOCK <= FILTER_BENCH_LEN;
+		     Done += FILTER_BENCH_BLOCK)
+			Filter_Process(ChainPtr, BenchOut + Done,
+				       FILTER_BENCH_BLOCK);
+	}
+	return (double)Reps * (FILTER_BENCH_LEN / FILTER_BENCH_BLOCK) *
+	       FILTER_BENCH_BLOCK * TIMEBASE_HZ / (now_ticks() - Start);
+}
+
+/*****************************************************************************/
+/**
+* Host check and benchmark.
+*
+* Builds a noisy sine with spikes and runs it, in blocks of random length,
+* through single-stage chains of each kind. The output is compared with a
+* plain per-sample reference: moving average, median and decimation must
+* match exactly, and the biquad must stay within one code of a double
+* precision section with the same coefficients. Then prints the throughput
+* of each stage and of a typical chain in samples per second.
+*
+* @note		The host build uses the scalar kernels unless it targets
+*		NEON.
+*
+******************************************************************************/
+void Filter_Benchmark(void)
+{
+	static const struct {
+		const char *Name;
+		u32 Type;
+		u32 Arg;
+	} Cases[] = {
+		{ "movavg 16", FILTER_MOVAVG, 16 },
+		{ "movavg 10", FILTER_MOVAVG, 10 },
+		{ "median 3", FILTER_MEDIAN, 3 },
+		{ "median 5", FILTER_MEDIAN, 5 },
+		{ "lowpass 1%", FILTER_BIQUAD, 100 },
+		{ "lowpass 0.1%", FILTER_BIQUAD, 1000 },
+		{ "decimate 16", FILTER_DECIMATE, 16 },
+		{ "decimate 6", FILTER_DECIMATE, 6 },
+	};
+	Filter_Chain Chain;
+	u32 Case, Index, Len, RefLen;
+	s32 Err, MaxErr, Limit;
+	int Fail = FALSE;
+
+	Filter_BenchSignal();
+
+	for (Case = 0; Case < sizeof(Cases) / sizeof(Cases[0]); Case++) {
+		Filter_ChainInit(&Chain);
+		switch (Cases[Case].Type) {
+		case FILTER_MOVAVG:
+			Filter_AddMovAvg(&Chain, Cases[Case].Arg);
+			RefLen = Filter_RefMovAvg(Cases[Case].Arg);
+			break;
+		case FILTER_MEDIAN:
+			Filter_AddMedian(&Chain, Cases[Case].Arg);
+			RefLen = Filter_RefMedian(Cases[Case].Arg);
+			break;
+		case FILTER_BIQUAD:
+			Filter_AddLowpass(&Chain, 10000 / Cases[Case].Arg, 10000);
+			RefLen = Filter_RefBiquad(&Chain.Stage[0].S.Biquad);
+			break;
+		default:
+			Filter_AddDecimate(&Chain, Cases[Case].Arg);
+			RefLen = Filter_RefDecimate(Cases[Case].Arg);
+			break;
+		}
+		Limit = (Cases[Case].Type == FILTER_BIQUAD) ? 1 : 0;
+
+		Len = Filter_BenchRun(&Chain);
+		MaxErr = (Len == RefLen) ? 0 : 0x7FFFFFFF;
+		for (Index = 0; Index < Len && Index < RefLen; Index++) {
+			Err = BenchOut[Index] - BenchRef[Index];
+			if (Err < 0)
+				Err = -Err;
+			if (Err > MaxErr)
+				MaxErr = Err;
+		}
+		if (MaxErr > Limit)
+			Fail = TRUE;
+
+		printf("filter: %-12s max error %d (%s), %6.1f Msamples/s\n",
+		       Cases[Case].Name, (int)MaxErr,
+		       (MaxErr <= Limit) ? "ok" : "FAIL",
+		       Filter_BenchTime(&Chain) / 1e6);
+	}
+
+	/* A spike-rejecting, smoothing, 4x decimating chain */
+	Filter_ChainInit(&Chain);
+	Filter_AddMedian(&Chain, 5);
+	Filter_AddMovAvg(&Chain, 8);
+	Filter_AddLowpass(&Chain, 1000, 100000);
+	Filter_AddDecimate(&Chain, 4);
+	printf("filter: median 5 > movavg 8 > lowpass > decimate 4: "
+	       "%.1f Msamples/s in\n", Filter_BenchTime(&Chain) / 1e6);
+	printf("filter: self-check %s\n", Fail ? "FAILED" : "passed");
+}
+#endif /* HOST_SIM */
@@ -0,0 +1,109 @@
+/*****************************************************************************/
+/**
+* @file filter.h
+*
+* Digital filters for ADC samples.
+*
+* A Filter_Chain is a short list of stages applied in order to blocks of
+* samples from one channel:
+*	- moving average over up to FILTER_MAX_WINDOW samples
+*	- biquad IIR section, e.g. a Butterworth low-pass
+*	- median of 3 or 5 samples, to reject single-sample spikes
+*	- decimation by averaging groups of samples
+*
+* Filter_Process() runs a block through every stage in place. Each stage
+* keeps its own history, so a stream can be fed in blocks of any size and
+* the output does not depend on how it was split. Every stage starts as if
+* its first input had always been present, so there is no start-up
+* transient from zero.
+*
+* Samples are s32 ADC codes. All arithmetic is integer: the biquad
+* coefficients are Q4.28 and its feedback keeps 12 fraction bits, which
+* limits its input to +/-2^17, and every division rounds to nearest. On
+* the Cortex-A9 the median and decimation kernels use NEON when the
+* compiler targets it (__ARM_NEON); the moving average and the biquad are
+* recursive and stay scalar.
+*
+******************************************************************************/
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "platform.h"
+
+/************************** Constant Definitions *****************************/
+
+#define FILTER_MAX_STAGES	4
+#define FILTER_MAX_WINDOW	32	/* Longest moving average */
+#define FILTER_MAX_MEDIAN	5
+#define FILTER_CHUNK		128	/* Median working block, in samples */
+
+#define FILTER_BIQUAD_FRAC	28	/* Coefficient fraction bits */
+
+/*
+ * Stage types
+ */
+#define FILTER_MOVAVG		1
+#define FILTER_BIQUAD		2
+#define FILTER_MEDIAN		3
+#define FILTER_DECIMATE		4
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Len;
+	u32 Pos;
+	s32 Shift;		/* log2(Len), or -1 if not a power of two */
+	s32 Sum;
+	s32 Hist[FILTER_MAX_WINDOW];
+} Filter_MovAvg;
+
+typedef struct {
+	s32 B0, B1, B2, A1, A2;	/* Q4.28, a0 normalized to 1 */
+	s32 X1, X2;		/* Previous inputs */
+	s32 Y1, Y2;		/* Previous outputs, Q12 */
+} Filter_Biquad;
+
+typedef struct {
+	u32 Len;
+	s32 Hist[FILTER_MAX_MEDIAN - 1];	/* Last Len - 1 inputs */
+} Filter_Median;
+
+typedef struct {
+	u32 Factor;
+	u32 Pos;		/* Samples summed into the current group */
+	s32 Shift;
+	s32 Sum;
+} Filter_Decimate;
+
+typedef struct {
+	u32 Type;
+	u32 Primed;		/* History holds real samples */
+	union {
+		Filter_MovAvg MovAvg;
+		Filter_Biquad Biquad;
+		Filter_Median Median;
+		Filter_Decimate Decimate;
+	} S;
+} Filter_Stage;
+
+typedef struct {
+	u32 Count;
+	Filter_Stage Stage[FILTER_MAX_STAGES];
+} Filter_Chain;
+
+/************************** Function Prototypes ******************************/
+
+void Filter_ChainInit(Filter_Chain *ChainPtr);
+int Filter_AddMovAvg(Filter_Chain *ChainPtr, u32 Len);
+int Filter_AddBiquad(Filter_Chain *ChainPtr, const s32 Coef[5]);
+int Filter_AddLowpass(Filter_Chain *ChainPtr, u32 CutoffHz, u32 SampleHz);
+int Filter_AddMedian(Filter_Chain *ChainPtr, u32 Len);
+int Filter_AddDecimate(Filter_Chain *ChainPtr, u32 Factor);
+void Filter_Reset(Filter_Chain *ChainPtr);
+u32 Filter_Process(Filter_Chain *ChainPtr, s32 *Data, u32 Count);
+
+#ifdef HOST_SIM
+void Filter_Benchmark(void);
+#endif
+
+#endif /* FILTER_H */
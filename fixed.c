@@ -0,0 +1,185 @@
+/*****************************************************************************/
+/**
+* @file fixed.c
+*
+* Fixed-point range mapping and ADC to PWM conversion. See fixed.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "fixed.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include <math.h>
+#include "timebase.h"
+#endif
+
+/*****************************************************************************/
+/**
+* Maps Value linearly from [InLo, InHi] to [OutLo, OutHi], rounding to
+* nearest. Values outside the input range are clamped to it first, so the
+* result never leaves the output range.
+*
+* @param	Value is the value to map.
+* @param	InLo is the start of the input range.
+* @param	InHi is the end of the input range, greater than InLo.
+* @param	OutLo is the result for InLo.
+* @param	OutHi is the result for InHi, may be below OutLo.
+*
+* @return	The mapped value.
+*
+******************************************************************************/
+s32 Fixed_Map(s32 Value, s32 InLo, s32 InHi, s32 OutLo, s32 OutHi)
+{
+	if (Value <= InLo)
+		return OutLo;
+	if (Value >= InHi)
+		return OutHi;
+
+	return OutLo + (s32)Fixed_RoundDiv((s64)(Value - InLo) *
+					   ((s64)OutHi - OutLo),
+					   (s64)InHi - InLo);
+}
+
+/*****************************************************************************/
+/**
+* Converts a 16-bit ADC code to a PWM compare value. The duty runs linearly
+* from DutyLo at code 0 to DutyHi at full scale (code 65536), and is
+* returned as counts of a PeriodCounts period, rounded to nearest.
+*
+* @param	Code is the left-aligned 16-bit ADC code.
+* @param	DutyLo is the duty at code 0, as a fraction of the period.
+* @param	DutyHi is the duty at full scale.
+* @param	PeriodCounts is the PWM period in counts.
+*
+* @return	Compare value, 0 to PeriodCounts.
+*
+* @note		Negative duties give 0. The intermediate duty is kept in Q1.31
+*		so no precision is lost before the final rounding.
+*
+******************************************************************************/
+u32 Fixed_AdcToCounts(u16 Code, Fixed_Q15 DutyLo, Fixed_Q15 DutyHi,
+		      u32 PeriodCounts)
+{
+	s64 Duty;	/* Q1.31 */
+
+	Duty = ((s64)DutyLo << 16) + (s64)(DutyHi - DutyLo) * Code;
+	if (Duty <= 0)
+		return 0;
+
+	return (u32)(((u64)Duty * PeriodCounts + (1ULL << 30)) >> 31);
+}
+
+#ifdef HOST_SIM
+/*
+ * The float expressions the fixed-point code replaced
+ */
+static u32 Fixed_BenchFloatServo(u16 Code)
+{
+	float Temp = Code;
+	float DutyCycle = (Temp / 327670) + 0.025;
+
+	return DutyCycle * 0xFFFF;
+}
+
+static u32 Fixed_BenchFloatMotor(float Volts)
+{
+	return Volts * 757575;
+}
+
+static u32 Fixed_BenchFloatPeriod(float Volts)
+{
+	return 1000000 - (Volts / 2047) * 666666;
+}
+
+/*****************************************************************************/
+/**
+* Host check and benchmark.
+*
+* Runs every 16-bit ADC code through the servo conversion, and through the
+* motor duty and buzzer period conversions with the code taken as 0 to 3.3 V,
+* and compares the results against a double precision reference of the same
+* fixed-point inputs: the error must stay within half a count. It also
+* prints how far the servo result is from the original float formula, which
+* differs by the Q1.15 rounding of its 0.025 and 0.225 end points.
+*
+* Then times each conversion in float and in fixed point. The host FPU is
+* much faster relative to integer code than the Cortex-A9 VFP in an
+* interrupt handler, so the host numbers understate the gain.
+*
+******************************************************************************/
+void Fixed_Benchmark(void)
+{
+	const Fixed_Q15 ServoLo = FIXED_Q15(0.025);
+	const Fixed_Q15 ServoHi = FIXED_Q15(0.225);
+	double Ref, Err;
+	double MaxServo = 0, MaxMotor = 0, MaxPeriod = 0, MaxOrig = 0;
+	volatile u32 Sink = 0;
+	u64 Start, FloatTicks, FixedTicks;
+	Fixed_Q16 Volts;
+	u32 Code, Rep, Counts;
+	const u32 Reps = 200;
+
+	for (Code = 0; Code < FIXED_ADC_FULL_SCALE; Code++) {
+		Counts = Fixed_AdcToCounts(Code, ServoLo, ServoHi, 0xFFFF);
+		Ref = ((double)ServoLo / 32768 + (double)(ServoHi - ServoLo) /
+		       32768 * Code / 65536) * 0xFFFF;
+		Err = fabs(Counts - Ref);
+		if (Err > MaxServo)
+			MaxServo = Err;
+		Err = fabs(Counts - ((double)Code / 327670 + 0.025) * 0xFFFF);
+		if (Err > MaxOrig)
+			MaxOrig = Err;
+
+		Volts = Fixed_Map(Code, 0, FIXED_ADC_FULL_SCALE, 0,
+				  FIXED_Q16(3.3));
+		Ref = (double)Volts / 65536 * 757575;
+		Err = fabs(Fixed_Q16Scale(Volts, 757575, 1) - Ref);
+		if (Err > MaxMotor)
+			MaxMotor = Err;
+		Ref = 1000000 - (double)Volts / 65536 / 2047 * 666666;
+		Err = fabs(1000000 - Fixed_Q16Scale(Volts, 666666, 2047) - Ref);
+		if (Err > MaxPeriod)
+			MaxPeriod = Err;
+	}
+
+	printf("fixed: %u codes, max error vs double: servo %.3f, motor %.3f, "
+	       "period %.3f counts (%s)\n", FIXED_ADC_FULL_SCALE,
+	       MaxServo, MaxMotor, MaxPeriod,
+	       (MaxServo <= 0.5 + 1e-9 && MaxMotor <= 0.5 + 1e-9 &&
+		MaxPeriod <= 0.5 + 1e-9) ? "ok" : "FAIL");
+	printf("fixed: servo max difference from the float formula %.3f counts\n",
+	       MaxOrig);
+
+	Start = now_ticks();
+	for (Rep = 0; Rep < Reps; Rep++) {
+		for (Code = 0; Code < FIXED_ADC_FULL_SCALE; Code++) {
+			float FloatVolts = Code * (3.3f / 65536);
+
+			Sink += Fixed_BenchFloatServo(Code);
+			Sink += Fixed_BenchFloatMotor(FloatVolts);
+			Sink += Fixed_BenchFloatPeriod(FloatVolts);
+		}
+	}
+	FloatTicks = now_ticks() - Start;
+
+	Start = now_ticks();
+	for (Rep = 0; Rep < Reps; Rep++) {
+		for (Code = 0; Code < FIXED_ADC_FULL_SCALE; Code++) {
+			Volts = Fixed_Map(Code, 0, FIXED_ADC_FULL_SCALE, 0,
+					  FIXED_Q16(3.3));
+			Sink += Fixed_AdcToCounts(Code, ServoLo, ServoHi, 0xFFFF);
+			Sink += Fixed_Q16Scale(Volts, 757575, 1);
+			Sink += 1000000 - Fixed_Q16Scale(Volts, 666666, 2047);
+		}
+	}
+	FixedTicks = now_ticks() - Start;
+
+	printf("fixed: servo+motor+period per code: float %.2f ns, "
+	       "fixed %.2f ns\n",
+	       (double)FloatTicks / Reps / FIXED_ADC_FULL_SCALE,
+	       (double)FixedTicks / Reps / FIXED_ADC_FULL_SCALE);
+}
+#endif /* HOST_SIM */
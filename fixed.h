@@ -0,0 +1,166 @@
+/*****************************************************************************/
+/**
+* @file fixed.h
+*
+* Fixed-point arithmetic for the control paths, so that handlers do not use
+* the VFP (whose registers the interrupt entry would otherwise have to save)
+* and rounding is explicit.
+*
+* Two formats are used:
+*	- Fixed_Q16, Q16.16 in an s32: -32768.0 to 32767.99998, step 1/65536
+*	- Fixed_Q15, Q1.15 in an s16: -1.0 to 0.99997, step 1/32768
+*
+* All operations round to nearest and saturate to the range of the result
+* instead of wrapping. The small operations are inline so they cost no call
+* in a handler.
+*
+******************************************************************************/
+#ifndef FIXED_H
+#define FIXED_H
+
+#include "platform.h"
+
+/************************** Constant Definitions *****************************/
+
+#define FIXED_Q16_FRAC		16
+#define FIXED_Q16_ONE		((Fixed_Q16)1 << FIXED_Q16_FRAC)
+#define FIXED_Q16_MAX		((Fixed_Q16)0x7FFFFFFF)
+#define FIXED_Q16_MIN		((Fixed_Q16)(-0x7FFFFFFF - 1))
+
+#define FIXED_Q15_FRAC		15
+#define FIXED_Q15_MAX		((Fixed_Q15)0x7FFF)
+#define FIXED_Q15_MIN		((Fixed_Q15)(-0x8000))
+
+#define FIXED_ADC_FULL_SCALE	65536	/* 16-bit XADC code range */
+
+/*
+ * Compile-time conversion of a constant, e.g. FIXED_Q16(2.4). The argument
+ * must be a constant expression so no floating point code is generated.
+ */
+#define FIXED_Q16(x)	((Fixed_Q16)((x) * 65536.0 + ((x) < 0 ? -0.5 : 0.5)))
+#define FIXED_Q15(x)	((Fixed_Q15)((x) >= 1.0 ? 0x7FFF : \
+			 (x) * 32768.0 + ((x) < 0 ? -0.5 : 0.5)))
+
+/**************************** Type Definitions *******************************/
+
+typedef s32 Fixed_Q16;
+typedef s16 Fixed_Q15;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+static inline Fixed_Q16 Fixed_Q16Sat(s64 Value)
+{
+	if (Value > FIXED_Q16_MAX)
+		return FIXED_Q16_MAX;
+	if (Value < FIXED_Q16_MIN)
+		return FIXED_Q16_MIN;
+	return (Fixed_Q16)Value;
+}
+
+static inline Fixed_Q15 Fixed_Q15Sat(s32 Value)
+{
+	if (Value > FIXED_Q15_MAX)
+		return FIXED_Q15_MAX;
+	if (Value < FIXED_Q15_MIN)
+		return FIXED_Q15_MIN;
+	return (Fixed_Q15)Value;
+}
+
+/*
+ * Shifts right by Shift bits rounding to nearest, halves away from zero
+ */
+static inline s64 Fixed_RoundShift(s64 Value, u32 Shift)
+{
+	s64 Half = (s64)1 << (Shift - 1);
+
+	return (Value >= 0) ? (Value + Half) >> Shift : -((-Value + Half) >> Shift);
+}
+
+/*
+ * Divides rounding to nearest, halves away from zero. Den must be positive.
+ */
+static inline s64 Fixed_RoundDiv(s64 Num, s64 Den)
+{
+	return (Num >= 0) ? (Num + Den / 2) / Den : -((-Num + Den / 2) / Den);
+}
+
+static inline Fixed_Q16 Fixed_Q16FromInt(s32 Value)
+{
+	return Fixed_Q16Sat((s64)Value << FIXED_Q16_FRAC);
+}
+
+static inline s32 Fixed_Q16ToInt(Fixed_Q16 Value)
+{
+	return (s32)Fixed_RoundShift(Value, FIXED_Q16_FRAC);
+}
+
+static inline Fixed_Q16 Fixed_Q16Add(Fixed_Q16 A, Fixed_Q16 B)
+{
+	return Fixed_Q16Sat((s64)A + B);
+}
+
+static inline Fixed_Q16 Fixed_Q16Sub(Fixed_Q16 A, Fixed_Q16 B)
+{
+	return Fixed_Q16Sat((s64)A - B);
+}
+
+static inline Fixed_Q16 Fixed_Q16Mul(Fixed_Q16 A, Fixed_Q16 B)
+{
+	return Fixed_Q16Sat(Fixed_RoundShift((s64)A * B, FIXED_Q16_FRAC));
+}
+
+static inline Fixed_Q16 Fixed_Q16Div(Fixed_Q16 A, Fixed_Q16 B)
+{
+	if (B == 0)
+		return (A < 0) ? FIXED_Q16_MIN : FIXED_Q16_MAX;
+	if (B < 0) {
+		A = -A;
+		B = -B;
+	}
+	return Fixed_Q16Sat(Fixed_RoundDiv((s64)A << FIXED_Q16_FRAC, B));
+}
+
+static inline Fixed_Q15 Fixed_Q15Mul(Fixed_Q15 A, Fixed_Q15 B)
+{
+	/* -1.0 * -1.0 is the only product that does not fit */
+	return Fixed_Q15Sat((s32)Fixed_RoundShift((s32)A * B, FIXED_Q15_FRAC));
+}
+
+static inline Fixed_Q16 Fixed_Q15ToQ16(Fixed_Q15 Value)
+{
+	return (Fixed_Q16)Value << (FIXED_Q16_FRAC - FIXED_Q15_FRAC);
+}
+
+static inline Fixed_Q15 Fixed_Q16ToQ15(Fixed_Q16 Value)
+{
+	return Fixed_Q15Sat((s32)Fixed_RoundShift(Value,
+				FIXED_Q16_FRAC - FIXED_Q15_FRAC));
+}
+
+/*
+ * Value * Num / Den as an integer, e.g. volts in Q16.16 times counts per
+ * volt. Den must be positive.
+ */
+static inline s32 Fixed_Q16Scale(Fixed_Q16 Value, s32 Num, s32 Den)
+{
+	s64 Result = Fixed_RoundDiv((s64)Value * Num,
+				    (s64)Den << FIXED_Q16_FRAC);
+
+	if (Result > 0x7FFFFFFF)
+		return 0x7FFFFFFF;
+	if (Result < -0x7FFFFFFF - 1)
+		return -0x7FFFFFFF - 1;
+	return (s32)Result;
+}
+
+/************************** Function Prototypes ******************************/
+
+s32 Fixed_Map(s32 Value, s32 InLo, s32 InHi, s32 OutLo, s32 OutHi);
+u32 Fixed_AdcToCounts(u16 Code, Fixed_Q15 DutyLo, Fixed_Q15 DutyHi,
+		      u32 PeriodCounts);
+
+#ifdef HOST_SIM
+void Fixed_Benchmark(void);
+#endif
+
+#endif /* FIXED_H */
@@ -0,0 +1,48 @@
+/*****************************************************************************/
+/**
+* @file hal.h
+*
+* Register access to the custom AXI peripherals.
+*
+* The application reaches the LCD_1.0, Custom_PWM and AXI GPIO register
+* blocks only through the base addresses and accessors below. On the board
+* they are the XPAR_* addresses and plain volatile loads and stores. On a
+* HOST_SIM build the bases are the register files of hw_sim.h and every
+* access goes through the simulated bus, which counts it and runs the
+* device model behind the register.
+*
+******************************************************************************/
+#ifndef HAL_H
+#define HAL_H
+
+#include "platform.h"
+
+#ifdef HOST_SIM
+#include "hw_sim.h"
+#else
+#include "xparameters.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#ifdef HOST_SIM
+#define HAL_LCD_BASEADDR	HwSim_LcdRegs
+#define HAL_PWM_BASEADDR	HwSim_PwmRegs
+#define HAL_GPIO_BASEADDR	HwSim_GpioRegs
+#else
+#define HAL_LCD_BASEADDR	((volatile u32 *)XPAR_LCD_0_S00_AXI_BASEADDR)
+#define HAL_PWM_BASEADDR	((volatile u32 *)XPAR_CUSTOM_PWM_0_S00_AXI_BASEADDR)
+#define HAL_GPIO_BASEADDR	((volatile u32 *)XPAR_AXI_GPIO_0_BASEADDR)
+#endif
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+#ifdef HOST_SIM
+#define HAL_WRITE(RegPtr, Value)	HwSim_Write((RegPtr), (u32)(Value))
+#define HAL_READ(RegPtr)		HwSim_Read(RegPtr)
+#else
+#define HAL_WRITE(RegPtr, Value)	(*(volatile u32 *)(RegPtr) = (u32)(Value))
+#define HAL_READ(RegPtr)		(*(volatile u32 *)(RegPtr))
+#endif
+
+#endif /* HAL_H */
@@ -0,0 +1,172 @@
+/*****************************************************************************/
+/**
+* @file host/main.c
+*
+* Host runner for the HOST_SIM build: runs every module benchmark and
+* self-check on the PC and fails if any of them does.
+*
+* Each benchmark runs in a child process whose output is passed through to
+* stdout and scanned for "FAIL", so a check that prints FAIL, or a crash,
+* fails the run without the benchmarks having to report their results in
+* any other way. Build and run it with the Makefile in this directory:
+*
+*	make -C host check
+*
+* Arguments select benchmarks by name, e.g. "host_sim sched intr"; with
+* none, all of them run in order.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "platform.h"
+#include "timebase.h"
+#include "lcd_async.h"
+#include "lcd_ui.h"
+#include "event_queue.h"
+#include "button_fsm.h"
+#include "idle.h"
+#include "pwm_update.h"
+#include "fixed.h"
+#include "xadc_acq.h"
+#include "adc_stream.h"
+#include "filter.h"
+#include "xadc_chan.h"
+#include "xadc_band.h"
+#include "pipeline.h"
+#include "hw_sim.h"
+#include "trace.h"
+#include "dlog.h"
+#include "numfmt.h"
+#include "scheduler.h"
+#include "amp.h"
+#include "intr.h"
+#include "bench.h"
+
+/************************** Constant Definitions *****************************/
+
+#define HOST_FAIL_TEXT		"FAIL"
+#define HOST_LINE_LEN		512
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	const char *Name;
+	void (*Run)(void);
+} Host_Bench;
+
+/************************** Function Prototypes ******************************/
+
+static void Host_LcdAsync(void)	{ LcdAsync_Benchmark(100); }
+static void Host_Event(void)	{ Event_Benchmark(1000000); }
+static void Host_Button(void)	{ ButtonFsm_Benchmark(1000000); }
+static void Host_Pwm(void)	{ PwmUpdate_Benchmark(1000000); }
+static void Host_XadcAcq(void)	{ XadcAcq_Benchmark(10000); }
+static void Host_Stream(void)	{ AdcStream_Benchmark(100000); }
+static void Host_HwSim(void)	{ HwSim_Benchmark(1000); }
+static void Host_Trace(void)	{ Trace_Benchmark(NULL); }
+static void Host_Dlog(void)	{ Dlog_Benchmark(1000000); }
+static void Host_Sched(void)	{ Sched_Benchmark(1000); }
+static void Host_Amp(void)	{ Amp_Benchmark(100000); }
+
+/************************** Variable Definitions *****************************/
+
+static const Host_Bench Benches[] = {
+	{ "timebase",	timebase_benchmark },
+	{ "lcd_async",	Host_LcdAsync },
+	{ "lcd_ui",	LcdUi_Benchmark },
+	{ "event",	Host_Event },
+	{ "button",	Host_Button },
+	{ "idle",	Idle_Benchmark },
+	{ "pwm",	Host_Pwm },
+	{ "fixed",	Fixed_Benchmark },
+	{ "xadc_acq",	Host_XadcAcq },
+	{ "adc_stream",	Host_Stream },
+	{ "filter",	Filter_Benchmark },
+	{ "xadc_chan",	XadcChan_Benchmark },
+	{ "xadc_band",	XadcBand_Benchmark },
+	{ "pipeline",	Pipeline_Benchmark },
+	{ "hw_sim",	Host_HwSim },
+	{ "trace",	Host_Trace },
+	{ "dlog",	Host_Dlog },
+	{ "numfmt",	NumFmt_Benchmark },
+	{ "sched",	Host_Sched },
+	{ "amp",	Host_Amp },
+	{ "intr",	Intr_Benchmark },
+	{ "suite",	Bench_Suite },
+};
+
+/*****************************************************************************/
+/**
+* Runs one benchmark in a child process and passes its output through.
+*
+* @return	0 if it exited normally and printed no HOST_FAIL_TEXT, 1
+*		otherwise.
+*
+******************************************************************************/
+static int Host_Run(const Host_Bench *BenchPtr)
+{
+	char Line[HOST_LINE_LEN];
+	FILE *Out;
+	int Pipe[2];
+	int Status, Failed = 0;
+	pid_t Pid;
+
+	fflush(stdout);
+	if (pipe(Pipe) != 0)
+		return 1;
+	Pid = fork();
+	if (Pid < 0)
+		return 1;
+	if (Pid == 0) {
+		close(Pipe[0]);
+		dup2(Pipe[1], STDOUT_FILENO);
+		close(Pipe[1]);
+		BenchPtr->Run();
+		fflush(stdout);
+		_exit(0);
+	}
+
+	close(Pipe[1]);
+	Out = fdopen(Pipe[0], "r");
+	while (Out != NULL && fgets(Line, sizeof(Line), Out) != NULL) {
+		fputs(Line, stdout);
+		if (strstr(Line, HOST_FAIL_TEXT) != NULL)
+			Failed = 1;
+	}
+	if (Out != NULL)
+		fclose(Out);
+	if (waitpid(Pid, &Status, 0) != Pid || !WIFEXITED(Status) ||
+	    WEXITSTATUS(Status) != 0)
+		Failed = 1;
+	printf("host: %-10s %s\n", BenchPtr->Name, Failed ? "FAIL" : "ok");
+	return Failed;
+}
+
+int main(int argc, char *argv[])
+{
+	u32 Count = sizeof(Benches) / sizeof(Benches[0]);
+	u32 i, Ran = 0, Failed = 0;
+	int Arg;
+
+	for (i = 0; i < Count; i++) {
+		if (argc > 1) {
+			for (Arg = 1; Arg < argc; Arg++) {
+				if (strcmp(argv[Arg], Benches[i].Name) == 0)
+					break;
+			}
+			if (Arg == argc)
+				continue;
+		}
+		Failed += Host_Run(&Benches[i]);
+		Ran++;
+	}
+
+	printf("host: %u of %u benchmarks failed\n", Failed, Ran);
+	return (Failed != 0 || Ran == 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
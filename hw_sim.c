@@ -0,0 +1,798 @@
+/*****************************************************************************/
+/**
+* @file hw_sim.c
+*
+* Linux simulation of the board. See hw_sim.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "hw_sim.h"
+
+#ifdef HOST_SIM
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "timebase.h"
+#include "hal.h"
+#include "xadc_chan.h"
+#include "xadc_acq.h"
+#include "lcd_async.h"
+#include "lcd_ui.h"
+#include "pipeline.h"
+#include "scheduler.h"
+#include "intr.h"
+#include "app.h"
+
+/************************** Constant Definitions *****************************/
+
+#define HWSIM_LCD_FIFO		0	/* LCD_1.0 register words */
+#define HWSIM_LCD_RAW		1
+#define HWSIM_LCD_STATUS	2
+#define HWSIM_LCD_CONTROL	3
+
+#define HWSIM_LCD_SEQ_EN	0x2	/* LCD_CONTROL_SEQ_EN_MASK */
+#define HWSIM_LCD_FIFO_RS	0x100	/* LCD_FIFO_RS_MASK */
+#define HWSIM_LCD_FIFO_NIBBLE	0x200	/* LCD_FIFO_NIBBLE_MASK */
+#define HWSIM_LCD_STATUS_IDLE	0x400	/* LCD_STATUS_IDLE_MASK */
+
+#define HWSIM_LCD_PIN_RS	0x1	/* lcd_out[0] */
+#define HWSIM_LCD_PIN_E		0x2	/* lcd_out[1] */
+
+#define HWSIM_DDRAM_LEN		0x80
+#define HWSIM_DDRAM_LINE_LEN	0x28	/* 40 cells per line */
+
+#define HWSIM_PWM_COMMIT	3	/* Custom_PWM register words */
+
+#define HWSIM_GPIO_ISR		72	/* 0x120, toggle on write */
+
+#define HWSIM_XADC_SPAN_MV	1000	/* Unipolar full scale at the XADC */
+
+#define HWSIM_BENCH_XADC_HZ	1000
+#define HWSIM_BENCH_PRESS_MS	100	/* Enable pressed, then source */
+#define HWSIM_BENCH_HOLD_MS	50
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	HwSim_Handler Handler;
+	void *CallBackRef;
+	u64 Raised;		/* When it last became pending */
+	u8 Priority;
+	u8 Enabled;
+	u8 Pending;
+} HwSim_GicEntry;
+
+typedef struct {
+	u32 Irq;
+	u64 PeriodTicks;
+	u64 Next;
+	u8 Running;
+} HwSim_Timer;
+
+/*
+ * HD44780 controller state, as far as the display content depends on it
+ */
+typedef struct {
+	u8 Ddram[HWSIM_DDRAM_LEN];
+	u8 Addr;
+	u8 Increment;
+	u8 DisplayOn;
+	u8 Cgram;		/* Data goes to CGRAM, not shown */
+	u8 Bus8;		/* 8-bit interface, as after power-on */
+	u8 HaveHigh;		/* 4-bit: upper nibble received */
+	u8 High;
+	u8 LastPins;		/* lcd_out at the previous write */
+	u64 BusyUntil;
+} HwSim_Hd44780;
+
+typedef struct {
+	HwSim_WavePoint Point[HWSIM_WAVE_POINTS];
+	u32 Count;
+} HwSim_Wave;
+
+/************************** Variable Definitions *****************************/
+
+volatile u32 HwSim_LcdRegs[HWSIM_LCD_REGS];
+volatile u32 HwSim_PwmRegs[HWSIM_PWM_REGS];
+volatile u32 HwSim_GpioRegs[HWSIM_GPIO_REGS];
+
+static HwSim_Stats Stats;
+static HwSim_GicEntry Gic[HWSIM_IRQS];
+static u8 GicRunning;		/* Priority of the running handler */
+static int CpuIrqMasked;	/* IRQ masked at the core, as in a handler */
+static HwSim_Timer Timer[HWSIM_TIMERS];
+static u32 TimerCount;
+static HwSim_Hd44780 Lcd;
+static HwSim_Wave Wave[32];
+
+static XSysMon *XadcSim;
+static u32 XadcIrq;
+
+/*****************************************************************************/
+/**
+* Resets the register files, the device models, the GIC and the timers, and
+* switches the time base to the simulated clock.
+*
+******************************************************************************/
+void HwSim_Init(void)
+{
+	u32 i;
+
+	memset((void *)HwSim_LcdRegs, 0, sizeof(HwSim_LcdRegs));
+	memset((void *)HwSim_PwmRegs, 0, sizeof(HwSim_PwmRegs));
+	memset((void *)HwSim_GpioRegs, 0, sizeof(HwSim_GpioRegs));
+	HwSim_LcdRegs[HWSIM_LCD_STATUS] = HWSIM_LCD_STATUS_IDLE;
+
+	memset(&Stats, 0, sizeof(Stats));
+	memset(Gic, 0, sizeof(Gic));
+	for (i = 0; i < HWSIM_IRQS; i++)
+		Gic[i].Priority = HWSIM_PRIORITY_DEFAULT;
+	GicRunning = HWSIM_PRIORITY_IDLE;
+	CpuIrqMasked = FALSE;
+	TimerCount = 0;
+	memset(Wave, 0, sizeof(Wave));
+	XadcSim = NULL;
+
+	memset(&Lcd, 0, sizeof(Lcd));
+	memset(Lcd.Ddram, ' ', sizeof(Lcd.Ddram));
+	Lcd.Increment = TRUE;
+	Lcd.Bus8 = TRUE;
+
+	timebase_sim_clock(TRUE);
+}
+
+/*
+ * Executes one instruction or data byte on the HD44780
+ */
+static void HwSim_LcdByte(u8 Rs, u8 Byte)
+{
+	u32 ExecUs = LCD_EXEC_US;
+	u8 Line;
+
+	Stats.LcdBytes++;
+	if (Rs) {
+		if (!Lcd.Cgram)
+			Lcd.Ddram[Lcd.Addr] = Byte;
+		Line = Lcd.Addr & 0x40;
+		Lcd.Addr = (u8)((Lcd.Addr & 0x3F) + (Lcd.Increment ? 1 : -1));
+		if (Lcd.Addr == 0xFF || Lcd.Addr >= HWSIM_DDRAM_LINE_LEN)
+			Lcd.Addr = Lcd.Increment ? 0 : HWSIM_DDRAM_LINE_LEN - 1;
+		Lcd.Addr |= Line;
+	} else if (Byte & 0x80) {
+		Lcd.Addr = Byte & 0x7F;
+		Lcd.Cgram = FALSE;
+	} else if (Byte & 0x40) {
+		Lcd.Cgram = TRUE;
+	} else if (Byte & 0x20) {
+		Lcd.Bus8 = (Byte & 0x10) != 0;
+	} else if (Byte & 0x10) {
+		;			/* Cursor or display shift */
+	} else if (Byte & 0x08) {
+		Lcd.DisplayOn = (Byte & 0x04) != 0;
+	} else if (Byte & 0x04) {
+		Lcd.Increment = (Byte & 0x02) != 0;
+	} else if (Byte & 0x02) {
+		Lcd.Addr = 0;
+		Lcd.Cgram = FALSE;
+		ExecUs = LCD_EXEC_CLEAR_US;
+	} else if (Byte == 0x01) {
+		memset(Lcd.Ddram, ' ', sizeof(Lcd.Ddram));
+		Lcd.Addr = 0;
+		Lcd.Increment = TRUE;
+		Lcd.Cgram = FALSE;
+		ExecUs = LCD_EXEC_CLEAR_US;
+	}
+	Lcd.BusyUntil = now_ticks() + us_to_ticks(ExecUs);
+}
+
+/*
+ * Takes one nibble off the bus: on its own in 8-bit mode, where the lower
+ * data lines are tied low, otherwise as half of a byte
+ */
+static void HwSim_LcdNibble(u8 Rs, u8 Nibble)
+{
+	if (Lcd.Bus8 || !Lcd.HaveHigh) {
+		if (now_ticks() < Lcd.BusyUntil)
+			Stats.LcdEarly++;
+	}
+	if (Lcd.Bus8) {
+		HwSim_LcdByte(Rs, (u8)(Nibble << 4));
+	} else if (!Lcd.HaveHigh) {
+		Lcd.High = Nibble;
+		Lcd.HaveHigh = TRUE;
+	} else {
+		Lcd.HaveHigh = FALSE;
+		HwSim_LcdByte(Rs, (u8)(Lcd.High << 4 | Nibble));
+	}
+}
+
+/*
+ * Write to an LCD_1.0 register. The raw register drives lcd_out directly
+ * and the data lines are latched on the falling edge of E. A FIFO word is
+ * sent at once: the simulated sequencer is never busy.
+ */
+static void HwSim_LcdWrite(u32 Reg, u32 Value)
+{
+	u8 Seq = (HwSim_LcdRegs[HWSIM_LCD_CONTROL] & HWSIM_LCD_SEQ_EN) != 0;
+
+	if (Reg == HWSIM_LCD_RAW && !Seq) {
+		if ((Lcd.LastPins & HWSIM_LCD_PIN_E) && !(Value & HWSIM_LCD_PIN_E))
+			HwSim_LcdNibble(Value & HWSIM_LCD_PIN_RS,
+					(Value >> 2) & 0xF);
+		Lcd.LastPins = (u8)Value;
+	} else if (Reg == HWSIM_LCD_FIFO && Seq) {
+		if (Value & HWSIM_LCD_FIFO_NIBBLE) {
+			HwSim_LcdNibble(0, (Value >> 4) & 0xF);
+		} else {
+			HwSim_LcdNibble((Value & HWSIM_LCD_FIFO_RS) != 0,
+					(Value >> 4) & 0xF);
+			HwSim_LcdNibble((Value & HWSIM_LCD_FIFO_RS) != 0,
+					Value & 0xF);
+		}
+	}
+	HwSim_LcdRegs[HWSIM_LCD_STATUS] = HWSIM_LCD_STATUS_IDLE;
+}
+
+/*
+ * Returns the peripheral a register belongs to and its word index
+ */
+static u32 HwSim_Bus(volatile u32 *RegPtr, u32 *IndexPtr)
+{
+	if (RegPtr >= HwSim_LcdRegs && RegPtr < HwSim_LcdRegs + HWSIM_LCD_REGS) {
+		*IndexPtr = (u32)(RegPtr - HwSim_LcdRegs);
+		return HWSIM_BUS_LCD;
+	}
+	if (RegPtr >= HwSim_PwmRegs && RegPtr < HwSim_PwmRegs + HWSIM_PWM_REGS) {
+		*IndexPtr = (u32)(RegPtr - HwSim_PwmRegs);
+		return HWSIM_BUS_PWM;
+	}
+	if (RegPtr >= HwSim_GpioRegs &&
+	    RegPtr < HwSim_GpioRegs + HWSIM_GPIO_REGS) {
+		*IndexPtr = (u32)(RegPtr - HwSim_GpioRegs);
+		return HWSIM_BUS_GPIO;
+	}
+	*IndexPtr = 0;
+	return HWSIM_BUS_OTHER;
+}
+
+/*****************************************************************************/
+/**
+* Bus write. Stores the value, counts the access against its peripheral and
+* lets the device model react. Addresses outside the register files are
+* plain memory, e.g. the stand-in registers of the module benchmarks.
+*
+******************************************************************************/
+void HwSim_Write(volatile u32 *RegPtr, u32 Value)
+{
+	u32 Index;
+	u32 Bus = HwSim_Bus(RegPtr, &Index);
+
+	Stats.Bus[Bus].Writes++;
+	switch (Bus) {
+	case HWSIM_BUS_LCD:
+		if (Index != HWSIM_LCD_STATUS)
+			*RegPtr = Value;
+		HwSim_LcdWrite(Index, Value);
+		break;
+	case HWSIM_BUS_PWM:
+		/* Committed at once, as if the counter wrapped */
+		*RegPtr = (Index == HWSIM_PWM_COMMIT) ? 0 : Value;
+		break;
+	case HWSIM_BUS_GPIO:
+		if (Index == HWSIM_GPIO_ISR)
+			*RegPtr &= ~Value;
+		else
+			*RegPtr = Value;
+		break;
+	default:
+		*RegPtr = Value;
+		break;
+	}
+}
+
+/*****************************************************************************/
+/**
+* Bus read, counted against the peripheral.
+*
+******************************************************************************/
+u32 HwSim_Read(volatile u32 *RegPtr)
+{
+	u32 Index;
+
+	Stats.Bus[HwSim_Bus(RegPtr, &Index)].Reads++;
+	return *RegPtr;
+}
+
+void HwSim_GetStats(HwSim_Stats *StatsPtr)
+{
+	*StatsPtr = Stats;
+}
+
+/*****************************************************************************/
+/**
+* Renders the first 16 cells of both DDRAM lines, the part the 2x16 glass
+* shows without display shift. Cells that are not printable ASCII, and the
+* whole display while it is off, read as spaces.
+*
+* @param	Text receives two NUL-terminated lines.
+*
+******************************************************************************/
+void HwSim_LcdRender(char Text[2][17])
+{
+	u8 Ch;
+	u32 Row, Col;
+
+	for (Row = 0; Row < 2; Row++) {
+		for (Col = 0; Col < 16; Col++) {
+			Ch = Lcd.Ddram[Row * 0x40 + Col];
+			Text[Row][Col] = (Lcd.DisplayOn && Ch >= 0x20 &&
+					  Ch < 0x7F) ? (char)Ch : ' ';
+		}
+		Text[Row][16] = '\0';
+	}
+}
+
+/*****************************************************************************/
+/**
+* Sets the level of the button inputs on GPIO channel 1 and raises the GPIO
+* interrupt, as the AXI GPIO does on any input change.
+*
+******************************************************************************/
+void HwSim_GpioSetButtons(u32 Buttons)
+{
+	HwSim_GpioRegs[HWSIM_GPIO_DATA] = Buttons;
+	HwSim_GpioRegs[HWSIM_GPIO_ISR] |= 1;
+	HwSim_GicRaise(HWSIM_IRQ_GPIO);
+}
+
+/*****************************************************************************/
+/**
+* Simulated GIC. Handlers are connected and enabled per interrupt ID like
+* XScuGic_Connect() and XScuGic_Enable(); a raised interrupt stays pending
+* until HwSim_GicDispatch() runs its handler.
+*
+* A handler runs with the core's IRQ masked and its priority as the running
+* priority, as on the A9. If it unmasks the IRQ (HwSim_GicIrqEnable(), the
+* host side of Xil_EnableNestedInterrupts()) a pending interrupt of a more
+* urgent priority preempts it at once, and so does one raised later while
+* it stays unmasked. Anything else waits until the handler returns.
+*
+******************************************************************************/
+void HwSim_GicConnect(u32 Irq, HwSim_Handler Handler, void *CallBackRef)
+{
+	Gic[Irq].Handler = Handler;
+	Gic[Irq].CallBackRef = CallBackRef;
+}
+
+void HwSim_GicSetPriority(u32 Irq, u8 Priority)
+{
+	Gic[Irq].Priority = Priority;
+}
+
+void HwSim_GicEnable(u32 Irq)
+{
+	Gic[Irq].Enabled = TRUE;
+}
+
+void HwSim_GicDisable(u32 Irq)
+{
+	Gic[Irq].Enabled = FALSE;
+}
+
+void HwSim_GicRaise(u32 Irq)
+{
+	if (!Gic[Irq].Pending) {
+		Gic[Irq].Pending = TRUE;
+		Gic[Irq].Raised = now_ticks();
+	}
+	if (GicRunning != HWSIM_PRIORITY_IDLE && !CpuIrqMasked)
+		HwSim_GicDispatch();
+}
+
+/*
+ * When Irq last became pending, for the interrupt latency of its handler
+ */
+u64 HwSim_GicRaisedAt(u32 Irq)
+{
+	return Gic[Irq].Raised;
+}
+
+void HwSim_GicIrqEnable(void)
+{
+	CpuIrqMasked = FALSE;
+	if (GicRunning != HWSIM_PRIORITY_IDLE)
+		HwSim_GicDispatch();
+}
+
+void HwSim_GicIrqDisable(void)
+{
+	CpuIrqMasked = TRUE;
+}
+
+/*****************************************************************************/
+/**
+* Runs the handlers of all pending, enabled interrupts more urgent than the
+* running priority, the most urgent first and the lower ID first among
+* equals. Interrupts raised by a handler are taken in the same call.
+*
+******************************************************************************/
+void HwSim_GicDispatch(void)
+{
+	u8 Running = GicRunning;
+	u32 Irq, Best;
+
+	if (CpuIrqMasked)
+		return;
+	for (;;) {
+		Best = HWSIM_IRQS;
+		for (Irq = 0; Irq < HWSIM_IRQS; Irq++) {
+			if (!Gic[Irq].Pending || !Gic[Irq].Enabled ||
+			    Gic[Irq].Handler == NULL ||
+			    Gic[Irq].Priority >= Running)
+				continue;
+			if (Best == HWSIM_IRQS ||
+			    Gic[Irq].Priority < Gic[Best].Priority)
+				Best = Irq;
+		}
+		if (Best == HWSIM_IRQS)
+			return;
+		Gic[Best].Pending = FALSE;
+		Stats.Irqs[Best]++;
+		if (Running != HWSIM_PRIORITY_IDLE)
+			Stats.Preemptions++;
+		GicRunning = Gic[Best].Priority;
+		CpuIrqMasked = TRUE;
+		Gic[Best].Handler(Gic[Best].CallBackRef);
+		GicRunning = Running;
+		CpuIrqMasked = FALSE;
+	}
+}
+
+/*****************************************************************************/
+/**
+* Starts a periodic timer that raises Irq every PeriodUs of simulated time,
+* the first time PeriodUs from now.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if all HWSIM_TIMERS are in use.
+*
+******************************************************************************/
+int HwSim_TimerStart(u32 Irq, u32 PeriodUs)
+{
+	HwSim_Timer *TimerPtr;
+
+	if (TimerCount == HWSIM_TIMERS || PeriodUs == 0)
+		return XST_FAILURE;
+	TimerPtr = &Timer[TimerCount++];
+	TimerPtr->Irq = Irq;
+	TimerPtr->PeriodTicks = us_to_ticks(PeriodUs);
+	TimerPtr->Next = now_ticks() + TimerPtr->PeriodTicks;
+	TimerPtr->Running = TRUE;
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Stops the timer of Irq, or restarts it to expire PeriodUs from now as the
+* private timers do when started. Restarting a running timer leaves it as
+* it is.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if no timer raises Irq.
+*
+******************************************************************************/
+int HwSim_TimerRun(u32 Irq, int Run)
+{
+	u32 i;
+
+	for (i = 0; i < TimerCount; i++) {
+		if (Timer[i].Irq != Irq)
+			continue;
+		if (Run && !Timer[i].Running)
+			Timer[i].Next = now_ticks() + Timer[i].PeriodTicks;
+		Timer[i].Running = Run ? TRUE : FALSE;
+		return XST_SUCCESS;
+	}
+	return XST_FAILURE;
+}
+
+/*****************************************************************************/
+/**
+* Moves the simulated clock to the next timer expiry or end of an XADC
+* sequence, but not past Limit, raises the interrupts that are due and
+* dispatches them. The caller runs its main loop work between steps.
+*
+******************************************************************************/
+void HwSim_Step(u64 Limit)
+{
+	u64 Next = Limit;
+	u64 Now = now_ticks();
+	u32 i;
+
+	for (i = 0; i < TimerCount; i++) {
+		if (Timer[i].Running && Timer[i].Next < Next)
+			Next = Timer[i].Next;
+	}
+	if (XadcSim != NULL && XadcSim->IntrEnabled && XadcSim->NextEos < Next)
+		Next = XadcSim->NextEos;
+
+	if (Next > Now) {
+		Stats.SimTicks += Next - Now;
+		timebase_sim_set(Next);
+	}
+
+	for (i = 0; i < TimerCount; i++) {
+		if (Timer[i].Running && Timer[i].Next <= Next) {
+			Timer[i].Next += Timer[i].PeriodTicks;
+			HwSim_GicRaise(Timer[i].Irq);
+		}
+	}
+	if (XadcSim != NULL && XadcSim->IntrEnabled) {
+		HwSim_XadcUpdate(XadcSim);
+		if (XadcSim->Status & HWSIM_XADC_SR_EOS)
+			HwSim_GicRaise(XadcIrq);
+	}
+
+	HwSim_GicDispatch();
+}
+
+/*****************************************************************************/
+/**
+* Makes HwSim_Step() raise Irq at the end of every sequence of XadcPtr once
+* its interrupt is enabled.
+*
+******************************************************************************/
+void HwSim_XadcAttach(XSysMon *XadcPtr, u32 Irq)
+{
+	XadcSim = XadcPtr;
+	XadcIrq = Irq;
+}
+
+/*****************************************************************************/
+/**
+* Completes the sequences of the simulated XSysMon that have ended by now
+* and latches end of sequence in its status until the status is read.
+*
+******************************************************************************/
+void HwSim_XadcUpdate(XSysMon *XadcPtr)
+{
+	u64 Now = now_ticks();
+
+	while (Now >= XadcPtr->NextEos) {
+		XadcPtr->Sequences++;
+		XadcPtr->Status |= HWSIM_XADC_SR_EOS;
+		XadcPtr->NextEos += XadcPtr->PeriodTicks;
+	}
+}
+
+/*****************************************************************************/
+/**
+* Drives an XADC channel with a waveform. The points give millivolts at the
+* header pins for channels in XadcChan_Table, otherwise at the XADC input.
+* The waveform repeats with the time of its last point as the period.
+*
+* @param	Channel is the XSysMon channel number.
+* @param	Points are in order of increasing time.
+* @param	Count is 1 to HWSIM_WAVE_POINTS, or 0 to return to the ramp.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the points are out of range.
+*
+******************************************************************************/
+int HwSim_XadcSetWaveform(u8 Channel, const HwSim_WavePoint *Points,
+			  u32 Count)
+{
+	u32 i;
+
+	if (Channel >= 32 || Count > HWSIM_WAVE_POINTS)
+		return XST_FAILURE;
+	for (i = 1; i < Count; i++) {
+		if (Points[i].TimeUs < Points[i - 1].TimeUs)
+			return XST_FAILURE;
+	}
+	memcpy(Wave[Channel].Point, Points, Count * sizeof(*Points));
+	Wave[Channel].Count = Count;
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Loads a waveform file for an XADC channel. Each line holds a time in us
+* and the voltage in mV, separated by white space, as for
+* HwSim_XadcSetWaveform(). Blank lines and lines starting with '#' are
+* skipped.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the file cannot be read or a
+*		line does not parse.
+*
+******************************************************************************/
+int HwSim_XadcLoadWaveform(u8 Channel, const char *Path)
+{
+	static HwSim_WavePoint Points[HWSIM_WAVE_POINTS];
+	char Line[128];
+	unsigned long TimeUs, Millivolts;
+	u32 Count = 0;
+	int Status = XST_SUCCESS;
+	FILE *File = fopen(Path, "r");
+
+	if (File == NULL)
+		return XST_FAILURE;
+	while (fgets(Line, sizeof(Line), File) != NULL) {
+		char *Ptr = Line + strspn(Line, " \t");
+
+		if (*Ptr == '#' || *Ptr == '\n' || *Ptr == '\r' || *Ptr == '\0')
+			continue;
+		if (Count == HWSIM_WAVE_POINTS ||
+		    sscanf(Ptr, "%lu %lu", &TimeUs, &Millivolts) != 2) {
+			Status = XST_FAILURE;
+			break;
+		}
+		Points[Count].TimeUs = (u32)TimeUs;
+		Points[Count].Millivolts = (u32)Millivolts;
+		Count++;
+	}
+	fclose(File);
+	if (Status != XST_SUCCESS || Count == 0)
+		return XST_FAILURE;
+	return HwSim_XadcSetWaveform(Channel, Points, Count);
+}
+
+/*****************************************************************************/
+/**
+* Returns the code the simulated XSysMon reads for Channel now: from the
+* channel's waveform if it has one, otherwise a ramp that moves a few LSB
+* per sequence and differs per channel.
+*
+* @return	A 16-bit left-aligned code, as XSysMon_GetAdcData() returns.
+*
+******************************************************************************/
+u16 HwSim_XadcData(u8 Channel, u32 Sequence)
+{
+	const HwSim_Wave *WavePtr = &Wave[Channel & 31];
+	const HwSim_WavePoint *P;
+	const XadcChan_Info *InfoPtr;
+	u32 Last, Us, i;
+	s32 Millivolts;
+
+	if (WavePtr->Count == 0)
+		return (u16)((Sequence * 37 + Channel * 1000) << 4);
+
+	Last = WavePtr->Point[WavePtr->Count - 1].TimeUs;
+	Us = ticks_to_us(now_ticks());
+	if (Last != 0)
+		Us %= Last;
+	for (i = 1; i < WavePtr->Count && WavePtr->Point[i].TimeUs <= Us; i++)
+		;
+	P = &WavePtr->Point[i - 1];
+	Millivolts = (s32)P->Millivolts;
+	if (i < WavePtr->Count && P[1].TimeUs > P->TimeUs)
+		Millivolts += (s32)(((s64)P[1].Millivolts - P->Millivolts) *
+				    (Us - P->TimeUs) / (P[1].TimeUs - P->TimeUs));
+
+	InfoPtr = XadcChan_Lookup(Channel);
+	if (InfoPtr != NULL)
+		return (u16)XadcChan_FromMillivolts(InfoPtr, Millivolts);
+	if (Millivolts >= HWSIM_XADC_SPAN_MV)
+		return 0xFFF0;
+	return (u16)(((u32)Millivolts * 4096 / HWSIM_XADC_SPAN_MV) << 4);
+}
+
+/*****************************************************************************/
+/**
+* Host benchmark. Runs the application of app.c for Ms of simulated time
+* against the simulated board, set up through the same calls as main.c:
+* the LCD reset sequence and status screen, with live values from the
+* 10 Hz lcd task, clocked out by the 40 us watchdog timer only while the
+* queue has work, the 1 kHz scheduler tick on the private timer, the
+* pipeline fed by XADC sequences at HWSIM_BENCH_XADC_HZ with a triangle on
+* the potentiometer and re-run by the 500 Hz control task, and the enable
+* and then the source button pressed HWSIM_BENCH_PRESS_MS apart.
+*
+* Prints the rendered LCD, the bus transactions per peripheral, the handler
+* runs per interrupt, the task timing and how much faster than real time
+* the run was, and checks that the glass shows the state the buttons
+* selected with live values, that no byte reached the HD44780 before the
+* previous one had executed, that no task overran and that the LCD tick
+* ran for less than half of the time.
+*
+******************************************************************************/
+void HwSim_Benchmark(u32 Ms)
+{
+	static const HwSim_WavePoint Triangle[] = {
+		{ 0, 0 }, { 200000, 3300 }, { 400000, 0 },
+	};
+	static const HwSim_WavePoint Light[] = { { 0, 2500 } };
+	static const char *const BusName[HWSIM_BUS_COUNT] = {
+		"lcd", "pwm", "gpio", "other",
+	};
+	HwSim_Stats Result;
+	struct timespec Start, End;
+	char Text[2][17];
+	u64 Stop, Press;
+	double WallNs;
+	u32 Step, Bus, Task, Fail = 0;
+
+	HwSim_Init();
+	HwSim_XadcSetWaveform(PIPELINE_POT_CHANNEL, Triangle, 3);
+	HwSim_XadcSetWaveform(PIPELINE_LIGHT_CHANNEL, Light, 1);
+
+	/* The drivers main.c initializes before the application */
+	TimerCounterInst = (XTmrCtr){ .IsReady = XIL_COMPONENT_IS_READY };
+	XadcAcq_SimSetRate(&Xadc, HWSIM_BENCH_XADC_HZ);
+
+	App_Init();
+	if (App_ControlInit() != XST_SUCCESS)
+		Fail |= 0x40;
+	App_LcdInit();
+	if (GpioSetupIntrSystem(&Intc, &Gpio, 0, HWSIM_IRQ_GPIO,
+				XGPIO_IR_CH1_MASK) != XST_SUCCESS ||
+	    LcdTimerSetupIntrSystem(&Intc, &LcdTimer, 0,
+				    HWSIM_IRQ_SCUWDT) != XST_SUCCESS ||
+	    TickTimerSetupIntrSystem(&Intc, &TickTimer, 0,
+				     HWSIM_IRQ_SCUTIMER) != XST_SUCCESS ||
+	    XadcAcq_SetupIntr(&XadcIn, &Intc, HWSIM_IRQ_XADC) != XST_SUCCESS)
+		Fail |= 0x40;
+
+	/* Press enable, release, press source, release */
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	Stop = us_to_ticks(Ms * 1000);
+	Press = us_to_ticks(HWSIM_BENCH_PRESS_MS * 1000);
+	Step = 0;
+	Sched_Start(&Tasks);
+	while (now_ticks() < Stop) {
+		HwSim_Step(Step < 4 && Press < Stop ? Press : Stop);
+		App_Run();
+		if (Step < 4 && now_ticks() >= Press) {
+			HwSim_GpioSetButtons((Step & 1) ? 0 :
+					     (Step == 0) ? 1 << BUTTON_ENABLE :
+					     1 << BUTTON_SOURCE);
+			Press += us_to_ticks((Step & 1) ?
+					     HWSIM_BENCH_PRESS_MS * 1000 :
+					     HWSIM_BENCH_HOLD_MS * 1000);
+			Step++;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	WallNs = (End.tv_sec - Start.tv_sec) * 1e9 +
+		 (End.tv_nsec - Start.tv_nsec);
+
+	HwSim_GetStats(&Result);
+	HwSim_LcdRender(Text);
+	printf("hw_sim: lcd |%s|\n", Text[0]);
+	printf("hw_sim: lcd |%s|\n", Text[1]);
+	for (Bus = 0; Bus < HWSIM_BUS_COUNT; Bus++)
+		printf("hw_sim: bus %-5s %8u reads %8u writes\n", BusName[Bus],
+		       Result.Bus[Bus].Reads, Result.Bus[Bus].Writes);
+	printf("hw_sim: buzzer timer %u register writes\n",
+	       TimerCounterInst.Writes);
+	printf("hw_sim: irq scutimer %u, scuwdt %u, xadc %u, gpio %u; hd44780 "
+	       "%u bytes, %u early; pipeline %u hardware updates\n",
+	       Result.Irqs[HWSIM_IRQ_SCUTIMER], Result.Irqs[HWSIM_IRQ_SCUWDT],
+	       Result.Irqs[HWSIM_IRQ_XADC], Result.Irqs[HWSIM_IRQ_GPIO],
+	       Result.LcdBytes, Result.LcdEarly, Pipe.Writes);
+	Sched_Report(&Tasks);
+	Intr_Report();
+	printf("hw_sim: %u ms simulated in %.1f ms, %.0fx real time\n", Ms,
+	       WallNs / 1e6, (double)Result.SimTicks / WallNs);
+
+	if (Step == 4 && (state != 1 || strstr(Text[0], "Enable") == NULL))
+		Fail |= 1;
+	if (Step == 4 && (strncmp(Text[1], analog_source ? "Light" : "Pot", 3)
+			  != 0 || Text[0][15] != 'V' || Text[1][15] != '%'))
+		Fail |= 2;
+	if (Result.LcdEarly != 0)
+		Fail |= 4;
+	if (Result.Irqs[HWSIM_IRQ_XADC] != Xadc.Sequences)
+		Fail |= 8;
+	for (Task = 0; Task < Tasks.Count; Task++) {
+		if (Tasks.Task[Task].Stats.Overruns != 0)
+			Fail |= 0x10;
+	}
+	if (Result.Irqs[HWSIM_IRQ_SCUWDT] >= Ms * 1000 / LCD_ASYNC_TICK_US / 2)
+		Fail |= 0x20;
+	LcdAsync_SetTimer(NULL);
+	printf("hw_sim: checks %s (0x%x)\n", Fail ? "FAIL" : "ok", Fail);
+	timebase_sim_clock(FALSE);
+}
+
+#endif /* HOST_SIM */
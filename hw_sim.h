@@ -0,0 +1,153 @@
+/*****************************************************************************/
+/**
+* @file hw_sim.h
+*
+* Linux simulation of the board, for HOST_SIM builds only.
+*
+* The LCD_1.0, Custom_PWM and AXI GPIO register blocks are plain register
+* files. Every access the firmware makes through HAL_READ()/HAL_WRITE() is
+* counted per peripheral and passed to a model of the device behind it:
+* an HD44780 that decodes the lcd_out nibbles (or the sequencer FIFO) into
+* DDRAM and renders the 2x16 display as text, and the Custom_PWM commit.
+*
+* Time is the simulated clock of the time base. HwSim_Step() moves it to the
+* next due interrupt source (a periodic timer or the end of an XADC
+* sequence), marks that IRQ pending at the simulated GIC and runs the
+* pending handlers in priority order, nesting them where a handler unmasks
+* the IRQ as the A9 does, so simulations run as fast as the handlers do
+* rather than in real time. XSysMon is a sequencer on the same clock whose
+* channels can be driven from waveform files.
+*
+******************************************************************************/
+#ifndef HW_SIM_H
+#define HW_SIM_H
+
+#include "platform.h"
+
+/************************** Constant Definitions *****************************/
+
+#define HWSIM_IRQS		96	/* GIC interrupt IDs */
+#define HWSIM_TIMERS		4
+
+/*
+ * Interrupt IDs of the simulated sources, as in xparameters.h
+ */
+#define HWSIM_IRQ_SCUTIMER	29	/* Cortex-A9 private timer */
+#define HWSIM_IRQ_SCUWDT	30	/* Private watchdog in timer mode */
+#define HWSIM_IRQ_XADC		61
+#define HWSIM_IRQ_GPIO		62
+#define HWSIM_IRQ_TMRCTR	63
+
+#define HWSIM_CPU_CLK_HZ	666666687	/* The private timers count at half */
+
+#define HWSIM_PRIORITY_DEFAULT	0xA0	/* Lower value is more urgent */
+#define HWSIM_PRIORITY_IDLE	0xFF	/* Running priority with no handler */
+
+/*
+ * Register file sizes in words
+ */
+#define HWSIM_LCD_REGS		4
+#define HWSIM_PWM_REGS		32	/* Up to the last phase register, 0x7C */
+#define HWSIM_GPIO_REGS		76	/* Up to IER, 0x128 */
+
+#define HWSIM_GPIO_DATA		0	/* Channel 1 data, word index */
+
+#define HWSIM_XADC_SR_EOS	0x20	/* XSysMon status, end of sequence */
+
+#define HWSIM_WAVE_POINTS	256	/* Points per XADC waveform */
+
+/*
+ * Peripherals counted by the bus model
+ */
+#define HWSIM_BUS_LCD		0
+#define HWSIM_BUS_PWM		1
+#define HWSIM_BUS_GPIO		2
+#define HWSIM_BUS_OTHER		3	/* Addresses outside the register files */
+#define HWSIM_BUS_COUNT		4
+
+/**************************** Type Definitions *******************************/
+
+typedef void (*HwSim_Handler)(void *CallBackRef);
+
+/*
+ * Host stand-in for the GIC driver instance
+ */
+typedef struct {
+	int Dummy;
+} XScuGic;
+
+/*
+ * Host stand-in for the XADC: a sequencer that finishes one conversion
+ * sequence every PeriodTicks. The codes come from HwSim_XadcData().
+ */
+typedef struct {
+	u64 PeriodTicks;	/* Time base ticks per sequence */
+	u64 NextEos;		/* When the next sequence completes */
+	u32 Sequences;		/* Sequences completed */
+	u32 Status;		/* Latched EOS, cleared by a status read */
+	u32 IntrEnabled;
+} XSysMon;
+
+typedef struct {
+	u32 Reads;
+	u32 Writes;
+} HwSim_BusStats;
+
+typedef struct {
+	HwSim_BusStats Bus[HWSIM_BUS_COUNT];
+	u32 Irqs[HWSIM_IRQS];	/* Handler runs per interrupt ID */
+	u32 Preemptions;	/* Handler runs that preempted another */
+	u32 LcdBytes;		/* Commands and data decoded by the HD44780 */
+	u32 LcdEarly;		/* Bytes sent before the previous one finished */
+	u64 SimTicks;		/* Simulated time moved by HwSim_Step() */
+} HwSim_Stats;
+
+/*
+ * One point of an XADC waveform: the pin voltage in mV at a time in us.
+ * Between points the voltage is interpolated linearly.
+ */
+typedef struct {
+	u32 TimeUs;
+	u32 Millivolts;
+} HwSim_WavePoint;
+
+/************************** Variable Definitions *****************************/
+
+extern volatile u32 HwSim_LcdRegs[HWSIM_LCD_REGS];
+extern volatile u32 HwSim_PwmRegs[HWSIM_PWM_REGS];
+extern volatile u32 HwSim_GpioRegs[HWSIM_GPIO_REGS];
+
+/************************** Function Prototypes ******************************/
+
+void HwSim_Init(void);
+void HwSim_Write(volatile u32 *RegPtr, u32 Value);
+u32 HwSim_Read(volatile u32 *RegPtr);
+void HwSim_GetStats(HwSim_Stats *StatsPtr);
+
+void HwSim_GicConnect(u32 Irq, HwSim_Handler Handler, void *CallBackRef);
+void HwSim_GicSetPriority(u32 Irq, u8 Priority);
+void HwSim_GicEnable(u32 Irq);
+void HwSim_GicDisable(u32 Irq);
+void HwSim_GicRaise(u32 Irq);
+u64 HwSim_GicRaisedAt(u32 Irq);
+void HwSim_GicIrqEnable(void);
+void HwSim_GicIrqDisable(void);
+void HwSim_GicDispatch(void);
+
+int HwSim_TimerStart(u32 Irq, u32 PeriodUs);
+int HwSim_TimerRun(u32 Irq, int Run);
+void HwSim_Step(u64 Limit);
+
+void HwSim_LcdRender(char Text[2][17]);
+void HwSim_GpioSetButtons(u32 Buttons);
+
+void HwSim_XadcAttach(XSysMon *XadcPtr, u32 Irq);
+void HwSim_XadcUpdate(XSysMon *XadcPtr);
+int HwSim_XadcSetWaveform(u8 Channel, const HwSim_WavePoint *Points,
+			  u32 Count);
+int HwSim_XadcLoadWaveform(u8 Channel, const char *Path);
+u16 HwSim_XadcData(u8 Channel, u32 Sequence);
+
+void HwSim_Benchmark(u32 Ms);
+
+#endif /* HW_SIM_H */
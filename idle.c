@@ -0,0 +1,256 @@
+/*****************************************************************************/
+/**
+* @file idle.c
+*
+* WFI idle loop and CPU load accounting. See idle.h.
+*
+* The counters only ever increase. A window is closed by latching the
+* difference between the counters and their values when it opened, so the
+* ISR slot can be charged from interrupt context without the main loop ever
+* having to clear it. The slot totals are added to and read atomically: the
+* A9 would otherwise access each 64-bit total as two words, and the main
+* loop could read one half from before an interrupt's charge and the other
+* from after it.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "idle.h"
+#include "timebase.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include <time.h>
+#else
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#ifdef HOST_SIM
+#define IDLE_HOST_SLEEP_US	40	/* Stands in for the LCD tick interrupt */
+#endif
+
+/************************** Variable Definitions *****************************/
+
+static u64 WindowTicks;
+static u64 WindowStart;
+
+static u64 IdleTotal;
+static u64 SlotTotal[IDLE_SLOT_COUNT];
+static u32 WakeupTotal;
+
+static u64 IdleAtStart;
+static u64 SlotAtStart[IDLE_SLOT_COUNT];
+static u32 WakeupAtStart;
+
+static Idle_Load Last;
+static int LastValid;
+
+/*****************************************************************************/
+/**
+* Closes the current window if it has run for IDLE_WINDOW_US. A window that
+* ran long because the loop was busy is latched with its real length.
+*
+******************************************************************************/
+static void Idle_Roll(u64 Now)
+{
+	u64 Length = Now - WindowStart;
+	u64 Total;
+	u32 Slot;
+
+	if (Length < WindowTicks)
+		return;
+
+	Last.WindowTicks = Length;
+	Last.IdleTicks = IdleTotal - IdleAtStart;
+	if (Last.IdleTicks > Length)
+		Last.IdleTicks = Length;
+	Last.BusyTicks = Length - Last.IdleTicks;
+	for (Slot = 0; Slot < IDLE_SLOT_COUNT; Slot++) {
+		Total = __atomic_load_n(&SlotTotal[Slot], __ATOMIC_RELAXED);
+		Last.SlotTicks[Slot] = Total - SlotAtStart[Slot];
+		SlotAtStart[Slot] = Total;
+	}
+	Last.Wakeups = WakeupTotal - WakeupAtStart;
+	Last.LoadPermille = (u32)(Last.BusyTicks * 1000 / Length);
+	LastValid = TRUE;
+
+	IdleAtStart = IdleTotal;
+	WakeupAtStart = WakeupTotal;
+	WindowStart = Now;
+}
+
+/*****************************************************************************/
+/**
+* Clears the counters and opens the first reporting window.
+*
+******************************************************************************/
+void Idle_Init(void)
+{
+	u32 Slot;
+
+	WindowTicks = us_to_ticks(IDLE_WINDOW_US);
+	WindowStart = now_ticks();
+	IdleTotal = 0;
+	IdleAtStart = 0;
+	WakeupTotal = 0;
+	WakeupAtStart = 0;
+	for (Slot = 0; Slot < IDLE_SLOT_COUNT; Slot++) {
+		SlotTotal[Slot] = 0;
+		SlotAtStart[Slot] = 0;
+	}
+	Last = (Idle_Load){0};
+	LastValid = FALSE;
+}
+
+/*****************************************************************************/
+/**
+* Sleeps until the next interrupt unless an event is already pending or the
+* deadline has passed. Called from the main loop once all work is done.
+*
+* @param	Deadline is a time base value the caller must be back by, or
+*		IDLE_NO_DEADLINE.
+*
+* @note		The core can only be woken by an interrupt, so on the target a
+*		deadline is met to within the period of the periodic
+*		interrupts: the 1 kHz tick, and the 40 us LCD tick while the
+*		display is being written. The host build sleeps for at most
+*		IDLE_HOST_SLEEP_US.
+*
+******************************************************************************/
+void Idle_Wait(u64 Deadline)
+{
+	u64 Start, End;
+
+#ifndef HOST_SIM
+	Xil_ExceptionDisable();
+#endif
+	Start = now_ticks();
+	if (Event_Pending() || (Deadline != IDLE_NO_DEADLINE &&
+				deadline_reached(Deadline))) {
+#ifndef HOST_SIM
+		Xil_ExceptionEnable();
+#endif
+		Idle_Roll(Start);
+		return;
+	}
+
+#ifdef HOST_SIM
+	{
+		u64 Sleep = us_to_ticks(IDLE_HOST_SLEEP_US);
+		struct timespec Ts;
+
+		if (Deadline != IDLE_NO_DEADLINE && Deadline - Start < Sleep)
+			Sleep = Deadline - Start;
+		Ts.tv_sec = 0;
+		Ts.tv_nsec = (long)ticks_to_us(Sleep) * 1000;
+		timebase_sim_advance_us(ticks_to_us(Sleep));
+		nanosleep(&Ts, NULL);
+	}
+	End = now_ticks();
+#else
+	/* A pending interrupt wakes WFI even while it is masked */
+	wfi();
+	End = now_ticks();
+	Xil_ExceptionEnable();
+#endif
+
+	IdleTotal += End - Start;
+	WakeupTotal++;
+	Idle_Roll(End);
+}
+
+/*****************************************************************************/
+/**
+* Charges busy time to a slot, an event type or IDLE_SLOT_ISR.
+*
+* @param	Slot is the slot to charge.
+* @param	Ticks is the time spent, in time base ticks.
+*
+* @note		IDLE_SLOT_ISR is charged by Intr_Entry() for the outermost
+*		handler only; the time of nested handlers is part of it.
+*
+******************************************************************************/
+void Idle_Charge(u32 Slot, u64 Ticks)
+{
+	if (Slot < IDLE_SLOT_COUNT)
+		__atomic_fetch_add(&SlotTotal[Slot], Ticks, __ATOMIC_RELAXED);
+}
+
+/*****************************************************************************/
+/**
+* Returns the totals of the last complete reporting window.
+*
+* @param	LoadPtr receives the window totals.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if no window has completed yet.
+*
+******************************************************************************/
+int Idle_GetLoad(Idle_Load *LoadPtr)
+{
+	Idle_Roll(now_ticks());
+	if (!LastValid)
+		return XST_FAILURE;
+
+	*LoadPtr = Last;
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* @return	CPU load of the last complete window in percent, rounded, or 0
+*		if no window has completed yet.
+*
+******************************************************************************/
+u32 Idle_LoadPercent(void)
+{
+	Idle_Load Load;
+
+	if (Idle_GetLoad(&Load) != XST_SUCCESS)
+		return 0;
+	return (Load.LoadPermille + 5) / 10;
+}
+
+#ifdef HOST_SIM
+/*****************************************************************************/
+/**
+* Host check of the accounting on the simulated clock. Runs a main loop for
+* one window with a button handler charged 150 us of every 1 ms and 50 us of
+* interrupt time, and prints the load it reports against the 20 % expected.
+*
+******************************************************************************/
+void Idle_Benchmark(void)
+{
+	Idle_Load Load;
+	u64 Deadline;
+	u32 Slot;
+
+	timebase_sim_clock(TRUE);
+	Event_Init();
+	Idle_Init();
+
+	while (Idle_GetLoad(&Load) != XST_SUCCESS) {
+		timebase_sim_advance_us(50);
+		Idle_Charge(IDLE_SLOT_ISR, us_to_ticks(50));
+		timebase_sim_advance_us(150);
+		Idle_Charge(EVENT_BUTTON, us_to_ticks(150));
+
+		Deadline = deadline_after_us(800);
+		while (!deadline_reached(Deadline))
+			Idle_Wait(Deadline);
+	}
+	timebase_sim_clock(FALSE);
+
+	printf("idle: window %u us, busy %u us, idle %u us, %u wakeups, "
+	       "load %u.%u %% (expected 20.0 %%)\n",
+	       ticks_to_us(Load.WindowTicks), ticks_to_us(Load.BusyTicks),
+	       ticks_to_us(Load.IdleTicks), Load.Wakeups,
+	       Load.LoadPermille / 10, Load.LoadPermille % 10);
+	for (Slot = 0; Slot < IDLE_SLOT_COUNT; Slot++)
+		printf("idle: slot %u: %u us\n", Slot,
+		       ticks_to_us(Load.SlotTicks[Slot]));
+}
+#endif /* HOST_SIM */
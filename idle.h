@@ -0,0 +1,59 @@
+/*****************************************************************************/
+/**
+* @file idle.h
+*
+* Idle loop and CPU load accounting.
+*
+* The main loop calls Idle_Wait() after it has run all pending work. With
+* interrupts masked it checks that no event is pending, then sleeps in WFI
+* until the next interrupt, so an event posted between the check and the
+* WFI still wakes the core. The time spent asleep is counted as idle, and
+* time spent in event handlers is charged to the handler's event type.
+*
+* Time is split into reporting windows of IDLE_WINDOW_US. When a window
+* ends its totals are latched and can be read with Idle_GetLoad() while the
+* next window accumulates. All times are in time base ticks.
+*
+******************************************************************************/
+#ifndef IDLE_H
+#define IDLE_H
+
+#include "platform.h"
+#include "event_queue.h"
+
+/************************** Constant Definitions *****************************/
+
+#define IDLE_WINDOW_US		1000000	/* Reporting window */
+#define IDLE_NO_DEADLINE	((u64)-1)
+
+/*
+ * Load is charged to one slot per event type plus one for the time spent
+ * in interrupt handlers
+ */
+#define IDLE_SLOT_ISR		EVENT_TYPE_COUNT
+#define IDLE_SLOT_COUNT		(EVENT_TYPE_COUNT + 1)
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u64 WindowTicks;	/* Length of the window */
+	u64 IdleTicks;		/* Time asleep in Idle_Wait() */
+	u64 BusyTicks;		/* WindowTicks - IdleTicks */
+	u64 SlotTicks[IDLE_SLOT_COUNT];	/* Busy time by handler */
+	u32 Wakeups;		/* Returns from WFI */
+	u32 LoadPermille;	/* BusyTicks / WindowTicks, in 0.1 % */
+} Idle_Load;
+
+/************************** Function Prototypes ******************************/
+
+void Idle_Init(void);
+void Idle_Wait(u64 Deadline);
+void Idle_Charge(u32 Slot, u64 Ticks);
+int Idle_GetLoad(Idle_Load *LoadPtr);
+u32 Idle_LoadPercent(void);
+
+#ifdef HOST_SIM
+void Idle_Benchmark(void);
+#endif
+
+#endif /* IDLE_H */
@@ -0,0 +1,517 @@
+/*****************************************************************************/
+/**
+* @file intr.c
+*
+* Interrupt manager. See intr.h.
+*
+* The GIC calls Intr_Entry() for every connected source with the source's
+* slot as the callback reference. The statistics of a slot are written
+* only by its own handler, which the GIC never nests in itself, and read
+* by the main loop. The outermost handler charges its time, nested
+* handlers included, to IDLE_SLOT_ISR, so every tick spent in interrupt
+* context is counted once.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "intr.h"
+#include "timebase.h"
+#include "idle.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HOST_SIM
+#include <time.h>
+#else
+#include "xparameters.h"
+#include "xil_exception.h"
+#include "xscutimer.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#ifndef HOST_SIM
+#define INTR_DEVICE_ID		XPAR_SCUGIC_SINGLE_DEVICE_ID
+#define INTR_BINARY_POINT	0x2	/* Group priority in bits [7:3] */
+#endif
+
+#ifdef HOST_SIM
+#define INTR_BENCH_BUSY_US	10	/* Simulated time in each handler */
+#define INTR_BENCH_LOG_LEN	32
+#define INTR_BENCH_RUNS		200000
+#define INTR_BENCH_NONE		(-1)
+#endif
+
+/************************** Variable Definitions *****************************/
+
+static XScuGic *Intc;
+static Intr_Source Source[INTR_MAX_SOURCES];
+static u32 Depth;		/* Handlers running, nested ones included */
+
+static const char *const TierName[INTR_TIER_COUNT] = {
+	"control", "acq", "ui",
+};
+
+/*****************************************************************************/
+/**
+* Initializes the GIC, registers its handler for the IRQ exception and
+* enables the exception. Later calls with the same instance do nothing,
+* so every driver setup may call it.
+*
+* @param	IntcPtr is the GIC driver instance of this core.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the GIC could not be initialized.
+*
+******************************************************************************/
+int Intr_Init(XScuGic *IntcPtr)
+{
+#ifndef HOST_SIM
+	XScuGic_Config *IntcConfig;
+#endif
+
+	if (Intc == IntcPtr)
+		return XST_SUCCESS;
+
+#ifndef HOST_SIM
+	IntcConfig = XScuGic_LookupConfig(INTR_DEVICE_ID);
+	if (IntcConfig == NULL)
+		return XST_FAILURE;
+	if (XScuGic_CfgInitialize(IntcPtr, IntcConfig,
+				  IntcConfig->CpuBaseAddress) != XST_SUCCESS)
+		return XST_FAILURE;
+	XScuGic_CPUWriteReg(IntcPtr, XSCUGIC_BIN_PT_OFFSET, INTR_BINARY_POINT);
+
+	Xil_ExceptionInit();
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+			(Xil_ExceptionHandler)XScuGic_InterruptHandler, IntcPtr);
+	Xil_ExceptionEnable();
+#endif
+	memset(Source, 0, sizeof(Source));
+	Depth = 0;
+	Intc = IntcPtr;
+	return XST_SUCCESS;
+}
+
+static Intr_Source *Intr_Find(u32 Id)
+{
+	u32 i;
+
+	for (i = 0; i < INTR_MAX_SOURCES; i++) {
+		if (Source[i].Handler != NULL && Source[i].Id == Id)
+			return &Source[i];
+	}
+	return NULL;
+}
+
+/*
+ * Runs a handler with the IRQ unmasked. On the board the handler runs in
+ * system mode on the main stack; Handler and CallBackRef stay in registers
+ * across the mode switch, which is why this is a function of its own.
+ */
+static void Intr_RunNested(Intr_Handler Handler, void *CallBackRef)
+{
+#ifdef HOST_SIM
+	HwSim_GicIrqEnable();
+	Handler(CallBackRef);
+	HwSim_GicIrqDisable();
+#else
+	Xil_EnableNestedInterrupts();
+	Handler(CallBackRef);
+	Xil_DisableNestedInterrupts();
+#endif
+}
+
+/*
+ * GIC handler of every connected source, entered with the IRQ masked
+ */
+static void Intr_Entry(void *CallBackRef)
+{
+	Intr_Source *SrcPtr = CallBackRef;
+	Intr_Stats *StatsPtr = &SrcPtr->Stats;
+	u64 Start = now_ticks();
+	u64 Raised = 0, End;
+	int Probed = (SrcPtr->Probe != NULL);
+
+	if (Probed)
+		Raised = SrcPtr->Probe(SrcPtr->CallBackRef);
+#ifdef HOST_SIM
+	else {
+		/* The simulated GIC knows when it was raised */
+		Raised = HwSim_GicRaisedAt(SrcPtr->Id);
+		Probed = TRUE;
+	}
+#endif
+	if (Probed && Raised <= Start) {
+		StatsPtr->Probed++;
+		if (Start - Raised > StatsPtr->MaxLatency)
+			StatsPtr->MaxLatency = Start - Raised;
+	}
+	StatsPtr->Hits++;
+	if (Depth++ != 0)
+		StatsPtr->Nested++;
+
+	if (SrcPtr->Tier != INTR_TIER_CONTROL)
+		Intr_RunNested(SrcPtr->Handler, SrcPtr->CallBackRef);
+	else
+		SrcPtr->Handler(SrcPtr->CallBackRef);
+
+	Depth--;
+	End = now_ticks();
+	StatsPtr->TotalTicks += End - Start;
+	if (End - Start > StatsPtr->MaxTicks)
+		StatsPtr->MaxTicks = End - Start;
+	if (Depth == 0)
+		Idle_Charge(IDLE_SLOT_ISR, End - Start);
+}
+
+/*****************************************************************************/
+/**
+* Connects and enables an interrupt source at the priority of its tier.
+* Connecting an ID again replaces its handler and clears its statistics.
+*
+* @param	Id is the GIC interrupt ID.
+* @param	Tier is INTR_TIER_CONTROL, INTR_TIER_ACQUISITION or
+*		INTR_TIER_UI.
+* @param	Trigger is INTR_TRIGGER_LEVEL, INTR_TRIGGER_EDGE or
+*		INTR_TRIGGER_KEEP.
+* @param	Handler is called in interrupt context; it must clear the
+*		source. Handlers below INTR_TIER_CONTROL can be preempted.
+* @param	CallBackRef is passed to Handler.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if Intr_Init() has not been called,
+*		the tier is invalid or all INTR_MAX_SOURCES are in use.
+*
+******************************************************************************/
+int Intr_Connect(u32 Id, u32 Tier, u8 Trigger, Intr_Handler Handler,
+		 void *CallBackRef)
+{
+	Intr_Source *SrcPtr;
+	u32 i;
+
+	if (Intc == NULL || Tier >= INTR_TIER_COUNT || Handler == NULL)
+		return XST_FAILURE;
+	SrcPtr = Intr_Find(Id);
+	for (i = 0; SrcPtr == NULL && i < INTR_MAX_SOURCES; i++) {
+		if (Source[i].Handler == NULL)
+			SrcPtr = &Source[i];
+	}
+	if (SrcPtr == NULL)
+		return XST_FAILURE;
+
+	*SrcPtr = (Intr_Source){0};
+	SrcPtr->Id = Id;
+	SrcPtr->Tier = Tier;
+	SrcPtr->Handler = Handler;
+	SrcPtr->CallBackRef = CallBackRef;
+
+#ifdef HOST_SIM
+	(void)Trigger;
+	HwSim_GicSetPriority(Id, INTR_PRIORITY(Tier));
+	HwSim_GicConnect(Id, Intr_Entry, SrcPtr);
+	HwSim_GicEnable(Id);
+#else
+	if (Trigger == INTR_TRIGGER_KEEP) {
+		u8 Priority;
+
+		XScuGic_GetPriorityTriggerType(Intc, Id, &Priority, &Trigger);
+	}
+	XScuGic_SetPriorityTriggerType(Intc, Id, INTR_PRIORITY(Tier), Trigger);
+	if (XScuGic_Connect(Intc, Id, (Xil_ExceptionHandler)Intr_Entry,
+			    SrcPtr) != XST_SUCCESS) {
+		SrcPtr->Handler = NULL;
+		return XST_FAILURE;
+	}
+	XScuGic_Enable(Intc, Id);
+#endif
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Disables and disconnects a source and frees its slot.
+*
+******************************************************************************/
+void Intr_Disconnect(u32 Id)
+{
+	Intr_Source *SrcPtr = Intr_Find(Id);
+
+	if (SrcPtr == NULL)
+		return;
+#ifdef HOST_SIM
+	HwSim_GicDisable(Id);
+	HwSim_GicConnect(Id, NULL, NULL);
+#else
+	XScuGic_Disable(Intc, Id);
+	XScuGic_Disconnect(Intc, Id);
+#endif
+	SrcPtr->Handler = NULL;
+}
+
+/*****************************************************************************/
+/**
+* Gives a connected source a probe for its interrupt latency.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if Id is not connected.
+*
+******************************************************************************/
+int Intr_SetProbe(u32 Id, Intr_Probe Probe)
+{
+	Intr_Source *SrcPtr = Intr_Find(Id);
+
+	if (SrcPtr == NULL)
+		return XST_FAILURE;
+	SrcPtr->Probe = Probe;
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Copies the statistics of a connected source.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if Id is not connected.
+*
+******************************************************************************/
+int Intr_GetStats(u32 Id, Intr_Stats *StatsPtr)
+{
+	Intr_Source *SrcPtr = Intr_Find(Id);
+
+	if (SrcPtr == NULL)
+		return XST_FAILURE;
+	*StatsPtr = SrcPtr->Stats;
+	return XST_SUCCESS;
+}
+
+void Intr_ResetStats(void)
+{
+	u32 i;
+
+	for (i = 0; i < INTR_MAX_SOURCES; i++)
+		Source[i].Stats = (Intr_Stats){0};
+}
+
+/*****************************************************************************/
+/**
+* Prints one line per connected source, most urgent tier first: hits,
+* nested hits, worst latency ("-" without a probe) and handler time in us.
+*
+******************************************************************************/
+void Intr_Report(void)
+{
+	const Intr_Stats *StatsPtr;
+	u32 Tier, i;
+
+	printf("%-4s %-8s %8s %8s %8s %8s %8s\r\n", "irq", "tier", "hits",
+	       "nested", "lat max", "exec avg", "exec max");
+	for (Tier = 0; Tier < INTR_TIER_COUNT; Tier++) {
+		for (i = 0; i < INTR_MAX_SOURCES; i++) {
+			if (Source[i].Handler == NULL || Source[i].Tier != Tier)
+				continue;
+			StatsPtr = &Source[i].Stats;
+			printf("%-4lu %-8s %8lu %8lu ", (unsigned long)Source[i].Id,
+			       TierName[Tier], (unsigned long)StatsPtr->Hits,
+			       (unsigned long)StatsPtr->Nested);
+			if (StatsPtr->Probed != 0)
+				printf("%8lu ", (unsigned long)
+				       ticks_to_us(StatsPtr->MaxLatency));
+			else
+				printf("%8s ", "-");
+			printf("%8lu %8lu\r\n", (unsigned long)ticks_to_us(
+				       StatsPtr->Hits ? StatsPtr->TotalTicks /
+				       StatsPtr->Hits : 0),
+			       (unsigned long)ticks_to_us(StatsPtr->MaxTicks));
+		}
+	}
+}
+
+#ifndef HOST_SIM
+/*****************************************************************************/
+/**
+* Latency probe for a Cortex-A9 private timer in auto reload mode, with the
+* XScuTimer instance as the callback reference. The timer asserted when it
+* reached zero and reloaded; it counts at half the CPU clock, as the global
+* timer of the time base does, so the counts since the reload are ticks.
+*
+* @note		A latency of more than one timer period reads short.
+*
+******************************************************************************/
+u64 Intr_ScuTimerProbe(void *CallBackRef)
+{
+	XScuTimer *TimerPtr = CallBackRef;
+	u32 Load, Count;
+
+	Count = XScuTimer_GetCounterValue(TimerPtr);
+	Load = XScuTimer_ReadReg(TimerPtr->Config.BaseAddr,
+				 XSCUTIMER_LOAD_OFFSET);
+	return now_ticks() - (Load - Count);
+}
+
+#else /* HOST_SIM */
+
+/*
+ * Benchmark source: logs its letter in upper case on entry and lower case
+ * on exit, raises another source and stays busy for INTR_BENCH_BUSY_US.
+ */
+typedef struct {
+	u32 Irq;
+	u32 Tier;
+	char Letter;
+	int Raise;		/* Index of the source to raise, or NONE */
+} Intr_BenchSource;
+
+static Intr_BenchSource BenchSource[] = {
+	{ HWSIM_IRQ_GPIO,     INTR_TIER_UI,          'U', INTR_BENCH_NONE },
+	{ HWSIM_IRQ_SCUTIMER, INTR_TIER_UI,          'L', INTR_BENCH_NONE },
+	{ HWSIM_IRQ_XADC,     INTR_TIER_ACQUISITION, 'A', INTR_BENCH_NONE },
+	{ HWSIM_IRQ_TMRCTR,   INTR_TIER_CONTROL,     'C', INTR_BENCH_NONE },
+};
+
+#define INTR_BENCH_U	0
+#define INTR_BENCH_L	1
+#define INTR_BENCH_A	2
+#define INTR_BENCH_C	3
+#define INTR_BENCH_SOURCES	4
+
+static char BenchLog[INTR_BENCH_LOG_LEN + 1];
+static u32 BenchLogLen;
+static u32 BenchBusyUs;
+
+static void Intr_BenchLog(char Letter)
+{
+	if (BenchLogLen < INTR_BENCH_LOG_LEN)
+		BenchLog[BenchLogLen++] = Letter;
+	BenchLog[BenchLogLen] = '\0';
+}
+
+static void Intr_BenchHandler(void *CallBackRef)
+{
+	Intr_BenchSource *SrcPtr = CallBackRef;
+
+	Intr_BenchLog(SrcPtr->Letter);
+	if (SrcPtr->Raise != INTR_BENCH_NONE)
+		HwSim_GicRaise(BenchSource[SrcPtr->Raise].Irq);
+	if (BenchBusyUs != 0)
+		timebase_sim_advance_us(BenchBusyUs);
+	Intr_BenchLog(SrcPtr->Letter + ('a' - 'A'));
+}
+
+static double Intr_BenchNsPerIrq(void)
+{
+	struct timespec Start, End;
+	u32 i;
+
+	BenchBusyUs = 0;
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < INTR_BENCH_RUNS; i++) {
+		BenchLogLen = 0;
+		HwSim_GicRaise(HWSIM_IRQ_GPIO);
+		HwSim_GicDispatch();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	return ((End.tv_sec - Start.tv_sec) * 1e9 +
+		(End.tv_nsec - Start.tv_nsec)) / INTR_BENCH_RUNS;
+}
+
+/*****************************************************************************/
+/**
+* Checks the tiers on the simulated GIC: sources are raised from the main
+* loop and from each other's handlers, and the order the handlers enter
+* and leave in must show that only a more urgent tier preempts. Then checks
+* the nesting counts and latencies, that the CPU load report counts the
+* time of nested handlers once, and measures the cost of the wrapper per
+* interrupt against a handler connected to the GIC directly.
+*
+******************************************************************************/
+void Intr_Benchmark(void)
+{
+	static const struct {
+		const char *Name;
+		u32 Start;		/* Sources raised from the loop */
+		int Raise[INTR_BENCH_SOURCES];
+		const char *Expect;
+	} Cases[] = {
+		{ "control preempts ui", 1 << INTR_BENCH_U,
+		  { INTR_BENCH_C, -1, -1, -1 }, "UCcu" },
+		{ "ui waits for control", 1 << INTR_BENCH_C,
+		  { -1, -1, -1, INTR_BENCH_U }, "CcUu" },
+		{ "acq waits for control", 1 << INTR_BENCH_C,
+		  { -1, -1, -1, INTR_BENCH_A }, "CcAa" },
+		{ "ui does not nest in ui", 1 << INTR_BENCH_U,
+		  { INTR_BENCH_L, -1, -1, -1 }, "UuLl" },
+		{ "three tiers nest", 1 << INTR_BENCH_U,
+		  { INTR_BENCH_A, -1, INTR_BENCH_C, -1 }, "UACcau" },
+		{ "pending in tier order", 0xF,
+		  { -1, -1, -1, -1 }, "CcAaLlUu" },
+	};
+	static XScuGic BenchIntc;
+	Intr_Stats Control, Acq, Ui;
+	HwSim_Stats Sim;
+	Idle_Load Load;
+	u32 Handlers = 0;
+	double Wrapped, Direct;
+	u32 Case, i, Fail = 0;
+
+	HwSim_Init();
+	Intc = NULL;
+	Intr_Init(&BenchIntc);
+	for (i = 0; i < INTR_BENCH_SOURCES; i++)
+		Intr_Connect(BenchSource[i].Irq, BenchSource[i].Tier,
+			     INTR_TRIGGER_KEEP, Intr_BenchHandler,
+			     &BenchSource[i]);
+	Idle_Init();
+
+	BenchBusyUs = INTR_BENCH_BUSY_US;
+	for (Case = 0; Case < sizeof(Cases) / sizeof(Cases[0]); Case++) {
+		BenchLogLen = 0;
+		BenchLog[0] = '\0';
+		for (i = 0; i < INTR_BENCH_SOURCES; i++)
+			BenchSource[i].Raise = Cases[Case].Raise[i];
+		for (i = 0; i < INTR_BENCH_SOURCES; i++) {
+			if (Cases[Case].Start & (1 << i))
+				HwSim_GicRaise(BenchSource[i].Irq);
+		}
+		HwSim_GicDispatch();
+		Handlers += BenchLogLen / 2;
+		if (strcmp(BenchLog, Cases[Case].Expect) != 0)
+			Fail |= 1 << Case;
+		printf("intr: %-22s %-10s %s\n", Cases[Case].Name, BenchLog,
+		       (Fail & (1 << Case)) ? "FAIL" : "ok");
+	}
+	for (i = 0; i < INTR_BENCH_SOURCES; i++)
+		BenchSource[i].Raise = INTR_BENCH_NONE;
+
+	Intr_Report();
+	Intr_GetStats(HWSIM_IRQ_TMRCTR, &Control);
+	Intr_GetStats(HWSIM_IRQ_XADC, &Acq);
+	Intr_GetStats(HWSIM_IRQ_GPIO, &Ui);
+	HwSim_GetStats(&Sim);
+	/* Control nested twice, acquisition once, never UI */
+	if (Control.Nested != 2 || Acq.Nested != 1 || Ui.Nested != 0 ||
+	    Sim.Preemptions != 3)
+		Fail |= 0x100;
+	/* Control never waited; UI waited behind control, acq and the LCD */
+	if (Control.MaxLatency != 0 ||
+	    Ui.MaxLatency != us_to_ticks(3 * INTR_BENCH_BUSY_US))
+		Fail |= 0x200;
+	/* Each handler was busy once, whether it nested or not */
+	timebase_sim_advance_us(IDLE_WINDOW_US);
+	if (Idle_GetLoad(&Load) != XST_SUCCESS ||
+	    Load.SlotTicks[IDLE_SLOT_ISR] !=
+	    us_to_ticks(Handlers * INTR_BENCH_BUSY_US))
+		Fail |= 0x400;
+	printf("intr: %u handlers, %u us charged to interrupts\n", Handlers,
+	       ticks_to_us(Load.SlotTicks[IDLE_SLOT_ISR]));
+
+	Wrapped = Intr_BenchNsPerIrq();
+	HwSim_GicConnect(HWSIM_IRQ_GPIO, Intr_BenchHandler,
+			 &BenchSource[INTR_BENCH_U]);
+	Direct = Intr_BenchNsPerIrq();
+	printf("intr: %.0f ns per interrupt through the manager, %.0f ns "
+	       "direct\n", Wrapped, Direct);
+
+	printf("intr: checks %s (0x%x)\n", Fail ? "FAIL" : "ok", Fail);
+	Intc = NULL;
+	timebase_sim_clock(FALSE);
+}
+
+#endif /* HOST_SIM */
@@ -0,0 +1,111 @@
+/*****************************************************************************/
+/**
+* @file intr.h
+*
+* Interrupt manager: one owner for the GIC, priority tiers and nesting.
+*
+* Intr_Init() initializes the GIC and the IRQ exception once per core;
+* drivers then connect their sources with Intr_Connect() instead of calling
+* XScuGic_Connect() on a controller of their own. Each source is given a
+* tier rather than a raw priority:
+*
+* - INTR_TIER_CONTROL: the scheduler tick, whose timing the motor and
+*   buzzer outputs depend on;
+* - INTR_TIER_ACQUISITION: the XADC end of sequence;
+* - INTR_TIER_UI: buttons, the LCD tick and the mailbox doorbell.
+*
+* Handlers of the two lower tiers run with the IRQ unmasked
+* (Xil_EnableNestedInterrupts()), so the GIC lets a source of a more urgent
+* tier preempt them; the running priority keeps a source of the same or a
+* lower tier pending until the handler returns. Control handlers run
+* masked and are never preempted.
+*
+* Every handler runs through a wrapper that counts its hits, the hits that
+* preempted another handler and its execution time including any handlers
+* nested in it, and the worst-case latency from the source asserting to
+* the handler starting where the manager can tell when that was: from a
+* probe (Intr_SetProbe(), e.g. Intr_ScuTimerProbe()) on the board, and
+* from the simulated GIC on a HOST_SIM build, where Intr_Benchmark()
+* checks the preemption order. All times are in time base ticks.
+*
+******************************************************************************/
+#ifndef INTR_H
+#define INTR_H
+
+#include "platform.h"
+
+#ifdef HOST_SIM
+#include "hw_sim.h"
+#else
+#include "xscugic.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define INTR_TIER_CONTROL	0	/* Most urgent */
+#define INTR_TIER_ACQUISITION	1
+#define INTR_TIER_UI		2
+#define INTR_TIER_COUNT		3
+
+/*
+ * GIC priority of a tier, lower is more urgent. The Zynq GIC implements
+ * the top five bits, and with the reset binary point each of them is a
+ * preemption level. The UI tier keeps the 0xA0 all sources used to share.
+ */
+#define INTR_PRIORITY(Tier)	(0x60 + (Tier) * 0x20)
+
+/*
+ * Trigger argument of Intr_Connect(), as for XScuGic_SetPriorityTriggerType()
+ */
+#define INTR_TRIGGER_KEEP	0x0	/* As configured, e.g. SGIs and PPIs */
+#define INTR_TRIGGER_LEVEL	0x1	/* Active high level */
+#define INTR_TRIGGER_EDGE	0x3	/* Rising edge */
+
+#define INTR_MAX_SOURCES	8
+
+/**************************** Type Definitions *******************************/
+
+typedef void (*Intr_Handler)(void *CallBackRef);
+
+/*
+ * Returns the time base value at which the source behind CallBackRef
+ * asserted its interrupt. Called at the start of its handler.
+ */
+typedef u64 (*Intr_Probe)(void *CallBackRef);
+
+typedef struct {
+	u32 Hits;
+	u32 Nested;		/* Hits that preempted another handler */
+	u32 Probed;		/* Hits with a latency */
+	u64 MaxLatency;		/* Assertion to handler start */
+	u64 MaxTicks;		/* Handler time, nested handlers included */
+	u64 TotalTicks;
+} Intr_Stats;
+
+typedef struct {
+	u32 Id;
+	u32 Tier;
+	Intr_Handler Handler;	/* NULL if the slot is free */
+	void *CallBackRef;
+	Intr_Probe Probe;
+	Intr_Stats Stats;
+} Intr_Source;
+
+/************************** Function Prototypes ******************************/
+
+int Intr_Init(XScuGic *IntcPtr);
+int Intr_Connect(u32 Id, u32 Tier, u8 Trigger, Intr_Handler Handler,
+		 void *CallBackRef);
+void Intr_Disconnect(u32 Id);
+int Intr_SetProbe(u32 Id, Intr_Probe Probe);
+int Intr_GetStats(u32 Id, Intr_Stats *StatsPtr);
+void Intr_ResetStats(void);
+void Intr_Report(void);
+
+#ifndef HOST_SIM
+u64 Intr_ScuTimerProbe(void *CallBackRef);
+#else
+void Intr_Benchmark(void);
+#endif
+
+#endif /* INTR_H */
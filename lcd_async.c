@@ -0,0 +1,358 @@
+/*****************************************************************************/
+/**
+* @file lcd_async.c
+*
+* Timer-driven HD44780 command queue. See lcd_async.h.
+*
+* The queue has a single producer (the code drawing the display) and a single
+* consumer (LcdAsync_Tick() in the timer interrupt). Head is only written by
+* the producer and Tail only by the consumer, so no locking is required.
+* TimerOn is set by whichever side starts the timer and cleared by the
+* consumer before it stops it; the consumer checks Head again after the
+* stop, so an op queued while it was stopping is not left waiting.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "lcd_async.h"
+#include "timebase.h"
+#include "hal.h"
+#include "trace.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include <time.h>
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define LCD_ASYNC_QUEUE_MASK	(LCD_ASYNC_QUEUE_LEN - 1)
+
+#define LCD_OP_NIBBLE	0	/* Single nibble, used by the reset sequence */
+#define LCD_OP_COMMAND	1	/* Instruction byte, RS = 0 */
+#define LCD_OP_DATA	2	/* Data byte, RS = 1 */
+#define LCD_OP_WAIT	3	/* Delay of Arg us before the next op */
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u8 Kind;
+	u8 Value;
+	u16 Arg;
+} LcdAsync_Op;
+
+/************************** Variable Definitions *****************************/
+
+static volatile u32 *LcdReg;
+
+static LcdAsync_Op Queue[LCD_ASYNC_QUEUE_LEN];
+static volatile u32 Head;	/* Next free slot, written by the producer */
+static volatile u32 Tail;	/* Next op to run, written by the consumer */
+
+static LcdAsync_Op Current;	/* Op being clocked out */
+static u8 Step;			/* Next bus step of Current */
+static u8 StepCount;		/* Bus steps in Current */
+static u64 ReadyAt;		/* Time base deadline for the next bus step */
+static u8 Busy;
+static u64 UpdateStart;
+
+static LcdAsync_TimerFn TimerFn;	/* NULL if the timer runs all the time */
+static volatile u8 TimerOn;
+
+static LcdAsync_Stats Stats;
+
+static void LcdAsync_StartTimer(void)
+{
+	TimerOn = 1;
+	MEMORY_BARRIER();
+	Stats.TimerStarts++;
+	TimerFn(TRUE);
+}
+
+static int LcdAsync_Put(u8 Kind, u8 Value, u16 Arg)
+{
+	u32 H = Head;
+	u32 Depth;
+
+	if ((H - Tail) >= LCD_ASYNC_QUEUE_LEN) {
+		Stats.Overflows++;
+		return XST_FAILURE;
+	}
+
+	Queue[H & LCD_ASYNC_QUEUE_MASK].Kind = Kind;
+	Queue[H & LCD_ASYNC_QUEUE_MASK].Value = Value;
+	Queue[H & LCD_ASYNC_QUEUE_MASK].Arg = Arg;
+	MEMORY_BARRIER();
+	Head = H + 1;
+	MEMORY_BARRIER();
+	if (TimerFn != NULL && !TimerOn)
+		LcdAsync_StartTimer();
+
+	Depth = H + 1 - Tail;
+	if (Depth > Stats.PeakDepth)
+		Stats.PeakDepth = Depth;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Resets the queue and binds it to the LCD register.
+*
+* @param	RegPtr is the LCD_1.0 register the nibbles are written to. On a
+*		host build this is a plain variable standing in for the IP.
+*
+******************************************************************************/
+void LcdAsync_Init(volatile u32 *RegPtr)
+{
+	LcdReg = RegPtr;
+	Head = 0;
+	Tail = 0;
+	Step = 0;
+	StepCount = 0;
+	ReadyAt = 0;
+	Busy = 0;
+	UpdateStart = 0;
+	TimerFn = NULL;
+	TimerOn = 0;
+	Stats = (LcdAsync_Stats){0};
+}
+
+/*****************************************************************************/
+/**
+* Installs the hook that starts and stops the tick timer, so it only runs
+* while there are ops to clock out. Call after LcdAsync_Init() with the
+* timer stopped; it is started here if ops are already queued.
+*
+* @param	Fn starts or stops the timer, or NULL for a timer that runs
+*		all the time.
+*
+******************************************************************************/
+void LcdAsync_SetTimer(LcdAsync_TimerFn Fn)
+{
+	TimerFn = Fn;
+	TimerOn = 0;
+	if (TimerFn != NULL && Head != Tail)
+		LcdAsync_StartTimer();
+}
+
+/*****************************************************************************/
+/**
+* Queues a single nibble with RS = 0, as needed by the 8-bit to 4-bit reset
+* sequence. Only the upper four bits of Data are used.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the queue was full.
+*
+******************************************************************************/
+int LcdAsync_Nibble(u8 Data)
+{
+	return LcdAsync_Put(LCD_OP_NIBBLE, Data, 0);
+}
+
+/*****************************************************************************/
+/**
+* Queues an instruction byte. Clear (0x01) and home (0x02, 0x03) are given
+* the long execution time, everything else the short one.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the queue was full.
+*
+******************************************************************************/
+int LcdAsync_Command(u8 Command)
+{
+	return LcdAsync_Put(LCD_OP_COMMAND, Command, 0);
+}
+
+/*****************************************************************************/
+/**
+* Queues a data byte to be written at the current DDRAM address.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the queue was full.
+*
+******************************************************************************/
+int LcdAsync_Data(u8 Data)
+{
+	return LcdAsync_Put(LCD_OP_DATA, Data, 0);
+}
+
+/*****************************************************************************/
+/**
+* Queues an explicit delay, for the power-on reset sequence.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the queue was full.
+*
+******************************************************************************/
+int LcdAsync_Wait(u16 Us)
+{
+	return LcdAsync_Put(LCD_OP_WAIT, 0, Us);
+}
+
+/*****************************************************************************/
+/**
+* Advances the engine by one step. Must be called every LCD_ASYNC_TICK_US
+* from a single context, normally the LCD timer interrupt, while there are
+* ops queued or the last one has not finished.
+*
+* @note		Each nibble takes two ticks (E high, then E low latching the
+*		data), so a command or data byte occupies the bus for four ticks
+*		plus its execution time.
+*
+******************************************************************************/
+void LcdAsync_Tick(void)
+{
+	u8 Nibble;
+	u8 Control;
+	u32 UpdateUs;
+
+	if (!Busy) {
+		if (Head == Tail)
+			return;
+		Busy = 1;
+		UpdateStart = now_ticks();
+	}
+
+	if (!deadline_reached(ReadyAt))
+		return;
+
+	if (Step == StepCount) {
+		if (Head == Tail) {
+			/* Drained and the last deadline has passed */
+			Busy = 0;
+			UpdateUs = ticks_to_us(now_ticks() - UpdateStart);
+			Stats.Updates++;
+			Stats.LastUpdateUs = UpdateUs;
+			if (UpdateUs > Stats.MaxUpdateUs)
+				Stats.MaxUpdateUs = UpdateUs;
+			if (TimerFn != NULL) {
+				TimerOn = 0;
+				MEMORY_BARRIER();
+				TimerFn(FALSE);
+				MEMORY_BARRIER();
+				if (Head != Tail)
+					LcdAsync_StartTimer();
+			}
+			return;
+		}
+
+		MEMORY_BARRIER();
+		Current = Queue[Tail & LCD_ASYNC_QUEUE_MASK];
+		MEMORY_BARRIER();
+		Tail = Tail + 1;
+
+		Step = 0;
+		if (Current.Kind == LCD_OP_WAIT) {
+			StepCount = 0;
+			ReadyAt = deadline_after_us(Current.Arg);
+			return;
+		}
+		StepCount = (Current.Kind == LCD_OP_NIBBLE) ? 2 : 4;
+	}
+
+	/* Steps 0/1 clock the upper nibble, steps 2/3 the lower one */
+	Nibble = (Step < 2) ? (Current.Value & 0xF0) : (u8)(Current.Value << 4);
+	Control = (Current.Kind == LCD_OP_DATA) ? LCD_CTRL_RS : 0;
+	if ((Step & 1) == 0)
+		Control |= LCD_CTRL_E;
+
+	HAL_WRITE(LcdReg, (u32)(Nibble | Control) >> 2);
+	TRACE_LCD_WRITE((u32)(Nibble | Control) >> 2);
+	Stats.BusWrites++;
+	Step++;
+
+	if (Step == StepCount) {
+		if (Current.Kind == LCD_OP_COMMAND && Current.Value < 4)
+			ReadyAt = deadline_after_us(LCD_EXEC_CLEAR_US);
+		else
+			ReadyAt = deadline_after_us(LCD_EXEC_US);
+	}
+}
+
+/*****************************************************************************/
+/**
+* @return	TRUE when the queue is empty and the last op has completed.
+*
+******************************************************************************/
+int LcdAsync_IsIdle(void)
+{
+	return !Busy && (Head == Tail);
+}
+
+/*****************************************************************************/
+/**
+* Returns a snapshot of the queue statistics.
+*
+* @param	StatsPtr receives the statistics.
+*
+******************************************************************************/
+void LcdAsync_GetStats(LcdAsync_Stats *StatsPtr)
+{
+	*StatsPtr = Stats;
+	StatsPtr->Depth = Head - Tail;
+}
+
+#ifdef HOST_SIM
+static int BenchTimerOn;
+
+static void LcdAsync_BenchTimer(int Run)
+{
+	BenchTimerOn = Run;
+}
+
+/*****************************************************************************/
+/**
+* Host throughput benchmark. Queues a full 2x16 screen Screens times against
+* a simulated LCD register and ticks the engine on the simulated clock for
+* as long as it keeps its timer running, then prints the host cost per tick
+* and the simulated glass time per screen, and checks that the timer was
+* started once per screen and stopped with the queue drained.
+*
+******************************************************************************/
+void LcdAsync_Benchmark(u32 Screens)
+{
+	static volatile u32 SimReg;
+	struct timespec Start, End;
+	u64 Ticks = 0;
+	double Ns;
+	u32 Screen;
+	u32 Col;
+	int Fail = 0;
+
+	timebase_sim_clock(TRUE);
+	LcdAsync_Init(&SimReg);
+	BenchTimerOn = FALSE;
+	LcdAsync_SetTimer(LcdAsync_BenchTimer);
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (Screen = 0; Screen < Screens; Screen++) {
+		LcdAsync_Command(0x80);
+		for (Col = 0; Col < 16; Col++)
+			LcdAsync_Data('A' + Col);
+		LcdAsync_Command(0xC0);
+		for (Col = 0; Col < 16; Col++)
+			LcdAsync_Data('a' + Col);
+
+		while (BenchTimerOn) {
+			timebase_sim_advance_us(LCD_ASYNC_TICK_US);
+			LcdAsync_Tick();
+			Ticks++;
+		}
+		if (!LcdAsync_IsIdle())
+			Fail = 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+
+	Ns = (End.tv_sec - Start.tv_sec) * 1e9 + (End.tv_nsec - Start.tv_nsec);
+	printf("lcd_async: %u screens, %llu ticks, %.1f ns/tick on host\n",
+	       Screens, (unsigned long long)Ticks, Ns / Ticks);
+	printf("lcd_async: %.1f ticks/screen, %u us on the glass, "
+	       "%.1f bus writes/screen, peak depth %u\n",
+	       (double)Ticks / Screens, Stats.LastUpdateUs,
+	       (double)Stats.BusWrites / Screens, Stats.PeakDepth);
+	if (Stats.TimerStarts != Screens)
+		Fail = 1;
+	printf("lcd_async: timer started %u times, checks %s\n",
+	       Stats.TimerStarts, Fail ? "FAIL" : "ok");
+	LcdAsync_SetTimer(NULL);
+	timebase_sim_clock(FALSE);
+}
+#endif /* HOST_SIM */
@@ -0,0 +1,80 @@
+/*****************************************************************************/
+/**
+* @file lcd_async.h
+*
+* Non-blocking command queue for the HD44780 LCD on the LCD_1.0 IP.
+*
+* Callers queue commands and data bytes and return immediately. A periodic
+* timer interrupt calls LcdAsync_Tick(), which advances the queue by one bus
+* write (E high or E low for one nibble) once the deadline set by the
+* previous op has passed on the time base. Deadlines follow the HD44780
+* execution times (37 us for most commands, 1.52 ms for clear/home).
+*
+* The LCD register is written as ((nibble | RS | E) >> 2), matching the
+* lcd_out[5:0] layout of the IP: D7..D4 on bits 5..2, E on bit 1 and RS on
+* bit 0.
+*
+* The timer only needs to run while there is work: with a hook installed by
+* LcdAsync_SetTimer(), the queue starts the timer when an op is queued while
+* it is stopped and stops it from LcdAsync_Tick() once it has drained, so
+* an idle display costs no interrupts.
+*
+******************************************************************************/
+#ifndef LCD_ASYNC_H
+#define LCD_ASYNC_H
+
+#include "platform.h"
+
+/************************** Constant Definitions *****************************/
+
+#define LCD_ASYNC_QUEUE_LEN	128	/* Queue entries, power of two */
+#define LCD_ASYNC_TICK_US	40	/* Period of LcdAsync_Tick() in us */
+
+#define LCD_EXEC_US		37	/* Execution time of most commands */
+#define LCD_EXEC_CLEAR_US	1520	/* Execution time of clear and home */
+
+#define LCD_CTRL_RS		0x4	/* Register select, 1 = data */
+#define LCD_CTRL_E		0x8	/* Enable strobe */
+
+/**************************** Type Definitions *******************************/
+
+/*
+ * Starts (Run = TRUE) or stops the timer that calls LcdAsync_Tick(). Called
+ * from the producer and from LcdAsync_Tick(); starting a running timer must
+ * be harmless.
+ */
+typedef void (*LcdAsync_TimerFn)(int Run);
+
+/*
+ * Queue and timing statistics. An update is one run of the engine from the
+ * first op queued while idle until the queue has drained and the last
+ * deadline has passed.
+ */
+typedef struct {
+	u32 Depth;		/* Ops currently queued */
+	u32 PeakDepth;		/* Highest Depth seen */
+	u32 Overflows;		/* Ops dropped because the queue was full */
+	u32 BusWrites;		/* Writes to the LCD register */
+	u32 Updates;		/* Completed updates */
+	u32 LastUpdateUs;	/* Duration of the most recent update */
+	u32 MaxUpdateUs;	/* Longest update seen */
+	u32 TimerStarts;	/* Times the hook started the timer */
+} LcdAsync_Stats;
+
+/************************** Function Prototypes ******************************/
+
+void LcdAsync_Init(volatile u32 *RegPtr);
+void LcdAsync_SetTimer(LcdAsync_TimerFn TimerFn);
+int LcdAsync_Nibble(u8 Data);
+int LcdAsync_Command(u8 Command);
+int LcdAsync_Data(u8 Data);
+int LcdAsync_Wait(u16 Us);
+void LcdAsync_Tick(void);
+int LcdAsync_IsIdle(void);
+void LcdAsync_GetStats(LcdAsync_Stats *StatsPtr);
+
+#ifdef HOST_SIM
+void LcdAsync_Benchmark(u32 Screens);
+#endif
+
+#endif /* LCD_ASYNC_H */
@@ -0,0 +1,136 @@
+/*****************************************************************************/
+/**
+* @file lcd_fb.c
+*
+* Shadow framebuffer with dirty-cell diffing. See lcd_fb.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "lcd_fb.h"
+#include "lcd_async.h"
+
+/************************** Constant Definitions *****************************/
+
+#define LCD_FB_CURSOR_UNKNOWN	0xFF
+
+/************************** Variable Definitions *****************************/
+
+static char Frame[LCD_FB_ROWS][LCD_FB_COLS];	/* What callers have drawn */
+static char Glass[LCD_FB_ROWS][LCD_FB_COLS];	/* What the LCD shows */
+static u8 Cursor;				/* LCD DDRAM address counter */
+
+/*****************************************************************************/
+/**
+* Initializes the framebuffer for a display that has just been cleared, as
+* LCD_Setup leaves it: every cell blank and the cursor at home.
+*
+******************************************************************************/
+void LcdFb_Init(void)
+{
+	u8 Row, Col;
+
+	for (Row = 0; Row < LCD_FB_ROWS; Row++) {
+		for (Col = 0; Col < LCD_FB_COLS; Col++) {
+			Frame[Row][Col] = ' ';
+			Glass[Row][Col] = ' ';
+		}
+	}
+	Cursor = 0;
+}
+
+/*****************************************************************************/
+/**
+* Blanks the frame in RAM. Nothing is sent until LcdFb_Flush().
+*
+******************************************************************************/
+void LcdFb_Clear(void)
+{
+	u8 Row, Col;
+
+	for (Row = 0; Row < LCD_FB_ROWS; Row++)
+		for (Col = 0; Col < LCD_FB_COLS; Col++)
+			Frame[Row][Col] = ' ';
+}
+
+/*****************************************************************************/
+/**
+* Draws one character. Positions outside the display are ignored.
+*
+******************************************************************************/
+void LcdFb_PutChar(u8 Row, u8 Col, char Ch)
+{
+	if (Row < LCD_FB_ROWS && Col < LCD_FB_COLS)
+		Frame[Row][Col] = Ch;
+}
+
+/*****************************************************************************/
+/**
+* Draws a string starting at Row, Col. Text past the end of the row is
+* clipped.
+*
+******************************************************************************/
+void LcdFb_Print(u8 Row, u8 Col, const char *Str)
+{
+	while (*Str != '\0' && Col < LCD_FB_COLS)
+		LcdFb_PutChar(Row, Col++, *Str++);
+}
+
+/*****************************************************************************/
+/**
+* Marks the whole display as unknown so that the next flush rewrites every
+* cell, e.g. after the LCD has been reset or cleared behind our back.
+*
+******************************************************************************/
+void LcdFb_Invalidate(void)
+{
+	u8 Row, Col;
+
+	for (Row = 0; Row < LCD_FB_ROWS; Row++)
+		for (Col = 0; Col < LCD_FB_COLS; Col++)
+			Glass[Row][Col] = '\0';
+	Cursor = LCD_FB_CURSOR_UNKNOWN;
+}
+
+/*****************************************************************************/
+/**
+* Queues the cells that differ between the frame and the glass. A Set DDRAM
+* Address command is only issued when the next dirty cell is not where the
+* LCD's auto-incrementing cursor already points.
+*
+* @return	Number of ops queued (address commands plus data bytes).
+*
+* @note		If the LCD queue is full the remaining cells stay dirty and are
+*		retried on the next flush.
+*
+******************************************************************************/
+u32 LcdFb_Flush(void)
+{
+	u32 Ops = 0;
+	u8 Row, Col;
+	u8 Addr;
+
+	for (Row = 0; Row < LCD_FB_ROWS; Row++) {
+		for (Col = 0; Col < LCD_FB_COLS; Col++) {
+			if (Frame[Row][Col] == Glass[Row][Col])
+				continue;
+
+			Addr = (Row ? LCD_DDRAM_LINE2 : 0) + Col;
+			if (Cursor != Addr) {
+				if (LcdAsync_Command(LCD_CMD_SET_DDRAM | Addr)
+				    != XST_SUCCESS)
+					return Ops;
+				Cursor = Addr;
+				Ops++;
+			}
+			if (LcdAsync_Data((u8)Frame[Row][Col]) != XST_SUCCESS)
+				return Ops;
+			Glass[Row][Col] = Frame[Row][Col];
+			Cursor++;
+			Ops++;
+		}
+	}
+
+	return Ops;
+}
@@ -0,0 +1,36 @@
+/*****************************************************************************/
+/**
+* @file lcd_fb.h
+*
+* 2x16 shadow framebuffer for the HD44780 LCD.
+*
+* Callers draw into RAM with LcdFb_Clear(), LcdFb_PutChar() and
+* LcdFb_Print(). LcdFb_Flush() compares the frame with what is known to be
+* on the glass and queues only the changed cells on the LCD command queue,
+* positioning the cursor with Set DDRAM Address (0x80 | addr, line 2 starts
+* at 0x40) instead of clearing the display.
+*
+******************************************************************************/
+#ifndef LCD_FB_H
+#define LCD_FB_H
+
+#include "platform.h"
+
+/************************** Constant Definitions *****************************/
+
+#define LCD_FB_ROWS		2
+#define LCD_FB_COLS		16
+
+#define LCD_CMD_SET_DDRAM	0x80
+#define LCD_DDRAM_LINE2		0x40
+
+/************************** Function Prototypes ******************************/
+
+void LcdFb_Init(void);
+void LcdFb_Clear(void);
+void LcdFb_PutChar(u8 Row, u8 Col, char Ch);
+void LcdFb_Print(u8 Row, u8 Col, const char *Str);
+void LcdFb_Invalidate(void);
+u32 LcdFb_Flush(void);
+
+#endif /* LCD_FB_H */
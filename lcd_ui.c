@@ -0,0 +1,252 @@
+/*****************************************************************************/
+/**
+* @file lcd_ui.c
+*
+* Status screen shown on the LCD. See lcd_ui.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "lcd_ui.h"
+#include "lcd_fb.h"
+#include "lcd_async.h"
+#include "timebase.h"
+#include "bench.h"
+#include "numfmt.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define LCD_UI_LIVE_COL		10	/* Live value fields, to the end of the line */
+#define LCD_UI_LIVE_WIDTH	6	/* "3.300V", "100.0%" */
+
+/************************** Variable Definitions *****************************/
+
+static int LiveValid;
+static Fixed_Q16 LiveVolts;
+static u32 LivePermille;
+
+/*
+ * Prints a number with a unit right-aligned in the live field of a row
+ */
+static void LcdUi_PrintLive(u8 Row, char *Num, u32 Len, char Unit)
+{
+	char Field[LCD_UI_LIVE_WIDTH + 1];
+
+	Num[Len++] = Unit;
+	NumFmt_Field(Field, Num, Len, LCD_UI_LIVE_WIDTH, NUMFMT_RIGHT);
+	LcdFb_Print(Row, LCD_UI_LIVE_COL, Field);
+}
+
+/*****************************************************************************/
+/**
+* Draws the status screen into the framebuffer and queues the cells that
+* changed since the last call.
+*
+* @param	state is 0 for reset, 1 for enabled and 2 for disabled.
+* @param	analog_source is 0 for the potentiometer, 1 for the
+*		photoresistor. Only shown while enabled or disabled.
+*
+******************************************************************************/
+void lcd_output(int state, int analog_source)
+{
+	BENCH_START(Start);
+	char Num[NUMFMT_MAX + 1];
+	u32 Len;
+
+	LcdFb_Clear();
+
+	if (state == 0) {
+		LcdFb_Print(0, 5, "Reset");
+	} else if ((state == 1 || state == 2) && LiveValid) {
+		LcdFb_Print(0, 0, (state == 1) ? "Enable" : "Disable");
+		LcdFb_Print(1, 0, (analog_source == 0) ? "Pot" : "Light");
+
+		Len = NumFmt_Q16(Num, LiveVolts, 3);
+		LcdUi_PrintLive(0, Num, Len, 'V');
+		Len = NumFmt_Point(Num, (s32)LivePermille, 1);
+		LcdUi_PrintLive(1, Num, Len, '%');
+	} else if (state == 1 || state == 2) {
+		if (state == 1)
+			LcdFb_Print(0, 5, "Enable");
+		else
+			LcdFb_Print(0, 4, "Disable");
+
+		if (analog_source == 0)
+			LcdFb_Print(1, 1, "Potentiometer");
+		else if (analog_source == 1)
+			LcdFb_Print(1, 1, "Photoresistor");
+	}
+
+	LcdFb_Flush();
+	if (state >= 0 && state <= 2)
+		BENCH_STOP(BENCH_LCD_OUTPUT_RESET + state, Start);
+}
+
+/*****************************************************************************/
+/**
+* Sets the live values the next lcd_output() shows while enabled or
+* disabled.
+*
+* @param	Volts is the selected input at the pins.
+* @param	DutyPermille is the motor duty, shown as a percentage.
+*
+******************************************************************************/
+void LcdUi_SetLive(Fixed_Q16 Volts, u32 DutyPermille)
+{
+	LiveVolts = Volts;
+	LivePermille = DutyPermille;
+	LiveValid = TRUE;
+}
+
+/*****************************************************************************/
+/**
+* Queues the HD44780 power-on reset, 4-bit mode and display setup, and
+* marks the glass as blank for the framebuffer. The LCD timer clocks it out.
+*
+******************************************************************************/
+void LcdUi_Setup(void)
+{
+	LcdAsync_Wait(30000);       /* power-on wait before the reset sequence */
+	LcdAsync_Nibble(0x30);
+	LcdAsync_Wait(10000);
+	LcdAsync_Nibble(0x30);
+	LcdAsync_Wait(1000);
+	LcdAsync_Nibble(0x30);
+	LcdAsync_Wait(1000);
+	LcdAsync_Nibble(0x20);      /* use 4-bit data mode */
+	LcdAsync_Wait(1000);
+	LcdAsync_Command(0x28);     /* set 4-bit data, 2-line, 5x7 font */
+	LcdAsync_Command(0x06);     /* move cursor right */
+	LcdAsync_Command(0x06);
+	LcdAsync_Command(0x01);     /* clear screen, move cursor to home */
+	LcdAsync_Command(0x0E);     /* turn on display, cursor blinking */
+
+	LcdFb_Init();               /* glass is blank once the clear has run */
+	LiveValid = FALSE;
+}
+
+#ifdef HOST_SIM
+/*
+ * Moves the cursor right Shifts cells and writes Text, as the old
+ * lcd_output did with 0x14 commands and LCD_data
+ */
+static void LcdUi_LegacyPrint(u32 Shifts, const char *Text)
+{
+	while (Shifts-- > 0)
+		LcdAsync_Command(0x14);
+	while (*Text != '\0')
+		LcdAsync_Data((u8)*Text++);
+}
+
+/*
+ * Queues the byte stream of the old clear-and-redraw lcd_output: clear
+ * the display, then every character of the screen.
+ */
+static void LcdUi_LegacyOutput(int state, int analog_source)
+{
+	if (state < 0 || state > 2)
+		return;
+
+	LcdAsync_Command(0x01);
+	if (state == 0) {
+		LcdUi_LegacyPrint(5, "Reset");
+		return;
+	}
+	if (state == 1)
+		LcdUi_LegacyPrint(5, "Enable");
+	else
+		LcdUi_LegacyPrint(4, "Disable");
+
+	LcdAsync_Command(0xC0);     /* 2nd line */
+	if (analog_source == 0)
+		LcdUi_LegacyPrint(1, "Potentiometer");
+	else if (analog_source == 1)
+		LcdUi_LegacyPrint(1, "Photoresistor");
+}
+
+/*****************************************************************************/
+/**
+* Runs one screen change to completion on the simulated LCD and returns the
+* bus writes it took. When Clear is set the old clear-and-redraw byte
+* stream is replayed instead of lcd_output().
+*
+******************************************************************************/
+static u32 LcdUi_Measure(int state, int analog_source, int Clear, u32 *UsPtr)
+{
+	LcdAsync_Stats Before, After;
+
+	LcdAsync_GetStats(&Before);
+	if (Clear)
+		LcdUi_LegacyOutput(state, analog_source);
+	else
+		lcd_output(state, analog_source);
+	while (!LcdAsync_IsIdle()) {
+		LcdAsync_Tick();
+		timebase_sim_advance_us(LCD_ASYNC_TICK_US);
+	}
+	LcdAsync_GetStats(&After);
+
+	*UsPtr = (After.Updates != Before.Updates) ? After.LastUpdateUs : 0;
+	return After.BusWrites - Before.BusWrites;
+}
+
+/*****************************************************************************/
+/**
+* Host benchmark of LCD bus transactions per screen change, diff flush
+* against clear-and-redraw, over the Reset/Enable/Disable and
+* Potentiometer/Photoresistor transitions.
+*
+******************************************************************************/
+void LcdUi_Benchmark(void)
+{
+	static const struct {
+		const char *Name;
+		int State;
+		int Source;
+	} Steps[] = {
+		{ "Reset",                 0, 1 },
+		{ "Enable/Photoresistor",  1, 1 },
+		{ "Enable/Potentiometer",  1, 0 },
+		{ "Disable/Potentiometer", 2, 0 },
+		{ "Disable/Photoresistor", 2, 1 },
+		{ "Enable/Photoresistor",  1, 1 },
+		{ "Reset",                 0, 1 },
+	};
+	static volatile u32 SimReg;
+	u32 DiffWrites, FullWrites, DiffUs, FullUs;
+	u32 TotalDiff = 0, TotalFull = 0;
+	u32 i;
+
+	timebase_sim_clock(TRUE);
+	printf("%-22s %18s %18s\n", "lcd_ui: transition to",
+	       "diff flush", "clear+redraw");
+	for (i = 0; i < sizeof(Steps) / sizeof(Steps[0]); i++) {
+		LcdAsync_Init(&SimReg);
+		LcdFb_Init();
+		if (i > 0)
+			LcdUi_Measure(Steps[i - 1].State, Steps[i - 1].Source,
+				      0, &DiffUs);
+		DiffWrites = LcdUi_Measure(Steps[i].State, Steps[i].Source,
+					   0, &DiffUs);
+
+		LcdAsync_Init(&SimReg);
+		LcdFb_Init();
+		FullWrites = LcdUi_Measure(Steps[i].State, Steps[i].Source,
+					   1, &FullUs);
+
+		printf("%-22s %4u writes %5u us %4u writes %5u us\n",
+		       Steps[i].Name,
+		       DiffWrites, DiffUs, FullWrites, FullUs);
+		TotalDiff += DiffWrites;
+		TotalFull += FullWrites;
+	}
+	printf("lcd_ui: %u bus writes with diffing, %u with clear+redraw\n",
+	       TotalDiff, TotalFull);
+	timebase_sim_clock(FALSE);
+}
+#endif /* HOST_SIM */
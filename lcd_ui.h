@@ -0,0 +1,27 @@
+/*****************************************************************************/
+/**
+* @file lcd_ui.h
+*
+* Status screen shown on the LCD: the enable state on line 1 and the
+* selected analog source on line 2. Once live values have been set, the
+* enabled and disabled screens also show the input voltage on line 1 and
+* the motor duty on line 2, right-aligned, with the source name shortened.
+*
+******************************************************************************/
+#ifndef LCD_UI_H
+#define LCD_UI_H
+
+#include "platform.h"
+#include "fixed.h"
+
+/************************** Function Prototypes ******************************/
+
+void lcd_output(int state, int analog_source);
+void LcdUi_Setup(void);
+void LcdUi_SetLive(Fixed_Q16 Volts, u32 DutyPermille);
+
+#ifdef HOST_SIM
+void LcdUi_Benchmark(void);
+#endif
+
+#endif /* LCD_UI_H */
@@ -0,0 +1,386 @@
+/*****************************************************************************/
+/**
+* @file numfmt.c
+*
+* Integer and fixed-point formatting. See numfmt.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "numfmt.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#ifdef HOST_SIM
+#define NUMFMT_BENCH_CALLS	1000000
+#define NUMFMT_BENCH_Q16_DECIMALS 3	/* Decimals checked over 24 bits */
+#endif
+
+/************************** Variable Definitions *****************************/
+
+static const char Pairs[200] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static const char HexDigits[16] = "0123456789abcdef";
+
+static const u32 Pow10[10] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+	1000000000,
+};
+
+/*
+ * Number of decimal digits in Value, at least 1
+ */
+static u32 NumFmt_Digits(u32 Value)
+{
+	u32 Digits = 1;
+
+	while (Digits < 10 && Value >= Pow10[Digits])
+		Digits++;
+	return Digits;
+}
+
+/*
+ * Writes exactly Digits decimal digits of Value, the low ones if Value has
+ * more, zero-filled on the left. No NUL.
+ */
+static void NumFmt_PutDigits(char *Buf, u32 Value, u32 Digits)
+{
+	char *Ptr = Buf + Digits;
+	u32 Pair;
+
+	while (Ptr - Buf >= 2) {
+		Pair = Value % 100;
+		Value /= 100;
+		Ptr -= 2;
+		Ptr[0] = Pairs[2 * Pair];
+		Ptr[1] = Pairs[2 * Pair + 1];
+	}
+	if (Ptr != Buf)
+		Buf[0] = (char)('0' + Value % 10);
+}
+
+/*
+ * Int.Frac with Decimals digits after the point, and a '-' in front if
+ * Negative and the value is not all zeros
+ */
+static u32 NumFmt_PutPoint(char *Buf, int Negative, u32 Int, u32 Frac,
+			   u32 Decimals)
+{
+	u32 Len = 0;
+	u32 Digits = NumFmt_Digits(Int);
+
+	if (Negative && (Int != 0 || Frac != 0))
+		Buf[Len++] = '-';
+	NumFmt_PutDigits(Buf + Len, Int, Digits);
+	Len += Digits;
+	if (Decimals != 0) {
+		Buf[Len++] = '.';
+		NumFmt_PutDigits(Buf + Len, Frac, Decimals);
+		Len += Decimals;
+	}
+	Buf[Len] = '\0';
+	return Len;
+}
+
+/*****************************************************************************/
+/**
+* Unsigned decimal, as printf "%u".
+*
+* @param	Buf has room for 11 characters.
+*
+******************************************************************************/
+u32 NumFmt_Udec(char *Buf, u32 Value)
+{
+	u32 Digits = NumFmt_Digits(Value);
+
+	NumFmt_PutDigits(Buf, Value, Digits);
+	Buf[Digits] = '\0';
+	return Digits;
+}
+
+/*****************************************************************************/
+/**
+* Signed decimal, as printf "%d".
+*
+* @param	Buf has room for 12 characters.
+*
+******************************************************************************/
+u32 NumFmt_Dec(char *Buf, s32 Value)
+{
+	if (Value >= 0)
+		return NumFmt_Udec(Buf, (u32)Value);
+	Buf[0] = '-';
+	return 1 + NumFmt_Udec(Buf + 1, 0U - (u32)Value);
+}
+
+/*****************************************************************************/
+/**
+* Lower-case hexadecimal, as printf "%x", zero-filled to at least Digits
+* digits as "%0*x".
+*
+* @param	Buf has room for the larger of Digits and 8, plus 1.
+*
+******************************************************************************/
+u32 NumFmt_Hex(char *Buf, u32 Value, u32 Digits)
+{
+	u32 Len = 1;
+	u32 i;
+
+	while (Len < 8 && (Value >> (4 * Len)) != 0)
+		Len++;
+	if (Digits < Len)
+		Digits = Len;
+	for (i = Digits; i > 0; i--) {
+		Buf[i - 1] = HexDigits[Value & 0xF];
+		Value >>= 4;
+	}
+	Buf[Digits] = '\0';
+	return Digits;
+}
+
+/*****************************************************************************/
+/**
+* Decimal fraction Value / 10^Decimals, e.g. millivolts as volts with
+* Decimals 3 or a duty in permille as a percentage with Decimals 1.
+*
+* @param	Buf has room for NUMFMT_MAX characters.
+* @param	Decimals is 0 to NUMFMT_POINT_DECIMALS.
+*
+******************************************************************************/
+u32 NumFmt_Point(char *Buf, s32 Value, u32 Decimals)
+{
+	u32 Abs = (Value < 0) ? 0U - (u32)Value : (u32)Value;
+
+	if (Decimals > NUMFMT_POINT_DECIMALS)
+		Decimals = NUMFMT_POINT_DECIMALS;
+	return NumFmt_PutPoint(Buf, Value < 0, Abs / Pow10[Decimals],
+			       Abs % Pow10[Decimals], Decimals);
+}
+
+/*****************************************************************************/
+/**
+* Q16.16 value rounded to Decimals places, as printf "%.*f" of the value
+* except that halves round away from zero.
+*
+* @param	Buf has room for NUMFMT_MAX characters.
+* @param	Decimals is 0 to NUMFMT_Q16_DECIMALS; the result stays in 32
+*		bits so no 64-bit division is needed.
+*
+******************************************************************************/
+u32 NumFmt_Q16(char *Buf, Fixed_Q16 Value, u32 Decimals)
+{
+	u32 Abs = (Value < 0) ? 0U - (u32)Value : (u32)Value;
+	u32 Scaled;
+
+	if (Decimals > NUMFMT_Q16_DECIMALS)
+		Decimals = NUMFMT_Q16_DECIMALS;
+	Scaled = (u32)(((u64)Abs * Pow10[Decimals] +
+			(1U << (FIXED_Q16_FRAC - 1))) >> FIXED_Q16_FRAC);
+	return NumFmt_PutPoint(Buf, Value < 0, Scaled / Pow10[Decimals],
+			       Scaled % Pow10[Decimals], Decimals);
+}
+
+/*****************************************************************************/
+/**
+* Copies Len characters of Text into a field of Width characters, padded
+* with spaces on the right (NUMFMT_LEFT) or left (NUMFMT_RIGHT). Text that
+* does not fit fills the field with '#', so a number that outgrew its
+* field is never shown cut short.
+*
+* @param	Buf has room for Width + 1 characters.
+*
+* @return	Width.
+*
+******************************************************************************/
+u32 NumFmt_Field(char *Buf, const char *Text, u32 Len, u32 Width, u32 Align)
+{
+	u32 Pad, i;
+
+	if (Len > Width) {
+		for (i = 0; i < Width; i++)
+			Buf[i] = '#';
+		Buf[Width] = '\0';
+		return Width;
+	}
+	Pad = Width - Len;
+	if (Align == NUMFMT_RIGHT) {
+		for (i = 0; i < Pad; i++)
+			Buf[i] = ' ';
+		for (i = 0; i < Len; i++)
+			Buf[Pad + i] = Text[i];
+	} else {
+		for (i = 0; i < Len; i++)
+			Buf[i] = Text[i];
+		for (i = Len; i < Width; i++)
+			Buf[i] = ' ';
+	}
+	Buf[Width] = '\0';
+	return Width;
+}
+
+#ifdef HOST_SIM
+/*
+ * Exact Q16 reference: the rounded value as integer and fraction digits
+ * printed with snprintf
+ */
+static void NumFmt_Q16Ref(char *Buf, u32 Size, Fixed_Q16 Value,
+			  u32 Decimals)
+{
+	s64 Scaled = Fixed_RoundDiv((s64)Value * Pow10[Decimals],
+				    (s64)1 << FIXED_Q16_FRAC);
+	u64 Abs = (Scaled < 0) ? (u64)-Scaled : (u64)Scaled;
+
+	if (Decimals == 0)
+		snprintf(Buf, Size, "%s%llu", Scaled < 0 ? "-" : "",
+			 (unsigned long long)Abs);
+	else
+		snprintf(Buf, Size, "%s%llu.%0*llu", Scaled < 0 ? "-" : "",
+			 (unsigned long long)(Abs / Pow10[Decimals]),
+			 (int)Decimals,
+			 (unsigned long long)(Abs % Pow10[Decimals]));
+}
+
+/*****************************************************************************/
+/**
+* Host benchmark. Times the formatters against snprintf() and checks them
+* exhaustively:
+* - NumFmt_Udec, NumFmt_Hex over every 24-bit value, NumFmt_Dec over every
+*   signed 24-bit value, against snprintf;
+* - NumFmt_Point over every 16-bit value with 0 to 4 decimals;
+* - NumFmt_Q16 over every signed 24-bit value (+-128.0) with
+*   NUMFMT_BENCH_Q16_DECIMALS decimals and every 16-bit value with 0 to 4,
+*   against an integer reference;
+* - the 32-bit limits and field alignment.
+*
+******************************************************************************/
+void NumFmt_Benchmark(void)
+{
+	static const s32 Limits[] = {
+		0, 1, -1, 9, 10, 99, 100, 0x7FFFFFFF, -0x7FFFFFFF - 1,
+		1000000000, -1000000000, 999999999,
+	};
+	char Buf[NUMFMT_MAX], Expect[2 * NUMFMT_MAX];
+	volatile u32 Sink = 0;
+	u32 Start, Fmt, Std, i, Decimals;
+	s32 Value;
+	u32 Fail = 0;
+
+	Bench_Init();
+
+	Start = Bench_Cycles();
+	for (i = 0; i < NUMFMT_BENCH_CALLS; i++)
+		Sink += NumFmt_Dec(Buf, (s32)(i * 2654435761U));
+	Fmt = Bench_Cycles() - Start;
+	Start = Bench_Cycles();
+	for (i = 0; i < NUMFMT_BENCH_CALLS; i++)
+		Sink += snprintf(Buf, sizeof(Buf), "%d", (int)(i * 2654435761U));
+	Std = Bench_Cycles() - Start;
+	printf("numfmt: decimal %.1f ns, snprintf %.1f ns\n",
+	       (double)Fmt / NUMFMT_BENCH_CALLS,
+	       (double)Std / NUMFMT_BENCH_CALLS);
+
+	Start = Bench_Cycles();
+	for (i = 0; i < NUMFMT_BENCH_CALLS; i++)
+		Sink += NumFmt_Q16(Buf, (Fixed_Q16)(i * 211), 3);
+	Fmt = Bench_Cycles() - Start;
+	Start = Bench_Cycles();
+	for (i = 0; i < NUMFMT_BENCH_CALLS; i++)
+		Sink += snprintf(Buf, sizeof(Buf), "%.3f",
+				 (double)(Fixed_Q16)(i * 211) / 65536.0);
+	Std = Bench_Cycles() - Start;
+	printf("numfmt: Q16.16 \"d.ddd\" %.1f ns, snprintf %%.3f %.1f ns\n",
+	       (double)Fmt / NUMFMT_BENCH_CALLS,
+	       (double)Std / NUMFMT_BENCH_CALLS);
+	(void)Sink;
+
+	for (i = 0; i < (1U << 24); i++) {
+		NumFmt_Udec(Buf, i);
+		snprintf(Expect, sizeof(Expect), "%u", i);
+		if (strcmp(Buf, Expect) != 0)
+			Fail |= 1;
+		Value = (s32)i - (1 << 23);
+		NumFmt_Dec(Buf, Value);
+		snprintf(Expect, sizeof(Expect), "%d", Value);
+		if (strcmp(Buf, Expect) != 0)
+			Fail |= 2;
+		NumFmt_Hex(Buf, i, (i & 1) ? 6 : 0);
+		snprintf(Expect, sizeof(Expect), (i & 1) ? "%06x" : "%x", i);
+		if (strcmp(Buf, Expect) != 0)
+			Fail |= 4;
+		NumFmt_Q16(Buf, Value, NUMFMT_BENCH_Q16_DECIMALS);
+		NumFmt_Q16Ref(Expect, sizeof(Expect), Value,
+			      NUMFMT_BENCH_Q16_DECIMALS);
+		if (strcmp(Buf, Expect) != 0)
+			Fail |= 8;
+	}
+
+	for (i = 0; i < (1U << 16); i++) {
+		Value = (s32)i - (1 << 15);
+		for (Decimals = 0; Decimals <= NUMFMT_Q16_DECIMALS; Decimals++) {
+			NumFmt_Point(Buf, Value, Decimals);
+			if (Decimals == 0)
+				snprintf(Expect, sizeof(Expect), "%d", Value);
+			else
+				snprintf(Expect, sizeof(Expect), "%s%u.%0*u",
+					 (Value < 0) ? "-" : "",
+					 (u32)(Value < 0 ? -Value : Value) /
+					 Pow10[Decimals], (int)Decimals,
+					 (u32)(Value < 0 ? -Value : Value) %
+					 Pow10[Decimals]);
+			if (strcmp(Buf, Expect) != 0)
+				Fail |= 0x10;
+			NumFmt_Q16(Buf, Value, Decimals);
+			NumFmt_Q16Ref(Expect, sizeof(Expect), Value, Decimals);
+			if (strcmp(Buf, Expect) != 0)
+				Fail |= 0x20;
+		}
+	}
+
+	for (i = 0; i < sizeof(Limits) / sizeof(Limits[0]); i++) {
+		NumFmt_Dec(Buf, Limits[i]);
+		snprintf(Expect, sizeof(Expect), "%d", (int)Limits[i]);
+		if (strcmp(Buf, Expect) != 0)
+			Fail |= 0x40;
+		NumFmt_Udec(Buf, (u32)Limits[i]);
+		snprintf(Expect, sizeof(Expect), "%u", (u32)Limits[i]);
+		if (strcmp(Buf, Expect) != 0)
+			Fail |= 0x40;
+		NumFmt_Hex(Buf, (u32)Limits[i], 0);
+		snprintf(Expect, sizeof(Expect), "%x", (u32)Limits[i]);
+		if (strcmp(Buf, Expect) != 0)
+			Fail |= 0x40;
+		NumFmt_Q16(Buf, Limits[i], NUMFMT_Q16_DECIMALS);
+		NumFmt_Q16Ref(Expect, sizeof(Expect), Limits[i],
+			      NUMFMT_Q16_DECIMALS);
+		if (strcmp(Buf, Expect) != 0)
+			Fail |= 0x40;
+	}
+	if (NumFmt_Point(Buf, -0x7FFFFFFF - 1, 9) != 12 ||
+	    strcmp(Buf, "-2.147483648") != 0)
+		Fail |= 0x40;
+
+	NumFmt_Field(Buf, "1.234", 5, 8, NUMFMT_RIGHT);
+	if (strcmp(Buf, "   1.234") != 0)
+		Fail |= 0x80;
+	NumFmt_Field(Buf, "Pot", 3, 6, NUMFMT_LEFT);
+	if (strcmp(Buf, "Pot   ") != 0)
+		Fail |= 0x80;
+	NumFmt_Field(Buf, "100.0", 5, 4, NUMFMT_RIGHT);
+	if (strcmp(Buf, "####") != 0)
+		Fail |= 0x80;
+
+	printf("numfmt: checks %s (0x%x)\n", Fail ? "FAIL" : "ok", Fail);
+}
+#endif /* HOST_SIM */
@@ -0,0 +1,49 @@
+/*****************************************************************************/
+/**
+* @file numfmt.h
+*
+* Integer and fixed-point formatting for the LCD and UART text.
+*
+* Each function writes into a buffer the caller provides, NUL-terminates it
+* and returns the number of characters written, without the NUL. Nothing is
+* allocated and no floating point is used, so the functions are safe in
+* the main loop and cheap enough to call on every screen refresh.
+*
+* Decimal output goes two digits at a time from a table. Fixed-point values
+* round to nearest with halves away from zero, like fixed.h, and a value
+* that rounds to zero is printed without a sign.
+*
+******************************************************************************/
+#ifndef NUMFMT_H
+#define NUMFMT_H
+
+#include "platform.h"
+#include "fixed.h"
+
+/************************** Constant Definitions *****************************/
+
+#define NUMFMT_MAX		16	/* Buffer size enough for any number */
+
+#define NUMFMT_POINT_DECIMALS	9	/* Most decimals of NumFmt_Point() */
+#define NUMFMT_Q16_DECIMALS	4	/* Most decimals of NumFmt_Q16() */
+
+/*
+ * NumFmt_Field() alignment
+ */
+#define NUMFMT_LEFT		0
+#define NUMFMT_RIGHT		1
+
+/************************** Function Prototypes ******************************/
+
+u32 NumFmt_Udec(char *Buf, u32 Value);
+u32 NumFmt_Dec(char *Buf, s32 Value);
+u32 NumFmt_Hex(char *Buf, u32 Value, u32 Digits);
+u32 NumFmt_Point(char *Buf, s32 Value, u32 Decimals);
+u32 NumFmt_Q16(char *Buf, Fixed_Q16 Value, u32 Decimals);
+u32 NumFmt_Field(char *Buf, const char *Text, u32 Len, u32 Width, u32 Align);
+
+#ifdef HOST_SIM
+void NumFmt_Benchmark(void);
+#endif
+
+#endif /* NUMFMT_H */
@@ -0,0 +1,428 @@
+/*****************************************************************************/
+/**
+* @file pipeline.c
+*
+* Sensor-to-actuator pipeline. See pipeline.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "pipeline.h"
+#include "timebase.h"
+#include "bench.h"
+#include <stdio.h>
+
+#ifdef HOST_SIM
+#include <pthread.h>
+#include "event_queue.h"
+#include "idle.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+/*
+ * Motor duty per volt at the selected input, and the buzzer period over the
+ * input range: 1 kHz at 0 V rising to 3 kHz at full scale
+ */
+#define PIPELINE_MOTOR_COUNTS_PER_V	757575	/* 3.3 V is the 25 ms period */
+#define PIPELINE_FULL_SCALE_MV		XADC_CHAN_SE_MV
+#define PIPELINE_BUZZER_LOW_NS		1000000	/* Period at 0 V */
+#define PIPELINE_BUZZER_HIGH_NS		333333	/* Period at full scale */
+
+#ifdef HOST_SIM
+#define PIPELINE_BENCH_FRAME_HZ	3000
+#define PIPELINE_BENCH_MS	1000
+#endif
+
+/*
+ * Counts one update in the histogram
+ */
+static void Pipeline_Record(Pipeline_Hist *HistPtr, u64 Ticks)
+{
+	u32 Us = ticks_to_us(Ticks);
+	u32 Bin = Us ? 32 - (u32)__builtin_clz(Us) : 0;
+
+	if (Bin >= PIPELINE_HIST_BINS)
+		Bin = PIPELINE_HIST_BINS - 1;
+	HistPtr->Bin[Bin]++;
+	HistPtr->Count++;
+	HistPtr->TotalUs += Us;
+	if (Us > HistPtr->MaxUs)
+		HistPtr->MaxUs = Us;
+}
+
+/*
+ * Volts at the pins of the selected input in a frame
+ */
+static Fixed_Q16 Pipeline_Volts(const Pipeline *PipePtr,
+				const XadcAcq_Frame *FramePtr)
+{
+	const XadcChan_Info *InfoPtr = PipePtr->Input[PipePtr->Source];
+	s32 Millivolts = XadcChan_ToMillivolts(InfoPtr,
+					       FramePtr->Data[InfoPtr->Channel]);
+
+	return Fixed_Q16Sat(Fixed_RoundDiv((s64)Millivolts << FIXED_Q16_FRAC,
+					   1000));
+}
+
+/*
+ * Requests the motor duty and buzzer period for the current input and
+ * times the update from Stamp if it wrote the hardware
+ */
+static void Pipeline_Drive(Pipeline *PipePtr, u64 Stamp)
+{
+	PwmUpdate_Stats Before, After;
+	u32 Period;
+	u64 Latency;
+
+	PwmUpdate_GetStats(PipePtr->PwmPtr, &Before);
+
+	if (PipePtr->Enabled)
+		PwmUpdate_SetMotor(PipePtr->PwmPtr,
+				   Fixed_Q16Scale(PipePtr->Volts,
+						  PIPELINE_MOTOR_COUNTS_PER_V, 1));
+	else
+		PwmUpdate_SetMotor(PipePtr->PwmPtr, 0);
+
+	Period = Fixed_Map(Fixed_Q16Scale(PipePtr->Volts, 1000, 1), 0,
+			   PIPELINE_FULL_SCALE_MV, PIPELINE_BUZZER_LOW_NS,
+			   PIPELINE_BUZZER_HIGH_NS);
+	PwmUpdate_Set(PipePtr->PwmPtr, Period, Period / 2);
+
+	PwmUpdate_GetStats(PipePtr->PwmPtr, &After);
+	if (After.Applied != Before.Applied ||
+	    After.MotorApplied != Before.MotorApplied) {
+		Latency = now_ticks() - Stamp;
+		PipePtr->Writes++;
+		Pipeline_Record(&PipePtr->Latency, Latency);
+		Bench_RecordTicks(BENCH_ADC_TO_PWM, Latency);
+	}
+}
+
+/*****************************************************************************/
+/**
+* Initializes a pipeline with the photoresistor selected and the motor off.
+*
+* @param	PipePtr is the pipeline.
+* @param	AcqPtr is an acquisition capturing at least Pipeline_Mask().
+* @param	PwmPtr is the motor and buzzer update path.
+*
+******************************************************************************/
+void Pipeline_Init(Pipeline *PipePtr, XadcAcq *AcqPtr, PwmUpdate *PwmPtr)
+{
+	*PipePtr = (Pipeline){0};
+	PipePtr->AcqPtr = AcqPtr;
+	PipePtr->PwmPtr = PwmPtr;
+	PipePtr->Input[PIPELINE_POT] = XadcChan_Lookup(PIPELINE_POT_CHANNEL);
+	PipePtr->Input[PIPELINE_LIGHT] = XadcChan_Lookup(PIPELINE_LIGHT_CHANNEL);
+	PipePtr->Source = PIPELINE_LIGHT;
+}
+
+/*****************************************************************************/
+/**
+* @return	Channels the pipeline reads, for XadcAcq_Init() and the
+*		sequencer channel enables. Both are single-ended inputs.
+*
+******************************************************************************/
+u32 Pipeline_Mask(void)
+{
+	return (1U << PIPELINE_POT_CHANNEL) | (1U << PIPELINE_LIGHT_CHANNEL);
+}
+
+/*****************************************************************************/
+/**
+* Selects the input and whether the motor runs, and applies the change to
+* the newest frame at once.
+*
+* @param	PipePtr is the pipeline.
+* @param	Source is PIPELINE_POT or PIPELINE_LIGHT (analog_source).
+* @param	Enabled is TRUE to drive the motor (state 1).
+* @param	Stamp is when the change was made, e.g. the button event
+*		stamp, for the latency histogram.
+*
+******************************************************************************/
+void Pipeline_Select(Pipeline *PipePtr, u32 Source, u32 Enabled, u64 Stamp)
+{
+	XadcAcq_Frame Frame;
+
+	if (Source >= PIPELINE_SOURCES)
+		return;
+	PipePtr->Source = Source;
+	PipePtr->Enabled = Enabled;
+
+	if (XadcAcq_Read(PipePtr->AcqPtr, &Frame) == 0)
+		return;
+	PipePtr->Volts = Pipeline_Volts(PipePtr, &Frame);
+	Pipeline_Drive(PipePtr, Stamp);
+}
+
+/*****************************************************************************/
+/**
+* Runs the newest frame through to the PWM. Called from the main loop for
+* EVENT_XADC_EOS; frames that arrived while the loop was busy are skipped
+* in favour of the newest.
+*
+* @param	PipePtr is the pipeline.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if there is no new frame.
+*
+******************************************************************************/
+int Pipeline_Update(Pipeline *PipePtr)
+{
+	XadcAcq_Frame Frame;
+	u32 Seq;
+
+	Seq = XadcAcq_Read(PipePtr->AcqPtr, &Frame);
+	if (Seq == 0 || Seq == PipePtr->LastSeq)
+		return XST_FAILURE;
+
+	PipePtr->Lost += XadcAcq_Lost(PipePtr->LastSeq, Seq);
+	PipePtr->LastSeq = Seq;
+	PipePtr->Frames++;
+
+	PipePtr->Volts = Pipeline_Volts(PipePtr, &Frame);
+	Pipeline_Drive(PipePtr, Frame.Stamp);
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Returns a snapshot of the latency histogram.
+*
+******************************************************************************/
+void Pipeline_GetLatency(const Pipeline *PipePtr, Pipeline_Hist *HistPtr)
+{
+	*HistPtr = PipePtr->Latency;
+}
+
+/*****************************************************************************/
+/**
+* Prints a latency histogram, one line per non-empty bin.
+*
+******************************************************************************/
+void Pipeline_PrintLatency(const Pipeline_Hist *HistPtr)
+{
+	u32 Bin, Lo, Hi;
+
+	printf("input to PWM latency: %lu updates, mean %lu us, max %lu us\r\n",
+	       (unsigned long)HistPtr->Count,
+	       (unsigned long)(HistPtr->Count ?
+			       HistPtr->TotalUs / HistPtr->Count : 0),
+	       (unsigned long)HistPtr->MaxUs);
+	for (Bin = 0; Bin < PIPELINE_HIST_BINS; Bin++) {
+		if (HistPtr->Bin[Bin] == 0)
+			continue;
+		Lo = Bin ? 1U << (Bin - 1) : 0;
+		Hi = 1U << Bin;
+		if (Bin == PIPELINE_HIST_BINS - 1)
+			printf("  %6lu us and up %8lu\r\n", (unsigned long)Lo,
+			       (unsigned long)HistPtr->Bin[Bin]);
+		else
+			printf("  %6lu-%-6lu us %8lu\r\n", (unsigned long)Lo,
+			       (unsigned long)Hi, (unsigned long)HistPtr->Bin[Bin]);
+	}
+}
+
+#ifndef HOST_SIM
+/*****************************************************************************/
+/**
+* Configures the XADC sequencer to convert the potentiometer and the
+* photoresistor continuously, so both are in every frame and switching
+* source needs no reconfiguration. Used by the single-core application and
+* by the control core in the AMP build.
+*
+* @param	XadcPtr is the XSysMon driver instance.
+* @param	DeviceId is the XPAR_<XADC_instance>_DEVICE_ID value from
+*		xparameters.h.
+*
+* @return	XST_SUCCESS if successful, otherwise XST_FAILURE.
+*
+******************************************************************************/
+int Pipeline_XadcSetup(XSysMon *XadcPtr, u16 DeviceId)
+{
+	XSysMon_Config *ConfigPtr;
+	int Status;
+
+	ConfigPtr = XSysMon_LookupConfig(DeviceId);
+	if (ConfigPtr == NULL)
+		return XST_FAILURE;
+
+	Status = XSysMon_CfgInitialize(XadcPtr, ConfigPtr,
+				       ConfigPtr->BaseAddress);
+	if (Status != XST_SUCCESS)
+		return XST_FAILURE;
+
+	/* Stop the sequencer while it is configured */
+	XSysMon_SetSequencerMode(XadcPtr, XSM_SEQ_MODE_SAFE);
+	XSysMon_SetAlarmEnables(XadcPtr, 0x0);
+
+	/* Both inputs single-ended, averaged over 16 conversions */
+	XSysMon_SetAvg(XadcPtr, XSM_AVG_16_SAMPLES);
+	XSysMon_SetSeqInputMode(XadcPtr, 0);
+	XSysMon_SetSeqAvgEnables(XadcPtr, Pipeline_Mask());
+	XSysMon_SetSeqChEnables(XadcPtr, Pipeline_Mask());
+
+	/* ADCCLK is 1/32 of the AXI clock */
+	XSysMon_SetAdcClkDivisor(XadcPtr, 32);
+	XSysMon_SetCalibEnables(XadcPtr, XSM_CFR1_CAL_PS_GAIN_OFFSET_MASK |
+				XSM_CFR1_CAL_ADC_GAIN_OFFSET_MASK);
+	XSysMon_SetSequencerMode(XadcPtr, XSM_SEQ_MODE_CONTINPASS);
+
+	return XST_SUCCESS;
+}
+#endif /* !HOST_SIM */
+
+#ifdef HOST_SIM
+static Pipeline *BenchPipe;
+static volatile int BenchStop;
+
+/*
+ * Publishes a frame with the given codes, the way the handler does
+ */
+static void Pipeline_BenchFrame(XadcAcq *AcqPtr, u16 Pot, u16 Light)
+{
+	u32 Back = AcqPtr->Front ^ 1;
+
+	AcqPtr->Buf[Back].Data[PIPELINE_POT_CHANNEL] = Pot;
+	AcqPtr->Buf[Back].Data[PIPELINE_LIGHT_CHANNEL] = Light;
+	AcqPtr->Buf[Back].Stamp = now_ticks();
+	AcqPtr->Buf[Back].Seq = AcqPtr->Seq + 1;
+	AcqPtr->Front = Back;
+	AcqPtr->Seq++;
+}
+
+/*
+ * End-of-sequence callback: posts the frame for the main loop
+ */
+static void Pipeline_BenchEos(XadcAcq *AcqPtr, u32 Seq)
+{
+	Event_Post(EVENT_XADC_EOS, Seq);
+	Event_IsrDone(EVENT_XADC_EOS, AcqPtr->Buf[AcqPtr->Front].Stamp);
+}
+
+static void Pipeline_BenchHandler(const Event *EventPtr)
+{
+	(void)EventPtr;
+	Pipeline_Update(BenchPipe);
+}
+
+/*
+ * Stands in for the XADC and its interrupt: captures every sequence of the
+ * simulated sequencer, whose codes ramp by a few LSB per sequence
+ */
+static void *Pipeline_BenchXadc(void *Arg)
+{
+	XadcAcq *AcqPtr = Arg;
+
+	while (!BenchStop)
+		XadcAcq_Poll(AcqPtr);
+	return NULL;
+}
+
+/*****************************************************************************/
+/**
+* Host check and benchmark.
+*
+* First, on the simulated clock: a frame must reach the motor and buzzer
+* with the latency it was given, the buzzer at the pitch of its input; a source switch must change the output
+* from the frame already captured; a code change below one PWM quantum
+* must not write; disabling must stop the motor.
+*
+* Then the whole path in real time: a thread runs the simulated XADC at
+* PIPELINE_BENCH_FRAME_HZ and posts EVENT_XADC_EOS for every frame, and the
+* main loop dispatches events and sleeps in Idle_Wait() as on the board.
+* Prints the end-to-end latency histogram of the host run.
+*
+******************************************************************************/
+void Pipeline_Benchmark(void)
+{
+	static volatile u32 MotorRegs[PWM_UPDATE_MOTOR_DUTY(1)];
+	static XSysMon Xadc;
+	static XadcAcq Acq;
+	static Pipeline Pipe;
+	XTmrCtr Timer = { .IsReady = XIL_COMPONENT_IS_READY };
+	PwmUpdate Pwm;
+	Pipeline_Hist Hist;
+	pthread_t Thread;
+	u64 End, Stamp;
+	u32 Writes, Fail = 0;
+	u16 Pot = XadcChan_FromMillivolts(XadcChan_Lookup(PIPELINE_POT_CHANNEL),
+					  1000);
+	u16 Light = XadcChan_FromMillivolts(
+		XadcChan_Lookup(PIPELINE_LIGHT_CHANNEL), 2500);
+
+	timebase_sim_clock(TRUE);
+	XadcAcq_Init(&Acq, &Xadc, Pipeline_Mask(), XADC_ACQ_MODE_INTR);
+	PwmUpdate_Init(&Pwm, &Timer, MotorRegs, 0);
+	Pipeline_Init(&Pipe, &Acq, &Pwm);
+	Pipeline_Select(&Pipe, PIPELINE_POT, TRUE, now_ticks());
+
+	/* A frame 100 us old reaches both outputs */
+	Pipeline_BenchFrame(&Acq, Pot, Light);
+	timebase_sim_advance_us(100);
+	Pipeline_Update(&Pipe);
+	if (Pipe.Writes != 1 || Pipe.Latency.MaxUs != 100 ||
+	    Pipe.Latency.Bin[7] != 1 || MotorRegs[PWM_UPDATE_MOTOR_DUTY(0)] !=
+	    757500 || !Pwm.Running || Pwm.PeriodNs != 798000)
+		Fail |= 1;
+
+	/* No new frame, nothing to do */
+	if (Pipeline_Update(&Pipe) != XST_FAILURE)
+		Fail |= 2;
+
+	/* The photoresistor is already in the frame: no sequencer change */
+	Stamp = now_ticks();
+	timebase_sim_advance_us(3);
+	Pipeline_Select(&Pipe, PIPELINE_LIGHT, TRUE, Stamp);
+	if (Pipe.Writes != 2 || Pipe.Latency.Bin[2] != 1 ||
+	    MotorRegs[PWM_UPDATE_MOTOR_DUTY(0)] != 1895000 ||
+	    Pwm.PeriodNs != 495000)
+		Fail |= 4;
+
+	/* One LSB of noise moves neither output */
+	Writes = Pipe.Writes;
+	Pipeline_BenchFrame(&Acq, Pot, Light + 16);
+	Pipeline_Update(&Pipe);
+	if (Pipe.Writes != Writes || Pipe.Frames != 2)
+		Fail |= 8;
+
+	/* Disabled: the motor stops, the buzzer keeps following the input */
+	Pipeline_Select(&Pipe, PIPELINE_LIGHT, FALSE, now_ticks());
+	if (MotorRegs[PWM_UPDATE_MOTOR_DUTY(0)] != 0)
+		Fail |= 16;
+
+	printf("pipeline: checks %s (0x%x)\n", Fail ? "FAIL" : "ok", Fail);
+	timebase_sim_clock(FALSE);
+
+	/* Real time, the way the board runs it */
+	Bench_Reset(BENCH_ADC_TO_PWM);
+	Event_Init();
+	Idle_Init();
+	XadcAcq_SimSetRate(&Xadc, PIPELINE_BENCH_FRAME_HZ);
+	XadcAcq_Init(&Acq, &Xadc, Pipeline_Mask(), XADC_ACQ_MODE_POLL);
+	XadcAcq_SetCallback(&Acq, Pipeline_BenchEos);
+	PwmUpdate_Init(&Pwm, &Timer, MotorRegs, 0);
+	Pipeline_Init(&Pipe, &Acq, &Pwm);
+	Pipeline_Select(&Pipe, PIPELINE_POT, TRUE, now_ticks());
+	BenchPipe = &Pipe;
+	Event_Register(EVENT_XADC_EOS, Pipeline_BenchHandler);
+
+	BenchStop = FALSE;
+	pthread_create(&Thread, NULL, Pipeline_BenchXadc, &Acq);
+	End = now_ticks() + us_to_ticks(PIPELINE_BENCH_MS * 1000);
+	while (now_ticks() < End) {
+		Event_Dispatch();
+		Idle_Wait(End);
+	}
+	BenchStop = TRUE;
+	pthread_join(Thread, NULL);
+
+	printf("pipeline: %u frames published, %u used, %u skipped for a newer "
+	       "one, %u hardware updates\n", Acq.Stats.Frames, Pipe.Frames,
+	       Pipe.Lost, Pipe.Writes);
+	Pipeline_GetLatency(&Pipe, &Hist);
+	Pipeline_PrintLatency(&Hist);
+}
+#endif /* HOST_SIM */
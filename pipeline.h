@@ -0,0 +1,92 @@
+/*****************************************************************************/
+/**
+* @file pipeline.h
+*
+* Sensor-to-actuator pipeline: XADC input to motor and buzzer PWM.
+*
+* The XSysMon sequencer converts the potentiometer (A0) and the
+* photoresistor (A1) in every sequence, so both are always in the newest
+* XadcAcq frame and analog_source only chooses which one is used. Switching
+* source takes effect on the frame already captured, with no sequencer
+* reconfiguration or settling delay.
+*
+* Each frame's end-of-sequence interrupt posts EVENT_XADC_EOS and the main
+* loop calls Pipeline_Update(), which converts the selected input to volts
+* and passes it to PwmUpdate: the motor duty on the Custom_PWM while the
+* system is enabled, and the buzzer period on the AXI timer PWM. PwmUpdate
+* only writes the hardware when the quantized values move.
+*
+* Every update that writes the hardware is timed from the input change that
+* caused it, the end-of-sequence stamp of the frame or the time of the
+* source/state change, to just after the register write, and counted in a
+* log2 histogram of microseconds. This does not include the conversion
+* before the end of sequence (one sequence) or the wait for the running PWM
+* period to end before the new values take effect (one PWM period).
+*
+******************************************************************************/
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "platform.h"
+#include "fixed.h"
+#include "xadc_acq.h"
+#include "xadc_chan.h"
+#include "pwm_update.h"
+
+/************************** Constant Definitions *****************************/
+
+/*
+ * analog_source values
+ */
+#define PIPELINE_POT		0
+#define PIPELINE_LIGHT		1
+#define PIPELINE_SOURCES	2
+
+#define PIPELINE_POT_CHANNEL	XADC_CHAN_AUX(1)	/* A0 */
+#define PIPELINE_LIGHT_CHANNEL	XADC_CHAN_AUX(9)	/* A1 */
+
+/*
+ * Latency histogram: bin 0 counts updates under 1 us, bin k those from
+ * 2^(k-1) up to 2^k us, and the last bin everything longer
+ */
+#define PIPELINE_HIST_BINS	16
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Count;
+	u32 MaxUs;
+	u64 TotalUs;
+	u32 Bin[PIPELINE_HIST_BINS];
+} Pipeline_Hist;
+
+typedef struct {
+	XadcAcq *AcqPtr;
+	PwmUpdate *PwmPtr;
+	const XadcChan_Info *Input[PIPELINE_SOURCES];
+	u32 Source;		/* analog_source */
+	u32 Enabled;		/* Motor runs, state 1 */
+	u32 LastSeq;		/* Newest frame used */
+	Fixed_Q16 Volts;	/* Selected input at the pins */
+	u32 Frames;		/* Frames used */
+	u32 Lost;		/* Frames published but never used */
+	u32 Writes;		/* Updates that wrote the hardware */
+	Pipeline_Hist Latency;
+} Pipeline;
+
+/************************** Function Prototypes ******************************/
+
+void Pipeline_Init(Pipeline *PipePtr, XadcAcq *AcqPtr, PwmUpdate *PwmPtr);
+u32 Pipeline_Mask(void);
+void Pipeline_Select(Pipeline *PipePtr, u32 Source, u32 Enabled, u64 Stamp);
+int Pipeline_Update(Pipeline *PipePtr);
+void Pipeline_GetLatency(const Pipeline *PipePtr, Pipeline_Hist *HistPtr);
+void Pipeline_PrintLatency(const Pipeline_Hist *HistPtr);
+
+#ifndef HOST_SIM
+int Pipeline_XadcSetup(XSysMon *XadcPtr, u16 DeviceId);
+#else
+void Pipeline_Benchmark(void);
+#endif
+
+#endif /* PIPELINE_H */
@@ -0,0 +1,51 @@
+/*****************************************************************************/
+/**
+* @file platform.h
+*
+* Basic types and status codes shared by the application modules. On the
+* board these come from the Xilinx BSP; when the modules are compiled on a
+* Linux host with HOST_SIM defined, equivalent definitions are provided here
+* so the same sources build against simulated peripherals.
+*
+******************************************************************************/
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#ifdef HOST_SIM
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+
+#ifndef TRUE
+#define TRUE	1
+#define FALSE	0
+#endif
+
+#define XST_SUCCESS	0L
+#define XST_FAILURE	1L
+
+#define XIL_COMPONENT_IS_READY	0x11111111U	/* Driver instance IsReady */
+
+#else /* !HOST_SIM */
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+#endif /* HOST_SIM */
+
+/*
+ * Orders memory accesses between an interrupt handler and the code it
+ * shares a lock-free queue with (DMB on the Cortex-A9).
+ */
+#define MEMORY_BARRIER()	__sync_synchronize()
+
+#endif /* PLATFORM_H */
@@ -0,0 +1,388 @@
+/*****************************************************************************/
+/**
+* @file pwm_update.c
+*
+* Change-only PWM update path. See pwm_update.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "pwm_update.h"
+#include "timebase.h"
+#include "fixed.h"
+#include "hal.h"
+#include "trace.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#ifdef HOST_SIM
+#define XTC_TIMER_0		0
+#define XTC_TIMER_1		1
+#define XTC_HZ_TO_NS(Hz)	(1000000000 / (Hz))
+#define PWM_UPDATE_TIMER_HZ(TimerPtr)	((void)(TimerPtr), PWM_UPDATE_CLOCK_HZ)
+#else
+#define PWM_UPDATE_TIMER_HZ(TimerPtr)	((TimerPtr)->Config.SysClockFreqHz)
+#endif
+
+#ifdef HOST_SIM
+/*
+ * Register writes the XTmrCtr calls make on the AXI timer, counted by the
+ * host stand-in
+ */
+static void XTmrCtr_SetResetValue(XTmrCtr *TimerPtr, u8 Timer, u32 Value)
+{
+	TimerPtr->Load[Timer] = Value;
+	TimerPtr->Writes++;
+}
+
+static void XTmrCtr_PwmDisable(XTmrCtr *TimerPtr)
+{
+	TimerPtr->IsPwmEnabled = FALSE;
+	TimerPtr->Writes += 2;
+}
+
+static void XTmrCtr_PwmEnable(XTmrCtr *TimerPtr)
+{
+	TimerPtr->IsPwmEnabled = TRUE;
+	TimerPtr->Writes += 2;
+}
+
+static u8 XTmrCtr_PwmConfigure(XTmrCtr *TimerPtr, u32 PeriodNs, u32 HighNs)
+{
+	u32 ClkNs = XTC_HZ_TO_NS(PWM_UPDATE_CLOCK_HZ);
+
+	TimerPtr->Writes += 2;	/* Options of timer 0 and timer 1 */
+	XTmrCtr_SetResetValue(TimerPtr, XTC_TIMER_0, PeriodNs / ClkNs - 2);
+	XTmrCtr_SetResetValue(TimerPtr, XTC_TIMER_1, HighNs / ClkNs - 2);
+	return (u8)((u64)HighNs * 100 / PeriodNs);
+}
+#endif /* HOST_SIM */
+
+static u32 PwmUpdate_Quantize(u32 Value, u32 Quantum)
+{
+	return (Value + Quantum / 2) / Quantum * Quantum;
+}
+
+/*
+ * A request within one quantum of the applied value is treated as noise
+ */
+static int PwmUpdate_Near(u32 Value, u32 Applied, u32 Quantum)
+{
+	u32 Diff = (Value > Applied) ? Value - Applied : Applied - Value;
+
+	return Diff < Quantum;
+}
+
+/*****************************************************************************/
+/**
+* Converts a quantized time to the count the timer is loaded with, the same
+* way XTmrCtr_PwmConfigure() does.
+*
+******************************************************************************/
+static u32 PwmUpdate_Counts(const PwmUpdate *PwmPtr, u32 Ns)
+{
+	u32 ClkNs = XTC_HZ_TO_NS(PWM_UPDATE_TIMER_HZ(PwmPtr->TimerPtr));
+
+	if (Ns < 2 * ClkNs)
+		return 0;
+	return Ns / ClkNs - 2;
+}
+
+/*****************************************************************************/
+/**
+* Binds the update path to the timer and a Custom_PWM channel. Nothing is
+* written until the first update.
+*
+* @param	PwmPtr is the update path.
+* @param	TimerPtr is a timer counter initialized with
+*		XTmrCtr_Initialize(), used in PWM mode.
+* @param	MotorBase is the Custom_PWM register block.
+* @param	MotorChannel is the Custom_PWM channel driving the motor.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the timer is not initialized.
+*		The motor channel is bound either way; PwmUpdate_Set() then
+*		fails instead of writing to the timer.
+*
+******************************************************************************/
+int PwmUpdate_Init(PwmUpdate *PwmPtr, XTmrCtr *TimerPtr,
+		   volatile u32 *MotorBase, u32 MotorChannel)
+{
+	*PwmPtr = (PwmUpdate){0};
+	PwmPtr->MotorBase = MotorBase;
+	PwmPtr->MotorChannel = MotorChannel;
+	if (TimerPtr == NULL || TimerPtr->IsReady != XIL_COMPONENT_IS_READY)
+		return XST_FAILURE;
+	PwmPtr->TimerPtr = TimerPtr;
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Requests a PWM period and high time. The timer is only written when a
+* value moves by at least PWM_UPDATE_QUANTUM_NS from the one applied, so
+* ADC noise around a quantization step does not cause updates.
+*
+* @param	PwmPtr is the update path.
+* @param	PeriodNs is the PWM period in ns.
+* @param	HighNs is the high time in ns.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if HighNs is longer than PeriodNs
+*		or PwmUpdate_Init() refused the timer.
+*
+* @note		The two load registers are written one after the other, so if
+*		a period ends between the writes that one period runs with the
+*		new period and the old high time. The output never stops.
+*
+******************************************************************************/
+int PwmUpdate_Set(PwmUpdate *PwmPtr, u32 PeriodNs, u32 HighNs)
+{
+	u32 PeriodCounts;
+	u32 HighCounts;
+
+	if (HighNs > PeriodNs || PwmPtr->TimerPtr == NULL)
+		return XST_FAILURE;
+
+	if (PwmPtr->Running &&
+	    PwmUpdate_Near(PeriodNs, PwmPtr->PeriodNs, PWM_UPDATE_QUANTUM_NS) &&
+	    PwmUpdate_Near(HighNs, PwmPtr->HighNs, PWM_UPDATE_QUANTUM_NS)) {
+		PwmPtr->Stats.Skipped++;
+		return XST_SUCCESS;
+	}
+
+	PeriodNs = PwmUpdate_Quantize(PeriodNs, PWM_UPDATE_QUANTUM_NS);
+	HighNs = PwmUpdate_Quantize(HighNs, PWM_UPDATE_QUANTUM_NS);
+	PeriodCounts = PwmUpdate_Counts(PwmPtr, PeriodNs);
+	HighCounts = PwmUpdate_Counts(PwmPtr, HighNs);
+
+	if (PwmPtr->Running && PeriodCounts == PwmPtr->PeriodCounts &&
+	    HighCounts == PwmPtr->HighCounts) {
+		PwmPtr->Stats.Skipped++;
+		return XST_SUCCESS;
+	}
+
+	if (!PwmPtr->Running) {
+		XTmrCtr_PwmDisable(PwmPtr->TimerPtr);
+		XTmrCtr_PwmConfigure(PwmPtr->TimerPtr, PeriodNs, HighNs);
+		XTmrCtr_SetResetValue(PwmPtr->TimerPtr, XTC_TIMER_0,
+				      PeriodCounts);
+		XTmrCtr_SetResetValue(PwmPtr->TimerPtr, XTC_TIMER_1,
+				      HighCounts);
+		XTmrCtr_PwmEnable(PwmPtr->TimerPtr);
+		PwmPtr->Running = TRUE;
+	} else {
+		if (PeriodCounts != PwmPtr->PeriodCounts)
+			XTmrCtr_SetResetValue(PwmPtr->TimerPtr, XTC_TIMER_0,
+					      PeriodCounts);
+		if (HighCounts != PwmPtr->HighCounts)
+			XTmrCtr_SetResetValue(PwmPtr->TimerPtr, XTC_TIMER_1,
+					      HighCounts);
+	}
+
+	PwmPtr->PeriodNs = PeriodNs;
+	PwmPtr->HighNs = HighNs;
+	PwmPtr->PeriodCounts = PeriodCounts;
+	PwmPtr->HighCounts = HighCounts;
+	PwmPtr->Stats.Applied++;
+	TRACE_PWM_APPLY(TRACE_PWM_BUZZER_PERIOD, PeriodCounts);
+	TRACE_PWM_APPLY(TRACE_PWM_BUZZER_HIGH, HighCounts);
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Writes and commits the motor channel duty if Duty has moved at least one
+* PWM_UPDATE_MOTOR_QUANTUM from the value last written. The Custom_PWM IP
+* takes a committed duty at the end of the running period, so no
+* reconfiguration is needed.
+*
+* @return	XST_SUCCESS.
+*
+******************************************************************************/
+int PwmUpdate_SetMotor(PwmUpdate *PwmPtr, u32 Duty)
+{
+	if (PwmPtr->MotorValid &&
+	    PwmUpdate_Near(Duty, PwmPtr->MotorDuty, PWM_UPDATE_MOTOR_QUANTUM)) {
+		PwmPtr->Stats.MotorSkipped++;
+		return XST_SUCCESS;
+	}
+
+	Duty = PwmUpdate_Quantize(Duty, PWM_UPDATE_MOTOR_QUANTUM);
+
+	HAL_WRITE(&PwmPtr->MotorBase[PWM_UPDATE_MOTOR_DUTY(PwmPtr->MotorChannel)],
+		  Duty);
+	HAL_WRITE(&PwmPtr->MotorBase[PWM_UPDATE_MOTOR_COMMIT], 1);
+	PwmPtr->MotorDuty = Duty;
+	PwmPtr->MotorValid = TRUE;
+	PwmPtr->Stats.MotorApplied++;
+	TRACE_PWM_APPLY(TRACE_PWM_MOTOR, Duty);
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Returns a snapshot of the update counters.
+*
+******************************************************************************/
+void PwmUpdate_GetStats(const PwmUpdate *PwmPtr, PwmUpdate_Stats *StatsPtr)
+{
+	*StatsPtr = PwmPtr->Stats;
+}
+
+#ifdef HOST_SIM
+/*
+ * Slowly rising 11-bit ADC code with +-1 LSB of noise
+ */
+static u32 PwmUpdate_BenchAdc(u32 *SeedPtr, u32 Tick)
+{
+	*SeedPtr = *SeedPtr * 1103515245 + 12345;
+	return 500 + Tick / 1000 + ((*SeedPtr >> 16) % 3) - 1;
+}
+
+/*
+ * Buzzer period the benchmark requests for an ADC code
+ */
+static u32 PwmUpdate_BenchPeriod(u32 Code)
+{
+	return 1000000 - Fixed_Map(Code, 0, 2047, 0, 666666);
+}
+
+/*****************************************************************************/
+/**
+* Runs Ticks requests through a fresh update path and checks its
+* bookkeeping against the stand-in timer and motor registers: every
+* request is counted as applied or skipped, the timer is only written when
+* a quantized count changes and then only the load registers that changed,
+* the motor only when its duty moves a quantum, and at the end the cached
+* values are within a quantum of the last request and are what the
+* registers hold.
+*
+* @return	0 if every check passed, otherwise a mask of the ones that
+*		failed: 1 init, 2 counts, 4 timer writes, 8 motor writes,
+*		0x10 final state.
+*
+******************************************************************************/
+static u32 PwmUpdate_BenchCheck(u32 Ticks)
+{
+	static volatile u32 MotorRegs[PWM_UPDATE_MOTOR_DUTY(1)];
+	XTmrCtr Timer = { .IsReady = XIL_COMPONENT_IS_READY };
+	PwmUpdate Pwm;
+	u32 Seed = 1;
+	u32 Code = 0, Period = 0, i;
+	u32 Writes, Changed, PrevPeriod, PrevHigh, PrevDuty, PrevMotor;
+	u32 Fail = 0;
+
+	if (PwmUpdate_Init(&Pwm, &Timer, MotorRegs, 0) != XST_SUCCESS)
+		return 1;
+	for (i = 0; i < Ticks; i++) {
+		Code = PwmUpdate_BenchAdc(&Seed, i);
+		Period = PwmUpdate_BenchPeriod(Code);
+
+		PrevPeriod = Pwm.PeriodCounts;
+		PrevHigh = Pwm.HighCounts;
+		Writes = Timer.Writes;
+		if (PwmUpdate_Set(&Pwm, Period, Period / 2) != XST_SUCCESS)
+			Fail |= 2;
+		Changed = (Pwm.PeriodCounts != PrevPeriod) +
+			  (Pwm.HighCounts != PrevHigh);
+		if (i > 0 && Timer.Writes - Writes != Changed)
+			Fail |= 4;
+
+		PrevDuty = Pwm.MotorDuty;
+		PrevMotor = Pwm.Stats.MotorApplied;
+		PwmUpdate_SetMotor(&Pwm, Code * 1221);
+		if (i > 0 && (Pwm.Stats.MotorApplied != PrevMotor) !=
+			     (Pwm.MotorDuty != PrevDuty))
+			Fail |= 8;
+	}
+
+	if (Pwm.Stats.Applied + Pwm.Stats.Skipped != Ticks ||
+	    Pwm.Stats.MotorApplied + Pwm.Stats.MotorSkipped != Ticks)
+		Fail |= 2;
+	if (Ticks > 0 &&
+	    (!PwmUpdate_Near(Period, Pwm.PeriodNs, PWM_UPDATE_QUANTUM_NS) ||
+	     !PwmUpdate_Near(Period / 2, Pwm.HighNs, PWM_UPDATE_QUANTUM_NS) ||
+	     !PwmUpdate_Near(Code * 1221, Pwm.MotorDuty,
+			     PWM_UPDATE_MOTOR_QUANTUM) ||
+	     Timer.Load[XTC_TIMER_0] != Pwm.PeriodCounts ||
+	     Timer.Load[XTC_TIMER_1] != Pwm.HighCounts ||
+	     MotorRegs[PWM_UPDATE_MOTOR_DUTY(0)] != Pwm.MotorDuty))
+		Fail |= 0x10;
+	return Fail;
+}
+
+/*****************************************************************************/
+/**
+* Host benchmark. Feeds Ticks timer ticks of a slowly rising ADC code with
+* noise through the old handler body (disable, configure, enable and a motor
+* write on every tick, float maths included) and through the update path
+* with fixed-point maths,
+* and prints the register writes and the host time per tick of each. The
+* two printf calls the old handler also made are not included, and on the
+* board each register write is an AXI access that costs far more than the
+* host time shown.
+*
+* Then checks the update path's bookkeeping with PwmUpdate_BenchCheck()
+* and prints "checks ok" or "checks FAIL" with the mask of failed checks.
+*
+******************************************************************************/
+void PwmUpdate_Benchmark(u32 Ticks)
+{
+	static volatile u32 MotorRegs[PWM_UPDATE_MOTOR_DUTY(1)];
+	XTmrCtr Timer = { .IsReady = XIL_COMPONENT_IS_READY };
+	PwmUpdate Pwm;
+	u32 Seed = 1;
+	u32 OldWrites, NewWrites;
+	u64 Start, OldTicks, NewTicks;
+	float Adc;
+	u32 Code, Period, i;
+	u32 Fail = 0;
+
+	Start = now_ticks();
+	for (i = 0; i < Ticks; i++) {
+		Adc = PwmUpdate_BenchAdc(&Seed, i);
+
+		MotorRegs[PWM_UPDATE_MOTOR_DUTY(0)] = Adc * 1221;
+		XTmrCtr_PwmDisable(&Timer);
+		Period = 1000000 - (Adc / 2047) * 666666;
+		XTmrCtr_PwmConfigure(&Timer, Period, Period / 2);
+		XTmrCtr_PwmEnable(&Timer);
+		Timer.Writes++;		/* Motor duty register */
+	}
+	OldTicks = now_ticks() - Start;
+	OldWrites = Timer.Writes;
+
+	Timer = (XTmrCtr){ .IsReady = XIL_COMPONENT_IS_READY };
+	Seed = 1;
+	if (PwmUpdate_Init(&Pwm, &Timer, MotorRegs, 0) != XST_SUCCESS)
+		Fail |= 1;
+	Start = now_ticks();
+	for (i = 0; i < Ticks; i++) {
+		Code = PwmUpdate_BenchAdc(&Seed, i);
+
+		Period = PwmUpdate_BenchPeriod(Code);
+		PwmUpdate_Set(&Pwm, Period, Period / 2);
+		PwmUpdate_SetMotor(&Pwm, Code * 1221);
+	}
+	NewTicks = now_ticks() - Start;
+	NewWrites = Timer.Writes + 2 * Pwm.Stats.MotorApplied;
+
+	printf("pwm_update: %u ticks, before: %u register writes (%.2f/tick), "
+	       "%.1f ns/tick\n", Ticks, OldWrites, (double)OldWrites / Ticks,
+	       (double)OldTicks / Ticks);
+	printf("pwm_update: after: %u register writes (%.3f/tick), %.1f ns/tick, "
+	       "%u applied, %u skipped, motor %u applied, %u skipped\n",
+	       NewWrites, (double)NewWrites / Ticks, (double)NewTicks / Ticks,
+	       Pwm.Stats.Applied, Pwm.Stats.Skipped,
+	       Pwm.Stats.MotorApplied, Pwm.Stats.MotorSkipped);
+
+	Fail |= PwmUpdate_BenchCheck(Ticks);
+	printf("pwm_update: checks %s (0x%x)\n", Fail ? "FAIL" : "ok", Fail);
+}
+#endif /* HOST_SIM */
@@ -0,0 +1,89 @@
+/*****************************************************************************/
+/**
+* @file pwm_update.h
+*
+* Change-only update path for the buzzer PWM (AXI timer in PWM mode) and the
+* motor channel of the Custom_PWM IP.
+*
+* The requested period and high time are quantized to PWM_UPDATE_QUANTUM_NS
+* and converted to timer counts, and the motor duty to PWM_UPDATE_MOTOR_QUANTUM
+* counts. The hardware is only written when a request moves at least one
+* quantum away from the value last applied, so ADC noise does not cause
+* writes. The first update configures and enables PWM mode. Later updates
+* only rewrite the load registers of timer 0 and timer 1, which the timer
+* copies into the counters when the period ends, so the output keeps running
+* and the new values start on a period boundary.
+*
+******************************************************************************/
+#ifndef PWM_UPDATE_H
+#define PWM_UPDATE_H
+
+#include "platform.h"
+
+#ifdef HOST_SIM
+/*
+ * Host stand-in for the AXI timer: the load registers and a count of the
+ * register writes made to it
+ */
+typedef struct {
+	u32 IsReady;		/* XIL_COMPONENT_IS_READY once initialized */
+	u32 Load[2];
+	u32 Writes;
+	u8 IsPwmEnabled;
+} XTmrCtr;
+#else
+#include "xtmrctr.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define PWM_UPDATE_QUANTUM_NS	1000	/* Resolution of period/high time */
+#define PWM_UPDATE_MOTOR_QUANTUM 2500	/* 0.1 % of the 25 ms motor period */
+
+/*
+ * Custom_PWM word offsets, CUSTOM_PWM_DUTY_OFFSET() and
+ * CUSTOM_PWM_COMMIT_OFFSET divided by 4
+ */
+#define PWM_UPDATE_MOTOR_DUTY(Channel)	(8 + 2 * (Channel))
+#define PWM_UPDATE_MOTOR_COMMIT		3
+
+#ifdef HOST_SIM
+#define PWM_UPDATE_CLOCK_HZ	100000000
+#endif
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Applied;		/* Timer updates written to the hardware */
+	u32 Skipped;		/* Timer updates equal to the applied value */
+	u32 MotorApplied;
+	u32 MotorSkipped;
+} PwmUpdate_Stats;
+
+typedef struct {
+	XTmrCtr *TimerPtr;
+	volatile u32 *MotorBase;	/* Custom_PWM register block */
+	u32 MotorChannel;
+	u32 PeriodNs;		/* Quantized values last applied */
+	u32 HighNs;
+	u32 PeriodCounts;	/* Counts in the timer 0/1 load registers */
+	u32 HighCounts;
+	u32 MotorDuty;		/* Value in the motor duty register */
+	u8 Running;		/* PWM mode configured and enabled */
+	u8 MotorValid;		/* MotorDuty reflects the register */
+	PwmUpdate_Stats Stats;
+} PwmUpdate;
+
+/************************** Function Prototypes ******************************/
+
+int PwmUpdate_Init(PwmUpdate *PwmPtr, XTmrCtr *TimerPtr,
+		   volatile u32 *MotorBase, u32 MotorChannel);
+int PwmUpdate_Set(PwmUpdate *PwmPtr, u32 PeriodNs, u32 HighNs);
+int PwmUpdate_SetMotor(PwmUpdate *PwmPtr, u32 Duty);
+void PwmUpdate_GetStats(const PwmUpdate *PwmPtr, PwmUpdate_Stats *StatsPtr);
+
+#ifdef HOST_SIM
+void PwmUpdate_Benchmark(u32 Ticks);
+#endif
+
+#endif /* PWM_UPDATE_H */
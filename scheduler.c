@@ -0,0 +1,360 @@
+/*****************************************************************************/
+/**
+* @file scheduler.c
+*
+* Fixed-rate cooperative task scheduler. See scheduler.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "scheduler.h"
+#include "timebase.h"
+#include <stdio.h>
+
+#ifdef HOST_SIM
+#include "bench.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#ifdef HOST_SIM
+#define SCHED_BENCH_OVERHEAD_RUNS	100000
+#endif
+
+/*****************************************************************************/
+/**
+* Initializes a scheduler with no tasks.
+*
+******************************************************************************/
+void Sched_Init(Sched *SchedPtr)
+{
+	*SchedPtr = (Sched){0};
+	SchedPtr->TickTicks = us_to_ticks(SCHED_TICK_US);
+}
+
+/*****************************************************************************/
+/**
+* Adds a task. Tasks run in the order they were added when several are
+* released at once, so add them fastest first (rate monotonic).
+*
+* @param	SchedPtr is the scheduler.
+* @param	Name is shown by Sched_Report().
+* @param	Fn is the task body. It must return; it runs with interrupts
+*		enabled.
+* @param	Period is the release period in ticks, e.g. SCHED_HZ(100).
+* @param	Phase is the offset of the first release from Sched_Start(),
+*		in ticks, to spread tasks of the same rate.
+* @param	Deadline is the time from release to the end of the run in
+*		ticks, or SCHED_NO_DEADLINE for the period.
+*
+* @return	The task index, or -1 if the table is full or Period is 0.
+*
+******************************************************************************/
+int Sched_Add(Sched *SchedPtr, const char *Name, Sched_Fn Fn, u32 Period,
+	      u32 Phase, u32 Deadline)
+{
+	Sched_Task *TaskPtr;
+
+	if (SchedPtr->Count == SCHED_MAX_TASKS || Period == 0)
+		return -1;
+	TaskPtr = &SchedPtr->Task[SchedPtr->Count];
+	*TaskPtr = (Sched_Task){0};
+	TaskPtr->Name = Name;
+	TaskPtr->Fn = Fn;
+	TaskPtr->Period = Period * SchedPtr->TickTicks;
+	TaskPtr->Phase = Phase * SchedPtr->TickTicks;
+	TaskPtr->Deadline = ((Deadline != SCHED_NO_DEADLINE) ? Deadline :
+			     Period) * SchedPtr->TickTicks;
+	return (int)SchedPtr->Count++;
+}
+
+/*****************************************************************************/
+/**
+* Sets the first release of every task from now and clears the statistics.
+*
+******************************************************************************/
+void Sched_Start(Sched *SchedPtr)
+{
+	u32 i;
+
+	SchedPtr->Start = now_ticks();
+	for (i = 0; i < SchedPtr->Count; i++)
+		SchedPtr->Task[i].Release = SchedPtr->Start +
+					    SchedPtr->Task[i].Phase;
+	Sched_ResetStats(SchedPtr);
+}
+
+/*
+ * Highest priority task released at Now that is not in the Done mask,
+ * or NULL
+ */
+static Sched_Task *Sched_Due(Sched *SchedPtr, u64 Now, u32 Done)
+{
+	u32 i;
+
+	for (i = 0; i < SchedPtr->Count; i++) {
+		if (!(Done & (1U << i)) && Now >= SchedPtr->Task[i].Release)
+			return &SchedPtr->Task[i];
+	}
+	return NULL;
+}
+
+/*****************************************************************************/
+/**
+* Runs the released tasks, highest priority first, until none is due.
+* After every task the highest priority task is looked for again, so a
+* fast task released while a slow one ran goes next. Each task runs at
+* most once per call, so when the tasks overload the core the main loop
+* still gets back to Event_Dispatch() between passes.
+*
+* A task that is still late by a whole period after its run has its
+* missed releases dropped and counted, and runs once at the newest one.
+*
+* @return	The next release, for Idle_Wait().
+*
+******************************************************************************/
+u64 Sched_Run(Sched *SchedPtr)
+{
+	u64 Entry = now_ticks();
+	u64 Busy = 0, Start, End, Exec, Jitter, Overhead;
+	u64 Next = ~0ULL;
+	Sched_Task *TaskPtr;
+	u32 Done = 0;
+	u32 i;
+
+	while ((TaskPtr = Sched_Due(SchedPtr, now_ticks(), Done)) != NULL) {
+		Start = now_ticks();
+		TaskPtr->Fn();
+		End = now_ticks();
+
+		Exec = End - Start;
+		Jitter = Start - TaskPtr->Release;
+		TaskPtr->Stats.Runs++;
+		TaskPtr->Stats.TotalExec += Exec;
+		TaskPtr->Stats.TotalJitter += Jitter;
+		if (Exec > TaskPtr->Stats.Wcet)
+			TaskPtr->Stats.Wcet = Exec;
+		if (Jitter > TaskPtr->Stats.MaxJitter)
+			TaskPtr->Stats.MaxJitter = Jitter;
+		if (End > TaskPtr->Release + TaskPtr->Deadline)
+			TaskPtr->Stats.Overruns++;
+
+		TaskPtr->Release += TaskPtr->Period;
+		while (TaskPtr->Release + TaskPtr->Period <= End) {
+			TaskPtr->Release += TaskPtr->Period;
+			TaskPtr->Stats.Skipped++;
+		}
+		Busy += Exec;
+		Done |= 1U << (TaskPtr - SchedPtr->Task);
+	}
+
+	if (Done != 0) {
+		Overhead = now_ticks() - Entry - Busy;
+		SchedPtr->Passes++;
+		SchedPtr->TotalOverhead += Overhead;
+		if (Overhead > SchedPtr->MaxOverhead)
+			SchedPtr->MaxOverhead = Overhead;
+	}
+	for (i = 0; i < SchedPtr->Count; i++) {
+		if (SchedPtr->Task[i].Release < Next)
+			Next = SchedPtr->Task[i].Release;
+	}
+	return Next;
+}
+
+void Sched_ResetStats(Sched *SchedPtr)
+{
+	u32 i;
+
+	for (i = 0; i < SchedPtr->Count; i++)
+		SchedPtr->Task[i].Stats = (Sched_TaskStats){0};
+	SchedPtr->Passes = 0;
+	SchedPtr->MaxOverhead = 0;
+	SchedPtr->TotalOverhead = 0;
+}
+
+/*****************************************************************************/
+/**
+* Prints one line per task with its rate, runs, jitter, execution time,
+* overruns and skipped releases, times in us.
+*
+******************************************************************************/
+void Sched_Report(const Sched *SchedPtr)
+{
+	const Sched_Task *TaskPtr;
+	const Sched_TaskStats *StatsPtr;
+	u32 i;
+
+	printf("%-8s %6s %8s %8s %8s %8s %8s %8s %8s\r\n", "task", "Hz",
+	       "runs", "jit avg", "jit max", "exec avg", "wcet", "overrun",
+	       "skipped");
+	for (i = 0; i < SchedPtr->Count; i++) {
+		TaskPtr = &SchedPtr->Task[i];
+		StatsPtr = &TaskPtr->Stats;
+		printf("%-8s %6lu %8lu %8lu %8lu %8lu %8lu %8lu %8lu\r\n",
+		       TaskPtr->Name,
+		       (unsigned long)(TIMEBASE_HZ / TaskPtr->Period),
+		       (unsigned long)StatsPtr->Runs,
+		       (unsigned long)ticks_to_us(StatsPtr->Runs ?
+				StatsPtr->TotalJitter / StatsPtr->Runs : 0),
+		       (unsigned long)ticks_to_us(StatsPtr->MaxJitter),
+		       (unsigned long)ticks_to_us(StatsPtr->Runs ?
+				StatsPtr->TotalExec / StatsPtr->Runs : 0),
+		       (unsigned long)ticks_to_us(StatsPtr->Wcet),
+		       (unsigned long)StatsPtr->Overruns,
+		       (unsigned long)StatsPtr->Skipped);
+	}
+	printf("sched: %lu passes, overhead avg %lu ticks, max %lu ticks\r\n",
+	       (unsigned long)SchedPtr->Passes,
+	       (unsigned long)(SchedPtr->Passes ?
+			       SchedPtr->TotalOverhead / SchedPtr->Passes : 0),
+	       (unsigned long)SchedPtr->MaxOverhead);
+}
+
+#ifdef HOST_SIM
+/*
+ * Bench tasks: each advances the simulated clock by its execution time
+ */
+static u32 BenchExecUs[SCHED_MAX_TASKS];
+static u64 BenchFirst[SCHED_MAX_TASKS];
+static Sched BenchSched;
+
+#define SCHED_BENCH_TASK(Index) \
+	static void Sched_BenchTask##Index(void) \
+	{ \
+		if (BenchFirst[Index] == 0) \
+			BenchFirst[Index] = now_ticks(); \
+		timebase_sim_advance_us(BenchExecUs[Index]); \
+	}
+SCHED_BENCH_TASK(0)
+SCHED_BENCH_TASK(1)
+SCHED_BENCH_TASK(2)
+SCHED_BENCH_TASK(3)
+SCHED_BENCH_TASK(4)
+
+static void Sched_BenchNop(void)
+{
+}
+
+/*
+ * Runs the bench scheduler for Ms on the simulated clock, jumping to the
+ * next release between passes the way Idle_Wait() sleeps until a tick
+ */
+static void Sched_BenchRun(u32 Ms)
+{
+	u64 Stop, Next;
+	u32 i;
+
+	timebase_sim_clock(TRUE);
+	timebase_sim_advance_us(1);	/* First starts are nonzero */
+	for (i = 0; i < SCHED_MAX_TASKS; i++)
+		BenchFirst[i] = 0;
+	Sched_Start(&BenchSched);
+	Stop = BenchSched.Start + us_to_ticks(Ms * 1000);
+	while (now_ticks() < Stop) {
+		Next = Sched_Run(&BenchSched);
+		timebase_sim_set(Next < Stop ? Next : Stop);
+	}
+}
+
+/*****************************************************************************/
+/**
+* Host benchmark. On the simulated clock:
+* - the example task set, ADC 1 kHz, control 500 Hz, buttons 100 Hz and
+*   LCD 10 Hz with phases and execution times that fit, runs Ms; every
+*   task must run Ms * rate times, start at its phase, never overrun and
+*   wait for no more than one run of each other task;
+* - a 10 Hz task that runs 150 ms must overrun on every run and drop the
+*   releases it missed, and the 1 kHz task, which cannot preempt it, must
+*   count the releases that fell inside the long runs as skipped and its
+*   late runs as overruns.
+* On the host clock, the scheduler overhead per pass with one empty task.
+*
+******************************************************************************/
+void Sched_Benchmark(u32 Ms)
+{
+	static const struct {
+		const char *Name;
+		u32 Hz;
+		u32 Phase;
+		u32 ExecUs;
+	} Tasks[] = {
+		{ "adc",      1000, 0,  100 },
+		{ "control",   500, 0,  200 },
+		{ "buttons",   100, 3,   50 },
+		{ "lcd",        10, 7, 1500 },
+	};
+	u32 Count = sizeof(Tasks) / sizeof(Tasks[0]);
+	Sched_Fn Fns[] = {
+		Sched_BenchTask0, Sched_BenchTask1, Sched_BenchTask2,
+		Sched_BenchTask3, Sched_BenchTask4,
+	};
+	const Sched_TaskStats *StatsPtr;
+	u64 Ahead, Start, Cycles;
+	u32 i, j, Expect;
+	u32 Fail = 0;
+
+	Sched_Init(&BenchSched);
+	for (i = 0; i < Count; i++) {
+		BenchExecUs[i] = Tasks[i].ExecUs;
+		Sched_Add(&BenchSched, Tasks[i].Name, Fns[i],
+			  SCHED_HZ(Tasks[i].Hz), Tasks[i].Phase,
+			  SCHED_NO_DEADLINE);
+	}
+	Sched_BenchRun(Ms);
+	Sched_Report(&BenchSched);
+
+	Ahead = 0;
+	for (i = 0; i < Count; i++) {
+		StatsPtr = &BenchSched.Task[i].Stats;
+		Expect = Ms * Tasks[i].Hz / 1000;
+		if (StatsPtr->Runs + 1 < Expect || StatsPtr->Runs > Expect)
+			Fail |= 1;
+		if (BenchFirst[i] < BenchSched.Start +
+				    us_to_ticks(Tasks[i].Phase * SCHED_TICK_US))
+			Fail |= 2;
+		if (StatsPtr->Overruns != 0 || StatsPtr->Skipped != 0)
+			Fail |= 4;
+		/* The set fits with room to spare, so a task waits at most
+		   for one run of every other task */
+		Ahead = 0;
+		for (j = 0; j < Count; j++) {
+			if (j != i)
+				Ahead += us_to_ticks(Tasks[j].ExecUs);
+		}
+		if (StatsPtr->MaxJitter > Ahead)
+			Fail |= 0x20;
+	}
+
+	/* Overload: the 10 Hz task runs longer than its period */
+	BenchExecUs[3] = 150000;
+	Sched_BenchRun(Ms);
+	Sched_Report(&BenchSched);
+	StatsPtr = &BenchSched.Task[3].Stats;
+	if (StatsPtr->Overruns != StatsPtr->Runs || StatsPtr->Skipped == 0)
+		Fail |= 8;
+	if (BenchSched.Task[0].Stats.Skipped == 0 ||
+	    BenchSched.Task[0].Stats.Overruns == 0)
+		Fail |= 0x10;
+	BenchExecUs[3] = Tasks[3].ExecUs;
+	timebase_sim_clock(FALSE);
+
+	/* Overhead per pass on the host clock */
+	Sched_Init(&BenchSched);
+	Sched_Add(&BenchSched, "nop", Sched_BenchNop, 1, 0, SCHED_NO_DEADLINE);
+	Sched_Start(&BenchSched);
+	Bench_Init();
+	Start = Bench_Cycles();
+	for (i = 0; i < SCHED_BENCH_OVERHEAD_RUNS; i++) {
+		BenchSched.Task[0].Release = now_ticks();
+		Sched_Run(&BenchSched);
+	}
+	Cycles = Bench_Cycles() - Start;
+	printf("sched: %.1f ns per pass with one task, %.1f ns of it "
+	       "outside the task\n", (double)Cycles / SCHED_BENCH_OVERHEAD_RUNS,
+	       (double)BenchSched.TotalOverhead / BenchSched.Passes);
+
+	printf("sched: checks %s (0x%x)\n", Fail ? "FAIL" : "ok", Fail);
+}
+#endif /* HOST_SIM */
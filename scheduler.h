@@ -0,0 +1,89 @@
+/*****************************************************************************/
+/**
+* @file scheduler.h
+*
+* Fixed-rate cooperative task scheduler.
+*
+* Tasks are registered with a period and a phase in scheduler ticks of
+* SCHED_TICK_US, and an optional deadline. Run k of a task is released at
+* start + (phase + k * period) ticks on the time base, so the rate does not
+* depend on how long the loop takes. The main loop calls Sched_Run(), which
+* runs each released task once to completion, highest priority (first
+* registered) first, and returns the next release for Idle_Wait(). A
+* hardware tick interrupt, or any other interrupt, wakes the core from
+* Idle_Wait(), so a release is served within one tick of its time when the
+* tasks before it are short.
+*
+* For each task the scheduler records:
+* - jitter: start time minus release time;
+* - execution time, with the worst case (WCET);
+* - overruns: runs that finished after release + deadline;
+* - skipped releases: releases more than a period old when the previous
+*   run ended. They are dropped and the task runs once, late, instead of
+*   back to back.
+* and for the scheduler itself the time Sched_Run() spends outside tasks.
+* All times are in time base ticks.
+*
+******************************************************************************/
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "platform.h"
+
+/************************** Constant Definitions *****************************/
+
+#define SCHED_TICK_US		1000	/* 1 kHz, the fastest task rate */
+#define SCHED_MAX_TASKS		8
+
+#define SCHED_HZ(Hz)		(1000000 / SCHED_TICK_US / (Hz))	/* Period */
+#define SCHED_NO_DEADLINE	0	/* Deadline is the period */
+
+/**************************** Type Definitions *******************************/
+
+typedef void (*Sched_Fn)(void);
+
+typedef struct {
+	u32 Runs;
+	u32 Overruns;		/* Finished after release + deadline */
+	u32 Skipped;		/* Releases dropped because the task was late */
+	u64 MaxJitter;
+	u64 TotalJitter;
+	u64 Wcet;		/* Longest execution */
+	u64 TotalExec;
+} Sched_TaskStats;
+
+typedef struct {
+	const char *Name;
+	Sched_Fn Fn;
+	u64 Period;		/* Time base ticks */
+	u64 Phase;
+	u64 Deadline;
+	u64 Release;		/* Next release */
+	Sched_TaskStats Stats;
+} Sched_Task;
+
+typedef struct {
+	Sched_Task Task[SCHED_MAX_TASKS];
+	u32 Count;
+	u64 TickTicks;		/* SCHED_TICK_US on the time base */
+	u64 Start;
+	u32 Passes;		/* Sched_Run() calls that ran a task */
+	u64 MaxOverhead;	/* Sched_Run() time outside tasks, per pass */
+	u64 TotalOverhead;
+} Sched;
+
+/************************** Function Prototypes ******************************/
+
+void Sched_Init(Sched *SchedPtr);
+int Sched_Add(Sched *SchedPtr, const char *Name, Sched_Fn Fn, u32 Period,
+	      u32 Phase, u32 Deadline);
+void Sched_Start(Sched *SchedPtr);
+u64 Sched_Run(Sched *SchedPtr);
+void Sched_ResetStats(Sched *SchedPtr);
+void Sched_Report(const Sched *SchedPtr);
+
+#ifdef HOST_SIM
+void Sched_Benchmark(u32 Ms);
+#endif
+
+#endif /* SCHEDULER_H */
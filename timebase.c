@@ -0,0 +1,200 @@
+/*****************************************************************************/
+/**
+* @file timebase.c
+*
+* Monotonic time base. See timebase.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "timebase.h"
+#include <stdio.h>
+
+#ifdef HOST_SIM
+#include <time.h>
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define CALIBRATION_READS	64
+#define BENCHMARK_RUNS		32
+
+/************************** Variable Definitions *****************************/
+
+static u32 OverheadTicks;	/* Cost of one now_ticks() call */
+
+#ifdef HOST_SIM
+static int SimClock;
+static u64 SimNow;
+#endif
+
+/*****************************************************************************/
+/**
+* Returns the current time in ticks of TIMEBASE_HZ.
+*
+******************************************************************************/
+u64 now_ticks(void)
+{
+#ifdef HOST_SIM
+	struct timespec Ts;
+
+	if (SimClock)
+		return SimNow;
+	clock_gettime(CLOCK_MONOTONIC, &Ts);
+	return (u64)Ts.tv_sec * TIMEBASE_HZ + (u64)Ts.tv_nsec;
+#else
+	XTime Now;
+
+	XTime_GetTime(&Now);
+	return Now;
+#endif
+}
+
+u64 us_to_ticks(u32 Us)
+{
+	return (u64)Us * TIMEBASE_HZ / 1000000;
+}
+
+u32 ticks_to_us(u64 Ticks)
+{
+	return (u32)(Ticks / TIMEBASE_TICKS_PER_US);
+}
+
+/*****************************************************************************/
+/**
+* Returns the tick count Us microseconds from now, for deadline_reached().
+*
+******************************************************************************/
+u64 deadline_after_us(u32 Us)
+{
+	return now_ticks() + us_to_ticks(Us);
+}
+
+/*****************************************************************************/
+/**
+* @return	TRUE once the time base has reached Deadline.
+*
+******************************************************************************/
+int deadline_reached(u64 Deadline)
+{
+	return now_ticks() >= Deadline;
+}
+
+/*****************************************************************************/
+/**
+* Busy-waits for at least Us microseconds. The measured cost of reading the
+* time base is taken off so short delays are not stretched by it.
+*
+******************************************************************************/
+void delay_us(u32 Us)
+{
+	u64 Start = now_ticks();
+	u64 Ticks = us_to_ticks(Us);
+
+#ifdef HOST_SIM
+	if (SimClock) {
+		SimNow += Ticks;
+		return;
+	}
+#endif
+	if (Ticks > OverheadTicks)
+		Ticks -= OverheadTicks;
+	while (now_ticks() - Start < Ticks)
+		;
+}
+
+/*****************************************************************************/
+/**
+* Self-calibration, run once at startup. Measures the cheapest back-to-back
+* now_ticks() pair, which delay_us() then compensates for.
+*
+******************************************************************************/
+void timebase_init(void)
+{
+	u64 Min = ~0ULL;
+	u64 A, B;
+	int i;
+
+	for (i = 0; i < CALIBRATION_READS; i++) {
+		A = now_ticks();
+		B = now_ticks();
+		if (B - A < Min)
+			Min = B - A;
+	}
+	OverheadTicks = (u32)Min;
+}
+
+u32 timebase_overhead_ticks(void)
+{
+	return OverheadTicks;
+}
+
+/*****************************************************************************/
+/**
+* Reports how far delay_us() strays from the requested delay, for the
+* delays the LCD driver uses. Errors are in nanoseconds, positive when the
+* delay ran long.
+*
+******************************************************************************/
+void timebase_benchmark(void)
+{
+	static const u32 Requested[] = { 1, 10, 37, 100, 1520, 4100, 10000 };
+	u64 Start, Elapsed;
+	s64 Err, MinErr, MaxErr, SumErr;
+	u32 i;
+	int Run;
+
+	printf("timebase: %llu Hz, now_ticks() overhead %u ticks\r\n",
+	       (unsigned long long)TIMEBASE_HZ, OverheadTicks);
+
+	for (i = 0; i < sizeof(Requested) / sizeof(Requested[0]); i++) {
+		MinErr = 0x7FFFFFFFFFFFFFFFLL;
+		MaxErr = -MinErr;
+		SumErr = 0;
+		for (Run = 0; Run < BENCHMARK_RUNS; Run++) {
+			Start = now_ticks();
+			delay_us(Requested[i]);
+			Elapsed = now_ticks() - Start;
+			Err = (s64)(Elapsed * 1000 / TIMEBASE_TICKS_PER_US)
+			      - (s64)Requested[i] * 1000;
+			if (Err < MinErr)
+				MinErr = Err;
+			if (Err > MaxErr)
+				MaxErr = Err;
+			SumErr += Err;
+		}
+		printf("timebase: delay_us(%5u) error min %+lld mean %+lld max %+lld ns\r\n",
+		       Requested[i], (long long)MinErr,
+		       (long long)(SumErr / BENCHMARK_RUNS), (long long)MaxErr);
+	}
+}
+
+#ifdef HOST_SIM
+/*****************************************************************************/
+/**
+* Switches now_ticks() between the host clock and a simulated clock that
+* starts at zero and only moves through timebase_sim_advance_us() and
+* delay_us().
+*
+******************************************************************************/
+void timebase_sim_clock(int Enable)
+{
+	SimClock = Enable;
+	SimNow = 0;
+}
+
+void timebase_sim_advance_us(u32 Us)
+{
+	SimNow += us_to_ticks(Us);
+}
+
+/*
+ * Moves the simulated clock forward to Ticks; it never goes back
+ */
+void timebase_sim_set(u64 Ticks)
+{
+	if (Ticks > SimNow)
+		SimNow = Ticks;
+}
+#endif /* HOST_SIM */
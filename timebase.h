@@ -0,0 +1,46 @@
+/*****************************************************************************/
+/**
+* @file timebase.h
+*
+* Monotonic time base, microsecond delays and deadline helpers.
+*
+* On the board the ticks are those of the Cortex-A9 global timer
+* (COUNTS_PER_SECOND, half the CPU clock), which keeps running regardless of
+* compiler flags, cache state or interrupts. On a HOST_SIM build they are
+* nanoseconds from clock_gettime(CLOCK_MONOTONIC), or a simulated clock that
+* only moves when told to, so simulations can run faster than real time.
+*
+******************************************************************************/
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include "platform.h"
+
+#ifdef HOST_SIM
+#define TIMEBASE_HZ		1000000000ULL
+#else
+#include "xtime_l.h"
+#define TIMEBASE_HZ		((u64)COUNTS_PER_SECOND)
+#endif
+
+#define TIMEBASE_TICKS_PER_US	(TIMEBASE_HZ / 1000000)
+
+/************************** Function Prototypes ******************************/
+
+void timebase_init(void);
+u64 now_ticks(void);
+u64 us_to_ticks(u32 Us);
+u32 ticks_to_us(u64 Ticks);
+u64 deadline_after_us(u32 Us);
+int deadline_reached(u64 Deadline);
+void delay_us(u32 Us);
+u32 timebase_overhead_ticks(void);
+void timebase_benchmark(void);
+
+#ifdef HOST_SIM
+void timebase_sim_clock(int Enable);
+void timebase_sim_advance_us(u32 Us);
+void timebase_sim_set(u64 Ticks);
+#endif
+
+#endif /* TIMEBASE_H */
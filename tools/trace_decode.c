@@ -0,0 +1,171 @@
+/*****************************************************************************/
+/**
+* @file trace_decode.c
+*
+* Turns a binary dump from Trace_Dump() into Chrome trace JSON, which
+* chrome://tracing and ui.perfetto.dev open.
+*
+* Build on the PC from the repository root:
+*	gcc -O2 -DHOST_SIM -I. -o trace_decode tools/trace_decode.c
+*
+* Usage:
+*	trace_decode dump.bin > trace.json
+*
+* The dump may be a raw UART capture; bytes before the "TRC1" header are
+* skipped. Interrupt handlers become duration slices, PWM values become
+* counter tracks and LCD writes and end-of-sequence events become instant
+* events. Stamps are unwrapped from 32 bits, so two records more than 2^31
+* counts apart (about 3 s at 667 MHz) come out too close together.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/************************** Constant Definitions *****************************/
+
+#define DECODE_PID		1
+#define DECODE_TID_ISR		1
+#define DECODE_TID_IO		2
+
+/************************** Variable Definitions *****************************/
+
+static const char *const PwmName[] = {
+	"buzzer_period", "buzzer_high", "motor_duty",
+};
+
+/*****************************************************************************/
+
+static u32 Decode_Word(const u8 *Bytes)
+{
+	return Bytes[0] | ((u32)Bytes[1] << 8) | ((u32)Bytes[2] << 16) |
+	       ((u32)Bytes[3] << 24);
+}
+
+/*
+ * Reads the whole file; a UART capture is small
+ */
+static u8 *Decode_Load(const char *Path, size_t *LenPtr)
+{
+	FILE *File = fopen(Path, "rb");
+	u8 *Buf = NULL;
+	size_t Len = 0, Size = 0, Got;
+
+	if (File == NULL)
+		return NULL;
+	do {
+		if (Len == Size) {
+			Size = Size ? Size * 2 : 65536;
+			Buf = realloc(Buf, Size);
+			if (Buf == NULL)
+				break;
+		}
+		Got = fread(Buf + Len, 1, Size - Len, File);
+		Len += Got;
+	} while (Got != 0);
+	fclose(File);
+	*LenPtr = Len;
+	return Buf;
+}
+
+static void Decode_Event(const u8 *RecBytes, double Us, int *FirstPtr)
+{
+	u32 Event = Decode_Word(RecBytes + 4) & 0xFFFF;
+	u32 Arg0 = Decode_Word(RecBytes + 8);
+	u32 Arg1 = Decode_Word(RecBytes + 12);
+
+	printf("%s\n{\"pid\":%d,\"ts\":%.3f,", *FirstPtr ? "" : ",", DECODE_PID,
+	       Us);
+	*FirstPtr = FALSE;
+	switch (Event) {
+	case TRACE_EV_ISR_ENTER:
+	case TRACE_EV_ISR_EXIT:
+		printf("\"tid\":%d,\"ph\":\"%s\",\"name\":\"irq %lu\"}",
+		       DECODE_TID_ISR, (Event == TRACE_EV_ISR_ENTER) ? "B" : "E",
+		       (unsigned long)Arg0);
+		break;
+	case TRACE_EV_LCD_WRITE:
+		printf("\"tid\":%d,\"ph\":\"i\",\"s\":\"t\",\"name\":\"lcd\","
+		       "\"args\":{\"data\":%lu,\"e\":%lu,\"rs\":%lu}}",
+		       DECODE_TID_IO, (unsigned long)(Arg0 >> 2),
+		       (unsigned long)((Arg0 >> 1) & 1),
+		       (unsigned long)(Arg0 & 1));
+		break;
+	case TRACE_EV_PWM_APPLY:
+		printf("\"ph\":\"C\",\"name\":\"%s\",\"args\":{\"counts\":%lu}}",
+		       (Arg0 < sizeof(PwmName) / sizeof(PwmName[0])) ?
+		       PwmName[Arg0] : "pwm", (unsigned long)Arg1);
+		break;
+	case TRACE_EV_ADC_EOS:
+		printf("\"tid\":%d,\"ph\":\"i\",\"s\":\"t\",\"name\":\"adc_eos\","
+		       "\"args\":{\"seq\":%lu}}", DECODE_TID_IO,
+		       (unsigned long)Arg0);
+		break;
+	default:
+		printf("\"tid\":%d,\"ph\":\"i\",\"s\":\"t\",\"name\":\"event %lu\","
+		       "\"args\":{\"arg0\":%lu,\"arg1\":%lu}}", DECODE_TID_IO,
+		       (unsigned long)Event, (unsigned long)Arg0,
+		       (unsigned long)Arg1);
+		break;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	u8 *Buf;
+	size_t Len, Offset;
+	u32 Hz, Count, Lost, i, Stamp, LastStamp = 0, Seq, Gaps = 0;
+	s64 Time = 0;
+	int First = TRUE;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s dump.bin > trace.json\n", argv[0]);
+		return 2;
+	}
+	Buf = Decode_Load(argv[1], &Len);
+	if (Buf == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	for (Offset = 0; Offset + sizeof(Trace_Header) <= Len; Offset++) {
+		if (Decode_Word(Buf + Offset) == TRACE_MAGIC)
+			break;
+	}
+	if (Offset + sizeof(Trace_Header) > Len) {
+		fprintf(stderr, "%s: no trace header\n", argv[1]);
+		return 1;
+	}
+	Hz = Decode_Word(Buf + Offset + 4);
+	Count = Decode_Word(Buf + Offset + 8);
+	Lost = Decode_Word(Buf + Offset + 12);
+	Offset += sizeof(Trace_Header);
+	if (Hz == 0 || (Len - Offset) / sizeof(Trace_Record) < Count) {
+		fprintf(stderr, "%s: dump is truncated\n", argv[1]);
+		if (Hz == 0)
+			return 1;
+		Count = (Len - Offset) / sizeof(Trace_Record);
+	}
+
+	printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	for (i = 0; i < Count; i++, Offset += sizeof(Trace_Record)) {
+		Stamp = Decode_Word(Buf + Offset);
+		Seq = Decode_Word(Buf + Offset + 4) >> 16;
+		if (i != 0) {
+			Time += (s32)(Stamp - LastStamp);
+			if (Seq != ((Lost + i) & 0xFFFF))
+				Gaps++;
+		}
+		LastStamp = Stamp;
+		Decode_Event(Buf + Offset, (double)Time * 1e6 / Hz, &First);
+	}
+	printf("\n]}\n");
+
+	fprintf(stderr, "%lu records, %lu overwritten before the dump, "
+		"%lu out of sequence\n", (unsigned long)Count,
+		(unsigned long)Lost, (unsigned long)Gaps);
+	free(Buf);
+	return 0;
+}
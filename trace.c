@@ -0,0 +1,165 @@
+/*****************************************************************************/
+/**
+* @file trace.c
+*
+* Binary event trace. See trace.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "trace.h"
+
+#ifdef HOST_SIM
+#include "hw_sim.h"
+#include <stdio.h>
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#ifdef HOST_SIM
+#define TRACE_BENCH_WRITES	1000000
+#define TRACE_BENCH_SIM_MS	110
+#define TRACE_BENCH_DUMP_BYTES	(sizeof(Trace_Header) + \
+				 TRACE_LEN * sizeof(Trace_Record))
+#endif
+
+/************************** Variable Definitions *****************************/
+
+Trace_Record Trace_Ring[TRACE_LEN];
+volatile u32 Trace_Next;
+volatile u32 Trace_Enabled;
+
+#ifdef HOST_SIM
+static u8 DumpBuf[TRACE_BENCH_DUMP_BYTES];
+static u32 DumpLen;
+#endif
+
+/*****************************************************************************/
+/**
+* Empties the ring and starts tracing.
+*
+******************************************************************************/
+void Trace_Init(void)
+{
+	Trace_Enabled = FALSE;
+	MEMORY_BARRIER();
+	Trace_Next = 0;
+	Trace_Enabled = TRUE;
+}
+
+static void Trace_PutWord(Trace_PutFn Put, u32 Word)
+{
+	Put((u8)Word);
+	Put((u8)(Word >> 8));
+	Put((u8)(Word >> 16));
+	Put((u8)(Word >> 24));
+}
+
+/*****************************************************************************/
+/**
+* Sends the ring through Put, oldest record first, and restarts it.
+*
+* Tracing is off while the dump runs so the records are not overwritten
+* under it; events in that time are not recorded. A handler that claimed a
+* slot just before may still be filling it, which the decoder sees as a
+* record whose Seq does not follow.
+*
+******************************************************************************/
+void Trace_Dump(Trace_PutFn Put)
+{
+	const Trace_Record *RecPtr;
+	u32 Next, Count, i;
+
+	Trace_Enabled = FALSE;
+	MEMORY_BARRIER();
+	Next = Trace_Next;
+	Count = (Next < TRACE_LEN) ? Next : TRACE_LEN;
+
+	Trace_PutWord(Put, TRACE_MAGIC);
+	Trace_PutWord(Put, (u32)BENCH_HZ);
+	Trace_PutWord(Put, Count);
+	Trace_PutWord(Put, Next - Count);
+	for (i = Next - Count; i != Next; i++) {
+		RecPtr = &Trace_Ring[i & (TRACE_LEN - 1)];
+		Trace_PutWord(Put, RecPtr->Stamp);
+		Trace_PutWord(Put, RecPtr->Event | ((u32)RecPtr->Seq << 16));
+		Trace_PutWord(Put, RecPtr->Arg0);
+		Trace_PutWord(Put, RecPtr->Arg1);
+	}
+	Trace_Init();
+}
+
+#ifdef HOST_SIM
+static void Trace_BufPut(u8 Byte)
+{
+	if (DumpLen < sizeof(DumpBuf))
+		DumpBuf[DumpLen++] = Byte;
+}
+
+static u32 Trace_BufWord(u32 Offset)
+{
+	return DumpBuf[Offset] | ((u32)DumpBuf[Offset + 1] << 8) |
+	       ((u32)DumpBuf[Offset + 2] << 16) |
+	       ((u32)DumpBuf[Offset + 3] << 24);
+}
+
+/*****************************************************************************/
+/**
+* Host benchmark. Times TRACE_BENCH_WRITES trace points, then dumps the
+* wrapped ring to memory and checks that the header is right and the
+* records come out oldest first with their arguments intact. With a Path,
+* it then traces a short HwSim_Benchmark() run and writes that dump there
+* for tools/trace_decode.
+*
+******************************************************************************/
+void Trace_Benchmark(const char *Path)
+{
+	u32 Start, Cycles, i, Offset, Expect, Word;
+	u32 Fail = 0;
+	FILE *File;
+
+	Bench_Init();
+	Trace_Init();
+	Start = Bench_Cycles();
+	for (i = 0; i < TRACE_BENCH_WRITES; i++)
+		Trace_Write(TRACE_EV_PWM_APPLY, TRACE_PWM_MOTOR, i);
+	Cycles = Bench_Cycles() - Start;
+	printf("trace: %u records, %.1f ns per record\n",
+	       TRACE_BENCH_WRITES, (double)Cycles / TRACE_BENCH_WRITES);
+
+	DumpLen = 0;
+	Trace_Dump(Trace_BufPut);
+	if (DumpLen != TRACE_BENCH_DUMP_BYTES)
+		Fail |= 1;
+	if (Trace_BufWord(0) != TRACE_MAGIC ||
+	    Trace_BufWord(8) != TRACE_LEN ||
+	    Trace_BufWord(12) != TRACE_BENCH_WRITES - TRACE_LEN)
+		Fail |= 2;
+	Expect = TRACE_BENCH_WRITES - TRACE_LEN;
+	for (Offset = sizeof(Trace_Header); Offset < DumpLen;
+	     Offset += sizeof(Trace_Record), Expect++) {
+		Word = Trace_BufWord(Offset + 4);
+		if ((Word & 0xFFFF) != TRACE_EV_PWM_APPLY ||
+		    (Word >> 16) != (Expect & 0xFFFF) ||
+		    Trace_BufWord(Offset + 12) != Expect)
+			Fail |= 4;
+	}
+	if (Trace_Next != 0 || !Trace_Enabled)
+		Fail |= 8;
+
+	if (Path != NULL) {
+		HwSim_Benchmark(TRACE_BENCH_SIM_MS);
+		DumpLen = 0;
+		Trace_Dump(Trace_BufPut);
+		File = fopen(Path, "wb");
+		if (File == NULL) {
+			Fail |= 0x10;
+		} else {
+			fwrite(DumpBuf, 1, DumpLen, File);
+			fclose(File);
+		}
+	}
+	printf("trace: checks %s (0x%x)\n", Fail ? "FAIL" : "ok", Fail);
+}
+#endif /* HOST_SIM */
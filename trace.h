@@ -0,0 +1,149 @@
+/*****************************************************************************/
+/**
+* @file trace.h
+*
+* Binary event trace in a RAM ring.
+*
+* A trace point stores one fixed-size record (cycle stamp, event ID and two
+* argument words) at the next slot of a ring and does no formatting, so it
+* is cheap enough for interrupt handlers. The ring keeps the newest
+* TRACE_LEN records. Trace_Dump() streams a header and the records, oldest
+* first, as raw bytes; tools/trace_decode.c turns a dump into Chrome trace
+* JSON (chrome://tracing, Perfetto).
+*
+* Each trace point belongs to a category. Only the categories set in
+* TRACE_CATEGORIES at compile time generate code; the others expand to
+* nothing.
+*
+* Stamps are Bench_Cycles(), so Bench_Init() must have run.
+*
+******************************************************************************/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "platform.h"
+#include "bench.h"
+
+/************************** Constant Definitions *****************************/
+
+#define TRACE_LEN		1024	/* Records in the ring, power of two */
+
+/*
+ * Categories, for TRACE_CATEGORIES
+ */
+#define TRACE_CAT_ISR		0x01	/* Interrupt handler enter and exit */
+#define TRACE_CAT_LCD		0x02	/* LCD register writes */
+#define TRACE_CAT_PWM		0x04	/* PWM values applied to the hardware */
+#define TRACE_CAT_ADC		0x08	/* XADC end of sequence */
+
+#ifndef TRACE_CATEGORIES
+#define TRACE_CATEGORIES	(TRACE_CAT_ISR | TRACE_CAT_LCD | \
+				 TRACE_CAT_PWM | TRACE_CAT_ADC)
+#endif
+
+/*
+ * Event IDs
+ */
+#define TRACE_EV_ISR_ENTER	1	/* Arg0: interrupt ID */
+#define TRACE_EV_ISR_EXIT	2	/* Arg0: interrupt ID */
+#define TRACE_EV_LCD_WRITE	3	/* Arg0: lcd_out value */
+#define TRACE_EV_PWM_APPLY	4	/* Arg0: TRACE_PWM_*, Arg1: value */
+#define TRACE_EV_ADC_EOS	5	/* Arg0: frame sequence number */
+
+#define TRACE_PWM_BUZZER_PERIOD	0	/* AXI timer period, counts */
+#define TRACE_PWM_BUZZER_HIGH	1	/* AXI timer high time, counts */
+#define TRACE_PWM_MOTOR		2	/* Custom_PWM duty, counts */
+
+/*
+ * Dump layout: a Trace_Header, then Count records of 16 bytes, oldest
+ * first, all little-endian
+ */
+#define TRACE_MAGIC		0x31435254	/* "TRC1" */
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Stamp;		/* Bench_Cycles() */
+	u16 Event;
+	u16 Seq;		/* Low bits of the record number */
+	u32 Arg0;
+	u32 Arg1;
+} Trace_Record;
+
+typedef struct {
+	u32 Magic;
+	u32 Hz;			/* Stamp rate */
+	u32 Count;		/* Records that follow */
+	u32 Lost;		/* Older records overwritten by the ring */
+} Trace_Header;
+
+/*
+ * Sends one byte of a dump, e.g. outbyte() to the UART
+ */
+typedef void (*Trace_PutFn)(u8 Byte);
+
+/************************** Variable Definitions *****************************/
+
+extern Trace_Record Trace_Ring[TRACE_LEN];
+extern volatile u32 Trace_Next;		/* Records ever written */
+extern volatile u32 Trace_Enabled;
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*
+ * Claims a slot with an atomic increment, so handlers and the main loop
+ * can trace at the same time, and fills it
+ */
+static inline void Trace_Write(u16 Event, u32 Arg0, u32 Arg1)
+{
+	Trace_Record *RecPtr;
+	u32 Index;
+
+	if (!Trace_Enabled)
+		return;
+	Index = __atomic_fetch_add(&Trace_Next, 1, __ATOMIC_RELAXED);
+	RecPtr = &Trace_Ring[Index & (TRACE_LEN - 1)];
+	RecPtr->Stamp = Bench_Cycles();
+	RecPtr->Event = Event;
+	RecPtr->Seq = (u16)Index;
+	RecPtr->Arg0 = Arg0;
+	RecPtr->Arg1 = Arg1;
+}
+
+#if TRACE_CATEGORIES & TRACE_CAT_ISR
+#define TRACE_ISR_ENTER(Irq)	Trace_Write(TRACE_EV_ISR_ENTER, (Irq), 0)
+#define TRACE_ISR_EXIT(Irq)	Trace_Write(TRACE_EV_ISR_EXIT, (Irq), 0)
+#else
+#define TRACE_ISR_ENTER(Irq)	do { } while (0)
+#define TRACE_ISR_EXIT(Irq)	do { } while (0)
+#endif
+
+#if TRACE_CATEGORIES & TRACE_CAT_LCD
+#define TRACE_LCD_WRITE(Value)	Trace_Write(TRACE_EV_LCD_WRITE, (Value), 0)
+#else
+#define TRACE_LCD_WRITE(Value)	do { } while (0)
+#endif
+
+#if TRACE_CATEGORIES & TRACE_CAT_PWM
+#define TRACE_PWM_APPLY(Which, Value) \
+	Trace_Write(TRACE_EV_PWM_APPLY, (Which), (Value))
+#else
+#define TRACE_PWM_APPLY(Which, Value)	do { } while (0)
+#endif
+
+#if TRACE_CATEGORIES & TRACE_CAT_ADC
+#define TRACE_ADC_EOS(Seq)	Trace_Write(TRACE_EV_ADC_EOS, (Seq), 0)
+#else
+#define TRACE_ADC_EOS(Seq)	do { } while (0)
+#endif
+
+/************************** Function Prototypes ******************************/
+
+void Trace_Init(void);
+void Trace_Dump(Trace_PutFn Put);
+
+#ifdef HOST_SIM
+void Trace_Benchmark(const char *Path);
+#endif
+
+#endif /* TRACE_H */
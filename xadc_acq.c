@@ -0,0 +1,430 @@
+/*****************************************************************************/
+/**
+* @file xadc_acq.c
+*
+* XADC sample acquisition. See xadc_acq.h.
+*
+* Each of the two frame buffers carries its own sequence number, which the
+* writer clears before it touches the samples and sets once they are
+* complete. A reader that finds the number changed or cleared after copying
+* the frame knows the handler rewrote it underneath and reads again, so no
+* lock is needed between the handler and the main loop.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xadc_acq.h"
+#include "timebase.h"
+#include "trace.h"
+#include "intr.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#ifdef HOST_SIM
+#define XSM_SR_EOS_MASK		HWSIM_XADC_SR_EOS
+#define XSM_IPIXR_EOS_MASK	0x10
+
+#define XADC_ACQ_BENCH_MS	200	/* Length of each benchmark run */
+#define XADC_ACQ_BENCH_READ_US	1000	/* Main loop read interval */
+#endif
+
+#ifdef HOST_SIM
+/*
+ * Simulated XSysMon, see HwSim_XadcUpdate() and HwSim_XadcData()
+ */
+static u32 XSysMon_GetStatus(XSysMon *XadcPtr)
+{
+	u32 Status;
+
+	HwSim_XadcUpdate(XadcPtr);
+	Status = XadcPtr->Status;
+	XadcPtr->Status = 0;
+	return Status;
+}
+
+static u16 XSysMon_GetAdcData(XSysMon *XadcPtr, u8 Channel)
+{
+	return HwSim_XadcData(Channel, XadcPtr->Sequences);
+}
+
+static u32 XSysMon_IntrGetStatus(XSysMon *XadcPtr)
+{
+	return (XadcPtr->Status & XSM_SR_EOS_MASK) ? XSM_IPIXR_EOS_MASK : 0;
+}
+
+static void XSysMon_IntrClear(XSysMon *XadcPtr, u32 Mask)
+{
+	if (Mask & XSM_IPIXR_EOS_MASK)
+		XadcPtr->Status &= ~XSM_SR_EOS_MASK;
+}
+#endif /* HOST_SIM */
+
+/*****************************************************************************/
+/**
+* Reads the enabled channels into the back buffer and makes it the front.
+*
+******************************************************************************/
+static void XadcAcq_Capture(XadcAcq *AcqPtr, u64 Stamp)
+{
+	u32 Back = AcqPtr->Front ^ 1;
+	XadcAcq_Frame *FramePtr = &AcqPtr->Buf[Back];
+	u32 Seq = AcqPtr->Seq + 1;
+	u32 Channel;
+
+	FramePtr->Seq = 0;
+	MEMORY_BARRIER();
+	for (Channel = 0; Channel < XADC_ACQ_CHANNELS; Channel++) {
+		if (AcqPtr->Mask & (1U << Channel))
+			FramePtr->Data[Channel] =
+				XSysMon_GetAdcData(AcqPtr->XadcPtr, Channel);
+	}
+	FramePtr->Stamp = Stamp;
+	MEMORY_BARRIER();
+	FramePtr->Seq = Seq;
+	MEMORY_BARRIER();
+	AcqPtr->Front = Back;
+	AcqPtr->Seq = Seq;
+	AcqPtr->Stats.Frames++;
+	TRACE_ADC_EOS(Seq);
+
+	if (AcqPtr->Callback != NULL)
+		AcqPtr->Callback(AcqPtr, Seq);
+}
+
+/*****************************************************************************/
+/**
+* Initializes an acquisition. The XADC must already be configured and its
+* sequencer running (Xadc_Init).
+*
+* @param	AcqPtr is the acquisition.
+* @param	XadcPtr is the XSysMon instance.
+* @param	ChannelMask has a bit set for each channel to capture.
+* @param	Mode is XADC_ACQ_MODE_POLL or XADC_ACQ_MODE_INTR.
+*
+******************************************************************************/
+void XadcAcq_Init(XadcAcq *AcqPtr, XSysMon *XadcPtr, u32 ChannelMask,
+		  u32 Mode)
+{
+	*AcqPtr = (XadcAcq){0};
+	AcqPtr->XadcPtr = XadcPtr;
+	AcqPtr->Mask = ChannelMask;
+	AcqPtr->Mode = Mode;
+}
+
+/*****************************************************************************/
+/**
+* Sets the function the handler calls after publishing each frame.
+*
+* @param	AcqPtr is the acquisition.
+* @param	Callback is the function, or NULL for none. It runs in interrupt
+*		context in interrupt mode.
+*
+******************************************************************************/
+void XadcAcq_SetCallback(XadcAcq *AcqPtr, XadcAcq_Callback Callback)
+{
+	AcqPtr->Callback = Callback;
+}
+
+/*****************************************************************************/
+/**
+* Sets the function the handler calls for interrupts other than end of
+* sequence. The caller enables those interrupts in the XSysMon itself.
+*
+* @param	AcqPtr is the acquisition.
+* @param	Callback is the function, or NULL for none. It runs in interrupt
+*		context.
+* @param	CallBackRef is stored in AcqPtr->AlarmRef for the callback.
+*
+******************************************************************************/
+void XadcAcq_SetAlarmCallback(XadcAcq *AcqPtr, XadcAcq_AlarmCallback Callback,
+			      void *CallBackRef)
+{
+	AcqPtr->AlarmCallback = Callback;
+	AcqPtr->AlarmRef = CallBackRef;
+}
+
+/*****************************************************************************/
+/**
+* Connects the XSysMon interrupt through the interrupt manager, in the
+* acquisition tier, and enables the end of sequence interrupt.
+*
+* @param	AcqPtr is an acquisition in XADC_ACQ_MODE_INTR.
+* @param	IntcPtr is the GIC driver instance, passed to Intr_Init().
+* @param	IntrId is the XADC interrupt ID, e.g.
+*		XPAR_FABRIC_XADC_WIZ_0_IP2INTC_IRPT_INTR.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the acquisition is in polling
+*		mode or the handler could not be connected.
+*
+******************************************************************************/
+int XadcAcq_SetupIntr(XadcAcq *AcqPtr, XScuGic *IntcPtr, u16 IntrId)
+{
+	if (AcqPtr->Mode != XADC_ACQ_MODE_INTR)
+		return XST_FAILURE;
+	AcqPtr->IntrId = IntrId;
+
+#ifdef HOST_SIM
+	/* Without a GIC the caller delivers the interrupt itself */
+	if (IntcPtr != NULL) {
+		if (Intr_Init(IntcPtr) != XST_SUCCESS ||
+		    Intr_Connect(IntrId, INTR_TIER_ACQUISITION,
+				 INTR_TRIGGER_KEEP, XadcAcq_IntrHandler,
+				 AcqPtr) != XST_SUCCESS)
+			return XST_FAILURE;
+		HwSim_XadcAttach(AcqPtr->XadcPtr, IntrId);
+	}
+	AcqPtr->XadcPtr->IntrEnabled = TRUE;
+#else
+	if (Intr_Init(IntcPtr) != XST_SUCCESS ||
+	    Intr_Connect(IntrId, INTR_TIER_ACQUISITION, INTR_TRIGGER_KEEP,
+			 XadcAcq_IntrHandler, AcqPtr) != XST_SUCCESS)
+		return XST_FAILURE;
+
+	XSysMon_IntrClear(AcqPtr->XadcPtr, XSysMon_IntrGetStatus(AcqPtr->XadcPtr));
+	XSysMon_IntrEnable(AcqPtr->XadcPtr, XSM_IPIXR_EOS_MASK);
+	XSysMon_IntrGlobalEnable(AcqPtr->XadcPtr);
+#endif
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* XSysMon interrupt handler. Acknowledges the interrupt and, on end of
+* sequence, captures and publishes a frame. Any other pending interrupt is
+* passed to the alarm callback.
+*
+* @param	CallBackRef is the acquisition.
+*
+******************************************************************************/
+void XadcAcq_IntrHandler(void *CallBackRef)
+{
+	XadcAcq *AcqPtr = (XadcAcq *)CallBackRef;
+	u64 Start = now_ticks();
+	u32 Status;
+
+	TRACE_ISR_ENTER(AcqPtr->IntrId);
+	Status = XSysMon_IntrGetStatus(AcqPtr->XadcPtr);
+	XSysMon_IntrClear(AcqPtr->XadcPtr, Status);
+	if (Status & XSM_IPIXR_EOS_MASK)
+		XadcAcq_Capture(AcqPtr, Start);
+	if ((Status & ~XSM_IPIXR_EOS_MASK) != 0 && AcqPtr->AlarmCallback != NULL)
+		AcqPtr->AlarmCallback(AcqPtr, Status & ~XSM_IPIXR_EOS_MASK);
+
+	AcqPtr->Stats.IsrCount++;
+	AcqPtr->Stats.IsrTicks += now_ticks() - Start;
+	TRACE_ISR_EXIT(AcqPtr->IntrId);
+}
+
+/*****************************************************************************/
+/**
+* Polling mode acquisition: waits for the end of the next conversion
+* sequence, then captures and publishes a frame.
+*
+* @param	AcqPtr is an acquisition in XADC_ACQ_MODE_POLL.
+*
+* @return	XST_SUCCESS, or XST_FAILURE in interrupt mode.
+*
+* @note		This busy-waits for up to a whole sequence.
+*
+******************************************************************************/
+int XadcAcq_Poll(XadcAcq *AcqPtr)
+{
+	u64 Start;
+
+	if (AcqPtr->Mode != XADC_ACQ_MODE_POLL)
+		return XST_FAILURE;
+
+	Start = now_ticks();
+	/* Clear the status, then wait for the end of a whole sequence */
+	XSysMon_GetStatus(AcqPtr->XadcPtr);
+	while ((XSysMon_GetStatus(AcqPtr->XadcPtr) & XSM_SR_EOS_MASK) !=
+	       XSM_SR_EOS_MASK)
+		;
+	XadcAcq_Capture(AcqPtr, now_ticks());
+	AcqPtr->Stats.PollTicks += now_ticks() - Start;
+
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* Copies the newest frame.
+*
+* @param	AcqPtr is the acquisition.
+* @param	FramePtr receives the frame.
+*
+* @return	Sequence number of the frame, or 0 if none has been captured.
+*
+* @note		Safe to call from the main loop while the handler publishes.
+*
+******************************************************************************/
+u32 XadcAcq_Read(XadcAcq *AcqPtr, XadcAcq_Frame *FramePtr)
+{
+	const XadcAcq_Frame *SrcPtr;
+	u32 Seq;
+
+	for (;;) {
+		if (AcqPtr->Seq == 0)
+			return 0;
+		MEMORY_BARRIER();
+		SrcPtr = &AcqPtr->Buf[AcqPtr->Front];
+		Seq = SrcPtr->Seq;
+		MEMORY_BARRIER();
+		*FramePtr = *SrcPtr;
+		MEMORY_BARRIER();
+		if (Seq != 0 && SrcPtr->Seq == Seq)
+			return Seq;
+		AcqPtr->Stats.Retries++;
+	}
+}
+
+/*****************************************************************************/
+/**
+* @return	Frames published between two reads that returned LastSeq and
+*		Seq and were never read.
+*
+******************************************************************************/
+u32 XadcAcq_Lost(u32 LastSeq, u32 Seq)
+{
+	if (LastSeq == 0 || Seq - LastSeq <= 1)
+		return 0;
+	return Seq - LastSeq - 1;
+}
+
+/*****************************************************************************/
+/**
+* Returns a snapshot of the acquisition counters.
+*
+******************************************************************************/
+void XadcAcq_GetStats(const XadcAcq *AcqPtr, XadcAcq_Stats *StatsPtr)
+{
+	*StatsPtr = AcqPtr->Stats;
+}
+
+#ifdef HOST_SIM
+/*****************************************************************************/
+/**
+* Sets how many conversion sequences the simulated XADC completes per
+* second, starting now.
+*
+******************************************************************************/
+void XadcAcq_SimSetRate(XSysMon *XadcPtr, u32 SequencesPerSec)
+{
+	*XadcPtr = (XSysMon){0};
+	XadcPtr->PeriodTicks = TIMEBASE_HZ / SequencesPerSec;
+	XadcPtr->NextEos = now_ticks() + XadcPtr->PeriodTicks;
+}
+
+static XadcAcq *BenchAcq;
+static volatile int BenchStop;
+
+/*
+ * Stands in for the GIC: sleeps until the next end of sequence, then runs
+ * the handler
+ */
+static void *XadcAcq_BenchIrq(void *Arg)
+{
+	XSysMon *XadcPtr = BenchAcq->XadcPtr;
+	struct timespec Ts;
+	u64 Now;
+
+	(void)Arg;
+	while (!BenchStop) {
+		Now = now_ticks();
+		if (Now < XadcPtr->NextEos) {
+			Ts.tv_sec = 0;
+			Ts.tv_nsec = (long)(XadcPtr->NextEos - Now);
+			nanosleep(&Ts, NULL);
+		}
+		HwSim_XadcUpdate(XadcPtr);
+		if (XadcPtr->IntrEnabled && (XadcPtr->Status & XSM_SR_EOS_MASK))
+			XadcAcq_IntrHandler(BenchAcq);
+	}
+	return NULL;
+}
+
+static void XadcAcq_BenchReport(const char *Name, const XadcAcq *AcqPtr,
+				u64 Elapsed, u64 CpuTicks)
+{
+	printf("xadc_acq: %-4s %u sequences, %u frames, %.0f samples/s, "
+	       "%.0f ns CPU per sample, %.1f %% CPU\n", Name,
+	       AcqPtr->XadcPtr->Sequences, AcqPtr->Stats.Frames,
+	       (double)AcqPtr->Stats.Frames * TIMEBASE_HZ / Elapsed,
+	       AcqPtr->Stats.Frames ?
+	       (double)CpuTicks / AcqPtr->Stats.Frames : 0.0,
+	       100.0 * CpuTicks / Elapsed);
+}
+
+/*****************************************************************************/
+/**
+* Host benchmark. Runs the simulated XADC at SequencesPerSec for
+* XADC_ACQ_BENCH_MS in polling mode and then in interrupt mode, and prints
+* samples per second and the CPU time per sample of each. In interrupt mode
+* a main loop reads a frame every XADC_ACQ_BENCH_READ_US and checks that
+* the frames it read plus the frames it detected as missed add up to those
+* published.
+*
+* @note		The host wakes the simulated interrupt with nanosleep(), so at
+*		high rates some sequences end before the handler runs; the
+*		first line shows those as sequences without frames.
+*
+******************************************************************************/
+void XadcAcq_Benchmark(u32 SequencesPerSec)
+{
+	static XSysMon Xadc;
+	static XadcAcq Acq;
+	XadcAcq_Frame Frame;
+	pthread_t Irq;
+	struct timespec Ts;
+	u64 Start, Elapsed, End;
+	u32 Seq, LastSeq = 0, FirstSeq = 0, Reads = 0, Lost = 0;
+
+	/* Polling: the main loop waits out every sequence */
+	XadcAcq_SimSetRate(&Xadc, SequencesPerSec);
+	XadcAcq_Init(&Acq, &Xadc, 0x00020000, XADC_ACQ_MODE_POLL);
+	Start = now_ticks();
+	End = Start + us_to_ticks(XADC_ACQ_BENCH_MS * 1000);
+	while (now_ticks() < End)
+		XadcAcq_Poll(&Acq);
+	Elapsed = now_ticks() - Start;
+	XadcAcq_BenchReport("poll", &Acq, Elapsed, Acq.Stats.PollTicks);
+
+	/* Interrupt: the main loop sleeps and picks up the newest frame */
+	XadcAcq_SimSetRate(&Xadc, SequencesPerSec);
+	XadcAcq_Init(&Acq, &Xadc, 0x00020000, XADC_ACQ_MODE_INTR);
+	XadcAcq_SetupIntr(&Acq, NULL, 0);
+	BenchAcq = &Acq;
+	BenchStop = FALSE;
+	pthread_create(&Irq, NULL, XadcAcq_BenchIrq, NULL);
+	Start = now_ticks();
+	End = Start + us_to_ticks(XADC_ACQ_BENCH_MS * 1000);
+	while (now_ticks() < End) {
+		Ts.tv_sec = 0;
+		Ts.tv_nsec = XADC_ACQ_BENCH_READ_US * 1000;
+		nanosleep(&Ts, NULL);
+		Seq = XadcAcq_Read(&Acq, &Frame);
+		if (Seq == 0 || Seq == LastSeq)
+			continue;
+		if (FirstSeq == 0)
+			FirstSeq = Seq;
+		Lost += XadcAcq_Lost(LastSeq, Seq);
+		LastSeq = Seq;
+		Reads++;
+	}
+	BenchStop = TRUE;
+	pthread_join(Irq, NULL);
+	Elapsed = now_ticks() - Start;
+	XadcAcq_BenchReport("intr", &Acq, Elapsed, Acq.Stats.IsrTicks);
+
+	printf("xadc_acq: intr main loop read %u frames, detected %u missed, "
+	       "%u retries (%s)\n", Reads, Lost, Acq.Stats.Retries,
+	       (Reads + Lost == LastSeq - FirstSeq + 1) ? "ok" : "FAIL");
+}
+#endif /* HOST_SIM */
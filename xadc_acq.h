@@ -0,0 +1,104 @@
+/*****************************************************************************/
+/**
+* @file xadc_acq.h
+*
+* XADC sample acquisition, interrupt driven or polled.
+*
+* In interrupt mode the XSysMon end-of-sequence interrupt is routed through
+* the GIC. The handler copies the enabled channels into the back buffer of a
+* double-buffered frame, stamps it with a sequence number and publishes it,
+* and the CPU does nothing while the sequencer converts. In polling mode
+* XadcAcq_Poll() waits for the end of the next sequence the way
+* Xadc_ReadData() always did.
+*
+* Consumers read the newest frame with XadcAcq_Read(). The sequence number
+* increases by one per sequence, so a consumer that finds it has moved by
+* more than one since its last read knows how many frames it missed.
+*
+* On a HOST_SIM build XSysMon is the simulated sequencer of hw_sim.h, which
+* completes a sequence at a configurable rate; see XadcAcq_SimSetRate().
+*
+******************************************************************************/
+#ifndef XADC_ACQ_H
+#define XADC_ACQ_H
+
+#include "platform.h"
+
+#ifdef HOST_SIM
+#include "hw_sim.h"
+#else
+#include "xsysmon.h"
+#include "xscugic.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define XADC_ACQ_CHANNELS	32	/* XSysMon channel numbers 0 to 31 */
+
+#define XADC_ACQ_MODE_POLL	0
+#define XADC_ACQ_MODE_INTR	1
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u32 Seq;		/* Sequence number, 1 for the first frame */
+	u64 Stamp;		/* now_ticks() at the end of the sequence */
+	u16 Data[XADC_ACQ_CHANNELS];	/* Codes of the channels in Mask */
+} XadcAcq_Frame;
+
+typedef struct {
+	u32 Frames;		/* Frames published */
+	u32 Retries;		/* Reads repeated because a frame changed */
+	u32 IsrCount;
+	u64 IsrTicks;		/* Time spent in the handler */
+	u64 PollTicks;		/* Time spent waiting in XadcAcq_Poll() */
+} XadcAcq_Stats;
+
+struct XadcAcq;
+
+/*
+ * Called from the handler after a frame is published, e.g. to post an
+ * event for the main loop
+ */
+typedef void (*XadcAcq_Callback)(struct XadcAcq *AcqPtr, u32 Seq);
+
+/*
+ * Called from the handler with the interrupt status when an XSysMon
+ * interrupt other than end of sequence is pending, e.g. an alarm
+ */
+typedef void (*XadcAcq_AlarmCallback)(struct XadcAcq *AcqPtr, u32 Status);
+
+typedef struct XadcAcq {
+	XSysMon *XadcPtr;
+	u32 Mask;		/* Channels copied into each frame */
+	u32 Mode;
+	XadcAcq_Frame Buf[2];
+	volatile u32 Front;	/* Buffer holding the newest frame */
+	volatile u32 Seq;	/* Seq of the newest frame, 0 before the first */
+	XadcAcq_Callback Callback;
+	XadcAcq_AlarmCallback AlarmCallback;
+	void *AlarmRef;		/* For the alarm callback */
+	u16 IntrId;		/* Set by XadcAcq_SetupIntr(), for the trace */
+	XadcAcq_Stats Stats;
+} XadcAcq;
+
+/************************** Function Prototypes ******************************/
+
+void XadcAcq_Init(XadcAcq *AcqPtr, XSysMon *XadcPtr, u32 ChannelMask,
+		  u32 Mode);
+void XadcAcq_SetCallback(XadcAcq *AcqPtr, XadcAcq_Callback Callback);
+void XadcAcq_SetAlarmCallback(XadcAcq *AcqPtr, XadcAcq_AlarmCallback Callback,
+			      void *CallBackRef);
+int XadcAcq_SetupIntr(XadcAcq *AcqPtr, XScuGic *IntcPtr, u16 IntrId);
+void XadcAcq_IntrHandler(void *CallBackRef);
+int XadcAcq_Poll(XadcAcq *AcqPtr);
+u32 XadcAcq_Read(XadcAcq *AcqPtr, XadcAcq_Frame *FramePtr);
+u32 XadcAcq_Lost(u32 LastSeq, u32 Seq);
+void XadcAcq_GetStats(const XadcAcq *AcqPtr, XadcAcq_Stats *StatsPtr);
+
+#ifdef HOST_SIM
+void XadcAcq_SimSetRate(XSysMon *XadcPtr, u32 SequencesPerSec);
+void XadcAcq_Benchmark(u32 SequencesPerSec);
+#endif
+
+#endif /* XADC_ACQ_H */
@@ -0,0 +1,478 @@
+/*****************************************************************************/
+/**
+* @file xadc_band.c
+*
+* XADC threshold band engine. See xadc_band.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xadc_band.h"
+#include "xadc_chan.h"
+#include "timebase.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include <string.h>
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#ifdef HOST_SIM
+#define XSM_IPIXR_TEMP_MASK		0x00000002
+#define XSM_IPIXR_TEMP_DEACTIVE_MASK	0x00000200
+#define XSM_SEQ_CH_TEMP			0x00000100
+
+#define XADC_BAND_BENCH_PERIOD	1000	/* Frames per waveform period */
+#define XADC_BAND_BENCH_CYCLES	100
+#define XADC_BAND_BENCH_FRAME_HZ 3000	/* For the events per second */
+#define XADC_BAND_BENCH_POLL_US	10	/* Main loop polling interval */
+#endif
+
+/*
+ * Queues a crossing for the main loop
+ */
+static void XadcBand_Emit(XadcBand_Engine *EnginePtr, u32 Id, u32 Enter,
+			  u16 Code, u64 Stamp)
+{
+	XadcBand *BandPtr = &EnginePtr->Band[Id];
+	Event Ev;
+
+	BandPtr->Inside = Enter;
+	BandPtr->Crossings++;
+
+	Ev.Stamp = Stamp;
+	Ev.Type = (u16)Id;
+	Ev.Reserved = 0;
+	Ev.Arg = (Enter << 16) | Code;
+	Event_Push(&EnginePtr->Events, &Ev);
+}
+
+/*****************************************************************************/
+/**
+* Initializes an engine with no bands.
+*
+* @param	EnginePtr is the engine.
+* @param	XadcPtr is the XSysMon instance whose alarms it may program.
+*
+******************************************************************************/
+void XadcBand_Init(XadcBand_Engine *EnginePtr, XSysMon *XadcPtr)
+{
+	*EnginePtr = (XadcBand_Engine){0};
+	EnginePtr->XadcPtr = XadcPtr;
+	EnginePtr->HwBand = XADC_BAND_MAX;
+	Event_QueueInit(&EnginePtr->Events);
+}
+
+/*****************************************************************************/
+/**
+* Registers a band. Call before XadcBand_Arm().
+*
+* @param	EnginePtr is the engine.
+* @param	Name is reported with the band's events.
+* @param	Channel is the XSysMon channel number.
+* @param	Lo is the lowest code inside the band. For a differential
+*		input codes are signed, e.g. from XadcChan_FromMillivolts().
+* @param	Hi is the highest code inside the band; 65535 (32767 for a
+*		differential input) for a band with no upper edge.
+* @param	Hyst is how far outside the band a sample must be to leave it.
+* @param	IdPtr receives the band ID used in its events, may be NULL.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the engine is full or the
+*		range is empty.
+*
+* @note		The first temperature band with no upper edge is given to the
+*		hardware alarm. All other bands are compared in software and
+*		their channel must be in the acquisition mask (see SwMask).
+*
+******************************************************************************/
+int XadcBand_Add(XadcBand_Engine *EnginePtr, const char *Name, u8 Channel,
+		 s32 Lo, s32 Hi, s32 Hyst, u32 *IdPtr)
+{
+	const XadcChan_Info *InfoPtr = XadcChan_Lookup(Channel);
+	XadcBand *BandPtr;
+	u32 Id = EnginePtr->Count;
+
+	if (Id >= XADC_BAND_MAX || Lo > Hi || Hyst < 0)
+		return XST_FAILURE;
+
+	BandPtr = &EnginePtr->Band[Id];
+	*BandPtr = (XadcBand){0};
+	BandPtr->Name = Name;
+	BandPtr->Channel = Channel;
+	BandPtr->Bipolar = (InfoPtr != NULL &&
+			    InfoPtr->Mode == XADC_CHAN_BIPOLAR);
+	BandPtr->Lo = Lo;
+	BandPtr->Hi = Hi;
+	BandPtr->Hyst = Hyst;
+
+	if (Channel == XADC_BAND_CH_TEMP && Hi >= 0xFFFF && Lo > Hyst &&
+	    EnginePtr->HwBand == XADC_BAND_MAX) {
+		BandPtr->Source = XADC_BAND_HW;
+		EnginePtr->HwBand = Id;
+	} else {
+		BandPtr->Source = XADC_BAND_SW;
+		EnginePtr->SwMask |= 1U << Channel;
+	}
+
+	EnginePtr->Count++;
+	if (IdPtr != NULL)
+		*IdPtr = Id;
+	return XST_SUCCESS;
+}
+
+/*****************************************************************************/
+/**
+* @return	Sequencer channel bits the bands need converted beyond the
+*		board inputs: the temperature sensor if any band uses it.
+*
+******************************************************************************/
+u32 XadcBand_SeqMask(const XadcBand_Engine *EnginePtr)
+{
+	u32 Id;
+
+	for (Id = 0; Id < EnginePtr->Count; Id++) {
+		if (EnginePtr->Band[Id].Channel == XADC_BAND_CH_TEMP)
+			return XSM_SEQ_CH_TEMP;
+	}
+	return 0;
+}
+
+/*****************************************************************************/
+/**
+* Programs the hardware band into the temperature alarm and enables its
+* interrupts. Call after Xadc_Init(), which disables all alarms, and route
+* the alarm interrupts here with XadcAcq_SetAlarmCallback().
+*
+******************************************************************************/
+void XadcBand_Arm(XadcBand_Engine *EnginePtr)
+{
+	XadcBand *BandPtr;
+
+	if (EnginePtr->HwBand == XADC_BAND_MAX)
+		return;
+	BandPtr = &EnginePtr->Band[EnginePtr->HwBand];
+
+#ifdef HOST_SIM
+	(void)BandPtr;
+	EnginePtr->SimAlarm = FALSE;
+#else
+	XSysMon_SetAlarmThreshold(EnginePtr->XadcPtr, XSM_ATR_TEMP_UPPER,
+				  (u16)BandPtr->Lo);
+	XSysMon_SetAlarmThreshold(EnginePtr->XadcPtr, XSM_ATR_TEMP_LOWER,
+				  (u16)(BandPtr->Lo - BandPtr->Hyst));
+	XSysMon_SetAlarmEnables(EnginePtr->XadcPtr,
+				XSysMon_GetAlarmEnables(EnginePtr->XadcPtr) |
+				XSM_CFR_ALM_TEMP_MASK);
+	XSysMon_IntrClear(EnginePtr->XadcPtr, XSM_IPIXR_TEMP_MASK |
+			  XSM_IPIXR_TEMP_DEACTIVE_MASK);
+	XSysMon_IntrEnable(EnginePtr->XadcPtr, XSM_IPIXR_TEMP_MASK |
+			   XSM_IPIXR_TEMP_DEACTIVE_MASK);
+#endif
+}
+
+/*****************************************************************************/
+/**
+* Compares a frame against every software band. Called for each published
+* frame, normally from the XadcAcq callback.
+*
+******************************************************************************/
+void XadcBand_Update(XadcBand_Engine *EnginePtr, const XadcAcq_Frame *FramePtr)
+{
+	XadcBand *BandPtr;
+	u32 Id;
+	u16 Code;
+	s32 Value;
+
+	EnginePtr->Frames++;
+	for (Id = 0; Id < EnginePtr->Count; Id++) {
+		BandPtr = &EnginePtr->Band[Id];
+		if (BandPtr->Source != XADC_BAND_SW)
+			continue;
+
+		Code = FramePtr->Data[BandPtr->Channel];
+		Value = BandPtr->Bipolar ? (s16)Code : Code;
+		if (!BandPtr->Inside) {
+			if (Value >= BandPtr->Lo && Value <= BandPtr->Hi)
+				XadcBand_Emit(EnginePtr, Id, XADC_BAND_ENTER,
+					      Code, FramePtr->Stamp);
+		} else if (Value < BandPtr->Lo - BandPtr->Hyst ||
+			   Value > BandPtr->Hi + BandPtr->Hyst) {
+			XadcBand_Emit(EnginePtr, Id, XADC_BAND_LEAVE, Code,
+				      FramePtr->Stamp);
+		}
+	}
+}
+
+/*****************************************************************************/
+/**
+* Handles the temperature alarm interrupts of the hardware band. Used as
+* the XadcAcq alarm callback (through a wrapper) or called with the
+* pending XSysMon interrupt status.
+*
+* @note		If the alarm both set and reset since the last interrupt,
+*		both crossings are reported, entry first.
+*
+******************************************************************************/
+void XadcBand_AlarmHandler(XadcBand_Engine *EnginePtr, u32 Status)
+{
+	XadcBand *BandPtr;
+	u64 Stamp = now_ticks();
+	u32 Id = EnginePtr->HwBand;
+
+	if (Id == XADC_BAND_MAX)
+		return;
+	BandPtr = &EnginePtr->Band[Id];
+	EnginePtr->Alarms++;
+
+	if ((Status & XSM_IPIXR_TEMP_MASK) && !BandPtr->Inside)
+		XadcBand_Emit(EnginePtr, Id, XADC_BAND_ENTER,
+			      (u16)BandPtr->Lo, Stamp);
+	if ((Status & XSM_IPIXR_TEMP_DEACTIVE_MASK) && BandPtr->Inside)
+		XadcBand_Emit(EnginePtr, Id, XADC_BAND_LEAVE,
+			      (u16)(BandPtr->Lo - BandPtr->Hyst), Stamp);
+}
+
+/*****************************************************************************/
+/**
+* Main loop side: takes the oldest crossing.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if there is none.
+*
+******************************************************************************/
+int XadcBand_Pop(XadcBand_Engine *EnginePtr, Event *EventPtr)
+{
+	return Event_Pop(&EnginePtr->Events, EventPtr);
+}
+
+/*****************************************************************************/
+/**
+* @return	TRUE if the band is currently entered.
+*
+******************************************************************************/
+int XadcBand_IsInside(const XadcBand_Engine *EnginePtr, u32 Id)
+{
+	return Id < EnginePtr->Count && EnginePtr->Band[Id].Inside;
+}
+
+#ifdef HOST_SIM
+/*****************************************************************************/
+/**
+* Host model of the temperature alarm: feeds a temperature code through the
+* comparator the XSysMon applies to the programmed thresholds and raises
+* the alarm interrupts on its edges.
+*
+******************************************************************************/
+void XadcBand_SimTemp(XadcBand_Engine *EnginePtr, u16 Code)
+{
+	XadcBand *BandPtr;
+
+	if (EnginePtr->HwBand == XADC_BAND_MAX)
+		return;
+	BandPtr = &EnginePtr->Band[EnginePtr->HwBand];
+
+	if (!EnginePtr->SimAlarm && Code > BandPtr->Lo) {
+		EnginePtr->SimAlarm = TRUE;
+		XadcBand_AlarmHandler(EnginePtr, XSM_IPIXR_TEMP_MASK);
+	} else if (EnginePtr->SimAlarm && Code < BandPtr->Lo - BandPtr->Hyst) {
+		EnginePtr->SimAlarm = FALSE;
+		XadcBand_AlarmHandler(EnginePtr, XSM_IPIXR_TEMP_DEACTIVE_MASK);
+	}
+}
+
+static u32 BenchSeed = 1;
+
+/*
+ * Uniform noise in [-Amp, Amp]
+ */
+static s32 XadcBand_BenchNoise(s32 Amp)
+{
+	BenchSeed = BenchSeed * 1103515245 + 12345;
+	return Amp ? (s32)((BenchSeed >> 8) % (2 * Amp + 1)) - Amp : 0;
+}
+
+/*
+ * Sine over a code range, as a code of the channel
+ */
+static s32 XadcBand_BenchSine(u32 Frame, s32 Mid, s32 Amp)
+{
+	/* Parabolic approximation: smooth enough for threshold tests */
+	s32 Phase = (s32)(Frame % XADC_BAND_BENCH_PERIOD);
+	s32 Half = XADC_BAND_BENCH_PERIOD / 2;
+	s32 X = (Phase < Half) ? Phase : Phase - Half;
+	s32 Y = (s32)((s64)4 * Amp * X * (Half - X) / ((s64)Half * Half));
+
+	return (Phase < Half) ? Mid + Y : Mid - Y;
+}
+
+static s32 XadcBand_BenchClamp(s32 Value, s32 Lo, s32 Hi)
+{
+	return (Value < Lo) ? Lo : (Value > Hi) ? Hi : Value;
+}
+
+/*
+ * Drains the engine's events and checks that each band alternates entry
+ * and exit and that every crossing code is on the right side of the band.
+ * Expect holds the next crossing expected of each band, and the events per
+ * band are counted into Counts.
+ */
+static u32 XadcBand_BenchDrain(XadcBand_Engine *EnginePtr, u32 *Expect,
+			       u32 *Counts)
+{
+	const XadcBand *BandPtr;
+	u32 Errors = 0, Enter;
+	s32 Value;
+	Event Ev;
+	u32 Id;
+
+	for (Id = 0; Id < XADC_BAND_MAX; Id++)
+		Counts[Id] = 0;
+	while (XadcBand_Pop(EnginePtr, &Ev) == XST_SUCCESS) {
+		Id = Ev.Type;
+		BandPtr = &EnginePtr->Band[Id];
+		Enter = XADC_BAND_EVENT_ENTERED(Ev.Arg);
+		Value = BandPtr->Bipolar ? (s16)XADC_BAND_EVENT_CODE(Ev.Arg) :
+			XADC_BAND_EVENT_CODE(Ev.Arg);
+		if (Enter != Expect[Id])
+			Errors++;
+		if (BandPtr->Source == XADC_BAND_SW && Enter &&
+		    (Value < BandPtr->Lo || Value > BandPtr->Hi))
+			Errors++;
+		if (BandPtr->Source == XADC_BAND_SW && !Enter &&
+		    Value >= BandPtr->Lo - BandPtr->Hyst &&
+		    Value <= BandPtr->Hi + BandPtr->Hyst)
+			Errors++;
+		Expect[Id] = !Enter;
+		Counts[Id]++;
+	}
+	return Errors;
+}
+
+/*****************************************************************************/
+/**
+* Host check and benchmark.
+*
+* Feeds synthetic waveforms through an engine: a pot (A0) sweeping full
+* scale with noise smaller than the hysteresis, the same signal on a band
+* without hysteresis, a differential input (A8/A9) swinging both ways, and
+* a temperature cycling through 60 C that is watched both by the hardware
+* alarm model and by an equivalent software band. Every band must cross
+* exactly twice per cycle except the one without hysteresis, which shows
+* how much the noise would chatter; events must alternate and lie on the
+* right side of their band, and the event ring must not overflow.
+*
+* Then compares the CPU cost of comparing each frame in the interrupt with
+* the old approach of the main loop copying the newest frame and comparing
+* it every XADC_BAND_BENCH_POLL_US.
+*
+******************************************************************************/
+void XadcBand_Benchmark(void)
+{
+	static XadcBand_Engine Engine;
+	XadcAcq_Frame Frame;
+	u32 Expect[XADC_BAND_MAX], Counts[XADC_BAND_MAX];
+	u32 Errors = 0, Events = 0, N, Id, Rep;
+	u32 Pot, PotRaw, Diff, TempHw, TempSw;
+	const u32 Frames = XADC_BAND_BENCH_PERIOD * XADC_BAND_BENCH_CYCLES;
+	const u32 Reps = 2000000;
+	static XadcAcq_Frame Shared;
+	u64 Start, IsrTicks, PollTicks;
+	double IsrCost, PollCost;
+	s32 Temp;
+	int Fail;
+
+	XadcBand_Init(&Engine, NULL);
+	XadcBand_Add(&Engine, "pot > 90%", XADC_CHAN_AUX(1), 58982, 65535, 1311,
+		     &Pot);
+	XadcBand_Add(&Engine, "pot > 90% raw", XADC_CHAN_AUX(1), 58982, 65535, 0,
+		     &PotRaw);
+	XadcBand_Add(&Engine, "A8/A9 < -250 mV", XADC_CHAN_AUX(0), -32768,
+		     -16384, 655, &Diff);
+	XadcBand_Add(&Engine, "temp > 60C", XADC_BAND_CH_TEMP,
+		     XADC_BAND_TEMP_CODE(60), 0xFFFF,
+		     XADC_BAND_TEMP_CODE(60) - XADC_BAND_TEMP_CODE(58), &TempHw);
+	XadcBand_Add(&Engine, "temp > 60C sw", XADC_BAND_CH_TEMP,
+		     XADC_BAND_TEMP_CODE(60), 0xFFFE,
+		     XADC_BAND_TEMP_CODE(60) - XADC_BAND_TEMP_CODE(58), &TempSw);
+	XadcBand_Arm(&Engine);
+
+	for (Id = 0; Id < XADC_BAND_MAX; Id++)
+		Expect[Id] = XADC_BAND_ENTER;
+	memset(&Frame, 0, sizeof(Frame));
+	for (N = 0; N < Frames; N++) {
+		Frame.Seq = N + 1;
+		Frame.Stamp = N;
+		Frame.Data[XADC_CHAN_AUX(1)] = (u16)XadcBand_BenchClamp(
+			XadcBand_BenchSine(N, 32768, 34000) +
+			XadcBand_BenchNoise(600), 0, 65535);
+		Frame.Data[XADC_CHAN_AUX(0)] = (u16)XadcBand_BenchClamp(
+			XadcBand_BenchSine(N, 0, 30000) +
+			XadcBand_BenchNoise(300), -32768, 32767);
+		Temp = XadcBand_BenchSine(N, XADC_BAND_TEMP_CODE(55),
+					  XADC_BAND_TEMP_CODE(70) -
+					  XADC_BAND_TEMP_CODE(55)) +
+		       XadcBand_BenchNoise(XADC_BAND_TEMP_CODE(60) -
+					   XADC_BAND_TEMP_CODE(59.5));
+		Frame.Data[XADC_BAND_CH_TEMP] = (u16)Temp;
+
+		XadcBand_SimTemp(&Engine, (u16)Temp);
+		XadcBand_Update(&Engine, &Frame);
+		/* Main loop drains often enough for the 64-entry ring */
+		if (N % 100 == 99) {
+			Errors += XadcBand_BenchDrain(&Engine, Expect, Counts);
+			Events += Counts[Pot] + Counts[Diff] + Counts[TempHw] +
+				  Counts[TempSw];
+		}
+	}
+	Errors += XadcBand_BenchDrain(&Engine, Expect, Counts);
+	Events += Counts[Pot] + Counts[Diff] + Counts[TempHw] + Counts[TempSw];
+
+	Fail = Errors != 0 || Engine.Events.Dropped != 0;
+	for (Id = 0; Id < Engine.Count; Id++) {
+		if (Id != PotRaw &&
+		    Engine.Band[Id].Crossings != 2 * XADC_BAND_BENCH_CYCLES)
+			Fail = TRUE;
+		printf("xadc_band: %-16s %s %5u crossings in %u cycles\n",
+		       Engine.Band[Id].Name,
+		       Engine.Band[Id].Source == XADC_BAND_HW ? "hw" : "sw",
+		       Engine.Band[Id].Crossings, XADC_BAND_BENCH_CYCLES);
+	}
+	printf("xadc_band: %u errors, %u dropped, %u alarm interrupts (%s)\n",
+	       Errors, Engine.Events.Dropped, Engine.Alarms,
+	       Fail ? "FAIL" : "ok");
+	printf("xadc_band: %.1f events/s at %u frames/s (hysteresis bands)\n",
+	       (double)Events * XADC_BAND_BENCH_FRAME_HZ / Frames,
+	       XADC_BAND_BENCH_FRAME_HZ);
+
+	/* Interrupt: compare each frame once */
+	Start = now_ticks();
+	for (Rep = 0; Rep < Reps; Rep++) {
+		Frame.Data[XADC_CHAN_AUX(1)] = (u16)(Rep << 4);
+		XadcBand_Update(&Engine, &Frame);
+		Event_QueueInit(&Engine.Events);
+	}
+	IsrTicks = now_ticks() - Start;
+
+	/* Polling: copy the newest frame and compare it, whether new or not */
+	Start = now_ticks();
+	for (Rep = 0; Rep < Reps; Rep++) {
+		MEMORY_BARRIER();
+		Frame = Shared;
+		Frame.Data[XADC_CHAN_AUX(1)] = (u16)(Rep << 4);
+		XadcBand_Update(&Engine, &Frame);
+		Event_QueueInit(&Engine.Events);
+	}
+	PollTicks = now_ticks() - Start;
+
+	IsrCost = (double)IsrTicks / Reps;
+	PollCost = (double)PollTicks / Reps;
+	printf("xadc_band: per frame in the interrupt %.1f ns -> %.4f %% CPU at "
+	       "%u frames/s\n", IsrCost,
+	       IsrCost * XADC_BAND_BENCH_FRAME_HZ / TIMEBASE_HZ * 100,
+	       XADC_BAND_BENCH_FRAME_HZ);
+	printf("xadc_band: per poll %.1f ns -> %.4f %% CPU polling every %u us\n",
+	       PollCost, PollCost / (XADC_BAND_BENCH_POLL_US * 1000.0) * 100,
+	       XADC_BAND_BENCH_POLL_US);
+}
+#endif /* HOST_SIM */
@@ -0,0 +1,100 @@
+/*****************************************************************************/
+/**
+* @file xadc_band.h
+*
+* Threshold bands on XADC channels, reported as events on crossings.
+*
+* A band is a range [Lo, Hi] of one channel's codes with a hysteresis
+* margin. It is entered when a sample falls inside the range and left only
+* when a sample falls more than the hysteresis outside it, so a noisy
+* signal sitting on a threshold does not chatter. Every band starts
+* outside. Each entry and exit is timestamped and queued as an Event for
+* the main loop, which then no longer needs to poll the samples.
+*
+* Bands on the on-chip temperature sensor of the form "above Lo" are
+* programmed into the XSysMon temperature alarm: the upper threshold
+* register holds Lo and the lower (reset) register Lo minus the
+* hysteresis, and the alarm and alarm-reset interrupts report the
+* crossings without any per-sample work. The board's analog inputs have no
+* alarm registers, so their bands are compared in software on every frame
+* from the XadcAcq callback, which runs in the end-of-sequence interrupt.
+*
+* Event fields: Type is the band ID and Arg holds XADC_BAND_ENTER or
+* XADC_BAND_LEAVE in bit 16 and the code that caused the crossing in bits
+* 15:0 (the threshold for a hardware band).
+*
+******************************************************************************/
+#ifndef XADC_BAND_H
+#define XADC_BAND_H
+
+#include "platform.h"
+#include "event_queue.h"
+#include "xadc_acq.h"
+
+/************************** Constant Definitions *****************************/
+
+#define XADC_BAND_MAX		16
+
+#define XADC_BAND_CH_TEMP	0	/* XSysMon on-chip temperature */
+
+#define XADC_BAND_SW		0	/* Compared on every frame */
+#define XADC_BAND_HW		1	/* XSysMon temperature alarm */
+
+#define XADC_BAND_LEAVE		0
+#define XADC_BAND_ENTER		1
+
+#define XADC_BAND_EVENT_ENTERED(Arg)	(((Arg) >> 16) & 1)
+#define XADC_BAND_EVENT_CODE(Arg)	((u16)(Arg))
+
+/*
+ * Temperature sensor code for a temperature in degrees C: the XADC
+ * transfer function is T = Code * 503.975 / 65536 - 273.15
+ */
+#define XADC_BAND_TEMP_CODE(C)	((s32)(((C) + 273.15) * 65536 / 503.975 + 0.5))
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	const char *Name;
+	u8 Channel;		/* XSysMon channel number */
+	u8 Source;		/* XADC_BAND_SW or XADC_BAND_HW */
+	u8 Bipolar;		/* Codes are two's complement */
+	u8 Inside;
+	s32 Lo;			/* Codes, sign-extended if Bipolar */
+	s32 Hi;
+	s32 Hyst;
+	u32 Crossings;
+} XadcBand;
+
+typedef struct {
+	XSysMon *XadcPtr;
+	u32 Count;
+	XadcBand Band[XADC_BAND_MAX];
+	u32 SwMask;		/* Channels with software bands */
+	u32 HwBand;		/* ID of the hardware band, or XADC_BAND_MAX */
+	Event_Queue Events;
+	u32 Frames;		/* Frames compared */
+	u32 Alarms;		/* Alarm interrupts handled */
+#ifdef HOST_SIM
+	u32 SimAlarm;		/* Simulated temperature alarm output */
+#endif
+} XadcBand_Engine;
+
+/************************** Function Prototypes ******************************/
+
+void XadcBand_Init(XadcBand_Engine *EnginePtr, XSysMon *XadcPtr);
+int XadcBand_Add(XadcBand_Engine *EnginePtr, const char *Name, u8 Channel,
+		 s32 Lo, s32 Hi, s32 Hyst, u32 *IdPtr);
+u32 XadcBand_SeqMask(const XadcBand_Engine *EnginePtr);
+void XadcBand_Arm(XadcBand_Engine *EnginePtr);
+void XadcBand_Update(XadcBand_Engine *EnginePtr, const XadcAcq_Frame *FramePtr);
+void XadcBand_AlarmHandler(XadcBand_Engine *EnginePtr, u32 Status);
+int XadcBand_Pop(XadcBand_Engine *EnginePtr, Event *EventPtr);
+int XadcBand_IsInside(const XadcBand_Engine *EnginePtr, u32 Id);
+
+#ifdef HOST_SIM
+void XadcBand_SimTemp(XadcBand_Engine *EnginePtr, u16 Code);
+void XadcBand_Benchmark(void);
+#endif
+
+#endif /* XADC_BAND_H */
@@ -0,0 +1,333 @@
+/*****************************************************************************/
+/**
+* @file xadc_chan.c
+*
+* Cora Z7 analog input table and millivolt lookup tables. See xadc_chan.h.
+*
+******************************************************************************/
+
+/***************************** Include Files *********************************/
+
+#include "xadc_chan.h"
+
+#ifdef HOST_SIM
+#include <stdio.h>
+#include "timebase.h"
+#include "fixed.h"
+#endif
+
+/************************** Constant Definitions *****************************/
+
+#define XADC_CHAN_CONV_CLKS	32	/* ADCCLK cycles per conversion with the
+					   extended acquisition time */
+#define XADC_CHAN_SEQ_VPVN	11	/* Sequencer bit of VP/VN */
+
+/*
+ * Lookup table generation. XADC_CHAN_LUT(F) expands to F(0) ... F(4096),
+ * the millivolts at codes 0, 16, ... 65536.
+ */
+#define XADC_CHAN_LUT_4(F, n)	F(n), F((n) + 1), F((n) + 2), F((n) + 3)
+#define XADC_CHAN_LUT_16(F, n)	XADC_CHAN_LUT_4(F, n), \
+				XADC_CHAN_LUT_4(F, (n) + 4), \
+				XADC_CHAN_LUT_4(F, (n) + 8), \
+				XADC_CHAN_LUT_4(F, (n) + 12)
+#define XADC_CHAN_LUT_64(F, n)	XADC_CHAN_LUT_16(F, n), \
+				XADC_CHAN_LUT_16(F, (n) + 16), \
+				XADC_CHAN_LUT_16(F, (n) + 32), \
+				XADC_CHAN_LUT_16(F, (n) + 48)
+#define XADC_CHAN_LUT_256(F, n)	XADC_CHAN_LUT_64(F, n), \
+				XADC_CHAN_LUT_64(F, (n) + 64), \
+				XADC_CHAN_LUT_64(F, (n) + 128), \
+				XADC_CHAN_LUT_64(F, (n) + 192)
+#define XADC_CHAN_LUT_1K(F, n)	XADC_CHAN_LUT_256(F, n), \
+				XADC_CHAN_LUT_256(F, (n) + 256), \
+				XADC_CHAN_LUT_256(F, (n) + 512), \
+				XADC_CHAN_LUT_256(F, (n) + 768)
+#define XADC_CHAN_LUT(F)	XADC_CHAN_LUT_1K(F, 0), \
+				XADC_CHAN_LUT_1K(F, 1024), \
+				XADC_CHAN_LUT_1K(F, 2048), \
+				XADC_CHAN_LUT_1K(F, 3072), F(4096)
+
+/* Unipolar: entry n is code 16n, rounded to nearest */
+#define XADC_CHAN_SE(n)		(s16)(((n) * 16 * XADC_CHAN_SE_MV + 32768) / 65536)
+/* Bipolar: entry n is code 16n - 32768; half the span is a whole mV */
+#define XADC_CHAN_DIFF(n)	(s16)(((n) * 16 * XADC_CHAN_DIFF_MV + 32768) / \
+				      65536 - XADC_CHAN_DIFF_MV / 2)
+
+/************************** Variable Definitions *****************************/
+
+static const s16 XadcChan_SeLut[4097] = { XADC_CHAN_LUT(XADC_CHAN_SE) };
+static const s16 XadcChan_DiffLut[4097] = { XADC_CHAN_LUT(XADC_CHAN_DIFF) };
+
+/*
+ * Every analog input of the Cora Z7, in channel order
+ */
+const XadcChan_Info XadcChan_Table[XADC_CHAN_COUNT] = {
+	{ XADC_CHAN_VPVN, XADC_CHAN_BIPOLAR, TRUE, XADC_CHAN_DIFF_MV,
+	  "VP/VN", XadcChan_DiffLut },
+	{ XADC_CHAN_AUX(0), XADC_CHAN_BIPOLAR, TRUE, XADC_CHAN_DIFF_MV,
+	  "A8/A9", XadcChan_DiffLut },
+	{ XADC_CHAN_AUX(1), XADC_CHAN_UNIPOLAR, TRUE, XADC_CHAN_SE_MV,
+	  "A0", XadcChan_SeLut },
+	{ XADC_CHAN_AUX(5), XADC_CHAN_UNIPOLAR, TRUE, XADC_CHAN_SE_MV,
+	  "A4", XadcChan_SeLut },
+	{ XADC_CHAN_AUX(6), XADC_CHAN_UNIPOLAR, TRUE, XADC_CHAN_SE_MV,
+	  "A2", XadcChan_SeLut },
+	{ XADC_CHAN_AUX(8), XADC_CHAN_BIPOLAR, TRUE, XADC_CHAN_DIFF_MV,
+	  "A10/A11", XadcChan_DiffLut },
+	{ XADC_CHAN_AUX(9), XADC_CHAN_UNIPOLAR, TRUE, XADC_CHAN_SE_MV,
+	  "A1", XadcChan_SeLut },
+	{ XADC_CHAN_AUX(12), XADC_CHAN_BIPOLAR, TRUE, XADC_CHAN_DIFF_MV,
+	  "A6/A7", XadcChan_DiffLut },
+	{ XADC_CHAN_AUX(13), XADC_CHAN_UNIPOLAR, TRUE, XADC_CHAN_SE_MV,
+	  "A5", XadcChan_SeLut },
+	{ XADC_CHAN_AUX(15), XADC_CHAN_UNIPOLAR, TRUE, XADC_CHAN_SE_MV,
+	  "A3", XadcChan_SeLut },
+};
+
+/*
+ * Sequencer register bit of a channel: VP/VN has its own bit, the
+ * auxiliary inputs use the bit of their channel number
+ */
+static u32 XadcChan_SeqBit(u32 Channel)
+{
+	return (Channel == XADC_CHAN_VPVN) ? XADC_CHAN_SEQ_VPVN : Channel;
+}
+
+/*****************************************************************************/
+/**
+* @return	The table entry of an XSysMon channel number, or NULL if the
+*		channel is not an input of the board.
+*
+******************************************************************************/
+const XadcChan_Info *XadcChan_Lookup(u32 Channel)
+{
+	u32 Index;
+
+	for (Index = 0; Index < XADC_CHAN_COUNT; Index++) {
+		if (XadcChan_Table[Index].Channel == Channel)
+			return &XadcChan_Table[Index];
+	}
+	return NULL;
+}
+
+/*****************************************************************************/
+/**
+* @return	A bit per enabled channel, by XSysMon channel number, as used
+*		by XadcAcq_Init() and XSysMon_GetAdcData().
+*
+******************************************************************************/
+u32 XadcChan_Mask(void)
+{
+	u32 Index, Mask = 0;
+
+	for (Index = 0; Index < XADC_CHAN_COUNT; Index++) {
+		if (XadcChan_Table[Index].Enabled)
+			Mask |= 1U << XadcChan_Table[Index].Channel;
+	}
+	return Mask;
+}
+
+/*****************************************************************************/
+/**
+* @return	Enabled channels in the sequencer bit layout, for
+*		XSysMon_SetSeqChEnables() and friends.
+*
+******************************************************************************/
+u32 XadcChan_SeqMask(void)
+{
+	u32 Index, Mask = 0;
+
+	for (Index = 0; Index < XADC_CHAN_COUNT; Index++) {
+		if (XadcChan_Table[Index].Enabled)
+			Mask |= 1U << XadcChan_SeqBit(XadcChan_Table[Index].Channel);
+	}
+	return Mask;
+}
+
+/*****************************************************************************/
+/**
+* @return	Enabled differential channels in the sequencer bit layout, for
+*		XSysMon_SetSeqInputMode().
+*
+******************************************************************************/
+u32 XadcChan_BipolarSeqMask(void)
+{
+	u32 Index, Mask = 0;
+
+	for (Index = 0; Index < XADC_CHAN_COUNT; Index++) {
+		if (XadcChan_Table[Index].Enabled &&
+		    XadcChan_Table[Index].Mode == XADC_CHAN_BIPOLAR)
+			Mask |= 1U << XadcChan_SeqBit(XadcChan_Table[Index].Channel);
+	}
+	return Mask;
+}
+
+/*****************************************************************************/
+/**
+* @return	Number of enabled channels.
+*
+******************************************************************************/
+u32 XadcChan_EnabledCount(void)
+{
+	u32 Mask = XadcChan_Mask(), Count = 0;
+
+	while (Mask != 0) {
+		XadcChan_NextBit(&Mask);
+		Count++;
+	}
+	return Count;
+}
+
+/*****************************************************************************/
+/**
+* Estimates the sequence rate.
+*
+* @param	AdcClkHz is the ADCCLK frequency.
+* @param	Average is the number of samples averaged per conversion.
+*
+* @return	Sequences per second through the enabled channels.
+*
+******************************************************************************/
+u32 XadcChan_FrameHz(u32 AdcClkHz, u32 Average)
+{
+	u32 Count = XadcChan_EnabledCount();
+
+	if (Count == 0 || Average == 0)
+		return 0;
+	return AdcClkHz / (XADC_CHAN_CONV_CLKS * Average * Count);
+}
+
+#ifdef HOST_SIM
+/*
+ * The conversion XADC_main.c used before the table: a scale per channel
+ * in float, with codes that have bit 15 set treated as negative
+ */
+static float XadcChan_BenchFloat(u16 Data, u8 Channel)
+{
+	float FloatData;
+	float Scale;
+
+	switch (Channel) {
+	case 3: case 16: case 24: case 28: Scale = 1.0; break;
+	case 17: case 21: case 22: case 25: case 29: case 31: Scale = 3.3; break;
+	default: Scale = 0.0;
+	}
+	if (Data & 0x8000) {
+		FloatData = -Scale;
+		Data = ~Data + 1;
+	} else
+		FloatData = Scale;
+	FloatData *= (float)Data / (float)0xFFFF;
+	return FloatData;
+}
+
+/*
+ * The Q16.16 conversion that replaced it
+ */
+static Fixed_Q16 XadcChan_BenchFixed(u16 Data, u8 Channel)
+{
+	Fixed_Q16 Scale;
+
+	switch (Channel) {
+	case 3: case 16: case 24: case 28: Scale = FIXED_Q16(1.0); break;
+	case 17: case 21: case 22: case 25: case 29: case 31:
+		Scale = FIXED_Q16(3.3); break;
+	default: Scale = 0;
+	}
+	if (Data & 0x8000) {
+		Data = ~Data + 1;
+		return -Fixed_Map(Data, 0, 0xFFFF, 0, Scale);
+	}
+	return Fixed_Map(Data, 0, 0xFFFF, 0, Scale);
+}
+
+/*****************************************************************************/
+/**
+* Host check and benchmark.
+*
+* Converts every code of every table channel through the lookup tables and
+* checks the result is within 1 mV of the exact value. Then times the
+* float conversion XADC_main.c used to do, the Q16.16 one that replaced
+* it and the table, and a 32-step channel loop against the bit scan for
+* the enabled mask.
+*
+******************************************************************************/
+void XadcChan_Benchmark(void)
+{
+	const XadcChan_Info *InfoPtr;
+	double Exact, Err, MaxErr = 0;
+	volatile s32 Sink = 0;
+	volatile float FloatSink = 0;
+	u64 Start, FloatTicks, FixedTicks, LutTicks, LoopTicks, ScanTicks;
+	u32 Index, Code, Mask, Rep, Channel;
+	const u32 Conversions = XADC_CHAN_COUNT * 65536;
+	const u32 Reps = 2000000;
+
+	for (Index = 0; Index < XADC_CHAN_COUNT; Index++) {
+		InfoPtr = &XadcChan_Table[Index];
+		for (Code = 0; Code < 65536; Code++) {
+			Exact = (InfoPtr->Mode == XADC_CHAN_BIPOLAR) ?
+				(s16)Code : (double)Code;
+			Exact = Exact * InfoPtr->SpanMv / 65536;
+			Err = XadcChan_ToMillivolts(InfoPtr, Code) - Exact;
+			if (Err < 0)
+				Err = -Err;
+			if (Err > MaxErr)
+				MaxErr = Err;
+		}
+	}
+	printf("xadc_chan: %u channels, max error %.3f mV (%s), masks "
+	       "chan %08x seq %08x bipolar %08x\n", XADC_CHAN_COUNT, MaxErr,
+	       (MaxErr <= 1.0) ? "ok" : "FAIL", XadcChan_Mask(),
+	       XadcChan_SeqMask(), XadcChan_BipolarSeqMask());
+
+	Start = now_ticks();
+	for (Index = 0; Index < XADC_CHAN_COUNT; Index++)
+		for (Code = 0; Code < 65536; Code++)
+			FloatSink += XadcChan_BenchFloat(Code,
+						XadcChan_Table[Index].Channel);
+	FloatTicks = now_ticks() - Start;
+
+	Start = now_ticks();
+	for (Index = 0; Index < XADC_CHAN_COUNT; Index++)
+		for (Code = 0; Code < 65536; Code++)
+			Sink += XadcChan_BenchFixed(Code,
+						XadcChan_Table[Index].Channel);
+	FixedTicks = now_ticks() - Start;
+
+	Start = now_ticks();
+	for (Index = 0; Index < XADC_CHAN_COUNT; Index++)
+		for (Code = 0; Code < 65536; Code++)
+			Sink += XadcChan_ToMillivolts(&XadcChan_Table[Index],
+						      Code);
+	LutTicks = now_ticks() - Start;
+
+	printf("xadc_chan: conversions/s: float %.1f M, Q16.16 %.1f M, "
+	       "table %.1f M\n",
+	       (double)Conversions * TIMEBASE_HZ / FloatTicks / 1e6,
+	       (double)Conversions * TIMEBASE_HZ / FixedTicks / 1e6,
+	       (double)Conversions * TIMEBASE_HZ / LutTicks / 1e6);
+
+	Start = now_ticks();
+	for (Rep = 0; Rep < Reps; Rep++) {
+		Mask = XadcChan_Mask() ^ (Rep & 1);
+		for (Channel = 0; Channel < 32; Channel++)
+			if (Mask & (1U << Channel))
+				Sink += Channel;
+	}
+	LoopTicks = now_ticks() - Start;
+
+	Start = now_ticks();
+	for (Rep = 0; Rep < Reps; Rep++) {
+		Mask = XadcChan_Mask() ^ (Rep & 1);
+		while (Mask != 0)
+			Sink += XadcChan_NextBit(&Mask);
+	}
+	ScanTicks = now_ticks() - Start;
+
+	printf("xadc_chan: walk enabled mask: 32-step loop %.1f ns, "
+	       "bit scan %.1f ns\n", (double)LoopTicks / Reps,
+	       (double)ScanTicks / Reps);
+}
+#endif /* HOST_SIM */
@@ -0,0 +1,118 @@
+/*****************************************************************************/
+/**
+* @file xadc_chan.h
+*
+* The Cora Z7 analog inputs and their conversion to millivolts.
+*
+* XadcChan_Table lists every XADC input brought out on the board, with its
+* XSysMon channel number, input mode, full-scale span and header pins. The
+* sequencer channel, input mode and frame masks are all derived from the
+* entries marked enabled, so adding an input to the acquisition is a one
+* line change.
+*
+* Single-ended inputs are converted in unipolar mode (code 0 to 65535 is
+* 0 V to the span) and differential inputs in bipolar mode (two's
+* complement code, +/- half the span). Codes are converted to millivolts
+* through a 4097-entry table per span, built by the preprocessor so it sits
+* in read-only memory with no init code, interpolating on the four
+* averaging bits below the 12-bit code.
+*
+******************************************************************************/
+#ifndef XADC_CHAN_H
+#define XADC_CHAN_H
+
+#include "platform.h"
+
+/************************** Constant Definitions *****************************/
+
+/*
+ * XSysMon channel numbers
+ */
+#define XADC_CHAN_VPVN		3
+#define XADC_CHAN_AUX(n)	(16 + (n))
+
+#define XADC_CHAN_UNIPOLAR	0	/* Single-ended */
+#define XADC_CHAN_BIPOLAR	1	/* Differential */
+
+#define XADC_CHAN_COUNT		10	/* Entries in XadcChan_Table */
+
+/*
+ * Cora Z7 input spans, in millivolts
+ */
+#define XADC_CHAN_SE_MV		3300	/* A0-A5, divided down to 1 V */
+#define XADC_CHAN_DIFF_MV	1000	/* VP/VN and the A6-A11 pairs */
+
+/**************************** Type Definitions *******************************/
+
+typedef struct {
+	u8 Channel;		/* XSysMon channel number */
+	u8 Mode;		/* XADC_CHAN_UNIPOLAR or XADC_CHAN_BIPOLAR */
+	u8 Enabled;		/* Included in the sequence */
+	u16 SpanMv;		/* Millivolts across the whole code range */
+	const char *Name;	/* Header pins */
+	const s16 *Lut;		/* Millivolts at every 16th code */
+} XadcChan_Info;
+
+/************************** Variable Definitions *****************************/
+
+extern const XadcChan_Info XadcChan_Table[XADC_CHAN_COUNT];
+
+/***************** Macros (Inline Functions) Definitions *********************/
+
+/*
+ * Returns the lowest channel in *MaskPtr and removes it from the mask.
+ * *MaskPtr must not be 0.
+ */
+static inline u32 XadcChan_NextBit(u32 *MaskPtr)
+{
+	u32 Bit = (u32)__builtin_ctz(*MaskPtr);
+
+	*MaskPtr &= *MaskPtr - 1;
+	return Bit;
+}
+
+/*
+ * Millivolts for a code of the channel, interpolating between table
+ * entries on the low four bits
+ */
+static inline s32 XadcChan_ToMillivolts(const XadcChan_Info *InfoPtr,
+					u16 Code)
+{
+	u32 Index = (InfoPtr->Mode == XADC_CHAN_BIPOLAR) ?
+		    (u32)(((s32)(s16)Code >> 4) + 2048) : (u32)(Code >> 4);
+	s32 Lo = InfoPtr->Lut[Index];
+	s32 Hi = InfoPtr->Lut[Index + 1];
+
+	return Lo + (((Hi - Lo) * (s32)(Code & 0xF) + 8) >> 4);
+}
+
+/*
+ * Code for a voltage at the pins of the channel, the inverse of
+ * XadcChan_ToMillivolts(). Bipolar codes are returned sign-extended, the
+ * way a comparison against a sample should see them.
+ */
+static inline s32 XadcChan_FromMillivolts(const XadcChan_Info *InfoPtr,
+					  s32 Millivolts)
+{
+	s32 Code = (s32)(((s64)Millivolts * 65536 + InfoPtr->SpanMv / 2) /
+			 InfoPtr->SpanMv);
+
+	if (InfoPtr->Mode == XADC_CHAN_BIPOLAR)
+		return (Code < -32768) ? -32768 : (Code > 32767) ? 32767 : Code;
+	return (Code < 0) ? 0 : (Code > 65535) ? 65535 : Code;
+}
+
+/************************** Function Prototypes ******************************/
+
+const XadcChan_Info *XadcChan_Lookup(u32 Channel);
+u32 XadcChan_Mask(void);
+u32 XadcChan_SeqMask(void);
+u32 XadcChan_BipolarSeqMask(void);
+u32 XadcChan_EnabledCount(void);
+u32 XadcChan_FrameHz(u32 AdcClkHz, u32 Average);
+
+#ifdef HOST_SIM
+void XadcChan_Benchmark(void);
+#endif
+
+#endif /* XADC_CHAN_H */